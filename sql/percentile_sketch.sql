@@ -0,0 +1,64 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+CREATE OR REPLACE FUNCTION _timescaledb_functions.ddsketch_sfunc(state INTERNAL, val DOUBLE PRECISION)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'ts_ddsketch_sfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_functions.ddsketch_merge_sfunc(state INTERNAL, sketch BYTEA)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'ts_ddsketch_merge_sfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_functions.ddsketch_combinefunc(state1 INTERNAL, state2 INTERNAL)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'ts_ddsketch_combinefunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_functions.ddsketch_serializefunc(INTERNAL)
+RETURNS bytea
+AS '@MODULE_PATHNAME@', 'ts_ddsketch_serializefunc'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_functions.ddsketch_deserializefunc(bytea, INTERNAL)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'ts_ddsketch_deserializefunc'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_functions.ddsketch_finalfunc(state INTERNAL)
+RETURNS bytea
+AS '@MODULE_PATHNAME@', 'ts_ddsketch_finalfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Mergeable sketch of the non-null values for approx_percentile(), with the
+-- relative error of 1%. The result is the serialized sketch, so it can be
+-- stored in a Continuous Aggregate and merged with percentile_sketch_merge().
+-- The format must stay readable by the newer versions.
+CREATE OR REPLACE AGGREGATE @extschema@.percentile_sketch(DOUBLE PRECISION) (
+    SFUNC = _timescaledb_functions.ddsketch_sfunc,
+    STYPE = INTERNAL,
+    COMBINEFUNC = _timescaledb_functions.ddsketch_combinefunc,
+    SERIALFUNC = _timescaledb_functions.ddsketch_serializefunc,
+    DESERIALFUNC = _timescaledb_functions.ddsketch_deserializefunc,
+    PARALLEL = SAFE,
+    FINALFUNC = _timescaledb_functions.ddsketch_finalfunc
+);
+
+-- Merge the sketches computed by percentile_sketch().
+CREATE OR REPLACE AGGREGATE @extschema@.percentile_sketch_merge(BYTEA) (
+    SFUNC = _timescaledb_functions.ddsketch_merge_sfunc,
+    STYPE = INTERNAL,
+    COMBINEFUNC = _timescaledb_functions.ddsketch_combinefunc,
+    SERIALFUNC = _timescaledb_functions.ddsketch_serializefunc,
+    DESERIALFUNC = _timescaledb_functions.ddsketch_deserializefunc,
+    PARALLEL = SAFE,
+    FINALFUNC = _timescaledb_functions.ddsketch_finalfunc
+);
+
+-- Estimate the given percentile, between 0 and 1, of the values in the sketch.
+CREATE OR REPLACE FUNCTION @extschema@.approx_percentile(sketch BYTEA, percentile DOUBLE PRECISION)
+RETURNS DOUBLE PRECISION
+AS '@MODULE_PATHNAME@', 'ts_approx_percentile'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
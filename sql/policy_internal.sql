@@ -139,89 +139,6 @@ BEGIN
 END;
 $$ LANGUAGE PLPGSQL;
 
-CREATE OR REPLACE PROCEDURE
-_timescaledb_functions.policy_compression(job_id INTEGER, config JSONB)
-AS $$
-DECLARE
-  dimtype             REGTYPE;
-  dimtypeinput        REGPROC;
-  compress_after      TEXT;
-  compress_created_before TEXT;
-  lag_value           TEXT;
-  lag_bigint_value    BIGINT;
-  htid                INTEGER;
-  htoid               REGCLASS;
-  chunk_rec           RECORD;
-  verbose_log         BOOL;
-  maxchunks           INTEGER := 0;
-  numchunks           INTEGER := 1;
-  recompress_enabled  BOOL;
-  use_creation_time   BOOL := FALSE;
-  hypercore_use_access_method   BOOL;
-BEGIN
-
-  -- procedures with SET clause cannot execute transaction
-  -- control so we adjust search_path in procedure body
-  SET LOCAL search_path TO pg_catalog, pg_temp;
-
-  IF config IS NULL THEN
-    RAISE EXCEPTION 'job % has null config', job_id;
-  END IF;
-
-  htid := jsonb_object_field_text(config, 'hypertable_id')::INTEGER;
-  IF htid is NULL THEN
-    RAISE EXCEPTION 'job % config must have hypertable_id', job_id;
-  END IF;
-
-  verbose_log         := COALESCE(jsonb_object_field_text(config, 'verbose_log')::BOOLEAN, FALSE);
-  maxchunks           := COALESCE(jsonb_object_field_text(config, 'maxchunks_to_compress')::INTEGER, 0);
-  recompress_enabled  := COALESCE(jsonb_object_field_text(config, 'recompress')::BOOLEAN, TRUE);
-
-  -- find primary dimension type --
-  SELECT dim.column_type INTO dimtype
-  FROM  _timescaledb_catalog.hypertable ht
-        JOIN _timescaledb_catalog.dimension dim ON ht.id = dim.hypertable_id
-  WHERE ht.id = htid
-  ORDER BY dim.id
-  LIMIT 1;
-
-  compress_after      := jsonb_object_field_text(config, 'compress_after');
-  IF compress_after IS NULL THEN
-    compress_created_before := jsonb_object_field_text(config, 'compress_created_before');
-    IF compress_created_before IS NULL THEN
-        RAISE EXCEPTION 'job % config must have compress_after or compress_created_before', job_id;
-    END IF;
-    lag_value := compress_created_before;
-    use_creation_time := true;
-    dimtype := 'INTERVAL' ::regtype;
-  ELSE
-    lag_value := compress_after;
-  END IF;
-
-  hypercore_use_access_method := jsonb_object_field_text(config, 'hypercore_use_access_method')::bool;
-
-  -- execute the properly type casts for the lag value
-  CASE dimtype
-    WHEN 'TIMESTAMP'::regtype, 'TIMESTAMPTZ'::regtype, 'DATE'::regtype, 'INTERVAL' ::regtype  THEN
-      CALL _timescaledb_functions.policy_compression_execute(
-        job_id, htid, lag_value::INTERVAL,
-        maxchunks, verbose_log, recompress_enabled, use_creation_time, hypercore_use_access_method
-      );
-    WHEN 'BIGINT'::regtype THEN
-      CALL _timescaledb_functions.policy_compression_execute(
-        job_id, htid, lag_value::BIGINT,
-        maxchunks, verbose_log, recompress_enabled, use_creation_time, hypercore_use_access_method
-      );
-    WHEN 'INTEGER'::regtype THEN
-      CALL _timescaledb_functions.policy_compression_execute(
-        job_id, htid, lag_value::INTEGER,
-        maxchunks, verbose_log, recompress_enabled, use_creation_time, hypercore_use_access_method
-      );
-    WHEN 'SMALLINT'::regtype THEN
-      CALL _timescaledb_functions.policy_compression_execute(
-        job_id, htid, lag_value::SMALLINT,
-        maxchunks, verbose_log, recompress_enabled, use_creation_time, hypercore_use_access_method
-      );
-  END CASE;
-END;
-$$ LANGUAGE PLPGSQL;
+CREATE OR REPLACE PROCEDURE _timescaledb_functions.policy_compression(job_id INTEGER, config JSONB)
+AS '@MODULE_PATHNAME@', 'ts_policy_compression_proc'
+LANGUAGE C;
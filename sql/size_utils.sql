@@ -560,6 +560,21 @@ CREATE OR REPLACE FUNCTION @extschema@.chunk_columnstore_stats (hypertable REGCL
     AS 'SELECT * FROM @extschema@.chunk_compression_stats($1)'
     SET search_path TO pg_catalog, pg_temp;
 
+-- Statistics of the compressed batch processing in the current session,
+-- collected with timescaledb.enable_decompression_stats. They are kept in
+-- backend-local memory and are not visible to the other sessions.
+CREATE OR REPLACE FUNCTION _timescaledb_functions.session_decompression_stats()
+    RETURNS TABLE (
+        kind text,
+        name text,
+        count bigint,
+        bytes bigint,
+        total_time double precision)
+AS '@MODULE_PATHNAME@', 'ts_session_decompression_stats' LANGUAGE C VOLATILE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_functions.session_decompression_stats_reset() RETURNS VOID
+AS '@MODULE_PATHNAME@', 'ts_session_decompression_stats_reset' LANGUAGE C VOLATILE;
+
 -- Get compression statistics for a hypertable that has
 -- compression enabled
 CREATE OR REPLACE FUNCTION @extschema@.hypertable_compression_stats (hypertable REGCLASS)
@@ -0,0 +1,18 @@
+DROP VIEW IF EXISTS timescaledb_information.session_decompression_stats;
+DROP FUNCTION IF EXISTS _timescaledb_functions.session_decompression_stats();
+DROP FUNCTION IF EXISTS _timescaledb_functions.session_decompression_stats_reset();
+DROP AGGREGATE IF EXISTS @extschema@.approx_count_distinct(anyelement);
+DROP FUNCTION IF EXISTS _timescaledb_functions.hll_sfunc(internal, anyelement);
+DROP FUNCTION IF EXISTS _timescaledb_functions.hll_combinefunc(internal, internal);
+DROP FUNCTION IF EXISTS _timescaledb_functions.hll_serializefunc(internal);
+DROP FUNCTION IF EXISTS _timescaledb_functions.hll_deserializefunc(bytea, internal);
+DROP FUNCTION IF EXISTS _timescaledb_functions.hll_finalfunc(internal);
+DROP FUNCTION IF EXISTS @extschema@.approx_percentile(bytea, double precision);
+DROP AGGREGATE IF EXISTS @extschema@.percentile_sketch(double precision);
+DROP AGGREGATE IF EXISTS @extschema@.percentile_sketch_merge(bytea);
+DROP FUNCTION IF EXISTS _timescaledb_functions.ddsketch_sfunc(internal, double precision);
+DROP FUNCTION IF EXISTS _timescaledb_functions.ddsketch_merge_sfunc(internal, bytea);
+DROP FUNCTION IF EXISTS _timescaledb_functions.ddsketch_combinefunc(internal, internal);
+DROP FUNCTION IF EXISTS _timescaledb_functions.ddsketch_serializefunc(internal);
+DROP FUNCTION IF EXISTS _timescaledb_functions.ddsketch_deserializefunc(bytea, internal);
+DROP FUNCTION IF EXISTS _timescaledb_functions.ddsketch_finalfunc(internal);
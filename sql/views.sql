@@ -288,7 +288,7 @@ SELECT
     h.execution_finish AS finish_time,
     h.data->'error_data'->>'sqlerrcode' AS sqlerrcode,
     CASE
-      WHEN h.succeeded IS NULL AND h.execution_finish IS NULL AND h.pid IS NULL THEN
+      WHEN h.succeeded IS NOT TRUE AND h.pid IS NULL AND h.data->'error_data' IS NULL THEN
         'job crash detected, see server logs'
       WHEN h.data->'error_data'->>'message' IS NOT NULL THEN
         CASE WHEN h.data->'error_data'->>'detail' IS NOT NULL THEN
@@ -329,7 +329,7 @@ SELECT
     h.data->'job'->'config' AS config,
     h.data->'error_data'->>'sqlerrcode' AS sqlerrcode,
     CASE
-      WHEN h.succeeded IS NULL AND h.execution_finish IS NULL AND h.pid IS NULL THEN
+      WHEN h.succeeded IS NOT TRUE AND h.pid IS NULL AND h.data->'error_data' IS NULL THEN
         'job crash detected, see server logs'
       WHEN h.succeeded IS FALSE AND h.data->'error_data'->>'message' IS NOT NULL THEN
         CASE WHEN h.data->'error_data'->>'detail' IS NOT NULL THEN
@@ -408,5 +408,8 @@ AS SELECT * FROM timescaledb_information.hypertable_compression_settings;
 CREATE OR REPLACE VIEW timescaledb_information.chunk_columnstore_settings AS
 SELECT * FROM timescaledb_information.chunk_compression_settings;
 
+CREATE OR REPLACE VIEW timescaledb_information.session_decompression_stats AS
+SELECT * FROM _timescaledb_functions.session_decompression_stats();
+
 GRANT SELECT ON ALL TABLES IN SCHEMA timescaledb_information TO PUBLIC;
 
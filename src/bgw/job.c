@@ -88,6 +88,9 @@ ts_bgw_job_start(BgwJob *job, Oid user_oid)
 		.job_id = Int32GetDatum(job->fd.id),
 		.job_history_id = job->job_history.id,
 		.job_history_execution_start = job->job_history.execution_start,
+		.job_history_deferrals = job->job_history.deferrals,
+		.job_history_last_deferral = job->job_history.last_deferral,
+		.job_history_deferred_since = job->job_history.deferred_since,
 		.user_oid = user_oid,
 	};
 
@@ -1011,6 +1014,28 @@ ts_is_telemetry_job(BgwJob *job)
 }
 #endif
 
+/*
+ * Get the admission control class of a job.
+ */
+BgwJobClass
+ts_bgw_job_get_class(BgwJob *job)
+{
+	if (namestrcmp(&job->fd.proc_schema, FUNCTIONS_SCHEMA_NAME) != 0)
+		return JOB_CLASS_OTHER;
+
+	if (namestrcmp(&job->fd.proc_name, "policy_compression") == 0 ||
+		namestrcmp(&job->fd.proc_name, "policy_recompression") == 0)
+		return JOB_CLASS_COMPRESSION;
+
+	if (namestrcmp(&job->fd.proc_name, "policy_refresh_continuous_aggregate") == 0)
+		return JOB_CLASS_REFRESH;
+
+	if (namestrcmp(&job->fd.proc_name, "policy_retention") == 0)
+		return JOB_CLASS_RETENTION;
+
+	return JOB_CLASS_OTHER;
+}
+
 JobResult
 ts_bgw_job_execute(BgwJob *job)
 {
@@ -1133,23 +1158,13 @@ ts_bgw_job_function_call_string(BgwJob *job)
 	return stmt->data;
 }
 
-extern Datum
-ts_bgw_job_entrypoint(PG_FUNCTION_ARGS)
+/*
+ * Set up a background worker for running jobs and connect it to the database
+ * as the given user.
+ */
+void
+ts_bgw_job_worker_init(Oid db_oid, Oid user_oid)
 {
-	Oid db_oid = DatumGetObjectId(MyBgworkerEntry->bgw_main_arg);
-	BgwParams params;
-	BgwJob *job;
-	JobResult res = JOB_FAILURE_IN_EXECUTION;
-	bool got_lock;
-	instr_time start;
-	instr_time duration;
-
-	memcpy(&params, MyBgworkerEntry->bgw_extra, sizeof(BgwParams));
-	Ensure(OidIsValid(params.user_oid) && params.job_id != 0,
-		   "job id or user oid was zero - job_id: %d, user_oid: %d",
-		   params.job_id,
-		   params.user_oid);
-
 	BackgroundWorkerBlockSignals();
 	/* Setup any signal handlers here */
 
@@ -1170,21 +1185,52 @@ ts_bgw_job_entrypoint(PG_FUNCTION_ARGS)
 		callbacks->toggle_allocation_blocking && !callbacks->enabled)
 		callbacks->toggle_allocation_blocking(/*enable=*/true);
 
-	BackgroundWorkerInitializeConnectionByOid(db_oid, params.user_oid, 0);
+	BackgroundWorkerInitializeConnectionByOid(db_oid, user_oid, 0);
 
 	log_min_messages = ts_guc_bgw_log_level;
 
-	elog(DEBUG2, "job %d started execution", params.job_id);
-
 	ts_license_enable_module_loading();
+}
+
+/*
+ * Set the job history information passed on by the scheduler. The history is
+ * recorded when the job ends.
+ */
+static void
+bgw_job_set_history_from_params(BgwJob *job, const BgwParams *params)
+{
+	job->job_history.id = params->job_history_id;
+	job->job_history.execution_start = params->job_history_execution_start;
+	job->job_history.pid = MyProcPid;
+	job->job_history.deferrals = params->job_history_deferrals;
+	job->job_history.last_deferral = params->job_history_last_deferral;
+	job->job_history.deferred_since = params->job_history_deferred_since;
+}
+
+/*
+ * Run the job given by the worker parameters and record the result.
+ *
+ * Errors are recorded in the job stats and then re-thrown, so the caller
+ * decides whether an error terminates the worker.
+ */
+JobResult
+ts_bgw_job_run(const BgwParams *params)
+{
+	BgwJob *job;
+	JobResult res = JOB_FAILURE_IN_EXECUTION;
+	bool got_lock;
+	instr_time start;
+	instr_time duration;
+
+	elog(DEBUG2, "job %d started execution", params->job_id);
 
 	INSTR_TIME_SET_CURRENT(start);
 
 	StartTransactionCommand();
 
 	/* Grab a session lock on the job row to prevent concurrent deletes. Lock is released
-	 * when the job process exits */
-	job = ts_bgw_job_find_with_lock(params.job_id,
+	 * when the job process exits or when a pooled worker resets its state */
+	job = ts_bgw_job_find_with_lock(params->job_id,
 									TopMemoryContext,
 									RowShareLock,
 									SESSION_LOCK,
@@ -1192,16 +1238,14 @@ ts_bgw_job_entrypoint(PG_FUNCTION_ARGS)
 									&got_lock);
 	if (job == NULL)
 		/* If the job is not found, we can't proceed */
-		elog(ERROR, "job %d not found when running the background worker", params.job_id);
+		elog(ERROR, "job %d not found when running the background worker", params->job_id);
 
 	/* get parameters from bgworker */
-	job->job_history.id = params.job_history_id;
-	job->job_history.execution_start = params.job_history_execution_start;
-	ts_bgw_job_stat_history_update(JOB_STAT_HISTORY_UPDATE_PID, job, JOB_SUCCESS, NULL);
+	bgw_job_set_history_from_params(job, params);
 
 	CommitTransactionCommand();
 
-	elog(DEBUG2, "job %d (%s) found", params.job_id, NameStr(job->fd.application_name));
+	elog(DEBUG2, "job %d (%s) found", params->job_id, NameStr(job->fd.application_name));
 
 	pgstat_report_appname(NameStr(job->fd.application_name));
 	MemoryContext oldcontext = CurrentMemoryContext;
@@ -1258,7 +1302,7 @@ ts_bgw_job_entrypoint(PG_FUNCTION_ARGS)
 		 * removed the session lock. Don't block and only record if the lock was actually
 		 * obtained.
 		 */
-		job = ts_bgw_job_find_with_lock(params.job_id,
+		job = ts_bgw_job_find_with_lock(params->job_id,
 										TopMemoryContext,
 										RowShareLock,
 										TXN_LOCK,
@@ -1269,8 +1313,7 @@ ts_bgw_job_entrypoint(PG_FUNCTION_ARGS)
 			namestrcpy(&proc_name, NameStr(job->fd.proc_name));
 			namestrcpy(&proc_schema, NameStr(job->fd.proc_schema));
 
-			job->job_history.id = params.job_history_id;
-			job->job_history.execution_start = params.job_history_execution_start;
+			bgw_job_set_history_from_params(job, params);
 
 			ts_bgw_job_stat_mark_end(job,
 									 JOB_FAILURE_IN_EXECUTION,
@@ -1283,7 +1326,7 @@ ts_bgw_job_entrypoint(PG_FUNCTION_ARGS)
 		 * the rethrow will log the error; but also log which job threw the
 		 * error
 		 */
-		elog(LOG, "job %d threw an error", params.job_id);
+		elog(LOG, "job %d threw an error", params->job_id);
 
 		CommitTransactionCommand();
 		FlushErrorState();
@@ -1314,7 +1357,7 @@ ts_bgw_job_entrypoint(PG_FUNCTION_ARGS)
 
 	elog(DEBUG1,
 		 "job %d (%s) exiting with %s: execution time %.2f ms",
-		 params.job_id,
+		 params->job_id,
 		 NameStr(job->fd.application_name),
 		 (res == JOB_SUCCESS ? "success" : "failure"),
 		 INSTR_TIME_GET_MILLISEC(duration));
@@ -1325,6 +1368,24 @@ ts_bgw_job_entrypoint(PG_FUNCTION_ARGS)
 		job = NULL;
 	}
 
+	return res;
+}
+
+extern Datum
+ts_bgw_job_entrypoint(PG_FUNCTION_ARGS)
+{
+	Oid db_oid = DatumGetObjectId(MyBgworkerEntry->bgw_main_arg);
+	BgwParams params;
+
+	memcpy(&params, MyBgworkerEntry->bgw_extra, sizeof(BgwParams));
+	Ensure(OidIsValid(params.user_oid) && params.job_id != 0,
+		   "job id or user oid was zero - job_id: %d, user_oid: %d",
+		   params.job_id,
+		   params.user_oid);
+
+	ts_bgw_job_worker_init(db_oid, params.user_oid);
+	ts_bgw_job_run(&params);
+
 	PG_RETURN_VOID();
 }
 
@@ -1361,7 +1422,10 @@ ts_bgw_job_run_and_set_next_start(BgwJob *job, job_main_func func, int64 initial
 		StartTransactionCommand();
 
 	if (mark)
+	{
 		ts_bgw_job_stat_mark_start(job);
+		job->job_history.pid = MyProcPid;
+	}
 
 	result = func();
 
@@ -11,6 +11,7 @@
 
 #include "export.h"
 #include "ts_catalog/catalog.h"
+#include "worker.h"
 
 #define TELEMETRY_INITIAL_NUM_RUNS 12
 #define SCHEDULER_APPNAME "TimescaleDB Background Worker Scheduler"
@@ -40,10 +41,40 @@ typedef struct MGCallbacks
 	mg_enabled enabled;
 } MGCallbacks;
 
+/*
+ * Reasons for the scheduler to hold back a job that is due to start.
+ */
+typedef enum BgwJobAdmission
+{
+	JOB_ADMITTED = 0,
+	JOB_DEFERRED_CLASS_LIMIT,
+	JOB_DEFERRED_HYPERTABLE_LIMIT,
+	JOB_DEFERRED_SYSTEM_LOAD,
+} BgwJobAdmission;
+
+/*
+ * Job classes used for admission control. Policies that do heavy I/O have a
+ * class of their own so that their concurrency can be limited separately.
+ */
+typedef enum BgwJobClass
+{
+	JOB_CLASS_OTHER = 0,
+	JOB_CLASS_COMPRESSION,
+	JOB_CLASS_REFRESH,
+	JOB_CLASS_RETENTION,
+} BgwJobClass;
+
 typedef struct BgwJobHistory
 {
 	int64 id;
 	TimestampTz execution_start;
+	/* Process running the execution, zero if not known to this process */
+	int32 pid;
+
+	/* Admission control decisions that delayed the start of the execution */
+	int32 deferrals;
+	BgwJobAdmission last_deferral;
+	TimestampTz deferred_since;
 } BgwJobHistory;
 
 typedef struct BgwJob
@@ -96,6 +127,9 @@ extern JobResult ts_bgw_job_execute(BgwJob *job);
 extern TSDLLEXPORT void ts_bgw_job_run_config_check(Oid check, int32 job_id, Jsonb *config);
 
 extern TSDLLEXPORT Datum ts_bgw_job_entrypoint(PG_FUNCTION_ARGS);
+extern BgwJobClass ts_bgw_job_get_class(BgwJob *job);
+extern void ts_bgw_job_worker_init(Oid db_oid, Oid user_oid);
+extern JobResult ts_bgw_job_run(const BgwParams *params);
 extern void ts_bgw_job_set_scheduler_test_hook(scheduler_test_hook_type hook);
 extern void ts_bgw_job_set_job_entrypoint_function_name(char *func_name);
 extern TSDLLEXPORT bool ts_bgw_job_run_and_set_next_start(BgwJob *job, job_main_func func,
@@ -0,0 +1,269 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+
+/*
+ * Pooled job workers.
+ *
+ * A pooled job worker is a long-lived background worker that runs jobs
+ * handed to it by the scheduler one after another. This avoids starting a
+ * new background worker, loading the extension and warming up the caches
+ * for every job execution, which dominates the runtime of short jobs.
+ *
+ * The scheduler side of the pool lives in scheduler.c.
+ */
+#include <postgres.h>
+
+#include <access/xact.h>
+#include <commands/discard.h>
+#include <miscadmin.h>
+#include <nodes/parsenodes.h>
+#include <pgstat.h>
+#include <postmaster/bgworker.h>
+#include <storage/dsm.h>
+#include <storage/latch.h>
+#include <utils/memutils.h>
+
+#include "debug_assert.h"
+#include "guc.h"
+#include "job.h"
+#include "job_pool.h"
+#include "worker.h"
+
+TS_FUNCTION_INFO_V1(ts_bgw_job_pool_worker_main);
+
+static char *pool_worker_entrypoint_function_name = BGW_JOB_POOL_WORKER_MAIN;
+
+const char *
+ts_bgw_job_pool_get_entrypoint_function_name(void)
+{
+	return pool_worker_entrypoint_function_name;
+}
+
+void
+ts_bgw_job_pool_set_entrypoint_function_name(char *func_name)
+{
+	pool_worker_entrypoint_function_name = func_name;
+}
+
+void
+ts_bgw_pool_slot_init(BgwPoolSlot *slot)
+{
+	memset(slot, 0, sizeof(*slot));
+	SpinLockInit(&slot->mutex);
+	slot->state = BGW_POOL_SLOT_IDLE;
+	slot->scheduler = MyProc;
+}
+
+/*
+ * Assign a job to an idle pooled worker and wake it up.
+ *
+ * The worker might not have started yet, in which case it will pick up the
+ * job when it does.
+ */
+void
+ts_bgw_pool_slot_assign(BgwPoolSlot *slot, const BgwJob *job)
+{
+	PGPROC *worker;
+
+	SpinLockAcquire(&slot->mutex);
+	Assert(slot->state == BGW_POOL_SLOT_IDLE);
+	slot->job_id = job->fd.id;
+	slot->job_history_id = job->job_history.id;
+	slot->job_history_execution_start = job->job_history.execution_start;
+	slot->job_history_deferrals = job->job_history.deferrals;
+	slot->job_history_last_deferral = job->job_history.last_deferral;
+	slot->job_history_deferred_since = job->job_history.deferred_since;
+	slot->state = BGW_POOL_SLOT_ASSIGNED;
+	worker = slot->worker;
+	SpinLockRelease(&slot->mutex);
+
+	if (worker != NULL)
+		SetLatch(&worker->procLatch);
+}
+
+bool
+ts_bgw_pool_slot_job_done(BgwPoolSlot *slot)
+{
+	bool done;
+
+	SpinLockAcquire(&slot->mutex);
+	done = slot->state == BGW_POOL_SLOT_DONE;
+	SpinLockRelease(&slot->mutex);
+
+	return done;
+}
+
+/*
+ * Make the worker available for a new job after the scheduler has noticed
+ * that the previous job is done.
+ */
+void
+ts_bgw_pool_slot_release(BgwPoolSlot *slot)
+{
+	SpinLockAcquire(&slot->mutex);
+	Assert(slot->state == BGW_POOL_SLOT_DONE);
+	slot->state = BGW_POOL_SLOT_IDLE;
+	SpinLockRelease(&slot->mutex);
+}
+
+/*
+ * Ask the worker to exit. A worker that is running a job exits once the job
+ * is done.
+ */
+void
+ts_bgw_pool_slot_request_shutdown(BgwPoolSlot *slot)
+{
+	PGPROC *worker;
+
+	SpinLockAcquire(&slot->mutex);
+	slot->shutdown_requested = true;
+	worker = slot->worker;
+	SpinLockRelease(&slot->mutex);
+
+	if (worker != NULL)
+		SetLatch(&worker->procLatch);
+}
+
+/*
+ * Reset the session after running a job so that the next job starts from a
+ * clean state.
+ *
+ * This does the same as DISCARD ALL does for pooled client connections:
+ * settings and roles are reset, temporary tables are dropped, and all
+ * session-level advisory locks are released, including the job lock taken
+ * when the job started.
+ */
+static void
+pool_worker_reset_state(void)
+{
+	DiscardStmt stmt = {
+		.type = T_DiscardStmt,
+		.target = DISCARD_ALL,
+	};
+
+	StartTransactionCommand();
+	DiscardCommand(&stmt, true);
+	CommitTransactionCommand();
+
+	log_min_messages = ts_guc_bgw_log_level;
+}
+
+extern Datum
+ts_bgw_job_pool_worker_main(PG_FUNCTION_ARGS)
+{
+	Oid db_oid = DatumGetObjectId(MyBgworkerEntry->bgw_main_arg);
+	BgwParams params;
+	dsm_segment *seg;
+	BgwPoolSlot *slot;
+	MemoryContext job_mctx;
+
+	memcpy(&params, MyBgworkerEntry->bgw_extra, sizeof(BgwParams));
+	Ensure(OidIsValid(params.user_oid) && params.pool_handle != DSM_HANDLE_INVALID,
+		   "pool handle or user oid was zero - pool_handle: %u, user_oid: %d",
+		   params.pool_handle,
+		   params.user_oid);
+
+	ts_bgw_job_worker_init(db_oid, params.user_oid);
+
+	seg = dsm_attach(params.pool_handle);
+	if (seg == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("could not map dynamic shared memory segment for job pool worker")));
+	dsm_pin_mapping(seg);
+	slot = dsm_segment_address(seg);
+
+	SpinLockAcquire(&slot->mutex);
+	slot->worker = MyProc;
+	SpinLockRelease(&slot->mutex);
+
+	pgstat_report_appname(BGW_JOB_POOL_WORKER_NAME);
+
+	job_mctx = AllocSetContextCreate(TopMemoryContext, "JobPoolWorker", ALLOCSET_DEFAULT_SIZES);
+
+	for (;;)
+	{
+		BgwParams job_params = params;
+		PGPROC *scheduler;
+		bool have_job = false;
+		bool shutdown = false;
+
+		CHECK_FOR_INTERRUPTS();
+
+		SpinLockAcquire(&slot->mutex);
+		if (slot->state == BGW_POOL_SLOT_ASSIGNED)
+		{
+			slot->state = BGW_POOL_SLOT_RUNNING;
+			job_params.job_id = slot->job_id;
+			job_params.job_history_id = slot->job_history_id;
+			job_params.job_history_execution_start = slot->job_history_execution_start;
+			job_params.job_history_deferrals = slot->job_history_deferrals;
+			job_params.job_history_last_deferral = slot->job_history_last_deferral;
+			job_params.job_history_deferred_since = slot->job_history_deferred_since;
+			have_job = true;
+		}
+		else
+			shutdown = slot->shutdown_requested;
+		scheduler = slot->scheduler;
+		SpinLockRelease(&slot->mutex);
+
+		if (shutdown)
+			break;
+
+		if (!have_job)
+		{
+			(void) WaitLatch(MyLatch, WL_LATCH_SET | WL_EXIT_ON_PM_DEATH, -1, PG_WAIT_EXTENSION);
+			ResetLatch(MyLatch);
+			continue;
+		}
+
+		MemoryContextSwitchTo(job_mctx);
+
+		PG_TRY();
+		{
+			ts_bgw_job_run(&job_params);
+		}
+		PG_CATCH();
+		{
+			/*
+			 * The job has already recorded the failure in the job stats, so
+			 * we only need to report the error and clean up after it. Unlike
+			 * a regular job worker, we keep running.
+			 */
+			HOLD_INTERRUPTS();
+			MemoryContextSwitchTo(job_mctx);
+			EmitErrorReport();
+			AbortOutOfAnyTransaction();
+			FlushErrorState();
+			RESUME_INTERRUPTS();
+		}
+		PG_END_TRY();
+
+		pool_worker_reset_state();
+
+		MemoryContextSwitchTo(TopMemoryContext);
+		MemoryContextReset(job_mctx);
+
+		SpinLockAcquire(&slot->mutex);
+		slot->state = BGW_POOL_SLOT_DONE;
+		SpinLockRelease(&slot->mutex);
+
+		SetLatch(&scheduler->procLatch);
+
+		/*
+		 * Only report the worker as idle once the slot is released, so that
+		 * an idle pool worker in pg_stat_activity can take a new job.
+		 */
+		pgstat_report_appname(BGW_JOB_POOL_WORKER_NAME);
+		pgstat_report_activity(STATE_IDLE, NULL);
+	}
+
+	elog(DEBUG1, "job pool worker exiting");
+
+	dsm_detach(seg);
+
+	PG_RETURN_VOID();
+}
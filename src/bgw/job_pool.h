@@ -0,0 +1,63 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+#include <fmgr.h>
+#include <storage/proc.h>
+#include <storage/spin.h>
+
+#include "export.h"
+#include "job.h"
+
+#define BGW_JOB_POOL_WORKER_NAME "TimescaleDB Background Job Pool Worker"
+#define BGW_JOB_POOL_WORKER_MAIN "ts_bgw_job_pool_worker_main"
+
+/* See the README for the state transitions of a pool slot */
+typedef enum BgwPoolSlotState
+{
+	/* The worker is waiting for a job */
+	BGW_POOL_SLOT_IDLE,
+	/* The scheduler has assigned a job that the worker has not picked up yet */
+	BGW_POOL_SLOT_ASSIGNED,
+	/* The worker is running the job */
+	BGW_POOL_SLOT_RUNNING,
+	/* The job has finished but the scheduler has not noticed it yet */
+	BGW_POOL_SLOT_DONE,
+} BgwPoolSlotState;
+
+/*
+ * State shared between the scheduler and a pooled job worker.
+ *
+ * Each pooled worker has a dynamic shared memory segment of its own holding
+ * the slot. The scheduler assigns jobs to the worker through the slot and the
+ * worker reports back when the job is done.
+ */
+typedef struct BgwPoolSlot
+{
+	slock_t mutex;
+	BgwPoolSlotState state;
+	bool shutdown_requested;
+	PGPROC *scheduler;
+	PGPROC *worker;
+	int32 job_id;
+	int64 job_history_id;
+	TimestampTz job_history_execution_start;
+	int32 job_history_deferrals;
+	int32 job_history_last_deferral;
+	TimestampTz job_history_deferred_since;
+} BgwPoolSlot;
+
+extern void ts_bgw_pool_slot_init(BgwPoolSlot *slot);
+extern void ts_bgw_pool_slot_assign(BgwPoolSlot *slot, const BgwJob *job);
+extern bool ts_bgw_pool_slot_job_done(BgwPoolSlot *slot);
+extern void ts_bgw_pool_slot_release(BgwPoolSlot *slot);
+extern void ts_bgw_pool_slot_request_shutdown(BgwPoolSlot *slot);
+
+extern const char *ts_bgw_job_pool_get_entrypoint_function_name(void);
+extern void ts_bgw_job_pool_set_entrypoint_function_name(char *func_name);
+
+extern TSDLLEXPORT Datum ts_bgw_job_pool_worker_main(PG_FUNCTION_ARGS);
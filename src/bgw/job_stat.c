@@ -6,6 +6,7 @@
 #include <postgres.h>
 
 #include <access/xact.h>
+#include <common/pg_prng.h>
 #include <math.h>
 #include <stdlib.h>
 #include <utils/builtins.h>
@@ -312,6 +313,17 @@ calculate_next_start_on_success(TimestampTz finish_time, BgwJob *job)
 	else
 		ts = calculate_next_start_on_success_drifting(last_finish, job);
 
+	/*
+	 * Spread out jobs that share a schedule. Retries and restarts requested
+	 * by the job itself are not delayed.
+	 */
+	if (ts_guc_bgw_job_start_jitter > 0 && !TIMESTAMP_NOT_FINITE(ts))
+	{
+		uint64 jitter = pg_prng_uint64_range(&pg_global_prng_state, 0, ts_guc_bgw_job_start_jitter);
+
+		ts = TimestampTzPlusMilliseconds(ts, jitter);
+	}
+
 	return ts;
 }
 
@@ -537,6 +549,7 @@ bgw_job_stat_tuple_mark_end(TupleInfo *ti, void *const data)
 static ScanTupleResult
 bgw_job_stat_tuple_mark_crash_reported(TupleInfo *ti, void *const data)
 {
+	BgwJob *job = data;
 	bool should_free;
 	HeapTuple tuple = ts_scanner_fetch_heap_tuple(ti, false, &should_free);
 	HeapTuple new_tuple = heap_copytuple(tuple);
@@ -545,6 +558,10 @@ bgw_job_stat_tuple_mark_crash_reported(TupleInfo *ti, void *const data)
 	if (should_free)
 		heap_freetuple(tuple);
 
+	/* The crashed execution is unknown if the scheduler restarted since */
+	if (job->job_history.id == INVALID_BGW_JOB_STAT_HISTORY_ID)
+		job->job_history.execution_start = fd->last_start;
+
 	fd->flags = ts_set_flags_32(fd->flags, LAST_CRASH_REPORTED);
 
 	ts_catalog_update(ti->scanrel, new_tuple);
@@ -649,6 +666,7 @@ ts_bgw_job_stat_mark_start(BgwJob *job)
 	/* We need to capture the execution start because failures are always logged */
 	job->job_history.execution_start = ts_timer_get_current_timestamp();
 	job->job_history.id = INVALID_BGW_JOB_STAT_HISTORY_ID;
+	job->job_history.pid = 0;
 
 	ts_bgw_job_stat_history_update(JOB_STAT_HISTORY_UPDATE_START, job, JOB_SUCCESS, NULL);
 
@@ -685,7 +703,7 @@ ts_bgw_job_stat_mark_crash_reported(BgwJob *job, JobResult result)
 	if (!bgw_job_stat_scan_job_id(job->fd.id,
 								  bgw_job_stat_tuple_mark_crash_reported,
 								  NULL,
-								  NULL,
+								  job,
 								  RowExclusiveLock))
 	{
 		ereport(ERROR,
@@ -6,6 +6,7 @@
 #include <postgres.h>
 
 #include <access/xact.h>
+#include <utils/fmgrprotos.h>
 #include <utils/jsonb.h>
 
 #include "compat/compat.h"
@@ -16,10 +17,15 @@
 #include "timer.h"
 #include "utils.h"
 
+/*
+ * The job history is append-only: a single row is inserted when an execution
+ * ends, as part of the transaction that marks the end in the job stats. Only
+ * the id is reserved when the execution starts so that the history is still
+ * ordered by the start of the executions.
+ */
 typedef struct BgwJobStatHistoryContext
 {
 	JobResult result;
-	BgwJobStatHistoryUpdateType update_type;
 	BgwJob *job;
 	Jsonb *edata;
 } BgwJobStatHistoryContext;
@@ -67,6 +73,47 @@ build_job_info(BgwJob *job)
 	return JsonbValueToJsonb(pushJsonbValue(&parse_state, WJB_END_OBJECT, NULL));
 }
 
+static const char *
+job_admission_name(BgwJobAdmission admission)
+{
+	switch (admission)
+	{
+		case JOB_DEFERRED_CLASS_LIMIT:
+			return "class_limit";
+		case JOB_DEFERRED_HYPERTABLE_LIMIT:
+			return "hypertable_limit";
+		case JOB_DEFERRED_SYSTEM_LOAD:
+			return "system_load";
+		case JOB_ADMITTED:
+			break;
+	}
+
+	return "admitted";
+}
+
+/*
+ * Build the admission control information for a job execution that the
+ * scheduler held back before starting it.
+ */
+static Jsonb *
+build_admission_info(BgwJob *job)
+{
+	JsonbParseState *parse_state = NULL;
+	Interval *delay = DatumGetIntervalP(
+		DirectFunctionCall2(timestamp_mi,
+							TimestampTzGetDatum(job->job_history.execution_start),
+							TimestampTzGetDatum(job->job_history.deferred_since)));
+
+	pushJsonbValue(&parse_state, WJB_BEGIN_OBJECT, NULL);
+	ts_jsonb_add_int32(parse_state, "deferrals", job->job_history.deferrals);
+	ts_jsonb_add_interval(parse_state, "delay", delay);
+	ts_jsonb_add_str(parse_state,
+					 "last_reason",
+					 job_admission_name(job->job_history.last_deferral));
+
+	return JsonbValueToJsonb(pushJsonbValue(&parse_state, WJB_END_OBJECT, NULL));
+}
+
 static Jsonb *
 ts_bgw_job_stat_history_build_data_info(BgwJobStatHistoryContext *context)
 {
@@ -87,56 +134,58 @@ ts_bgw_job_stat_history_build_data_info(BgwJobStatHistoryContext *context)
 		ts_jsonb_add_value(parse_state, "error_data", &value);
 	}
 
+	if (context->job->job_history.deferrals > 0)
+	{
+		JsonbToJsonbValue(build_admission_info(context->job), &value);
+		ts_jsonb_add_value(parse_state, "admission", &value);
+	}
+
 	return JsonbValueToJsonb(pushJsonbValue(&parse_state, WJB_END_OBJECT, NULL));
 }
 
 static void
-bgw_job_stat_history_insert(BgwJobStatHistoryContext *context, bool track_only_errors)
+bgw_job_stat_history_insert(BgwJobStatHistoryContext *context)
 {
 	Assert(context != NULL);
 
+	/* Concurrent inserts do not conflict, so don't serialize job executions here */
 	Relation rel = table_open(catalog_get_table_id(ts_catalog_get(), BGW_JOB_STAT_HISTORY),
-							  ShareRowExclusiveLock);
+							  RowExclusiveLock);
 	TupleDesc desc = RelationGetDescr(rel);
 	NullableDatum values[Natts_bgw_job_stat_history] = { { 0 } };
 	CatalogSecurityContext sec_ctx;
 
 	ts_datum_set_int32(Anum_bgw_job_stat_history_job_id, values, context->job->fd.id, false);
+	/*
+	 * The scheduler records failures and crashes of executions that ran in
+	 * another process, so only record the PID when it is known.
+	 */
+	ts_datum_set_int32(Anum_bgw_job_stat_history_pid,
+					   values,
+					   context->job->job_history.pid,
+					   context->job->job_history.pid == 0);
 	ts_datum_set_timestamptz(Anum_bgw_job_stat_history_execution_start,
 							 values,
 							 context->job->job_history.execution_start,
 							 false);
-	if (track_only_errors)
-	{
-		/* In case of logging only ERRORs */
-		ts_datum_set_int32(Anum_bgw_job_stat_history_pid, values, MyProcPid, false);
-		ts_datum_set_timestamptz(Anum_bgw_job_stat_history_execution_finish,
-								 values,
-								 ts_timer_get_current_timestamp(),
-								 false);
-		ts_datum_set_bool(Anum_bgw_job_stat_history_succeeded, values, false, false);
-	}
-	else
-	{
-		/* When tracking history first we INSERT the job without the FINISH execution timestamp,
-		 * PID and SUCCEED flag because it will be marked once the job finishes */
-		ts_datum_set_int32(Anum_bgw_job_stat_history_pid, values, 0, true);
-		ts_datum_set_timestamptz(Anum_bgw_job_stat_history_execution_finish, values, 0, true);
-		ts_datum_set_bool(Anum_bgw_job_stat_history_succeeded, values, false, true);
-	}
-
+	ts_datum_set_timestamptz(Anum_bgw_job_stat_history_execution_finish,
+							 values,
+							 ts_timer_get_current_timestamp(),
+							 false);
+	ts_datum_set_bool(Anum_bgw_job_stat_history_succeeded,
+					  values,
+					  context->result == JOB_SUCCESS,
+					  false);
 	ts_datum_set_jsonb(Anum_bgw_job_stat_history_data,
 					   values,
 					   ts_bgw_job_stat_history_build_data_info(context));
 
 	ts_catalog_database_info_become_owner(ts_catalog_database_info_get(), &sec_ctx);
 
+	/* Failures are logged even if the id was not reserved at the start */
 	if (context->job->job_history.id == INVALID_BGW_JOB_STAT_HISTORY_ID)
-	{
-		/* We need to get a new job id to mark the end later */
 		context->job->job_history.id =
 			ts_catalog_table_next_seq_id(ts_catalog_get(), BGW_JOB_STAT_HISTORY);
-	}
 	ts_datum_set_int64(Anum_bgw_job_stat_history_id, values, context->job->job_history.id, false);
 
 	ts_catalog_insert_datums(rel, desc, values);
@@ -148,122 +197,20 @@ bgw_job_stat_history_insert(BgwJobStatHistoryContext *context, bool track_only_e
 static void
 bgw_job_stat_history_mark_start(BgwJobStatHistoryContext *context)
 {
+	CatalogSecurityContext sec_ctx;
+
 	/* Don't mark the start in case of the GUC be disabled */
 	if (!ts_guc_enable_job_execution_logging)
 		return;
 
-	bgw_job_stat_history_insert(context, false);
-}
-
-static bool
-bgw_job_stat_history_scan_one(int indexid, ScanKeyData scankey[], int nkeys,
-							  tuple_found_func tuple_found, tuple_filter_func tuple_filter,
-							  void *data, LOCKMODE lockmode)
-{
-	Catalog *catalog = ts_catalog_get();
-	ScannerCtx scanctx = {
-		.table = catalog_get_table_id(catalog, BGW_JOB_STAT_HISTORY),
-		.index = catalog_get_index(catalog, BGW_JOB_STAT_HISTORY, indexid),
-		.nkeys = nkeys,
-		.scankey = scankey,
-		.flags = SCANNER_F_KEEPLOCK,
-		.tuple_found = tuple_found,
-		.filter = tuple_filter,
-		.data = data,
-		.lockmode = lockmode,
-		.scandirection = ForwardScanDirection,
-	};
-
-	return ts_scanner_scan_one(&scanctx, false, "bgw job stat");
-}
-
-static inline bool
-bgw_job_stat_history_scan_id(int64 bgw_job_history_id, tuple_found_func tuple_found,
-							 tuple_filter_func tuple_filter, void *data, LOCKMODE lockmode)
-{
-	if (bgw_job_history_id == INVALID_BGW_JOB_STAT_HISTORY_ID)
-		return true;
-
-	ScanKeyData scankey[1];
-
-	ScanKeyInit(&scankey[0],
-				Anum_bgw_job_stat_history_pkey_idx_id,
-				BTEqualStrategyNumber,
-				F_INT8EQ,
-				Int64GetDatum(bgw_job_history_id));
-
-	return bgw_job_stat_history_scan_one(BGW_JOB_STAT_HISTORY_PKEY_IDX,
-										 scankey,
-										 1,
-										 tuple_found,
-										 tuple_filter,
-										 data,
-										 lockmode);
-}
-
-static ScanTupleResult
-bgw_job_stat_history_tuple_update(TupleInfo *ti, void *const data)
-{
-	bool should_free;
-	HeapTuple tuple = ts_scanner_fetch_heap_tuple(ti, false, &should_free);
-	BgwJobStatHistoryContext *context = (BgwJobStatHistoryContext *) data;
-	Jsonb *job_history_data = NULL;
-
-	Datum values[Natts_bgw_job_stat_history] = { 0 };
-	bool nulls[Natts_bgw_job_stat_history] = { 0 };
-	bool doReplace[Natts_bgw_job_stat_history] = { 0 };
-
-	switch (context->update_type)
-	{
-		case JOB_STAT_HISTORY_UPDATE_PID:
-		{
-			values[AttrNumberGetAttrOffset(Anum_bgw_job_stat_history_pid)] =
-				Int32GetDatum(MyProcPid);
-			doReplace[AttrNumberGetAttrOffset(Anum_bgw_job_stat_history_pid)] = true;
-			break;
-		}
-
-		case JOB_STAT_HISTORY_UPDATE_END:
-		{
-			values[AttrNumberGetAttrOffset(Anum_bgw_job_stat_history_execution_finish)] =
-				TimestampTzGetDatum(ts_timer_get_current_timestamp());
-			doReplace[AttrNumberGetAttrOffset(Anum_bgw_job_stat_history_execution_finish)] = true;
-
-			values[AttrNumberGetAttrOffset(Anum_bgw_job_stat_history_succeeded)] =
-				BoolGetDatum((context->result == JOB_SUCCESS));
-			doReplace[AttrNumberGetAttrOffset(Anum_bgw_job_stat_history_succeeded)] = true;
-
-			job_history_data = ts_bgw_job_stat_history_build_data_info(context);
-
-			if (job_history_data != NULL)
-			{
-				values[AttrNumberGetAttrOffset(Anum_bgw_job_stat_history_data)] =
-					JsonbPGetDatum(job_history_data);
-				doReplace[AttrNumberGetAttrOffset(Anum_bgw_job_stat_history_data)] = true;
-			}
-			break;
-		}
-
-		case JOB_STAT_HISTORY_UPDATE_START:
-			pg_unreachable();
-			break;
-	}
-
-	HeapTuple new_tuple =
-		heap_modify_tuple(tuple, ts_scanner_get_tupledesc(ti), values, nulls, doReplace);
-
-	ts_catalog_update(ti->scanrel, new_tuple);
-
-	heap_freetuple(new_tuple);
-
-	if (should_free)
-		heap_freetuple(tuple);
-
-	return SCAN_DONE;
+	ts_catalog_database_info_become_owner(ts_catalog_database_info_get(), &sec_ctx);
+	context->job->job_history.id =
+		ts_catalog_table_next_seq_id(ts_catalog_get(), BGW_JOB_STAT_HISTORY);
+	ts_catalog_restore_user(&sec_ctx);
 }
 
 static void
-bgw_job_stat_history_update(BgwJobStatHistoryContext *context)
+bgw_job_stat_history_mark_end(BgwJobStatHistoryContext *context)
 {
 	/* Don't execute in case of the GUC is false and the job succeeded, because failures are always
 	 * logged
@@ -282,24 +229,7 @@ bgw_job_stat_history_update(BgwJobStatHistoryContext *context)
 	 * execution history */
 	context->job = new_job;
 
-	/* Failures are always logged so in case of the GUC is false and a failure happens then we need
-	 * to insert all the information in the job error history table */
-	if (!ts_guc_enable_job_execution_logging && context->result != JOB_SUCCESS)
-	{
-		bgw_job_stat_history_insert(context, true);
-	}
-	else
-	{
-		/* Mark the end of the previous inserted start execution */
-		if (!bgw_job_stat_history_scan_id(new_job->job_history.id,
-										  bgw_job_stat_history_tuple_update,
-										  NULL,
-										  context,
-										  RowExclusiveLock))
-			ereport(ERROR,
-					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-					 errmsg("unable to find job history " INT64_FORMAT, new_job->job_history.id)));
-	}
+	bgw_job_stat_history_insert(context);
 }
 
 void
@@ -308,7 +238,6 @@ ts_bgw_job_stat_history_update(BgwJobStatHistoryUpdateType update_type, BgwJob *
 {
 	BgwJobStatHistoryContext context = {
 		.result = result,
-		.update_type = update_type,
 		.job = job,
 		.edata = edata,
 	};
@@ -319,8 +248,7 @@ ts_bgw_job_stat_history_update(BgwJobStatHistoryUpdateType update_type, BgwJob *
 			bgw_job_stat_history_mark_start(&context);
 			break;
 		case JOB_STAT_HISTORY_UPDATE_END:
-		case JOB_STAT_HISTORY_UPDATE_PID:
-			bgw_job_stat_history_update(&context);
+			bgw_job_stat_history_mark_end(&context);
 			break;
 	}
 }
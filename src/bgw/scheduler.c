@@ -12,11 +12,14 @@
  */
 #include <postgres.h>
 
+#include <stdlib.h>
+#include <unistd.h>
 #include <access/xact.h>
 #include <miscadmin.h>
 #include <nodes/pg_list.h>
 #include <pgstat.h>
 #include <postmaster/bgworker.h>
+#include <storage/dsm.h>
 #include <storage/ipc.h>
 #include <storage/latch.h>
 #include <storage/lwlock.h>
@@ -33,7 +36,9 @@
 #include "compat/compat.h"
 #include "extension.h"
 #include "guc.h"
+#include "hypertable.h"
 #include "job.h"
+#include "job_pool.h"
 #include "job_stat.h"
 #include "launcher_interface.h"
 #include "scheduler.h"
@@ -91,6 +96,31 @@ typedef enum JobState
 	JOB_STATE_TERMINATING
 } JobState;
 
+/*
+ * A pooled job worker as seen from the scheduler. See job_pool.c for the
+ * worker side.
+ *
+ * Each pooled worker holds a reserved background worker slot for as long as
+ * it is alive.
+ */
+typedef struct BgwPoolWorker
+{
+	Oid user_oid;
+	BackgroundWorkerHandle *handle;
+	dsm_segment *seg;
+	BgwPoolSlot *slot;
+
+	/* A job has been assigned to the worker and not yet noticed as done */
+	bool busy;
+
+	/* The worker has been asked to exit or was terminated */
+	bool stopping;
+	TimestampTz idle_since;
+} BgwPoolWorker;
+
+/* has to be global to shutdown pooled workers on exit */
+static List *pool_workers = NIL;
+
 typedef struct ScheduledBgwJob
 {
 	BgwJob job;
@@ -99,6 +129,14 @@ typedef struct ScheduledBgwJob
 	JobState state;
 	BackgroundWorkerHandle *handle;
 
+	/* The pooled worker running the job, if any */
+	BgwPoolWorker *pool_worker;
+
+	/* Admission control decisions since the job was last started */
+	int32 admission_deferrals;
+	BgwJobAdmission admission_last_deferral;
+	TimestampTz admission_deferred_since;
+
 	bool reserved_worker;
 
 	/*
@@ -143,6 +181,260 @@ ts_bgw_start_worker(const char *name, const BgwParams *bgw_params)
 	return handle;
 }
 
+/*
+ * Launch a new pooled worker for jobs owned by the given user.
+ *
+ * Returns NULL if no background worker could be reserved or started.
+ */
+static BgwPoolWorker *
+pool_worker_launch(Oid user_oid)
+{
+	MemoryContext oldcontext = CurrentMemoryContext;
+	BgwParams bgw_params = {
+		.user_oid = user_oid,
+	};
+	BgwPoolWorker *pw;
+	dsm_segment *seg;
+
+	if (!ts_bgw_worker_reserve())
+		return NULL;
+
+	seg = dsm_create(sizeof(BgwPoolSlot), DSM_CREATE_NULL_IF_MAXSEGMENTS);
+	if (seg == NULL)
+	{
+		ts_bgw_worker_release();
+		return NULL;
+	}
+
+	/* The segment has to outlive the transaction we might be in */
+	dsm_pin_mapping(seg);
+	ts_bgw_pool_slot_init(dsm_segment_address(seg));
+
+	bgw_params.pool_handle = dsm_segment_handle(seg);
+	strlcpy(bgw_params.bgw_main,
+			ts_bgw_job_pool_get_entrypoint_function_name(),
+			sizeof(bgw_params.bgw_main));
+
+	MemoryContextSwitchTo(scheduler_mctx);
+	pw = palloc0(sizeof(BgwPoolWorker));
+	pw->user_oid = user_oid;
+	pw->seg = seg;
+	pw->slot = dsm_segment_address(seg);
+	pw->handle = ts_bgw_start_worker(BGW_JOB_POOL_WORKER_NAME, &bgw_params);
+
+	if (pw->handle == NULL)
+	{
+		MemoryContextSwitchTo(oldcontext);
+		dsm_detach(seg);
+		pfree(pw);
+		ts_bgw_worker_release();
+		return NULL;
+	}
+
+	MemoryContextSwitchTo(scheduler_mctx);
+	pool_workers = lappend(pool_workers, pw);
+	MemoryContextSwitchTo(oldcontext);
+
+	elog(DEBUG1, "launched job pool worker for user %u", user_oid);
+
+	return pw;
+}
+
+/* Free a pooled worker that has exited. The caller removes it from the list. */
+static void
+pool_worker_free(BgwPoolWorker *pw)
+{
+	dsm_detach(pw->seg);
+	pfree(pw->handle);
+	pfree(pw);
+	ts_bgw_worker_release();
+}
+
+static bool
+pool_worker_has_stopped(BgwPoolWorker *pw)
+{
+	pid_t pid;
+
+	return GetBackgroundWorkerPid(pw->handle, &pid) == BGWH_STOPPED;
+}
+
+/*
+ * Get a pooled worker to run a job owned by the given user.
+ *
+ * Prefer an idle worker for the same user and launch a new worker if the
+ * pool is not full. If the pool is full, ask an idle worker for another user
+ * to exit so that its slot can be used later on. Idle workers that have
+ * exited, e.g., because they were terminated, are reaped on the way.
+ *
+ * Returns NULL if the pool is disabled or no pooled worker is available, in
+ * which case the job should be run in a regular background worker.
+ */
+static BgwPoolWorker *
+pool_worker_acquire(Oid user_oid)
+{
+	BgwPoolWorker *idle_other = NULL;
+	BgwPoolWorker *pw = NULL;
+	int num_live = 0;
+	ListCell *lc;
+
+	if (ts_guc_bgw_job_pool_size <= 0)
+		return NULL;
+
+	foreach (lc, pool_workers)
+	{
+		BgwPoolWorker *candidate = lfirst(lc);
+
+		if (candidate->stopping)
+			continue;
+
+		if (!candidate->busy && pool_worker_has_stopped(candidate))
+		{
+			pool_workers = foreach_delete_current(pool_workers, lc);
+			pool_worker_free(candidate);
+			continue;
+		}
+
+		num_live++;
+
+		if (candidate->busy)
+			continue;
+
+		if (candidate->user_oid == user_oid)
+		{
+			pw = candidate;
+			break;
+		}
+
+		if (idle_other == NULL)
+			idle_other = candidate;
+	}
+
+	if (pw == NULL && num_live < ts_guc_bgw_job_pool_size)
+		pw = pool_worker_launch(user_oid);
+	else if (pw == NULL && idle_other != NULL)
+	{
+		ts_bgw_pool_slot_request_shutdown(idle_other->slot);
+		idle_other->stopping = true;
+	}
+
+	if (pw != NULL)
+		pw->busy = true;
+
+	return pw;
+}
+
+/*
+ * Get the status of the job running in a pooled worker in terms of the
+ * background worker status used for regular jobs: the job is stopped when the
+ * worker reports it as done or when the worker has exited.
+ */
+static BgwHandleStatus
+pool_worker_get_job_status(BgwPoolWorker *pw)
+{
+	pid_t pid;
+	BgwHandleStatus status = GetBackgroundWorkerPid(pw->handle, &pid);
+
+	switch (status)
+	{
+		case BGWH_NOT_YET_STARTED:
+			/* the job is picked up once the worker has started */
+			return BGWH_STARTED;
+		case BGWH_STARTED:
+			return ts_bgw_pool_slot_job_done(pw->slot) ? BGWH_STOPPED : BGWH_STARTED;
+		default:
+			return status;
+	}
+}
+
+/*
+ * Detach a pooled worker from the job it has been running. The worker goes
+ * back to the pool unless it is exiting.
+ *
+ * A worker that is exiting still holds its background worker slot. We don't
+ * wait for it here since that would block the scheduler, but leave it to
+ * pool_workers_maintain() to reap it once it has exited.
+ */
+static void
+pool_worker_release_job(BgwPoolWorker *pw)
+{
+	Assert(pw->busy);
+	pw->busy = false;
+
+	if (pw->stopping || pool_worker_has_stopped(pw))
+	{
+		pw->stopping = true;
+		return;
+	}
+
+	ts_bgw_pool_slot_release(pw->slot);
+	pw->idle_since = ts_timer_get_current_timestamp();
+}
+
+/*
+ * Reap pooled workers that have exited and ask idle workers to exit when
+ * they have been idle for too long or the pool has shrunk.
+ */
+static void
+pool_workers_maintain(void)
+{
+	TimestampTz now = ts_timer_get_current_timestamp();
+	int num_live = 0;
+	ListCell *lc;
+
+	foreach (lc, pool_workers)
+	{
+		BgwPoolWorker *pw = lfirst(lc);
+
+		if (pw->busy)
+		{
+			num_live++;
+			continue;
+		}
+
+		if (pool_worker_has_stopped(pw))
+		{
+			pool_workers = foreach_delete_current(pool_workers, lc);
+			pool_worker_free(pw);
+			continue;
+		}
+
+		if (pw->stopping)
+			continue;
+
+		if (num_live >= ts_guc_bgw_job_pool_size ||
+			TimestampDifferenceExceeds(pw->idle_since, now, ts_guc_bgw_job_pool_idle_timeout))
+		{
+			elog(DEBUG1, "stopping idle job pool worker for user %u", pw->user_oid);
+			ts_bgw_pool_slot_request_shutdown(pw->slot);
+			pw->stopping = true;
+			continue;
+		}
+
+		num_live++;
+	}
+}
+
+/* Returns the earliest time an idle pooled worker should be asked to exit */
+static TimestampTz
+earliest_pool_worker_idle_timeout(void)
+{
+	TimestampTz earliest = DT_NOEND;
+	ListCell *lc;
+
+	foreach (lc, pool_workers)
+	{
+		BgwPoolWorker *pw = lfirst(lc);
+
+		if (!pw->busy && !pw->stopping)
+			earliest =
+				least_timestamp(earliest,
+								TimestampTzPlusMilliseconds(pw->idle_since,
+															ts_guc_bgw_job_pool_idle_timeout));
+	}
+
+	return earliest;
+}
+
 #ifdef USE_ASSERT_CHECKING
 static void
 assert_that_worker_has_stopped(ScheduledBgwJob *sjob)
@@ -163,6 +455,7 @@ mark_job_as_started(ScheduledBgwJob *sjob)
 	sjob->consecutive_failed_launches = 0;
 	ts_bgw_job_stat_mark_start(&sjob->job);
 	sjob->may_need_mark_end = true;
+	sjob->admission_deferrals = 0;
 }
 
 static void
@@ -232,6 +525,12 @@ worker_state_cleanup(ScheduledBgwJob *sjob)
 		sjob->reserved_worker = false;
 	}
 
+	if (sjob->pool_worker != NULL)
+	{
+		pool_worker_release_job(sjob->pool_worker);
+		sjob->pool_worker = NULL;
+	}
+
 	if (sjob->may_need_mark_end)
 	{
 		BgwJobStat *job_stat;
@@ -320,9 +619,16 @@ scheduled_bgw_job_transition_state_to(ScheduledBgwJob *sjob, JobState new_state)
 				return;
 			}
 
-			/* If we are unable to reserve a worker go back to the scheduled state */
-			sjob->reserved_worker = ts_bgw_worker_reserve();
-			if (!sjob->reserved_worker)
+			/*
+			 * Run the job in a pooled worker if possible, otherwise reserve a
+			 * worker to launch a new background worker for the job. If we
+			 * are unable to do either, go back to the scheduled state.
+			 */
+			Assert(sjob->pool_worker == NULL);
+			sjob->pool_worker = pool_worker_acquire(sjob->job.fd.owner);
+			if (sjob->pool_worker == NULL)
+				sjob->reserved_worker = ts_bgw_worker_reserve();
+			if (sjob->pool_worker == NULL && !sjob->reserved_worker)
 			{
 				elog(WARNING,
 					 "failed to launch job %d \"%s\": out of background workers",
@@ -335,6 +641,11 @@ scheduled_bgw_job_transition_state_to(ScheduledBgwJob *sjob, JobState new_state)
 				return;
 			}
 
+			/* Record why the start of the job was delayed in the job history */
+			sjob->job.job_history.deferrals = sjob->admission_deferrals;
+			sjob->job.job_history.last_deferral = sjob->admission_last_deferral;
+			sjob->job.job_history.deferred_since = sjob->admission_deferred_since;
+
 			/*
 			 * start the job before you can encounter any errors so that they
 			 * are always registered
@@ -349,6 +660,16 @@ scheduled_bgw_job_transition_state_to(ScheduledBgwJob *sjob, JobState new_state)
 			CommitTransactionCommand();
 			MemoryContextSwitchTo(scratch_mctx);
 
+			if (sjob->pool_worker != NULL)
+			{
+				elog(DEBUG1,
+					 "running job %d \"%s\" in job pool worker",
+					 sjob->job.fd.id,
+					 NameStr(sjob->job.fd.application_name));
+				ts_bgw_pool_slot_assign(sjob->pool_worker->slot, &sjob->job);
+				break;
+			}
+
 			elog(DEBUG1,
 				 "launching job %d \"%s\"",
 				 sjob->job.fd.id,
@@ -368,6 +689,13 @@ scheduled_bgw_job_transition_state_to(ScheduledBgwJob *sjob, JobState new_state)
 			break;
 		case JOB_STATE_TERMINATING:
 			Assert(prev_state == JOB_STATE_STARTED);
+			if (sjob->pool_worker != NULL)
+			{
+				/* the only way to stop a pooled job is to stop its worker */
+				sjob->pool_worker->stopping = true;
+				TerminateBackgroundWorker(sjob->pool_worker->handle);
+				break;
+			}
 			Assert(sjob->handle != NULL);
 			Assert(sjob->reserved_worker);
 			TerminateBackgroundWorker(sjob->handle);
@@ -436,6 +764,10 @@ scheduled_ts_bgw_job_start(ScheduledBgwJob *sjob,
 	if (sjob->state != JOB_STATE_STARTED)
 		return;
 
+	/* Pooled workers report the end of the job through the pool slot */
+	if (sjob->pool_worker != NULL)
+		return;
+
 	Assert(sjob->handle != NULL);
 	if (bgw_register != NULL)
 		bgw_register(sjob->handle, scheduler_mctx);
@@ -470,6 +802,12 @@ terminate_and_cleanup_job(ScheduledBgwJob *sjob)
 		TerminateBackgroundWorker(sjob->handle);
 		WaitForBackgroundWorkerShutdown(sjob->handle);
 	}
+	else if (sjob->pool_worker != NULL)
+	{
+		sjob->pool_worker->stopping = true;
+		TerminateBackgroundWorker(sjob->pool_worker->handle);
+		WaitForBackgroundWorkerShutdown(sjob->pool_worker->handle);
+	}
 	sjob->may_need_mark_end = false;
 	worker_state_cleanup(sjob);
 }
@@ -594,11 +932,138 @@ cmp_next_start(const ListCell *left_cell, const ListCell *right_cell)
 	return 0;
 }
 
+/*
+ * Get the system load average per CPU, or a negative value if it is not
+ * available on this platform.
+ *
+ * On Linux, the load average also counts processes waiting for disk I/O, so
+ * it reflects both CPU and I/O pressure.
+ */
+static double
+get_system_load(void)
+{
+#ifndef WIN32
+	double loadavg;
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (getloadavg(&loadavg, 1) != 1)
+		return -1.0;
+
+	return loadavg / Max(ncpus, 1);
+#else
+	return -1.0;
+#endif
+}
+
+static int
+get_job_class_limit(BgwJobClass job_class)
+{
+	switch (job_class)
+	{
+		case JOB_CLASS_COMPRESSION:
+			return ts_guc_bgw_max_concurrent_compression_jobs;
+		case JOB_CLASS_REFRESH:
+			return ts_guc_bgw_max_concurrent_refresh_jobs;
+		case JOB_CLASS_RETENTION:
+			return ts_guc_bgw_max_concurrent_retention_jobs;
+		case JOB_CLASS_OTHER:
+			break;
+	}
+
+	return 0;
+}
+
+static const char *
+job_admission_reason(BgwJobAdmission admission)
+{
+	switch (admission)
+	{
+		case JOB_DEFERRED_CLASS_LIMIT:
+			return "concurrency limit for job class reached";
+		case JOB_DEFERRED_HYPERTABLE_LIMIT:
+			return "concurrency limit for hypertable reached";
+		case JOB_DEFERRED_SYSTEM_LOAD:
+			return "system load too high";
+		case JOB_ADMITTED:
+			break;
+	}
+
+	return "admitted";
+}
+
+/*
+ * Decide if a job that is due to start can be started now.
+ *
+ * Jobs are held back if too many jobs of the same class or on the same
+ * hypertable are already running, or if the system is under load. Only the
+ * policies doing heavy I/O are subject to back-pressure from the system
+ * load so that other jobs still run on schedule.
+ */
+static BgwJobAdmission
+job_admission_check(ScheduledBgwJob *sjob, double system_load)
+{
+	BgwJobClass job_class = ts_bgw_job_get_class(&sjob->job);
+	int class_limit = get_job_class_limit(job_class);
+	int hypertable_limit = ts_guc_bgw_max_concurrent_jobs_per_hypertable;
+	int class_running = 0;
+	int hypertable_running = 0;
+	ListCell *lc;
+
+	if (job_class != JOB_CLASS_OTHER && ts_guc_bgw_job_max_load > 0 &&
+		system_load > ts_guc_bgw_job_max_load)
+		return JOB_DEFERRED_SYSTEM_LOAD;
+
+	if (sjob->job.fd.hypertable_id == INVALID_HYPERTABLE_ID)
+		hypertable_limit = 0;
+
+	if (class_limit <= 0 && hypertable_limit <= 0)
+		return JOB_ADMITTED;
+
+	foreach (lc, scheduled_jobs)
+	{
+		ScheduledBgwJob *other = lfirst(lc);
+
+		if (other->state != JOB_STATE_STARTED && other->state != JOB_STATE_TERMINATING)
+			continue;
+
+		if (class_limit > 0 && ts_bgw_job_get_class(&other->job) == job_class)
+			class_running++;
+
+		if (hypertable_limit > 0 && other->job.fd.hypertable_id == sjob->job.fd.hypertable_id)
+			hypertable_running++;
+	}
+
+	if (class_limit > 0 && class_running >= class_limit)
+		return JOB_DEFERRED_CLASS_LIMIT;
+
+	if (hypertable_limit > 0 && hypertable_running >= hypertable_limit)
+		return JOB_DEFERRED_HYPERTABLE_LIMIT;
+
+	return JOB_ADMITTED;
+}
+
+static void
+defer_job_start(ScheduledBgwJob *sjob, BgwJobAdmission admission)
+{
+	if (sjob->admission_deferrals == 0)
+		sjob->admission_deferred_since = ts_timer_get_current_timestamp();
+
+	sjob->admission_deferrals++;
+	sjob->admission_last_deferral = admission;
+
+	elog(DEBUG2,
+		 "deferring start of job %d \"%s\": %s",
+		 sjob->job.fd.id,
+		 NameStr(sjob->job.fd.application_name),
+		 job_admission_reason(admission));
+}
+
 static void
 start_scheduled_jobs(register_background_worker_callback_type bgw_register)
 {
 	List *ordered_scheduled_jobs;
 	ListCell *lc;
+	double system_load = ts_guc_bgw_job_max_load > 0 ? get_system_load() : -1.0;
 	Assert(CurrentMemoryContext == scratch_mctx);
 
 	/* Order jobs by increasing next_start */
@@ -615,6 +1080,15 @@ start_scheduled_jobs(register_background_worker_callback_type bgw_register)
 		if (sjob->state == JOB_STATE_SCHEDULED &&
 			(job_start_diff <= 0 || sjob->next_start == DT_NOBEGIN))
 		{
+			BgwJobAdmission admission = job_admission_check(sjob, system_load);
+
+			/* retried after START_RETRY_MS, see earliest_wakeup_to_start_next_job */
+			if (admission != JOB_ADMITTED)
+			{
+				defer_job_start(sjob, admission);
+				continue;
+			}
+
 			elog(DEBUG2, "starting scheduled job %d", sjob->job.fd.id);
 			scheduled_ts_bgw_job_start(sjob, bgw_register);
 		}
@@ -700,7 +1174,18 @@ terminate_all_jobs_and_release_workers()
 			ts_bgw_worker_release();
 			sjob->reserved_worker = false;
 		}
+
+		sjob->pool_worker = NULL;
+	}
+
+	foreach (lc, pool_workers)
+	{
+		BgwPoolWorker *pw = lfirst(lc);
+
+		TerminateBackgroundWorker(pw->handle);
+		ts_bgw_worker_release();
 	}
+	pool_workers = NIL;
 }
 
 static void
@@ -712,9 +1197,22 @@ wait_for_all_jobs_to_shutdown()
 	{
 		ScheduledBgwJob *sjob = lfirst(lc);
 
-		if (sjob->state == JOB_STATE_STARTED || sjob->state == JOB_STATE_TERMINATING)
+		if ((sjob->state == JOB_STATE_STARTED || sjob->state == JOB_STATE_TERMINATING) &&
+			sjob->handle != NULL)
 			WaitForBackgroundWorkerShutdown(sjob->handle);
 	}
+
+	/* Pooled workers exit once they have finished their current job */
+	foreach (lc, pool_workers)
+	{
+		BgwPoolWorker *pw = lfirst(lc);
+
+		ts_bgw_pool_slot_request_shutdown(pw->slot);
+		pw->stopping = true;
+	}
+
+	foreach (lc, pool_workers)
+		WaitForBackgroundWorkerShutdown(((BgwPoolWorker *) lfirst(lc))->handle);
 }
 
 static void
@@ -732,7 +1230,10 @@ check_for_stopped_and_timed_out_jobs()
 		if (sjob->state != JOB_STATE_STARTED && sjob->state != JOB_STATE_TERMINATING)
 			continue;
 
-		status = GetBackgroundWorkerPid(sjob->handle, &pid);
+		if (sjob->pool_worker != NULL)
+			status = pool_worker_get_job_status(sjob->pool_worker);
+		else
+			status = GetBackgroundWorkerPid(sjob->handle, &pid);
 
 		switch (status)
 		{
@@ -833,6 +1334,7 @@ ts_bgw_scheduler_process(int32 run_for_interval_ms,
 		start_scheduled_jobs(bgw_register);
 		next_wakeup = least_timestamp(next_wakeup, earliest_wakeup_to_start_next_job());
 		next_wakeup = least_timestamp(next_wakeup, earliest_job_timeout());
+		next_wakeup = least_timestamp(next_wakeup, earliest_pool_worker_idle_timeout());
 
 		pgstat_report_activity(STATE_IDLE, NULL);
 		ts_timer_wait(next_wakeup);
@@ -864,6 +1366,7 @@ ts_bgw_scheduler_process(int32 run_for_interval_ms,
 		}
 
 		check_for_stopped_and_timed_out_jobs();
+		pool_workers_maintain();
 
 		MemoryContextReset(scratch_mctx);
 	}
@@ -883,6 +1386,7 @@ scheduler_exit:
 
 	wait_for_all_jobs_to_shutdown();
 	check_for_stopped_and_timed_out_jobs();
+	pool_workers_maintain();
 	scheduled_jobs = NIL;
 	proc_exit(ts_debug_bgw_scheduler_exit_status);
 }
@@ -8,6 +8,7 @@
 #include <postgres.h>
 
 #include <postmaster/bgworker.h>
+#include <storage/dsm.h>
 
 /**
  * Parameters to background workers.
@@ -16,14 +17,18 @@
  * using memcpy(3). If it is necessary to add fields that cannot simply be
  * copied, we need to start using the send and recv functions for the types.
  *
- * Only one of `job_id` and `ttl` is passed currently, with `job_id` being used
- * for normal jobs and `ttl` being used for tests.
+ * Only one of `job_id`, `ttl` and `pool_handle` is passed currently, with
+ * `job_id` being used for normal jobs, `ttl` being used for tests and
+ * `pool_handle` being used for pooled job workers.
  *
  * The `bgw_main` is the function to execute when starting the job and is
  * different depending on whether this is a test runner or the real runner.
+ * It is a function name, so it is limited to NAMEDATALEN rather than
+ * BGW_MAXLEN to leave room for the other fields in `bgw_extra`.
  *
  * @see ts_bgw_db_scheduler_test_main
  * @see ts_bgw_job_entrypoint
+ * @see ts_bgw_job_pool_worker_main
  */
 typedef struct BgwParams
 {
@@ -38,11 +43,19 @@ typedef struct BgwParams
 	int64 job_history_id;
 	TimestampTz job_history_execution_start;
 
+	/** Admission control decisions to record in the job history */
+	int32 job_history_deferrals;
+	int32 job_history_last_deferral;
+	TimestampTz job_history_deferred_since;
+
 	/** Time to live. Only used in tests. */
 	int32 ttl;
 
+	/** Shared memory segment of a pooled job worker. Only used by the job pool. */
+	dsm_handle pool_handle;
+
 	/** Name of function to call when starting the background worker. */
-	char bgw_main[BGW_MAXLEN];
+	char bgw_main[NAMEDATALEN];
 } BgwParams;
 
 /**
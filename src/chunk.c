@@ -5177,6 +5177,27 @@ get_chunks_in_creation_time_range(Hypertable *ht, int64 older_than, int64 newer_
 	return chunks;
 }
 
+/*
+ * Get the chunks of the hypertable that are older than the given time, either
+ * by the range of the primary dimension or by the chunk creation time. These
+ * are the chunks that show_chunks() returns for the "older_than" or the
+ * "created_before" argument.
+ */
+Chunk *
+ts_chunk_get_chunks_older_than(Hypertable *ht, int64 older_than, bool use_creation_time,
+							   MemoryContext mctx, uint64 *num_chunks_returned)
+{
+	if (use_creation_time)
+		return get_chunks_in_creation_time_range(ht,
+												 older_than,
+												 PG_INT64_MIN,
+												 mctx,
+												 num_chunks_returned,
+												 NULL);
+
+	return get_chunks_in_time_range(ht, older_than, PG_INT64_MIN, mctx, num_chunks_returned, NULL);
+}
+
 Datum
 ts_chunk_drop_osm_chunk(PG_FUNCTION_ARGS)
 {
@@ -237,6 +237,10 @@ extern TSDLLEXPORT Chunk *ts_chunk_create_only_table(Hypertable *ht, Hypercube *
 extern TSDLLEXPORT int64 ts_chunk_primary_dimension_start(const Chunk *chunk);
 
 extern TSDLLEXPORT int64 ts_chunk_primary_dimension_end(const Chunk *chunk);
+extern TSDLLEXPORT Chunk *ts_chunk_get_chunks_older_than(Hypertable *ht, int64 older_than,
+														  bool use_creation_time,
+														  MemoryContext mctx,
+														  uint64 *num_chunks_returned);
 extern Chunk *ts_chunk_build_from_tuple_and_stub(Chunk **chunkptr, TupleInfo *ti,
 												 const ChunkStub *stub);
 
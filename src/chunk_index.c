@@ -416,6 +416,63 @@ ts_chunk_index_create_from_adjusted_index_info(int32 hypertable_id, Relation hyp
 					   get_rel_name(RelationGetRelid(hypertable_idxrel)));
 }
 
+/*
+ * Create the chunk index of a hypertable index on a single chunk, unless the
+ * chunk already has it.
+ *
+ * This is used when the chunk indexes are created in a separate transaction
+ * per chunk, either by the session running CREATE INDEX or by the background
+ * workers building the chunk indexes in parallel. A chunk might already have
+ * the index if an interrupted CREATE INDEX is resumed, in which case it is
+ * skipped. Returns true if the index was created.
+ */
+bool
+ts_chunk_index_create_if_missing(int32 hypertable_id, Oid hypertable_relid, int hypertable_natts,
+								 Oid hypertable_indexrelid, Oid chunk_relid)
+{
+	Relation chunk_rel;
+	Relation hypertable_idxrel;
+	IndexInfo *indexinfo;
+	ChunkIndexMapping cim;
+	Chunk *chunk;
+	bool created = false;
+
+	/*
+	 * We grab a ShareLock on the chunk, because that's what CREATE INDEX
+	 * does. For the hypertable's index, we are ok using the weaker
+	 * AccessShareLock, since we only need to prevent the index itself from
+	 * being ALTERed or DROPped during this part of index creation.
+	 */
+	chunk_rel = table_open(chunk_relid, ShareLock);
+	chunk = ts_chunk_get_by_relid(chunk_relid, true);
+
+	/* Cannot create index on foreign OSM chunk */
+	if (IS_OSM_CHUNK(chunk))
+	{
+		ereport(NOTICE, (errmsg("skipping index creation for tiered data")));
+	}
+	else if (!ts_chunk_index_get_by_hypertable_indexrelid(chunk, hypertable_indexrelid, &cim))
+	{
+		hypertable_idxrel = index_open(hypertable_indexrelid, AccessShareLock);
+		indexinfo = BuildIndexInfo(hypertable_idxrel);
+
+		if (chunk_index_columns_changed(hypertable_natts, RelationGetDescr(chunk_rel)))
+			ts_adjust_indexinfo_attnos(indexinfo, hypertable_relid, chunk_rel);
+
+		ts_chunk_index_create_from_adjusted_index_info(hypertable_id,
+													   hypertable_idxrel,
+													   chunk->fd.id,
+													   chunk_rel,
+													   indexinfo);
+		index_close(hypertable_idxrel, NoLock);
+		created = true;
+	}
+
+	table_close(chunk_rel, NoLock);
+
+	return created;
+}
+
 /*
  * Create all indexes on a chunk, given the indexes that exists on the chunk's
  * hypertable.
@@ -33,6 +33,9 @@ extern void ts_chunk_index_create_from_adjusted_index_info(int32 hypertable_id,
 														   Relation hypertable_idxrel,
 														   int32 chunk_id, Relation chunkrel,
 														   IndexInfo *indexinfo);
+extern bool ts_chunk_index_create_if_missing(int32 hypertable_id, Oid hypertable_relid,
+											 int hypertable_natts, Oid hypertable_indexrelid,
+											 Oid chunk_relid);
 extern TSDLLEXPORT void ts_chunk_index_create_all(int32 hypertable_id, Oid hypertable_relid,
 												  int32 chunk_id, Oid chunkrelid, Oid index_tblspc);
 extern TSDLLEXPORT void ts_chunk_index_move_all(Oid chunk_relid, Oid index_tblspc);
@@ -0,0 +1,402 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+
+/*
+ * Parallel creation of chunk indexes.
+ *
+ * CREATE INDEX ... WITH (timescaledb.transaction_per_chunk,
+ * timescaledb.parallel_workers = N) distributes the per-chunk index builds
+ * across a pool of at most N dynamic background workers. The session running
+ * the command only coordinates: it puts the list of chunks in a dynamic
+ * shared memory segment, and the workers repeatedly claim the next chunk and
+ * build its index in a transaction of its own, just like the serial
+ * transaction-per-chunk mode does.
+ *
+ * The progress is reported in pg_stat_progress_create_index, where the
+ * session running the command shows the number of chunks indexed so far
+ * (partitions_done) and each worker shows the progress of the chunk it is
+ * building.
+ *
+ * If the command is interrupted, or a worker fails, the hypertable index is
+ * left invalid and the chunks that were already indexed keep their
+ * indexes. Running the same CREATE INDEX IF NOT EXISTS again resumes the
+ * build and only indexes the remaining chunks.
+ */
+#include <postgres.h>
+#include <access/xact.h>
+#include <catalog/pg_inherits.h>
+#include <commands/progress.h>
+#include <miscadmin.h>
+#include <pgstat.h>
+#include <postmaster/bgworker.h>
+#include <storage/dsm.h>
+#include <storage/latch.h>
+#include <storage/spin.h>
+#include <tcop/tcopprot.h>
+#include <utils/backend_progress.h>
+#include <utils/guc.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+#include <utils/snapmgr.h>
+
+#include "compat/compat.h"
+#include "chunk_index.h"
+#include "chunk_index_parallel.h"
+#include "extension.h"
+#include "license_guc.h"
+#include "ts_catalog/catalog.h"
+
+#define CHUNK_INDEX_BUILD_WORKER_MAIN "ts_chunk_index_build_worker_main"
+#define CHUNK_INDEX_BUILD_ERRMSG_LEN 256
+
+/*
+ * The state shared between the session running CREATE INDEX and the
+ * workers. Lives in a dynamic shared memory segment whose handle is passed
+ * as the main argument of the workers.
+ */
+typedef struct ChunkIndexBuildShared
+{
+	Oid database_id;
+	Oid user_id;
+	int32 hypertable_id;
+	Oid hypertable_relid;
+	int hypertable_natts;
+	Oid hypertable_indexrelid;
+
+	/* The next chunk to claim, and the number of chunks processed */
+	pg_atomic_uint32 next_chunk;
+	pg_atomic_uint32 chunks_done;
+
+	/* The first error raised by a worker, protected by the mutex */
+	slock_t mutex;
+	bool failed;
+	Oid failed_chunk_relid;
+	char errmsg[CHUNK_INDEX_BUILD_ERRMSG_LEN];
+
+	uint32 nchunks;
+	Oid chunk_relids[FLEXIBLE_ARRAY_MEMBER];
+} ChunkIndexBuildShared;
+
+#define CHUNK_INDEX_BUILD_SHARED_SIZE(nchunks)                                                     \
+	(offsetof(ChunkIndexBuildShared, chunk_relids) + sizeof(Oid) * (nchunks))
+
+TS_FUNCTION_INFO_V1(ts_chunk_index_build_worker_main);
+
+static bool
+chunk_index_build_failed(ChunkIndexBuildShared *shared)
+{
+	bool failed;
+
+	SpinLockAcquire(&shared->mutex);
+	failed = shared->failed;
+	SpinLockRelease(&shared->mutex);
+
+	return failed;
+}
+
+static void
+chunk_index_build_set_failed(ChunkIndexBuildShared *shared, Oid chunk_relid, const char *message)
+{
+	SpinLockAcquire(&shared->mutex);
+	if (!shared->failed)
+	{
+		shared->failed = true;
+		shared->failed_chunk_relid = chunk_relid;
+		strlcpy(shared->errmsg, message, sizeof(shared->errmsg));
+	}
+	SpinLockRelease(&shared->mutex);
+}
+
+/*
+ * Build the index on one chunk in a transaction of its own. Same as
+ * process_index_chunk_multitransaction() for the serial case.
+ */
+static void
+chunk_index_build_one(const ChunkIndexBuildShared *shared, Oid chunk_relid)
+{
+	CatalogSecurityContext sec_ctx;
+
+	StartTransactionCommand();
+	PushActiveSnapshot(GetTransactionSnapshot());
+
+	pgstat_progress_start_command(PROGRESS_COMMAND_CREATE_INDEX, chunk_relid);
+	pgstat_progress_update_param(PROGRESS_CREATEIDX_COMMAND, PROGRESS_CREATEIDX_COMMAND_CREATE);
+
+	/*
+	 * Change user since chunks are typically located in an internal schema
+	 * and chunk indexes require metadata changes.
+	 */
+	ts_catalog_database_info_become_owner(ts_catalog_database_info_get(), &sec_ctx);
+	ts_chunk_index_create_if_missing(shared->hypertable_id,
+									 shared->hypertable_relid,
+									 shared->hypertable_natts,
+									 shared->hypertable_indexrelid,
+									 chunk_relid);
+	ts_catalog_restore_user(&sec_ctx);
+
+	pgstat_progress_end_command();
+
+	PopActiveSnapshot();
+	CommitTransactionCommand();
+}
+
+/*
+ * Main function of the background workers building chunk indexes.
+ *
+ * The worker claims chunks until there are none left, or another worker
+ * failed. On failure, the error is recorded in the shared state for the
+ * session running CREATE INDEX to report, and the worker exits.
+ */
+Datum
+ts_chunk_index_build_worker_main(PG_FUNCTION_ARGS)
+{
+	dsm_handle handle = DatumGetUInt32(MyBgworkerEntry->bgw_main_arg);
+	ChunkIndexBuildShared *shared;
+	dsm_segment *seg;
+	volatile Oid chunk_relid = InvalidOid;
+
+	/*
+	 * do not use the default `bgworker_die` sigterm handler because it does
+	 * not respect critical sections
+	 */
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	seg = dsm_attach(handle);
+
+	if (seg == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("could not map dynamic shared memory segment")));
+
+	shared = dsm_segment_address(seg);
+
+	BackgroundWorkerInitializeConnectionByOid(shared->database_id, shared->user_id, 0);
+	ts_license_enable_module_loading();
+
+	/*
+	 * we do not necessarily have a valid parallel worker context in
+	 * background workers, so disable parallel index builds
+	 */
+	SetConfigOption("max_parallel_maintenance_workers", "0", PGC_SUSET, PGC_S_OVERRIDE);
+
+	PG_TRY();
+	{
+		while (!chunk_index_build_failed(shared))
+		{
+			uint32 next = pg_atomic_fetch_add_u32(&shared->next_chunk, 1);
+
+			if (next >= shared->nchunks)
+				break;
+
+			chunk_relid = shared->chunk_relids[next];
+			chunk_index_build_one(shared, chunk_relid);
+			pg_atomic_fetch_add_u32(&shared->chunks_done, 1);
+		}
+	}
+	PG_CATCH();
+	{
+		ErrorData *edata;
+
+		MemoryContextSwitchTo(TopMemoryContext);
+		edata = CopyErrorData();
+		chunk_index_build_set_failed(shared, chunk_relid, edata->message);
+		FreeErrorData(edata);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	dsm_detach(seg);
+
+	PG_RETURN_VOID();
+}
+
+static BackgroundWorkerHandle *
+chunk_index_build_start_worker(dsm_segment *seg, int worker_number)
+{
+	BackgroundWorker worker = {
+		.bgw_flags = BGWORKER_SHMEM_ACCESS | BGWORKER_BACKEND_DATABASE_CONNECTION,
+		.bgw_start_time = BgWorkerStart_RecoveryFinished,
+		.bgw_restart_time = BGW_NEVER_RESTART,
+		.bgw_notify_pid = MyProcPid,
+		.bgw_main_arg = UInt32GetDatum(dsm_segment_handle(seg)),
+	};
+	BackgroundWorkerHandle *handle = NULL;
+
+	snprintf(worker.bgw_name, BGW_MAXLEN, "TimescaleDB Chunk Index Build Worker %d", worker_number);
+	strlcpy(worker.bgw_type, "TimescaleDB Chunk Index Build Worker", BGW_MAXLEN);
+	strlcpy(worker.bgw_library_name, ts_extension_get_so_name(), BGW_MAXLEN);
+	strlcpy(worker.bgw_function_name, CHUNK_INDEX_BUILD_WORKER_MAIN, BGW_MAXLEN);
+
+	if (!RegisterDynamicBackgroundWorker(&worker, &handle))
+		return NULL;
+
+	return handle;
+}
+
+/*
+ * Wait for all the workers to exit, while reporting the number of chunks
+ * processed so far.
+ */
+static void
+chunk_index_build_wait(ChunkIndexBuildShared *shared, BackgroundWorkerHandle **handles,
+					   int nworkers)
+{
+	for (;;)
+	{
+		int nrunning = 0;
+
+		for (int i = 0; i < nworkers; i++)
+		{
+			pid_t pid;
+
+			if (GetBackgroundWorkerPid(handles[i], &pid) != BGWH_STOPPED)
+				nrunning++;
+		}
+
+		pgstat_progress_update_param(PROGRESS_CREATEIDX_PARTITIONS_DONE,
+									 pg_atomic_read_u32(&shared->chunks_done));
+
+		if (nrunning == 0)
+			break;
+
+		/* The postmaster sets our latch when a worker exits */
+		(void) WaitLatch(MyLatch,
+						 WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+						 1000L,
+						 PG_WAIT_EXTENSION);
+		ResetLatch(MyLatch);
+		CHECK_FOR_INTERRUPTS();
+	}
+}
+
+/*
+ * Create the index on all chunks of a hypertable using background workers.
+ *
+ * Must be called outside of a transaction, after the hypertable index was
+ * created and committed. Returns false if no worker could be started, in
+ * which case nothing was done and the caller should create the chunk
+ * indexes serially. Raises an error if any chunk could not be indexed.
+ */
+bool
+ts_chunk_index_create_parallel(int32 hypertable_id, Oid hypertable_relid, int hypertable_natts,
+							   Oid hypertable_indexrelid, int nworkers)
+{
+	ChunkIndexBuildShared *shared;
+	BackgroundWorkerHandle **handles;
+	dsm_segment *seg;
+	List *chunks;
+	ListCell *lc;
+	int nchunks;
+	int nlaunched = 0;
+	uint32 chunks_done;
+	bool failed;
+
+	StartTransactionCommand();
+
+	chunks = find_inheritance_children(hypertable_relid, NoLock);
+	nchunks = list_length(chunks);
+
+	/* Do not hold back the xmin horizon while waiting for the workers */
+	InvalidateCatalogSnapshot();
+
+	if (nchunks == 0)
+	{
+		CommitTransactionCommand();
+		return true;
+	}
+
+	seg = dsm_create(CHUNK_INDEX_BUILD_SHARED_SIZE(nchunks), 0);
+	shared = dsm_segment_address(seg);
+	memset(shared, 0, CHUNK_INDEX_BUILD_SHARED_SIZE(nchunks));
+	shared->database_id = MyDatabaseId;
+	shared->user_id = GetUserId();
+	shared->hypertable_id = hypertable_id;
+	shared->hypertable_relid = hypertable_relid;
+	shared->hypertable_natts = hypertable_natts;
+	shared->hypertable_indexrelid = hypertable_indexrelid;
+	pg_atomic_init_u32(&shared->next_chunk, 0);
+	pg_atomic_init_u32(&shared->chunks_done, 0);
+	SpinLockInit(&shared->mutex);
+	shared->nchunks = nchunks;
+
+	foreach (lc, chunks)
+		shared->chunk_relids[foreach_current_index(lc)] = lfirst_oid(lc);
+
+	nworkers = Min(nworkers, nchunks);
+	handles = palloc0(sizeof(BackgroundWorkerHandle *) * nworkers);
+
+	for (int i = 0; i < nworkers; i++)
+	{
+		handles[nlaunched] = chunk_index_build_start_worker(seg, i + 1);
+
+		if (handles[nlaunched] != NULL)
+			nlaunched++;
+	}
+
+	if (nlaunched == 0)
+	{
+		dsm_detach(seg);
+		CommitTransactionCommand();
+		ereport(NOTICE,
+				(errmsg("could not start background workers for index creation"),
+				 errdetail("Creating the chunk indexes serially."),
+				 errhint("Consider increasing the configuration parameter "
+						 "\"max_worker_processes\".")));
+		return false;
+	}
+
+	if (nlaunched < nworkers)
+		elog(DEBUG1, "started %d of %d chunk index build workers", nlaunched, nworkers);
+
+	pgstat_progress_start_command(PROGRESS_COMMAND_CREATE_INDEX, hypertable_relid);
+	pgstat_progress_update_param(PROGRESS_CREATEIDX_COMMAND, PROGRESS_CREATEIDX_COMMAND_CREATE);
+	pgstat_progress_update_param(PROGRESS_CREATEIDX_INDEX_OID, hypertable_indexrelid);
+	pgstat_progress_update_param(PROGRESS_CREATEIDX_PARTITIONS_TOTAL, nchunks);
+
+	PG_TRY();
+	{
+		chunk_index_build_wait(shared, handles, nlaunched);
+	}
+	PG_CATCH();
+	{
+		/* Stop the workers if the command is canceled */
+		for (int i = 0; i < nlaunched; i++)
+			TerminateBackgroundWorker(handles[i]);
+
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	pgstat_progress_end_command();
+
+	chunks_done = pg_atomic_read_u32(&shared->chunks_done);
+	failed = chunk_index_build_failed(shared);
+
+	if (failed)
+		ereport(ERROR,
+				(errmsg("could not create index on all chunks"),
+				 errdetail("%s", shared->errmsg),
+				 OidIsValid(shared->failed_chunk_relid) ?
+					 errcontext("creating index on chunk \"%s\"",
+								get_rel_name(shared->failed_chunk_relid)) :
+					 0,
+				 errhint("Run the same CREATE INDEX with IF NOT EXISTS to resume the index "
+						 "creation.")));
+
+	if (chunks_done < (uint32) nchunks)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("background workers exited before creating the index on all chunks"),
+				 errdetail("Created the index on %u of %d chunks.", chunks_done, nchunks),
+				 errhint("Run the same CREATE INDEX with IF NOT EXISTS to resume the index "
+						 "creation.")));
+
+	dsm_detach(seg);
+	CommitTransactionCommand();
+
+	return true;
+}
@@ -0,0 +1,17 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+#include <fmgr.h>
+
+#include "export.h"
+
+extern bool ts_chunk_index_create_parallel(int32 hypertable_id, Oid hypertable_relid,
+										   int hypertable_natts, Oid hypertable_indexrelid,
+										   int nworkers);
+
+extern TSDLLEXPORT Datum ts_chunk_index_build_worker_main(PG_FUNCTION_ARGS);
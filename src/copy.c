@@ -60,6 +60,8 @@
 #include "copy.h"
 #include "cross_module_fn.h"
 #include "dimension.h"
+#include "foreign_key.h"
+#include "guc.h"
 #include "hypertable.h"
 #include "nodes/chunk_dispatch/chunk_dispatch.h"
 #include "nodes/chunk_dispatch/chunk_insert_state.h"
@@ -125,6 +127,7 @@ typedef struct TSCopyMultiInsertInfo
 	CommandId mycid;		  /* Command Id used for COPY */
 	int ti_options;			  /* table insert options */
 	Hypertable *ht;			  /* The hypertable for the inserts */
+	FkBatchCheck *fk_check;	  /* Batched foreign key checks, or NULL */
 } TSCopyMultiInsertInfo;
 
 /*
@@ -263,6 +266,7 @@ TSCopyMultiInsertInfoInit(TSCopyMultiInsertInfo *miinfo, ResultRelInfo *rri,
 	miinfo->mycid = mycid;
 	miinfo->ti_options = ti_options;
 	miinfo->ht = ht;
+	miinfo->fk_check = ts_guc_enable_foreign_key_batch_check ? ts_fk_batch_check_create() : NULL;
 }
 
 /*
@@ -345,6 +349,20 @@ TSCopyMultiInsertBufferFlush(TSCopyMultiInsertInfo *miinfo, TSCopyMultiInsertBuf
 					   buffer->bistate);
 	MemoryContextSwitchTo(oldcontext);
 
+	/*
+	 * Check the foreign keys of the whole batch at once. If they are valid,
+	 * run the after row triggers without the per-row foreign key checks.
+	 */
+	TriggerDesc *saved_trigdesc = resultRelInfo->ri_TrigDesc;
+	if (miinfo->fk_check != NULL)
+	{
+		TriggerDesc *trigdesc =
+			ts_fk_batch_check_slots(miinfo->fk_check, resultRelInfo, slots, nused);
+
+		if (trigdesc != NULL)
+			resultRelInfo->ri_TrigDesc = trigdesc;
+	}
+
 	for (i = 0; i < nused; i++)
 	{
 		if (cstate != NULL)
@@ -392,6 +410,8 @@ TSCopyMultiInsertBufferFlush(TSCopyMultiInsertInfo *miinfo, TSCopyMultiInsertBuf
 		ExecClearTuple(slots[i]);
 	}
 
+	resultRelInfo->ri_TrigDesc = saved_trigdesc;
+
 	/* Mark that all slots are free */
 	buffer->nused = 0;
 
@@ -543,6 +563,9 @@ TSCopyMultiInsertInfoFlushAndCleanup(TSCopyMultiInsertInfo *miinfo)
 	}
 
 	hash_destroy(miinfo->multiInsertBuffers);
+
+	if (miinfo->fk_check != NULL)
+		ts_fk_batch_check_free(miinfo->fk_check);
 }
 
 /*
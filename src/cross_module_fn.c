@@ -25,6 +25,7 @@
 /* bgw policy functions */
 CROSSMODULE_WRAPPER(policy_compression_add);
 CROSSMODULE_WRAPPER(policy_compression_remove);
+CROSSMODULE_WRAPPER(policy_compression_proc);
 CROSSMODULE_WRAPPER(policy_recompression_proc);
 CROSSMODULE_WRAPPER(policy_compression_check);
 CROSSMODULE_WRAPPER(policy_refresh_cagg_add);
@@ -60,6 +61,22 @@ CROSSMODULE_WRAPPER(partialize_agg);
 CROSSMODULE_WRAPPER(finalize_agg_sfunc);
 CROSSMODULE_WRAPPER(finalize_agg_ffunc);
 
+/* approx_count_distinct aggregate */
+CROSSMODULE_WRAPPER(hll_sfunc);
+CROSSMODULE_WRAPPER(hll_combinefunc);
+CROSSMODULE_WRAPPER(hll_serializefunc);
+CROSSMODULE_WRAPPER(hll_deserializefunc);
+CROSSMODULE_WRAPPER(hll_finalfunc);
+
+/* percentile_sketch aggregates */
+CROSSMODULE_WRAPPER(ddsketch_sfunc);
+CROSSMODULE_WRAPPER(ddsketch_merge_sfunc);
+CROSSMODULE_WRAPPER(ddsketch_combinefunc);
+CROSSMODULE_WRAPPER(ddsketch_serializefunc);
+CROSSMODULE_WRAPPER(ddsketch_deserializefunc);
+CROSSMODULE_WRAPPER(ddsketch_finalfunc);
+CROSSMODULE_WRAPPER(approx_percentile);
+
 /* compression functions */
 CROSSMODULE_WRAPPER(compressed_data_decompress_forward);
 CROSSMODULE_WRAPPER(compressed_data_decompress_reverse);
@@ -69,6 +86,8 @@ CROSSMODULE_WRAPPER(compressed_data_in);
 CROSSMODULE_WRAPPER(compressed_data_out);
 CROSSMODULE_WRAPPER(compressed_data_info);
 CROSSMODULE_WRAPPER(compressed_data_has_nulls);
+CROSSMODULE_WRAPPER(session_decompression_stats);
+CROSSMODULE_WRAPPER(session_decompression_stats_reset);
 CROSSMODULE_WRAPPER(deltadelta_compressor_append);
 CROSSMODULE_WRAPPER(deltadelta_compressor_finish);
 CROSSMODULE_WRAPPER(gorilla_compressor_append);
@@ -353,6 +372,7 @@ TSDLLEXPORT CrossModuleFunctions ts_cm_functions_default = {
 	/* bgw policies */
 	.policy_compression_add = error_no_default_fn_pg_community,
 	.policy_compression_remove = error_no_default_fn_pg_community,
+	.policy_compression_proc = error_no_default_fn_pg_community,
 	.policy_recompression_proc = error_no_default_fn_pg_community,
 	.policy_compression_check = error_no_default_fn_pg_community,
 	.policy_refresh_cagg_add = error_no_default_fn_pg_community,
@@ -389,6 +409,18 @@ TSDLLEXPORT CrossModuleFunctions ts_cm_functions_default = {
 	.partialize_agg = error_no_default_fn_pg_community,
 	.finalize_agg_sfunc = error_no_default_fn_pg_community,
 	.finalize_agg_ffunc = error_no_default_fn_pg_community,
+	.hll_sfunc = error_no_default_fn_pg_community,
+	.hll_combinefunc = error_no_default_fn_pg_community,
+	.hll_serializefunc = error_no_default_fn_pg_community,
+	.hll_deserializefunc = error_no_default_fn_pg_community,
+	.hll_finalfunc = error_no_default_fn_pg_community,
+	.ddsketch_sfunc = error_no_default_fn_pg_community,
+	.ddsketch_merge_sfunc = error_no_default_fn_pg_community,
+	.ddsketch_combinefunc = error_no_default_fn_pg_community,
+	.ddsketch_serializefunc = error_no_default_fn_pg_community,
+	.ddsketch_deserializefunc = error_no_default_fn_pg_community,
+	.ddsketch_finalfunc = error_no_default_fn_pg_community,
+	.approx_percentile = error_no_default_fn_pg_community,
 	.process_cagg_viewstmt = process_cagg_viewstmt_default,
 	.continuous_agg_invalidation_trigger = error_no_default_fn_pg_community,
 	.continuous_agg_call_invalidation_trigger = continuous_agg_call_invalidation_trigger_default,
@@ -411,6 +443,8 @@ TSDLLEXPORT CrossModuleFunctions ts_cm_functions_default = {
 	.create_compressed_chunk = error_no_default_fn_pg_community,
 	.compress_chunk = error_no_default_fn_pg_community,
 	.decompress_chunk = error_no_default_fn_pg_community,
+	.session_decompression_stats = error_no_default_fn_pg_community,
+	.session_decompression_stats_reset = error_no_default_fn_pg_community,
 	.compressed_data_decompress_forward = error_no_default_fn_pg_community,
 	.compressed_data_decompress_reverse = error_no_default_fn_pg_community,
 	.deltadelta_compressor_append = error_no_default_fn_pg_community,
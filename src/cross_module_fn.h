@@ -40,6 +40,7 @@ typedef struct CrossModuleFunctions
 {
 	PGFunction policy_compression_add;
 	PGFunction policy_compression_remove;
+	PGFunction policy_compression_proc;
 	PGFunction policy_recompression_proc;
 	PGFunction policy_compression_check;
 	PGFunction policy_refresh_cagg_add;
@@ -99,6 +100,18 @@ typedef struct CrossModuleFunctions
 	PGFunction partialize_agg;
 	PGFunction finalize_agg_sfunc;
 	PGFunction finalize_agg_ffunc;
+	PGFunction hll_sfunc;
+	PGFunction hll_combinefunc;
+	PGFunction hll_serializefunc;
+	PGFunction hll_deserializefunc;
+	PGFunction hll_finalfunc;
+	PGFunction ddsketch_sfunc;
+	PGFunction ddsketch_merge_sfunc;
+	PGFunction ddsketch_combinefunc;
+	PGFunction ddsketch_serializefunc;
+	PGFunction ddsketch_deserializefunc;
+	PGFunction ddsketch_finalfunc;
+	PGFunction approx_percentile;
 	DDLResult (*process_cagg_viewstmt)(Node *stmt, const char *query_string, void *pstmt,
 									   WithClauseResult *with_clause_options);
 	PGFunction continuous_agg_invalidation_trigger;
@@ -123,6 +136,8 @@ typedef struct CrossModuleFunctions
 	PGFunction compressed_data_out;
 	PGFunction compressed_data_info;
 	PGFunction compressed_data_has_nulls;
+	PGFunction session_decompression_stats;
+	PGFunction session_decompression_stats_reset;
 	bool (*process_compress_table)(AlterTableCmd *cmd, Hypertable *ht,
 								   WithClauseResult *with_clause_options);
 	void (*process_altertable_cmd)(Hypertable *ht, const AlterTableCmd *cmd);
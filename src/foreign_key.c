@@ -15,13 +15,28 @@
 
 #include <postgres.h>
 #include "access/attmap.h"
+#include "access/htup_details.h"
+#include "access/tupmacs.h"
+#include "access/xact.h"
+#include "catalog/pg_class.h"
+#include "catalog/pg_operator.h"
 #include "catalog/pg_trigger.h"
 #include "commands/trigger.h"
+#include "executor/spi.h"
+#include "miscadmin.h"
 #include "parser/parser.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/fmgroids.h"
+#include "utils/hsearch.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/syscache.h"
 
 #include "compat/compat.h"
 #include "chunk.h"
 #include "foreign_key.h"
+#include "guc.h"
 #include "hypertable.h"
 
 static HeapTuple relation_get_fk_constraint(Oid conrelid, Oid confrelid);
@@ -569,3 +584,440 @@ get_fk_index(Relation rel, int nkeys, AttrNumber *confkeys)
 
 	return indexoid;
 }
+
+/*
+ * Batched checking of the foreign keys of chunks.
+ *
+ * The foreign keys of chunks are enforced by the RI_FKey_check_ins trigger,
+ * which looks up the referenced row for every inserted row. When COPY inserts
+ * a batch of rows into a chunk, we can instead collect the distinct keys of
+ * the batch and lock all the referenced rows with one query, the same way the
+ * trigger does for a single key. If all the referenced rows are found, the
+ * batch is valid and the row triggers can be skipped for it. Otherwise, we
+ * let the row triggers run as usual, so that they report the violation.
+ *
+ * The validated keys are remembered for the rest of the statement, since the
+ * referenced rows stay locked until the end of the transaction.
+ *
+ * Only single-column, non-deferrable foreign keys over fixed-length types
+ * without collation are checked in batches. This covers the usual integer
+ * and uuid references to dimension tables. We don't check in batches in
+ * the repeatable read and serializable isolation levels, where the trigger
+ * additionally checks for the rows invisible to the transaction snapshot.
+ */
+
+/* The maximum length of the keys that can be checked in batches. */
+#define FK_BATCH_KEY_MAXLEN 16
+
+/* The maximum number of validated keys remembered per referenced column. */
+#define FK_BATCH_MAX_VALIDATED_KEYS (64 * 1024)
+
+typedef struct FkBatchKey
+{
+	char data[FK_BATCH_KEY_MAXLEN];
+} FkBatchKey;
+
+typedef struct FkBatchReferenceId
+{
+	Oid confrelid;
+	AttrNumber confkey;
+	Oid eqop;
+	Oid fktypid;
+} FkBatchReferenceId;
+
+/*
+ * A referenced column together with the keys already validated for it.
+ */
+typedef struct FkBatchReference
+{
+	FkBatchReferenceId id; /* hash key, must be first */
+	int16 typlen;
+	bool typbyval;
+	char typalign;
+	Oid arraytypid;
+	Oid owner;
+	char *query;
+	HTAB *validated;
+} FkBatchReference;
+
+typedef struct FkBatchColumn
+{
+	AttrNumber attnum;
+	FkBatchReference *ref;
+} FkBatchColumn;
+
+/*
+ * The foreign keys of a chunk that are checked in batches. The trigdesc is a
+ * copy of the chunk triggers without the foreign key check triggers, and is
+ * NULL if the foreign keys of the chunk cannot be checked in batches.
+ */
+typedef struct FkBatchRelation
+{
+	Oid relid; /* hash key, must be first */
+	TriggerDesc *trigdesc;
+	int ncolumns;
+	FkBatchColumn *columns;
+} FkBatchRelation;
+
+struct FkBatchCheck
+{
+	MemoryContext mcxt;
+	MemoryContext batch_mcxt;
+	HTAB *relations;
+	HTAB *references;
+};
+
+FkBatchCheck *
+ts_fk_batch_check_create(void)
+{
+	MemoryContext mcxt =
+		AllocSetContextCreate(CurrentMemoryContext, "FK batch check", ALLOCSET_DEFAULT_SIZES);
+	FkBatchCheck *check = MemoryContextAllocZero(mcxt, sizeof(FkBatchCheck));
+	HASHCTL relctl = {
+		.keysize = sizeof(Oid),
+		.entrysize = sizeof(FkBatchRelation),
+		.hcxt = mcxt,
+	};
+	HASHCTL refctl = {
+		.keysize = sizeof(FkBatchReferenceId),
+		.entrysize = sizeof(FkBatchReference),
+		.hcxt = mcxt,
+	};
+
+	check->mcxt = mcxt;
+	check->batch_mcxt = AllocSetContextCreate(mcxt, "FK batch", ALLOCSET_DEFAULT_SIZES);
+	check->relations =
+		hash_create("FK batch check relations", 16, &relctl, HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	check->references = hash_create("FK batch check references",
+									16,
+									&refctl,
+									HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	return check;
+}
+
+void
+ts_fk_batch_check_free(FkBatchCheck *check)
+{
+	MemoryContextDelete(check->mcxt);
+}
+
+static char *
+get_operator_qualified_name(Oid opoid)
+{
+	HeapTuple tup = SearchSysCache1(OPEROID, ObjectIdGetDatum(opoid));
+
+	if (!HeapTupleIsValid(tup))
+		elog(ERROR, "cache lookup failed for operator %u", opoid);
+
+	Form_pg_operator op = (Form_pg_operator) GETSTRUCT(tup);
+	char *name = psprintf("OPERATOR(%s.%s)",
+						  quote_identifier(get_namespace_name(op->oprnamespace)),
+						  NameStr(op->oprname));
+	ReleaseSysCache(tup);
+
+	return name;
+}
+
+/*
+ * Get the referenced column for the foreign key, or NULL if the keys of
+ * this type cannot be checked in batches.
+ */
+static FkBatchReference *
+fk_batch_reference_get(FkBatchCheck *check, const FkBatchReferenceId *id)
+{
+	bool found;
+	FkBatchReference *ref = hash_search(check->references, id, HASH_ENTER, &found);
+
+	if (found)
+		return ref->query != NULL ? ref : NULL;
+
+	ref->query = NULL;
+	ref->validated = NULL;
+	get_typlenbyvalalign(id->fktypid, &ref->typlen, &ref->typbyval, &ref->typalign);
+	ref->arraytypid = get_array_type(id->fktypid);
+
+	if (ref->typlen <= 0 || ref->typlen > FK_BATCH_KEY_MAXLEN || !OidIsValid(ref->arraytypid) ||
+		type_is_collatable(id->fktypid))
+		return NULL;
+
+	HeapTuple tup = SearchSysCache1(RELOID, ObjectIdGetDatum(id->confrelid));
+
+	if (!HeapTupleIsValid(tup))
+		elog(ERROR, "cache lookup failed for relation %u", id->confrelid);
+
+	Form_pg_class pkrel = (Form_pg_class) GETSTRUCT(tup);
+	MemoryContext oldmcxt = MemoryContextSwitchTo(check->mcxt);
+
+	/* The same query as the one of RI_FKey_check(), but for an array of keys. */
+	ref->owner = pkrel->relowner;
+	ref->query = psprintf("SELECT 1 FROM %s%s x WHERE x.%s %s ANY ($1) FOR KEY SHARE OF x",
+						  pkrel->relkind == RELKIND_PARTITIONED_TABLE ? "" : "ONLY ",
+						  quote_qualified_identifier(get_namespace_name(pkrel->relnamespace),
+													 NameStr(pkrel->relname)),
+						  quote_identifier(get_attname(id->confrelid, id->confkey, false)),
+						  get_operator_qualified_name(id->eqop));
+
+	HASHCTL ctl = {
+		.keysize = sizeof(FkBatchKey),
+		.entrysize = sizeof(FkBatchKey),
+		.hcxt = check->mcxt,
+	};
+	ref->validated =
+		hash_create("FK batch validated keys", 256, &ctl, HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	MemoryContextSwitchTo(oldmcxt);
+	ReleaseSysCache(tup);
+
+	return ref;
+}
+
+/*
+ * Find the foreign key check triggers of the chunk and the referenced
+ * columns they check.
+ */
+static void
+fk_batch_relation_init(FkBatchCheck *check, FkBatchRelation *rel, Relation chunk_rel,
+					   TriggerDesc *trigdesc)
+{
+	FkBatchColumn *columns = palloc(sizeof(FkBatchColumn) * trigdesc->numtriggers);
+	int ncolumns = 0;
+
+	rel->trigdesc = NULL;
+	rel->ncolumns = 0;
+	rel->columns = NULL;
+
+	for (int i = 0; i < trigdesc->numtriggers; i++)
+	{
+		Trigger *trigger = &trigdesc->triggers[i];
+
+		if (trigger->tgfoid != F_RI_FKEY_CHECK_INS)
+			continue;
+
+		if (trigger->tgenabled == TRIGGER_DISABLED)
+			return;
+
+		HeapTuple tup = SearchSysCache1(CONSTROID, ObjectIdGetDatum(trigger->tgconstraint));
+
+		if (!HeapTupleIsValid(tup))
+			elog(ERROR, "cache lookup failed for constraint %u", trigger->tgconstraint);
+
+		Form_pg_constraint fk = (Form_pg_constraint) GETSTRUCT(tup);
+		int numfks;
+		AttrNumber conkey[INDEX_MAX_KEYS];
+		AttrNumber confkey[INDEX_MAX_KEYS];
+		Oid conpfeqop[INDEX_MAX_KEYS];
+		FkBatchReference *ref = NULL;
+
+		if (fk->contype == CONSTRAINT_FOREIGN && !fk->condeferrable)
+		{
+			DeconstructFkConstraintRow(tup,
+									   &numfks,
+									   conkey,
+									   confkey,
+									   conpfeqop,
+									   NULL,
+									   NULL,
+									   NULL,
+									   NULL);
+
+			if (numfks == 1)
+			{
+				FkBatchReferenceId id;
+
+				/* Zero the padding of the hash key. */
+				memset(&id, 0, sizeof(id));
+				id.confrelid = fk->confrelid;
+				id.confkey = confkey[0];
+				id.eqop = conpfeqop[0];
+				id.fktypid = TupleDescAttr(RelationGetDescr(chunk_rel), conkey[0] - 1)->atttypid;
+				ref = fk_batch_reference_get(check, &id);
+			}
+		}
+
+		ReleaseSysCache(tup);
+
+		if (ref == NULL)
+			return;
+
+		columns[ncolumns].attnum = conkey[0];
+		columns[ncolumns].ref = ref;
+		ncolumns++;
+	}
+
+	if (ncolumns == 0)
+		return;
+
+	/* Copy the triggers without the foreign key check triggers. */
+	TriggerDesc *filtered = CopyTriggerDesc(trigdesc);
+	int ntriggers = 0;
+
+	filtered->trig_insert_after_row = false;
+	for (int i = 0; i < filtered->numtriggers; i++)
+	{
+		Trigger *trigger = &filtered->triggers[i];
+
+		if (trigger->tgfoid == F_RI_FKEY_CHECK_INS)
+			continue;
+
+		if (TRIGGER_TYPE_MATCHES(trigger->tgtype,
+								 TRIGGER_TYPE_ROW,
+								 TRIGGER_TYPE_AFTER,
+								 TRIGGER_TYPE_INSERT))
+			filtered->trig_insert_after_row = true;
+
+		filtered->triggers[ntriggers++] = *trigger;
+	}
+	filtered->numtriggers = ntriggers;
+
+	rel->trigdesc = filtered;
+	rel->ncolumns = ncolumns;
+	rel->columns = columns;
+}
+
+static void
+fk_batch_key_make(const FkBatchReference *ref, Datum value, FkBatchKey *key)
+{
+	memset(key, 0, sizeof(FkBatchKey));
+
+	if (ref->typbyval)
+		store_att_byval(key->data, value, ref->typlen);
+	else
+		memcpy(key->data, DatumGetPointer(value), ref->typlen);
+}
+
+/*
+ * Lock the referenced rows of all the given keys. Returns true if all of
+ * them were found.
+ *
+ * The query runs as the owner of the referenced table, like the foreign key
+ * check trigger does.
+ */
+static bool
+fk_batch_probe(const FkBatchReference *ref, Datum *values, int nvalues)
+{
+	Oid save_userid;
+	int save_sec_context;
+	Datum array = PointerGetDatum(construct_array(values,
+												  nvalues,
+												  ref->id.fktypid,
+												  ref->typlen,
+												  ref->typbyval,
+												  ref->typalign));
+	Oid argtype = ref->arraytypid;
+
+	GetUserIdAndSecContext(&save_userid, &save_sec_context);
+	SetUserIdAndSecContext(ref->owner,
+						   save_sec_context | SECURITY_LOCAL_USERID_CHANGE |
+							   SECURITY_NOFORCE_RLS);
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "could not connect to SPI");
+
+	int res = SPI_execute_with_args(ref->query, 1, &argtype, &array, NULL, false, 0);
+
+	if (res != SPI_OK_SELECT)
+		elog(ERROR, "could not check foreign key batch: %s", SPI_result_code_string(res));
+
+	uint64 nfound = SPI_processed;
+
+	if (SPI_finish() != SPI_OK_FINISH)
+		elog(ERROR, "could not finish SPI");
+
+	SetUserIdAndSecContext(save_userid, save_sec_context);
+
+	return nfound == (uint64) nvalues;
+}
+
+/*
+ * Check the foreign keys of the given slots, which were just inserted into
+ * the chunk, in one batch.
+ *
+ * Returns the triggers of the chunk without the foreign key check triggers
+ * if the foreign keys of all the slots are valid, so that the caller can use
+ * them to run the after row triggers. Returns NULL if the foreign key check
+ * triggers have to run for the slots.
+ */
+TriggerDesc *
+ts_fk_batch_check_slots(FkBatchCheck *check, ResultRelInfo *rri, TupleTableSlot **slots,
+						int nslots)
+{
+	TriggerDesc *trigdesc = rri->ri_TrigDesc;
+
+	if (trigdesc == NULL || !trigdesc->trig_insert_after_row ||
+		!ts_guc_enable_foreign_key_batch_check ||
+		SessionReplicationRole == SESSION_REPLICATION_ROLE_REPLICA || IsolationUsesXactSnapshot())
+		return NULL;
+
+	Oid relid = RelationGetRelid(rri->ri_RelationDesc);
+	bool found;
+	FkBatchRelation *rel = hash_search(check->relations, &relid, HASH_ENTER, &found);
+
+	if (!found)
+	{
+		MemoryContext oldmcxt = MemoryContextSwitchTo(check->mcxt);
+		fk_batch_relation_init(check, rel, rri->ri_RelationDesc, trigdesc);
+		MemoryContextSwitchTo(oldmcxt);
+	}
+
+	if (rel->trigdesc == NULL)
+		return NULL;
+
+	MemoryContext oldmcxt = MemoryContextSwitchTo(check->batch_mcxt);
+	Datum *values = palloc(sizeof(Datum) * nslots);
+	bool valid = true;
+
+	for (int i = 0; i < rel->ncolumns && valid; i++)
+	{
+		FkBatchReference *ref = rel->columns[i].ref;
+		HASHCTL ctl = {
+			.keysize = sizeof(FkBatchKey),
+			.entrysize = sizeof(FkBatchKey),
+			.hcxt = check->batch_mcxt,
+		};
+		HTAB *batch_keys =
+			hash_create("FK batch keys", nslots, &ctl, HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+		int nvalues = 0;
+
+		for (int j = 0; j < nslots; j++)
+		{
+			bool isnull;
+			Datum value = slot_getattr(slots[j], rel->columns[i].attnum, &isnull);
+			FkBatchKey key;
+
+			/* Rows with a null key are not checked. */
+			if (isnull)
+				continue;
+
+			fk_batch_key_make(ref, value, &key);
+
+			if (hash_search(ref->validated, &key, HASH_FIND, NULL) != NULL)
+				continue;
+
+			hash_search(batch_keys, &key, HASH_ENTER, &found);
+
+			if (!found)
+				values[nvalues++] = value;
+		}
+
+		if (nvalues == 0)
+			continue;
+
+		valid = fk_batch_probe(ref, values, nvalues);
+
+		if (valid && hash_get_num_entries(ref->validated) + nvalues <= FK_BATCH_MAX_VALIDATED_KEYS)
+		{
+			HASH_SEQ_STATUS status;
+			FkBatchKey *key;
+
+			hash_seq_init(&status, batch_keys);
+			while ((key = hash_seq_search(&status)) != NULL)
+				hash_search(ref->validated, key, HASH_ENTER, NULL);
+		}
+	}
+
+	MemoryContextSwitchTo(oldmcxt);
+	MemoryContextReset(check->batch_mcxt);
+
+	return valid ? rel->trigdesc : NULL;
+}
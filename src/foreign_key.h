@@ -6,6 +6,9 @@
 
 #include <postgres.h>
 #include <catalog/pg_constraint.h>
+#include <commands/trigger.h>
+#include <executor/tuptable.h>
+#include <nodes/execnodes.h>
 #include <nodes/parsenodes.h>
 
 #include "chunk.h"
@@ -14,3 +17,10 @@
 
 extern TSDLLEXPORT void ts_fk_propagate(Oid conrelid, Hypertable *ht);
 extern TSDLLEXPORT void ts_chunk_copy_referencing_fk(const Hypertable *ht, const Chunk *chunk);
+
+typedef struct FkBatchCheck FkBatchCheck;
+
+extern FkBatchCheck *ts_fk_batch_check_create(void);
+extern void ts_fk_batch_check_free(FkBatchCheck *check);
+extern TriggerDesc *ts_fk_batch_check_slots(FkBatchCheck *check, ResultRelInfo *rri,
+											TupleTableSlot **slots, int nslots);
@@ -514,6 +514,31 @@ static FuncInfo funcinfo[] = {
 		.group_estimate = date_trunc_group_estimate,
 		.sort_transform = date_trunc_sort_transform,
 	},
+	/* Aggregate functions that have a vectorized implementation. */
+	{
+		.origin = ORIGIN_TIMESCALE,
+		.is_bucketing_func = false,
+		.allowed_in_cagg_definition = false,
+		.funcname = "histogram",
+		.nargs = 4,
+		.arg_types = { FLOAT8OID, FLOAT8OID, FLOAT8OID, INT4OID },
+	},
+	{
+		.origin = ORIGIN_TIMESCALE,
+		.is_bucketing_func = false,
+		.allowed_in_cagg_definition = false,
+		.funcname = "approx_count_distinct",
+		.nargs = 1,
+		.arg_types = { ANYELEMENTOID },
+	},
+	{
+		.origin = ORIGIN_TIMESCALE,
+		.is_bucketing_func = false,
+		.allowed_in_cagg_definition = false,
+		.funcname = "percentile_sketch",
+		.nargs = 1,
+		.arg_types = { FLOAT8OID },
+	},
 };
 
 #define _MAX_CACHE_FUNCTIONS (sizeof(funcinfo) / sizeof(funcinfo[0]))
@@ -6,6 +6,7 @@
 #include <postgres.h>
 #include <miscadmin.h>
 #include <parser/parse_func.h>
+#include <postmaster/bgworker.h>
 #include <utils/guc.h>
 #include <utils/regproc.h>
 #include <utils/varlena.h>
@@ -130,6 +131,7 @@ bool ts_guc_enable_qual_propagation = true;
 bool ts_guc_enable_cagg_reorder_groupby = true;
 bool ts_guc_enable_now_constify = true;
 bool ts_guc_enable_foreign_key_propagation = true;
+bool ts_guc_enable_foreign_key_batch_check = true;
 #if PG16_GE
 TSDLLEXPORT bool ts_guc_enable_cagg_sort_pushdown = true;
 #endif
@@ -145,8 +147,13 @@ TSDLLEXPORT bool ts_guc_enable_compression_wal_markers = false;
 TSDLLEXPORT bool ts_guc_enable_decompression_sorted_merge = true;
 bool ts_guc_enable_chunkwise_aggregation = true;
 bool ts_guc_enable_vectorized_aggregation = true;
+TSDLLEXPORT bool ts_guc_enable_batch_metadata_aggregation = true;
+TSDLLEXPORT bool ts_guc_enable_runtime_join_filter = false;
+TSDLLEXPORT bool ts_guc_enable_decompression_cost_stats = false;
+TSDLLEXPORT bool ts_guc_enable_decompression_stats = false;
 bool ts_guc_enable_custom_hashagg = false;
 TSDLLEXPORT bool ts_guc_enable_compression_indexscan = false;
+TSDLLEXPORT int ts_guc_compress_chunk_parallel_workers = 0;
 TSDLLEXPORT bool ts_guc_enable_bulk_decompression = true;
 TSDLLEXPORT bool ts_guc_auto_sparse_indexes = true;
 TSDLLEXPORT bool ts_guc_default_hypercore_use_access_method = false;
@@ -162,6 +169,14 @@ TSDLLEXPORT bool ts_guc_enable_null_compression = true;
  * disabled, regular sequence scans will be used instead. */
 TSDLLEXPORT bool ts_guc_enable_columnarscan = true;
 TSDLLEXPORT int ts_guc_bgw_log_level = WARNING;
+int ts_guc_bgw_job_pool_size = 0;
+int ts_guc_bgw_job_pool_idle_timeout = 60 * 1000;
+int ts_guc_bgw_max_concurrent_compression_jobs = 0;
+int ts_guc_bgw_max_concurrent_refresh_jobs = 0;
+int ts_guc_bgw_max_concurrent_retention_jobs = 0;
+int ts_guc_bgw_max_concurrent_jobs_per_hypertable = 0;
+int ts_guc_bgw_job_start_jitter = 0;
+double ts_guc_bgw_job_max_load = 0.0;
 TSDLLEXPORT bool ts_guc_enable_skip_scan = true;
 static char *ts_guc_default_segmentby_fn = NULL;
 static char *ts_guc_default_orderby_fn = NULL;
@@ -173,6 +188,7 @@ TSDLLEXPORT char *ts_guc_hypercore_indexam_whitelist;
 TSDLLEXPORT HypercoreCopyToBehavior ts_guc_hypercore_copy_to_behavior =
 	HYPERCORE_COPY_NO_COMPRESSED_DATA;
 TSDLLEXPORT bool ts_guc_enable_hypercore_scankey_pushdown = true;
+TSDLLEXPORT bool ts_guc_enable_hypercore_index_vector_quals = true;
 TSDLLEXPORT int ts_guc_hypercore_arrow_cache_max_entries;
 
 /* default value of ts_guc_max_open_chunks_per_insert and
@@ -565,6 +581,18 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomBoolVariable(MAKE_EXTOPTION("enable_foreign_key_batch_check"),
+							 "Enable batched foreign key checks",
+							 "Check the foreign keys of the rows copied into a chunk with one "
+							 "lookup per batch of rows instead of one lookup per row",
+							 &ts_guc_enable_foreign_key_batch_check,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
 	DefineCustomBoolVariable(MAKE_EXTOPTION("enable_qual_propagation"),
 							 "Enable qualifier propagation",
 							 "Enable propagation of qualifiers in JOINs",
@@ -855,6 +883,59 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomBoolVariable(MAKE_EXTOPTION("enable_batch_metadata_aggregation"),
+							 "Enable aggregation using compressed batch metadata",
+							 "Compute count(*), min() and max() from the compressed batch "
+							 "metadata without decompressing the batches, when the batch "
+							 "metadata shows that all rows of the batch pass the filters",
+							 &ts_guc_enable_batch_metadata_aggregation,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable(MAKE_EXTOPTION("enable_runtime_join_filter"),
+							 "Enable runtime join filters",
+							 "Build filters on the join keys from the inner side of a hash "
+							 "join and use them to skip the compressed batches and rows of "
+							 "the outer side that cannot have a match",
+							 &ts_guc_enable_runtime_join_filter,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable(MAKE_EXTOPTION("enable_decompression_cost_stats"),
+							 "Enable decompression cost statistics",
+							 "Use the statistics gathered by ANALYZE on the compressed chunks "
+							 "to estimate the number of rows per batch and the cost of "
+							 "decompression, and show the estimates with the EXPLAIN option "
+							 "decompress_stats",
+							 &ts_guc_enable_decompression_cost_stats,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable(MAKE_EXTOPTION("enable_decompression_stats"),
+							 "Enable decompression runtime statistics",
+							 "Collect the timing of the compressed batch processing phases and "
+							 "the per-algorithm decompression statistics for the "
+							 "timescaledb_information.session_decompression_stats view",
+							 &ts_guc_enable_decompression_stats,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
 	DefineCustomBoolVariable(MAKE_EXTOPTION("enable_compression_indexscan"),
 							 "Enable compression to take indexscan path",
 							 "Enable indexscan during compression, if matching index is found",
@@ -866,6 +947,24 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomIntVariable(MAKE_EXTOPTION("compress_chunk_parallel_workers"),
+							"Number of parallel workers used to compress a chunk",
+							"Compress the segmentby partitions of a chunk in parallel workers "
+							"when the chunk has segmentby columns. The chunk is read once and "
+							"its rows are sent to the workers, and the compressed data is "
+							"buffered, spilling to disk above work_mem, until it is inserted "
+							"after the workers are done. Zero disables parallel compression. "
+							"Limited by max_parallel_maintenance_workers.",
+							&ts_guc_compress_chunk_parallel_workers,
+							0,
+							0,
+							MAX_PARALLEL_WORKER_LIMIT,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
 	DefineCustomBoolVariable(MAKE_EXTOPTION("enable_bulk_decompression"),
 							 "Enable decompression of the entire compressed batches",
 							 "Increases throughput of decompression, but might increase query "
@@ -1051,6 +1150,120 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomIntVariable(MAKE_EXTOPTION("bgw_job_pool_size"),
+							"Number of pooled job workers per database",
+							"Run jobs in long-lived background workers that execute jobs one "
+							"after another instead of starting a new background worker for "
+							"each job execution. Zero disables the job pool.",
+							&ts_guc_bgw_job_pool_size,
+							0,
+							0,
+							1000, /* bounded by timescaledb.max_background_workers */
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(MAKE_EXTOPTION("bgw_job_pool_idle_timeout"),
+							"Idle time before a pooled job worker exits",
+							"Pooled job workers that have not run a job for this long exit to "
+							"release their background worker slot.",
+							&ts_guc_bgw_job_pool_idle_timeout,
+							60 * 1000,
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_UNIT_MS,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(MAKE_EXTOPTION("bgw_max_concurrent_compression_jobs"),
+							"Maximum number of concurrent compression jobs",
+							"Compression policy jobs that are due to start are held back while "
+							"this many are running. Zero means no limit.",
+							&ts_guc_bgw_max_concurrent_compression_jobs,
+							0,
+							0,
+							1000,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(MAKE_EXTOPTION("bgw_max_concurrent_refresh_jobs"),
+							"Maximum number of concurrent refresh jobs",
+							"Continuous aggregate refresh policy jobs that are due to start are "
+							"held back while this many are running. Zero means no limit.",
+							&ts_guc_bgw_max_concurrent_refresh_jobs,
+							0,
+							0,
+							1000,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(MAKE_EXTOPTION("bgw_max_concurrent_retention_jobs"),
+							"Maximum number of concurrent retention jobs",
+							"Retention policy jobs that are due to start are held back while "
+							"this many are running. Zero means no limit.",
+							&ts_guc_bgw_max_concurrent_retention_jobs,
+							0,
+							0,
+							1000,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(MAKE_EXTOPTION("bgw_max_concurrent_jobs_per_hypertable"),
+							"Maximum number of concurrent jobs per hypertable",
+							"Jobs that are due to start are held back while this many jobs on "
+							"the same hypertable are running. Zero means no limit.",
+							&ts_guc_bgw_max_concurrent_jobs_per_hypertable,
+							0,
+							0,
+							1000,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(MAKE_EXTOPTION("bgw_job_start_jitter"),
+							"Maximum random delay added to job start times",
+							"Spread out the start of jobs that share a schedule by delaying "
+							"each start by a random amount of time up to this value.",
+							&ts_guc_bgw_job_start_jitter,
+							0,
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_UNIT_MS,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomRealVariable(MAKE_EXTOPTION("bgw_job_max_load"),
+							 "System load above which policy jobs are held back",
+							 "Compression, refresh and retention policy jobs that are due to "
+							 "start are held back while the system load average per CPU is "
+							 "above this value. Zero disables the check.",
+							 &ts_guc_bgw_job_max_load,
+							 0.0,
+							 0.0,
+							 1000.0,
+							 PGC_SIGHUP,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
 	/* this information is useful in general on customer deployments */
 	DefineCustomBoolVariable(/* name= */ MAKE_EXTOPTION("debug_compression_path_info"),
 							 /* short_desc= */ "show various compression-related debug info",
@@ -1128,6 +1341,21 @@ _guc_init(void)
 							 /* assign_hook= */ NULL,
 							 /* show_hook= */ NULL);
 
+	DefineCustomBoolVariable(/* name= */ MAKE_EXTOPTION("enable_hypercore_index_vector_quals"),
+							 /* short_desc= */
+							 "Filter rows with vectorized quals in Hypercore index scans",
+							 /* long_desc= */
+							 "Enabling this setting evaluates the vectorizable quals of an "
+							 "index scan once per compressed segment, so that only the rows "
+							 "that pass them are returned to the index scan.",
+							 /* valueAddr= */ &ts_guc_enable_hypercore_index_vector_quals,
+							 /* bootValue= */ true,
+							 /* context= */ PGC_USERSET,
+							 /* flags= */ 0,
+							 /* check_hook= */ NULL,
+							 /* assign_hook= */ NULL,
+							 /* show_hook= */ NULL);
+
 	DefineCustomIntVariable(/* name= */ MAKE_EXTOPTION("hypercore_arrow_cache_max_entries"),
 							/* short_desc= */ "max number of entries in arrow data cache",
 							/* long_desc= */
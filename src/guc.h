@@ -44,6 +44,7 @@ extern bool ts_guc_enable_cagg_reorder_groupby;
 extern TSDLLEXPORT int ts_guc_cagg_max_individual_materializations;
 extern bool ts_guc_enable_now_constify;
 extern bool ts_guc_enable_foreign_key_propagation;
+extern bool ts_guc_enable_foreign_key_batch_check;
 extern TSDLLEXPORT bool ts_guc_enable_osm_reads;
 #if PG16_GE
 extern TSDLLEXPORT bool ts_guc_enable_cagg_sort_pushdown;
@@ -59,6 +60,10 @@ extern TSDLLEXPORT bool ts_guc_enable_decompression_sorted_merge;
 extern TSDLLEXPORT bool ts_guc_enable_skip_scan;
 extern TSDLLEXPORT bool ts_guc_enable_chunkwise_aggregation;
 extern TSDLLEXPORT bool ts_guc_enable_vectorized_aggregation;
+extern TSDLLEXPORT bool ts_guc_enable_batch_metadata_aggregation;
+extern TSDLLEXPORT bool ts_guc_enable_runtime_join_filter;
+extern TSDLLEXPORT bool ts_guc_enable_decompression_cost_stats;
+extern TSDLLEXPORT bool ts_guc_enable_decompression_stats;
 extern TSDLLEXPORT bool ts_guc_enable_custom_hashagg;
 extern bool ts_guc_restoring;
 extern int ts_guc_max_open_chunks_per_insert;
@@ -92,10 +97,19 @@ extern char *ts_last_tune_time;
 extern char *ts_last_tune_version;
 extern TSDLLEXPORT bool ts_guc_enable_2pc;
 extern TSDLLEXPORT bool ts_guc_enable_compression_indexscan;
+extern TSDLLEXPORT int ts_guc_compress_chunk_parallel_workers;
 extern TSDLLEXPORT bool ts_guc_enable_bulk_decompression;
 extern TSDLLEXPORT bool ts_guc_auto_sparse_indexes;
 extern TSDLLEXPORT bool ts_guc_enable_columnarscan;
 extern TSDLLEXPORT int ts_guc_bgw_log_level;
+extern int ts_guc_bgw_job_pool_size;
+extern int ts_guc_bgw_job_pool_idle_timeout;
+extern int ts_guc_bgw_max_concurrent_compression_jobs;
+extern int ts_guc_bgw_max_concurrent_refresh_jobs;
+extern int ts_guc_bgw_max_concurrent_retention_jobs;
+extern int ts_guc_bgw_max_concurrent_jobs_per_hypertable;
+extern int ts_guc_bgw_job_start_jitter;
+extern double ts_guc_bgw_job_max_load;
 
 /*
  * Exit code to use when scheduler exits.
@@ -154,6 +168,7 @@ typedef enum HypercoreCopyToBehavior
 
 extern TSDLLEXPORT HypercoreCopyToBehavior ts_guc_hypercore_copy_to_behavior;
 extern TSDLLEXPORT bool ts_guc_enable_hypercore_scankey_pushdown;
+extern TSDLLEXPORT bool ts_guc_enable_hypercore_index_vector_quals;
 extern TSDLLEXPORT int ts_guc_hypercore_arrow_cache_max_entries;
 
 void _guc_init(void);
@@ -30,8 +30,10 @@
 #include <executor/spi.h>
 #include <miscadmin.h>
 #include <nodes/makefuncs.h>
+#include <nodes/nodeFuncs.h>
 #include <nodes/nodes.h>
 #include <nodes/parsenodes.h>
+#include <optimizer/optimizer.h>
 #include <parser/parse_expr.h>
 #include <parser/parse_relation.h>
 #include <parser/parse_type.h>
@@ -56,6 +58,7 @@
 #include "annotations.h"
 #include "chunk.h"
 #include "chunk_index.h"
+#include "chunk_index_parallel.h"
 #include "compression_with_clause.h"
 #include "copy.h"
 #include "cross_module_fn.h"
@@ -426,39 +429,89 @@ add_hypertable_to_process_args(ProcessUtilityArgs *args, const Hypertable *ht)
 	args->hypertable_list = lappend_oid(args->hypertable_list, ht->main_table_relid);
 }
 
-static bool
-check_table_in_rangevar_list(List *rvlist, Name schema_name, Name table_name)
+/*
+ * The set of relations in the object list of a GRANT/REVOKE statement.
+ *
+ * A GRANT on a hypertable is applied to all its chunks by adding them to the
+ * object list of the statement, so that the chunks are processed in the same
+ * command as the hypertable. With many chunks, looking for duplicates in the
+ * list would be quadratic, so the names are also kept in a hash table.
+ */
+typedef struct GrantObjectKey
 {
-	ListCell *l;
+	NameData schema_name;
+	NameData table_name;
+} GrantObjectKey;
 
-	foreach (l, rvlist)
+typedef struct GrantObjects
+{
+	GrantStmt *stmt;
+	HTAB *names;
+} GrantObjects;
+
+static void
+grant_objects_init(GrantObjects *objects, GrantStmt *stmt)
+{
+	HASHCTL hctl = {
+		.keysize = sizeof(GrantObjectKey),
+		.entrysize = sizeof(GrantObjectKey),
+		.hcxt = CurrentMemoryContext,
+	};
+	ListCell *lc;
+
+	objects->stmt = stmt;
+	objects->names = hash_create("GRANT objects",
+								 Max(list_length(stmt->objects), 64),
+								 &hctl,
+								 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	foreach (lc, stmt->objects)
 	{
-		RangeVar *rvar = lfirst_node(RangeVar, l);
+		RangeVar *rv = lfirst_node(RangeVar, lc);
+		GrantObjectKey key;
 
-		if (strcmp(rvar->relname, NameStr(*table_name)) == 0 &&
-			strcmp(rvar->schemaname, NameStr(*schema_name)) == 0)
-			return true;
+		/* Unqualified names never match the names we add */
+		if (rv->schemaname == NULL)
+			continue;
+
+		memset(&key, 0, sizeof(key));
+		namestrcpy(&key.schema_name, rv->schemaname);
+		namestrcpy(&key.table_name, rv->relname);
+		hash_search(objects->names, &key, HASH_ENTER, NULL);
 	}
+}
+
+/*
+ * Add a relation to the GRANT/REVOKE statement unless it is already in
+ * it. For example, the chunks of a hypertable are already in the list in the
+ * case of "GRANT ALL IN SCHEMA" when they are in the same schema as the
+ * hypertable.
+ */
+static void
+grant_objects_add(GrantObjects *objects, const char *schema_name, const char *table_name)
+{
+	GrantObjectKey key;
+	bool found;
 
-	return false;
+	memset(&key, 0, sizeof(key));
+	namestrcpy(&key.schema_name, schema_name);
+	namestrcpy(&key.table_name, table_name);
+	hash_search(objects->names, &key, HASH_ENTER, &found);
+
+	if (!found)
+		objects->stmt->objects =
+			lappend(objects->stmt->objects,
+					makeRangeVar(pstrdup(schema_name), pstrdup(table_name), -1));
 }
 
 static void
-add_chunk_oid(Hypertable *ht, Oid chunk_relid, void *vargs)
+add_chunk_oid(Hypertable *ht, Oid chunk_relid, void *arg)
 {
-	ProcessUtilityArgs *args = vargs;
-	GrantStmt *stmt = castNode(GrantStmt, args->parsetree);
-	Chunk *chunk = ts_chunk_get_by_relid(chunk_relid, true);
-	/*
-	 * If chunk is in the same schema as the hypertable it could already be part of
-	 * the objects list in the case of "GRANT ALL IN SCHEMA" for example
-	 */
-	if (!check_table_in_rangevar_list(stmt->objects, &chunk->fd.schema_name, &chunk->fd.table_name))
-	{
-		RangeVar *rv =
-			makeRangeVar(NameStr(chunk->fd.schema_name), NameStr(chunk->fd.table_name), -1);
-		stmt->objects = lappend(stmt->objects, rv);
-	}
+	GrantObjects *objects = arg;
+
+	grant_objects_add(objects,
+					  get_namespace_name(get_rel_namespace(chunk_relid)),
+					  get_rel_name(chunk_relid));
 }
 
 static void
@@ -1632,25 +1685,6 @@ process_grant_add_by_rel(GrantStmt *stmt, RangeVar *relation)
 	stmt->objects = lappend(stmt->objects, relation);
 }
 
-/*
- * If it is a "GRANT/REVOKE ON ALL TABLES IN SCHEMA" operation then we need to check if
- * the rangevar was already added when we added all objects inside the SCHEMA
- *
- * This could get a little expensive for schemas containing a lot of objects..
- */
-static void
-process_grant_add_by_name(GrantStmt *stmt, bool was_schema_op, Name schema_name, Name table_name)
-{
-	bool already_added = false;
-
-	if (was_schema_op)
-		already_added = check_table_in_rangevar_list(stmt->objects, schema_name, table_name);
-
-	if (!already_added)
-		process_grant_add_by_rel(stmt,
-								 makeRangeVar(NameStr(*schema_name), NameStr(*table_name), -1));
-}
-
 static void
 process_relations_in_namespace(GrantStmt *stmt, Name schema_name, Oid namespaceId, char relkind)
 {
@@ -1675,11 +1709,10 @@ process_relations_in_namespace(GrantStmt *stmt, Name schema_name, Oid namespaceI
 
 	while ((tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
 	{
-		Name relname = palloc(NAMEDATALEN);
-		namestrcpy(relname, NameStr(((Form_pg_class) GETSTRUCT(tuple))->relname));
+		char *relname = pstrdup(NameStr(((Form_pg_class) GETSTRUCT(tuple))->relname));
 
 		/* these are being added for the first time into this list */
-		process_grant_add_by_name(stmt, false, schema_name, relname);
+		process_grant_add_by_rel(stmt, makeRangeVar(NameStr(*schema_name), relname, -1));
 	}
 
 	table_endscan(scan);
@@ -1768,6 +1801,8 @@ process_grant_and_revoke(ProcessUtilityArgs *args)
 				ListCell *cell;
 				List *saved_schema_objects = NIL;
 				bool was_schema_op = false;
+				GrantObjects objects;
+				int nobjects;
 
 				/*
 				 * If it's a GRANT/REVOKE ALL IN SCHEMA then we need to collect all
@@ -1781,6 +1816,8 @@ process_grant_and_revoke(ProcessUtilityArgs *args)
 					was_schema_op = true;
 				}
 
+				grant_objects_init(&objects, stmt);
+
 				hcache = ts_hypertable_cache_pin();
 				/* First process all continuous aggregates in the list and add
 				 * the associated hypertables and views to the list of objects
@@ -1793,24 +1830,21 @@ process_grant_and_revoke(ProcessUtilityArgs *args)
 					{
 						Hypertable *mat_hypertable =
 							ts_hypertable_get_by_id(cagg->data.mat_hypertable_id);
-						process_grant_add_by_name(stmt,
-												  was_schema_op,
-												  &mat_hypertable->fd.schema_name,
-												  &mat_hypertable->fd.table_name);
-						process_grant_add_by_name(stmt,
-												  was_schema_op,
-												  &cagg->data.direct_view_schema,
-												  &cagg->data.direct_view_name);
-						process_grant_add_by_name(stmt,
-												  was_schema_op,
-												  &cagg->data.partial_view_schema,
-												  &cagg->data.partial_view_name);
+						grant_objects_add(&objects,
+										  NameStr(mat_hypertable->fd.schema_name),
+										  NameStr(mat_hypertable->fd.table_name));
+						grant_objects_add(&objects,
+										  NameStr(cagg->data.direct_view_schema),
+										  NameStr(cagg->data.direct_view_name));
+						grant_objects_add(&objects,
+										  NameStr(cagg->data.partial_view_schema),
+										  NameStr(cagg->data.partial_view_name));
 					}
 
 					/*
 					 * If this is a hypertable and it has a compressed
 					 * hypertable associated with it, add it to the list of
-					 * hypertables to process.
+					 * hypertables to process. Its chunks are added below.
 					 */
 					Hypertable *hypertable = ts_hypertable_cache_get_entry_rv(hcache, relation);
 					if (hypertable && TS_HYPERTABLE_HAS_COMPRESSION_TABLE(hypertable))
@@ -1818,37 +1852,31 @@ process_grant_and_revoke(ProcessUtilityArgs *args)
 						Hypertable *compressed_hypertable =
 							ts_hypertable_get_by_id(hypertable->fd.compressed_hypertable_id);
 						Assert(compressed_hypertable);
-						process_grant_add_by_name(stmt,
-												  was_schema_op,
-												  &compressed_hypertable->fd.schema_name,
-												  &compressed_hypertable->fd.table_name);
-						List *chunks =
-							ts_chunk_get_by_hypertable_id(hypertable->fd.compressed_hypertable_id);
-						ListCell *cell;
-						foreach (cell, chunks)
-						{
-							Chunk *chunk = lfirst(cell);
-							process_grant_add_by_name(stmt,
-													  was_schema_op,
-													  &chunk->fd.schema_name,
-													  &chunk->fd.table_name);
-						}
+						grant_objects_add(&objects,
+										  NameStr(compressed_hypertable->fd.schema_name),
+										  NameStr(compressed_hypertable->fd.table_name));
 					}
 				}
 
-				/* Process all hypertables, including those added in the loop above */
-				foreach (cell, stmt->objects)
+				/*
+				 * Process all hypertables, including those added in the loop
+				 * above, but not the chunks added here, which cannot be
+				 * hypertables.
+				 */
+				nobjects = list_length(stmt->objects);
+				for (int i = 0; i < nobjects; i++)
 				{
-					RangeVar *relation = lfirst_node(RangeVar, cell);
+					RangeVar *relation = list_nth_node(RangeVar, stmt->objects, i);
 					Hypertable *ht = ts_hypertable_cache_get_entry_rv(hcache, relation);
 
 					if (ht)
 					{
 						add_hypertable_to_process_args(args, ht);
-						foreach_chunk(ht, add_chunk_oid, args);
+						foreach_chunk(ht, add_chunk_oid, &objects);
 					}
 				}
 
+				hash_destroy(objects.names);
 				ts_cache_release(hcache);
 
 				result = DDL_DONE;
@@ -2489,31 +2517,34 @@ process_rename(ProcessUtilityArgs *args)
 static void
 process_altertable_change_owner_chunk(Hypertable *ht, Oid chunk_relid, void *arg)
 {
-	AlterTableCmd *cmd = arg;
-	Oid roleid = get_rolespec_oid(cmd->newowner, false);
+	Oid *roleid = arg;
 
-	ATExecChangeOwner(chunk_relid, roleid, false, AccessExclusiveLock);
+	ATExecChangeOwner(chunk_relid, *roleid, false, AccessExclusiveLock);
 }
 
+/*
+ * Change the owner of all chunks of the hypertable, and of its compressed
+ * hypertable and chunks.
+ *
+ * The chunks get the new owner directly instead of through an ALTER TABLE
+ * per chunk. The compressed chunks are chunks of the compressed hypertable,
+ * so they are handled by the recursive call.
+ */
 static void
 process_altertable_change_owner(Hypertable *ht, AlterTableCmd *cmd)
 {
+	Oid roleid;
+
 	Assert(IsA(cmd->newowner, RoleSpec));
 
-	foreach_chunk(ht, process_altertable_change_owner_chunk, cmd);
+	roleid = get_rolespec_oid(cmd->newowner, false);
+	foreach_chunk(ht, process_altertable_change_owner_chunk, &roleid);
 
 	if (TS_HYPERTABLE_HAS_COMPRESSION_TABLE(ht))
 	{
 		Hypertable *compressed_hypertable =
 			ts_hypertable_get_by_id(ht->fd.compressed_hypertable_id);
 		AlterTableInternal(compressed_hypertable->main_table_relid, list_make1(cmd), false);
-		ListCell *lc;
-		List *chunks = ts_chunk_get_by_hypertable_id(ht->fd.compressed_hypertable_id);
-		foreach (lc, chunks)
-		{
-			Chunk *chunk = lfirst(lc);
-			AlterTableInternal(chunk->table_id, list_make1(cmd), false);
-		}
 		process_altertable_change_owner(compressed_hypertable, cmd);
 	}
 }
@@ -2992,6 +3023,11 @@ typedef struct HypertableIndexOptions
 	 * transaction for all the chunks
 	 */
 	bool multitransaction;
+	/*
+	 * number of background workers to create the chunk indexes with when
+	 * using one transaction per chunk, 0 to create them in this session
+	 */
+	int parallel_workers;
 	int n_ht_atts;
 
 	/* Concurrency testing options. */
@@ -3014,6 +3050,7 @@ typedef struct CreateIndexInfo
 {
 	IndexStmt *stmt;
 	ObjectAddress obj;
+	int32 hypertable_id;
 	Oid main_table_relid;
 	HypertableIndexOptions extended_options;
 	MemoryContext mctx;
@@ -3083,9 +3120,6 @@ process_index_chunk_multitransaction(int32 hypertable_id, Oid chunk_relid, void
 	CreateIndexInfo *info = (CreateIndexInfo *) arg;
 	CatalogSecurityContext sec_ctx;
 	Chunk *chunk;
-	Relation hypertable_index_rel;
-	Relation chunk_rel;
-	IndexInfo *indexinfo;
 
 	Assert(info->extended_options.multitransaction);
 
@@ -3136,43 +3170,18 @@ process_index_chunk_multitransaction(int32 hypertable_id, Oid chunk_relid, void
 	 * there is a potential issue if the id gets reassigned between one
 	 * sub-transaction and the next. CLUSTER has a similar issue.
 	 *
-	 * We grab a ShareLock on the chunk, because that's what CREATE INDEX
-	 * does. For the hypertable's index, we are ok using the weaker
-	 * AccessShareLock, since we only need to prevent the index itself from
-	 * being ALTERed or DROPped during this part of index creation.
-	 */
-	chunk_rel = table_open(chunk_relid, ShareLock);
-	chunk = ts_chunk_get_by_relid(chunk_relid, true);
-
-	/*
 	 * Validation happens when creating the hypertable's index, which goes
 	 * through the usual DefineIndex mechanism.
 	 */
-	if (!IS_OSM_CHUNK(chunk)) /*cannot create index on foreign OSM chunk */
-	{
-		hypertable_index_rel = index_open(info->obj.objectId, AccessShareLock);
-		indexinfo = BuildIndexInfo(hypertable_index_rel);
-		if (chunk_index_columns_changed(info->extended_options.n_ht_atts,
-										RelationGetDescr(chunk_rel)))
-			ts_adjust_indexinfo_attnos(indexinfo, info->main_table_relid, chunk_rel);
-
-		ts_chunk_index_create_from_adjusted_index_info(hypertable_id,
-													   hypertable_index_rel,
-													   chunk->fd.id,
-													   chunk_rel,
-													   indexinfo);
-
-		index_close(hypertable_index_rel, NoLock);
-	}
-	else
-	{
-		ereport(NOTICE, (errmsg("skipping index creation for tiered data")));
-	}
+	ts_chunk_index_create_if_missing(hypertable_id,
+									 info->main_table_relid,
+									 info->extended_options.n_ht_atts,
+									 info->obj.objectId,
+									 chunk_relid);
 
+	chunk = ts_chunk_get_by_relid(chunk_relid, true);
 	validate_index_constraints(chunk, info->stmt);
 
-	table_close(chunk_rel, NoLock);
-
 	ts_catalog_restore_user(&sec_ctx);
 
 	PopActiveSnapshot();
@@ -3182,6 +3191,7 @@ process_index_chunk_multitransaction(int32 hypertable_id, Oid chunk_relid, void
 typedef enum HypertableIndexFlags
 {
 	HypertableIndexFlagMultiTransaction = 0,
+	HypertableIndexFlagParallelWorkers,
 #ifdef DEBUG
 	HypertableIndexFlagBarrierTable,
 	HypertableIndexFlagMaxChunks,
@@ -3190,12 +3200,130 @@ typedef enum HypertableIndexFlags
 
 static const WithClauseDefinition index_with_clauses[] = {
 	[HypertableIndexFlagMultiTransaction] = {.arg_names = {"transaction_per_chunk", NULL}, .type_id = BOOLOID,},
+	[HypertableIndexFlagParallelWorkers] = {.arg_names = {"parallel_workers", NULL}, .type_id = INT4OID, .default_val = (Datum)0},
 #ifdef DEBUG
 	[HypertableIndexFlagBarrierTable] = {.arg_names = {"barrier_table", NULL}, .type_id = REGCLASSOID,},
 	[HypertableIndexFlagMaxChunks] = {.arg_names = {"max_chunks", NULL}, .type_id = INT4OID, .default_val = (Datum)-1},
 #endif
 };
 
+/*
+ * Check that an existing index has the definition given in the (transformed)
+ * IndexStmt: the same access method, uniqueness, key and included columns,
+ * expressions and predicate.
+ *
+ * The expressions and predicate are normalized the same way as the relcache
+ * does for the stored ones, so that they can be compared with equal().
+ */
+static bool
+index_matches_stmt(Relation indexrel, const IndexStmt *stmt, Oid relid)
+{
+	Form_pg_index index = indexrel->rd_index;
+	char *amname = get_am_name(indexrel->rd_rel->relam);
+	List *params = list_concat_copy(stmt->indexParams, stmt->indexIncludingParams);
+	List *exprs = RelationGetIndexExpressions(indexrel);
+	ListCell *expr_lc = list_head(exprs);
+	List *predicate = NIL;
+	ListCell *lc;
+	int i = 0;
+
+	if (amname == NULL || strcmp(amname, stmt->accessMethod) != 0 ||
+		index->indisunique != stmt->unique ||
+		index->indnkeyatts != list_length(stmt->indexParams) ||
+		index->indnatts != list_length(params))
+		return false;
+
+	foreach (lc, params)
+	{
+		IndexElem *elem = lfirst_node(IndexElem, lc);
+		AttrNumber attno = index->indkey.values[i++];
+		Node *expr = elem->expr;
+
+		if (elem->name != NULL)
+		{
+			if (get_attnum(relid, elem->name) != attno)
+				return false;
+			continue;
+		}
+
+		/* A parenthesized column is stored as a plain column */
+		if (IsA(expr, Var) && castNode(Var, expr)->varattno != InvalidAttrNumber)
+		{
+			if (castNode(Var, expr)->varattno != attno)
+				return false;
+			continue;
+		}
+
+		if (attno != InvalidAttrNumber || expr_lc == NULL)
+			return false;
+
+		expr = eval_const_expressions(NULL, expr);
+		fix_opfuncids(expr);
+
+		if (!equal(expr, lfirst(expr_lc)))
+			return false;
+
+		expr_lc = lnext(exprs, expr_lc);
+	}
+
+	if (stmt->whereClause != NULL)
+	{
+		Node *where = eval_const_expressions(NULL, stmt->whereClause);
+
+		where = (Node *) canonicalize_qual((Expr *) where, false);
+		predicate = make_ands_implicit((Expr *) where);
+		fix_opfuncids((Node *) predicate);
+	}
+
+	return equal(predicate, RelationGetIndexPredicate(indexrel));
+}
+
+/*
+ * Find the index of an interrupted CREATE INDEX that should be resumed.
+ *
+ * If CREATE INDEX with one transaction per chunk is interrupted, the
+ * hypertable index is left invalid and only some of the chunks have the
+ * index. Running the same CREATE INDEX IF NOT EXISTS again resumes the index
+ * creation on the remaining chunks, instead of skipping it because the index
+ * already exists. Resuming with a different index definition would leave
+ * chunk indexes that don't match the hypertable index, so that is an error.
+ */
+static Oid
+get_interrupted_index(const IndexStmt *stmt, const Hypertable *ht, bool multitransaction,
+					  const char *query_string)
+{
+	Oid indexrelid;
+	IndexStmt *transformed;
+	Relation indexrel;
+	bool matches;
+
+	if (!multitransaction || !stmt->if_not_exists || stmt->idxname == NULL)
+		return InvalidOid;
+
+	indexrelid = get_relname_relid(stmt->idxname, get_rel_namespace(ht->main_table_relid));
+
+	if (!OidIsValid(indexrelid) || get_rel_relkind(indexrelid) != RELKIND_INDEX ||
+		IndexGetRelation(indexrelid, false) != ht->main_table_relid || get_index_isvalid(indexrelid))
+		return InvalidOid;
+
+	/* Take the lock that creating the index would take before parse analysis */
+	LockRelationOid(ht->main_table_relid, ShareLock);
+	transformed = transformIndexStmt(ht->main_table_relid, (IndexStmt *) stmt, query_string);
+
+	indexrel = index_open(indexrelid, AccessShareLock);
+	matches = index_matches_stmt(indexrel, transformed, ht->main_table_relid);
+	index_close(indexrel, AccessShareLock);
+
+	if (!matches)
+		ereport(ERROR,
+				(errcode(ERRCODE_DUPLICATE_TABLE),
+				 errmsg("invalid index \"%s\" has a different definition", stmt->idxname),
+				 errhint("Drop the index or create it with the same definition to resume the "
+						 "interrupted index creation.")));
+
+	return indexrelid;
+}
+
 static bool
 multitransaction_create_index_mark_valid(CreateIndexInfo info)
 {
@@ -3305,6 +3433,8 @@ process_index_start(ProcessUtilityArgs *args)
 
 	info.extended_options.multitransaction =
 		DatumGetBool(parsed_with_clauses[HypertableIndexFlagMultiTransaction].parsed);
+	info.extended_options.parallel_workers =
+		DatumGetInt32(parsed_with_clauses[HypertableIndexFlagParallelWorkers].parsed);
 #ifdef DEBUG
 	info.extended_options.max_chunks =
 		DatumGetInt32(parsed_with_clauses[HypertableIndexFlagMaxChunks].parsed);
@@ -3326,6 +3456,30 @@ process_index_start(ProcessUtilityArgs *args)
 				 errmsg(
 					 "cannot use timescaledb.transaction_per_chunk with UNIQUE or PRIMARY KEY")));
 
+	if (info.extended_options.parallel_workers < 0 ||
+		info.extended_options.parallel_workers > max_worker_processes)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid number of parallel workers: %d",
+						info.extended_options.parallel_workers),
+				 errhint("Use a value between 0 and \"max_worker_processes\".")));
+
+	if (info.extended_options.parallel_workers > 0 && !info.extended_options.multitransaction)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot use timescaledb.parallel_workers without "
+						"timescaledb.transaction_per_chunk")));
+
+#ifdef DEBUG
+	/* The parallel build does not stop early, so the debug options would be ignored */
+	if (info.extended_options.parallel_workers > 0 &&
+		(info.extended_options.max_chunks >= 0 || OidIsValid(info.extended_options.barrier_table)))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot use timescaledb.max_chunks or timescaledb.barrier_table with "
+						"timescaledb.parallel_workers")));
+#endif
+
 	ts_indexing_verify_index(ht->space, stmt);
 
 	if (info.extended_options.multitransaction)
@@ -3344,10 +3498,26 @@ process_index_start(ProcessUtilityArgs *args)
 		SWITCH_TO_TS_USER(NameStr(cagg->data.direct_view_schema), uid, saved_uid, sec_ctx);
 	}
 
-	/* CREATE INDEX on the root table of the hypertable */
-	root_table_index = ts_indexing_root_table_create_index(stmt,
-														   args->query_string,
-														   info.extended_options.multitransaction);
+	/*
+	 * CREATE INDEX on the root table of the hypertable, unless we are
+	 * resuming an interrupted index creation.
+	 */
+	ObjectAddressSet(root_table_index,
+					 RelationRelationId,
+					 get_interrupted_index(stmt,
+										   ht,
+										   info.extended_options.multitransaction,
+										   args->query_string));
+
+	if (OidIsValid(root_table_index.objectId))
+		ereport(NOTICE,
+				(errmsg("resuming creation of index \"%s\" on chunks without it",
+						stmt->idxname)));
+	else
+		root_table_index =
+			ts_indexing_root_table_create_index(stmt,
+												args->query_string,
+												info.extended_options.multitransaction);
 
 	if (cagg)
 		RESTORE_USER(uid, saved_uid, sec_ctx);
@@ -3378,6 +3548,7 @@ process_index_start(ProcessUtilityArgs *args)
 	main_table_index_lock_relid = main_table_index_relation->rd_lockInfo.lockRelId;
 
 	info.extended_options.n_ht_atts = main_table_desc->natts;
+	info.hypertable_id = ht->fd.id;
 	info.main_table_relid = ht->main_table_relid;
 
 	index_close(main_table_index_relation, NoLock);
@@ -3433,10 +3604,18 @@ process_index_start(ProcessUtilityArgs *args)
 	PopActiveSnapshot();
 	CommitTransactionCommand();
 
-	foreach_chunk_multitransaction(info.main_table_relid,
-								   info.mctx,
-								   process_index_chunk_multitransaction,
-								   &info);
+	/* Fall back to creating the chunk indexes in this session if no
+	 * background worker could be started */
+	if (info.extended_options.parallel_workers == 0 ||
+		!ts_chunk_index_create_parallel(info.hypertable_id,
+										info.main_table_relid,
+										info.extended_options.n_ht_atts,
+										info.obj.objectId,
+										info.extended_options.parallel_workers))
+		foreach_chunk_multitransaction(info.main_table_relid,
+									   info.mctx,
+									   process_index_chunk_multitransaction,
+									   &info);
 
 	StartTransactionCommand();
 	MemoryContextSwitchTo(info.mctx);
@@ -13,6 +13,7 @@
 #include <utils/timestamp.h>
 
 #include "time_bucket.h"
+#include "timezones.h"
 #include "utils.h"
 
 #define TIME_BUCKET(period, timestamp, offset, min, max, result)                                   \
@@ -316,6 +317,96 @@ ts_timestamptz_offset_bucket(PG_FUNCTION_ARGS)
 	PG_RETURN_DATUM(timestamp);
 }
 
+/*
+ * The time zone offsets cached in fn_extra for ts_timestamptz_timezone_bucket,
+ * for the time zone name they were created for.
+ */
+typedef struct TimezoneBucketCache
+{
+	text *tzname;
+	TsTimezoneOffsets *offsets;
+} TimezoneBucketCache;
+
+static TsTimezoneOffsets *
+get_timezone_offsets(FunctionCallInfo fcinfo, text *tzname)
+{
+	if (fcinfo->flinfo == NULL)
+		return NULL;
+
+	TimezoneBucketCache *cache = (TimezoneBucketCache *) fcinfo->flinfo->fn_extra;
+	if (cache != NULL && VARSIZE_ANY_EXHDR(cache->tzname) == VARSIZE_ANY_EXHDR(tzname) &&
+		memcmp(VARDATA_ANY(cache->tzname), VARDATA_ANY(tzname), VARSIZE_ANY_EXHDR(tzname)) == 0)
+		return cache->offsets;
+
+	MemoryContext mcxt = fcinfo->flinfo->fn_mcxt;
+	if (cache == NULL)
+	{
+		cache = MemoryContextAllocZero(mcxt, sizeof(TimezoneBucketCache));
+		fcinfo->flinfo->fn_extra = cache;
+	}
+	else
+	{
+		/*
+		 * The time zone name is not a constant, so free the offsets of the
+		 * previous one to not accumulate them over the rows.
+		 */
+		pfree(cache->tzname);
+		if (cache->offsets != NULL)
+			ts_timezone_offsets_destroy(cache->offsets);
+	}
+
+	cache->offsets = ts_timezone_offsets_create(tzname, mcxt);
+	cache->tzname = MemoryContextAlloc(mcxt, VARSIZE_ANY(tzname));
+	memcpy(cache->tzname, tzname, VARSIZE_ANY(tzname));
+
+	return cache->offsets;
+}
+
+/*
+ * Bucket the time stamp in the given time zone using the cached offsets of
+ * the time zone, without going through timestamptz_zone() and
+ * timestamp_zone(). Returns false if the slow path has to be used.
+ */
+static bool
+timezone_bucket_fast(FunctionCallInfo fcinfo, bool have_origin, TimestampTz *result)
+{
+	Interval *interval = PG_GETARG_INTERVAL_P(0);
+	TimestampTz timestamp = PG_GETARG_TIMESTAMPTZ(1);
+	Timestamp origin = DEFAULT_ORIGIN;
+	Timestamp local;
+	Timestamp bucket;
+
+	if (interval->month != 0)
+		return false;
+
+	TsTimezoneOffsets *offsets = get_timezone_offsets(fcinfo, PG_GETARG_TEXT_PP(2));
+	if (offsets == NULL)
+		return false;
+
+	if (TIMESTAMP_NOT_FINITE(timestamp))
+	{
+		*result = timestamp;
+		return true;
+	}
+
+	if (!ts_timezone_offsets_to_local(offsets, timestamp, &local))
+		return false;
+
+	if (have_origin && !ts_timezone_offsets_to_local(offsets, PG_GETARG_TIMESTAMPTZ(3), &origin))
+		return false;
+
+	int64 period = get_interval_period_timestamp_units(interval);
+	TIME_BUCKET_TS(period, local, bucket, origin);
+
+	if (!ts_timezone_offsets_from_local(offsets, bucket, result))
+	{
+		*result = DatumGetTimestampTz(
+			DirectFunctionCall2(timestamp_zone, PG_GETARG_DATUM(2), TimestampGetDatum(bucket)));
+	}
+
+	return true;
+}
+
 TS_FUNCTION_INFO_V1(ts_timestamptz_timezone_bucket);
 
 /*
@@ -344,6 +435,19 @@ ts_timestamptz_timezone_bucket(PG_FUNCTION_ARGS)
 	if (PG_ARGISNULL(0) || PG_ARGISNULL(1) || PG_ARGISNULL(2))
 		PG_RETURN_NULL();
 
+	/*
+	 * Without the offset, the common case can use the cached offsets of the
+	 * time zone instead of converting the time stamps to local time and back
+	 * through the calendar representation.
+	 */
+	if (!have_offset)
+	{
+		TimestampTz result;
+
+		if (timezone_bucket_fast(fcinfo, have_origin, &result))
+			PG_RETURN_TIMESTAMPTZ(result);
+	}
+
 	/* Convert to local timestamp according to timezone */
 	timestamp = DirectFunctionCall2(timestamptz_zone, tzname, timestamp);
 	if (have_offset)
@@ -8,10 +8,15 @@
 #include "timezones.h"
 #include <access/xact.h>
 #include <datatype/timestamp.h>
+#include <parser/scansup.h>
 #include <pgtime.h>
 #include <port.h>
+#include <utils/builtins.h>
+#include <utils/datetime.h>
 #include <utils/timestamp.h>
 
+#include "compat/compat.h"
+
 /* Checks if the given TZ name is valid. */
 bool
 ts_is_valid_timezone_name(const char *tz_name)
@@ -48,3 +53,388 @@ ts_is_valid_timezone_name(const char *tz_name)
 	pg_tzenumerate_end(tzenum);
 	return found;
 }
+
+/*
+ * The maximum number of the offset transitions that we keep for a time zone.
+ * The conversions of the time stamps that need more fall back to the
+ * PostgreSQL functions.
+ */
+#define TZ_MAX_TRANSITIONS 4096
+
+/* By how much we extend the covered time range when it has to be extended. */
+#define TZ_COVERAGE_SLACK (SECS_PER_DAY * 366)
+
+/* The offset of the PostgreSQL epoch from the Unix epoch, in seconds. */
+#define TZ_EPOCH_DIFF ((int64) (POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE) * SECS_PER_DAY)
+
+/*
+ * The time stamps closer than that to the limits of the valid range are
+ * converted by the PostgreSQL functions, which report the out of range errors.
+ */
+#define TZ_MIN_TIMESTAMP (MIN_TIMESTAMP + 7 * USECS_PER_DAY)
+#define TZ_END_TIMESTAMP (END_TIMESTAMP - 7 * USECS_PER_DAY)
+
+struct TsTimezoneOffsets
+{
+	MemoryContext mcxt;
+
+	/* The time zone, or NULL if it has the fixed offset below. */
+	pg_tz *tz;
+	int32 fixed_gmtoff;
+
+	/*
+	 * The covered range of the Unix times in seconds, [covered_from,
+	 * covered_to). The covered_to is PG_INT64_MAX when the zone has no
+	 * transitions after covered_from.
+	 */
+	bool built;
+	pg_time_t covered_from;
+	pg_time_t covered_to;
+
+	/*
+	 * The transitions in the covered range. The span i is the interval
+	 * between transitions[i - 1] and transitions[i], so there are
+	 * ntransitions + 1 spans. For each span, we keep the offset reported by
+	 * pg_localtime() which is what timestamptz_zone() uses, and the offset
+	 * reported by pg_next_dst_boundary() which is what timestamp_zone() uses.
+	 */
+	int ntransitions;
+	pg_time_t *transitions;
+	int32 *local_gmtoffs;
+	int32 *boundary_gmtoffs;
+
+	/* The span found by the last lookup, which is likely to match the next one. */
+	int last_span;
+};
+
+/*
+ * Create the offsets for the given time zone name, which is interpreted the
+ * same way as by timestamptz_zone(). Returns NULL for the time zones that are
+ * not supported, namely the dynamic abbreviations and the invalid names, which
+ * have to be handled by the PostgreSQL functions.
+ */
+TsTimezoneOffsets *
+ts_timezone_offsets_create(const text *tzname, MemoryContext mcxt)
+{
+	char tzname_str[TZ_STRLEN_MAX + 1];
+	pg_tz *tzp = NULL;
+	int val = 0;
+	bool fixed;
+
+	text_to_cstring_buffer(tzname, tzname_str, sizeof(tzname_str));
+
+#if PG16_GE
+	switch (DecodeTimezoneName(tzname_str, &val, &tzp))
+	{
+		case TZNAME_FIXED_OFFSET:
+			fixed = true;
+			break;
+		case TZNAME_ZONE:
+			fixed = false;
+			break;
+		default:
+			return NULL;
+	}
+#else
+	char *lowzone = downcase_truncate_identifier(tzname_str, strlen(tzname_str), false);
+	int type = DecodeTimezoneAbbrev(0, lowzone, &val, &tzp);
+
+	if (type == TZ || type == DTZ)
+	{
+		fixed = true;
+	}
+	else if (type == DYNTZ)
+	{
+		return NULL;
+	}
+	else
+	{
+		tzp = pg_tzset(tzname_str);
+		if (tzp == NULL)
+			return NULL;
+		fixed = false;
+	}
+#endif
+
+	TsTimezoneOffsets *offsets = MemoryContextAllocZero(mcxt, sizeof(TsTimezoneOffsets));
+	offsets->mcxt = mcxt;
+	if (fixed)
+		offsets->fixed_gmtoff = val;
+	else
+		offsets->tz = tzp;
+
+	return offsets;
+}
+
+/*
+ * Free the offsets together with the transitions looked up for them.
+ */
+void
+ts_timezone_offsets_destroy(TsTimezoneOffsets *offsets)
+{
+	if (offsets->built)
+	{
+		pfree(offsets->transitions);
+		pfree(offsets->local_gmtoffs);
+		pfree(offsets->boundary_gmtoffs);
+	}
+
+	pfree(offsets);
+}
+
+static bool
+local_gmtoff(pg_time_t t, const pg_tz *tz, int32 *gmtoff)
+{
+	struct pg_tm *tm = pg_localtime(&t, tz);
+
+	if (tm == NULL)
+		return false;
+
+	*gmtoff = (int32) tm->tm_gmtoff;
+	return true;
+}
+
+/*
+ * Look up the transitions in the given range of the Unix times.
+ */
+static bool
+build_transitions(TsTimezoneOffsets *offsets, pg_time_t from, pg_time_t to)
+{
+	pg_time_t *transitions =
+		MemoryContextAlloc(offsets->mcxt, sizeof(pg_time_t) * TZ_MAX_TRANSITIONS);
+	int32 *local_gmtoffs =
+		MemoryContextAlloc(offsets->mcxt, sizeof(int32) * (TZ_MAX_TRANSITIONS + 1));
+	int32 *boundary_gmtoffs =
+		MemoryContextAlloc(offsets->mcxt, sizeof(int32) * (TZ_MAX_TRANSITIONS + 1));
+	int ntransitions = 0;
+	pg_time_t pos = from;
+	long before_gmtoff;
+	long after_gmtoff;
+	int before_isdst;
+	int after_isdst;
+	pg_time_t boundary;
+	int res;
+
+	res = pg_next_dst_boundary(&pos,
+							   &before_gmtoff,
+							   &before_isdst,
+							   &boundary,
+							   &after_gmtoff,
+							   &after_isdst,
+							   offsets->tz);
+	if (res < 0 || !local_gmtoff(from, offsets->tz, &local_gmtoffs[0]))
+		goto fail;
+	boundary_gmtoffs[0] = (int32) before_gmtoff;
+
+	while (res == 1 && boundary < to)
+	{
+		if (ntransitions >= TZ_MAX_TRANSITIONS)
+			goto fail;
+
+		transitions[ntransitions] = boundary;
+		boundary_gmtoffs[ntransitions + 1] = (int32) after_gmtoff;
+		if (!local_gmtoff(boundary, offsets->tz, &local_gmtoffs[ntransitions + 1]))
+			goto fail;
+		ntransitions++;
+
+		/*
+		 * Look for the next transition strictly after this one. Starting
+		 * exactly at the last transition of the zone data would not extend
+		 * the transitions with the recurring rule of the zone.
+		 */
+		pos = boundary + 1;
+		res = pg_next_dst_boundary(&pos,
+								   &before_gmtoff,
+								   &before_isdst,
+								   &boundary,
+								   &after_gmtoff,
+								   &after_isdst,
+								   offsets->tz);
+		if (res < 0)
+			goto fail;
+	}
+
+	if (offsets->built)
+	{
+		pfree(offsets->transitions);
+		pfree(offsets->local_gmtoffs);
+		pfree(offsets->boundary_gmtoffs);
+	}
+
+	offsets->built = true;
+	offsets->covered_from = from;
+	offsets->covered_to = res == 0 ? PG_INT64_MAX : to;
+	offsets->ntransitions = ntransitions;
+	offsets->transitions = transitions;
+	offsets->local_gmtoffs = local_gmtoffs;
+	offsets->boundary_gmtoffs = boundary_gmtoffs;
+	offsets->last_span = 0;
+	return true;
+
+fail:
+	pfree(transitions);
+	pfree(local_gmtoffs);
+	pfree(boundary_gmtoffs);
+	return false;
+}
+
+/*
+ * Make sure that the given range of the Unix times is covered by the
+ * transitions we have, extending the covered range if needed.
+ */
+static bool
+ensure_covered(TsTimezoneOffsets *offsets, pg_time_t from, pg_time_t to)
+{
+	if (offsets->built && from >= offsets->covered_from && to <= offsets->covered_to)
+		return true;
+
+	pg_time_t new_from = from - TZ_COVERAGE_SLACK;
+	pg_time_t new_to = to + TZ_COVERAGE_SLACK;
+
+	if (offsets->built)
+	{
+		/*
+		 * Extend the covered range. If it would have too many transitions,
+		 * only the new range is covered.
+		 */
+		if (build_transitions(offsets,
+							  from < offsets->covered_from ? new_from : offsets->covered_from,
+							  to > offsets->covered_to ? new_to : offsets->covered_to))
+			return true;
+	}
+
+	return build_transitions(offsets, new_from, new_to);
+}
+
+/*
+ * Find the span that contains the given covered Unix time.
+ */
+static int
+find_span(TsTimezoneOffsets *offsets, pg_time_t t)
+{
+	const pg_time_t *transitions = offsets->transitions;
+	int span = offsets->last_span;
+
+	if ((span == 0 || transitions[span - 1] <= t) &&
+		(span == offsets->ntransitions || t < transitions[span]))
+		return span;
+
+	/* The number of the transitions not after t. */
+	int lo = 0;
+	int hi = offsets->ntransitions;
+	while (lo < hi)
+	{
+		int mid = (lo + hi) / 2;
+		if (transitions[mid] <= t)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	offsets->last_span = lo;
+	return lo;
+}
+
+static inline pg_time_t
+timestamp_to_seconds(int64 timestamp)
+{
+	int64 seconds = timestamp / USECS_PER_SEC;
+
+	if (timestamp < 0 && seconds * USECS_PER_SEC != timestamp)
+		seconds--;
+
+	return seconds + TZ_EPOCH_DIFF;
+}
+
+/*
+ * Convert the time stamp with time zone to the local time stamp, same as
+ * timestamptz_zone(). Returns false if the time stamp has to be converted by
+ * timestamptz_zone() instead.
+ */
+bool
+ts_timezone_offsets_to_local(TsTimezoneOffsets *offsets, TimestampTz timestamp,
+							 Timestamp *result)
+{
+	int32 gmtoff;
+
+	if (timestamp < TZ_MIN_TIMESTAMP || timestamp >= TZ_END_TIMESTAMP)
+		return false;
+
+	if (offsets->tz == NULL)
+	{
+		gmtoff = offsets->fixed_gmtoff;
+	}
+	else
+	{
+		pg_time_t t = timestamp_to_seconds(timestamp);
+
+		if (!ensure_covered(offsets, t, t + 1))
+			return false;
+
+		gmtoff = offsets->local_gmtoffs[find_span(offsets, t)];
+	}
+
+	*result = timestamp + (int64) gmtoff * USECS_PER_SEC;
+	return true;
+}
+
+/*
+ * Convert the local time stamp to the time stamp with time zone, same as
+ * timestamp_zone(). The ambiguous and the skipped local times are resolved
+ * like DetermineTimeZoneOffset() does. Returns false if the time stamp has to
+ * be converted by timestamp_zone() instead.
+ */
+bool
+ts_timezone_offsets_from_local(TsTimezoneOffsets *offsets, Timestamp timestamp,
+							   TimestampTz *result)
+{
+	int32 gmtoff;
+
+	if (timestamp < TZ_MIN_TIMESTAMP || timestamp >= TZ_END_TIMESTAMP)
+		return false;
+
+	if (offsets->tz == NULL)
+	{
+		gmtoff = offsets->fixed_gmtoff;
+	}
+	else
+	{
+		/*
+		 * The local time is looked up as if it were UTC, one day earlier, to
+		 * find the transition that may affect it.
+		 */
+		pg_time_t mytime = timestamp_to_seconds(timestamp);
+		pg_time_t prec = mytime - SECS_PER_DAY;
+
+		if (!ensure_covered(offsets, prec, prec + 3 * SECS_PER_DAY))
+			return false;
+
+		int span = find_span(offsets, prec);
+		int32 before = offsets->boundary_gmtoffs[span];
+
+		if (span == offsets->ntransitions)
+		{
+			/* No transition that could affect this local time. */
+			gmtoff = before;
+		}
+		else
+		{
+			pg_time_t boundary = offsets->transitions[span];
+			int32 after = offsets->boundary_gmtoffs[span + 1];
+			pg_time_t beforetime = mytime - before;
+			pg_time_t aftertime = mytime - after;
+
+			if (beforetime < boundary && aftertime < boundary)
+				gmtoff = before;
+			else if (beforetime > boundary && aftertime >= boundary)
+				gmtoff = after;
+			else if (beforetime > aftertime)
+				gmtoff = before;
+			else
+				gmtoff = after;
+		}
+	}
+
+	*result = timestamp - (int64) gmtoff * USECS_PER_SEC;
+	return true;
+}
@@ -6,6 +6,26 @@
 
 #pragma once
 
+#include <postgres.h>
+#include <datatype/timestamp.h>
+
 #include "export.h"
 
 extern TSDLLEXPORT bool ts_is_valid_timezone_name(const char *tz_name);
+
+/*
+ * The UTC offsets of a time zone, for converting between the time stamps with
+ * time zone and the local time stamps with integer arithmetic instead of the
+ * calendar decomposition of timestamptz_zone() and timestamp_zone(). The
+ * offset transitions are looked up once and kept for the covered time range,
+ * which is extended as needed.
+ */
+typedef struct TsTimezoneOffsets TsTimezoneOffsets;
+
+extern TSDLLEXPORT TsTimezoneOffsets *ts_timezone_offsets_create(const text *tzname,
+																  MemoryContext mcxt);
+extern TSDLLEXPORT void ts_timezone_offsets_destroy(TsTimezoneOffsets *offsets);
+extern TSDLLEXPORT bool ts_timezone_offsets_to_local(TsTimezoneOffsets *offsets,
+													 TimestampTz timestamp, Timestamp *result);
+extern TSDLLEXPORT bool ts_timezone_offsets_from_local(TsTimezoneOffsets *offsets,
+													   Timestamp timestamp, TimestampTz *result);
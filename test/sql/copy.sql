@@ -52,6 +52,29 @@ COPY hyper (time, meta_id, value) FROM STDIN DELIMITER ',';
 \.
 \set ON_ERROR_STOP 1
 
+-- the foreign keys of a batch are checked together, and a batch with
+-- a missing key falls back to the per-row checks
+INSERT INTO "meta" ("id") values (2), (3);
+COPY hyper (time, meta_id, value) FROM STDIN DELIMITER ',';
+3,2,1
+3,3,1
+4,2,1
+4,3,1
+\.
+\set ON_ERROR_STOP 0
+COPY hyper (time, meta_id, value) FROM STDIN DELIMITER ',';
+5,2,1
+5,4,1
+5,3,1
+\.
+\set ON_ERROR_STOP 1
+SET timescaledb.enable_foreign_key_batch_check TO off;
+COPY hyper (time, meta_id, value) FROM STDIN DELIMITER ',';
+6,1,1
+6,3,1
+\.
+RESET timescaledb.enable_foreign_key_batch_check;
+
 COPY (SELECT * FROM hyper ORDER BY time, meta_id) TO STDOUT;
 
 --test that copy works with a low setting for max_open_chunks_per_insert
@@ -147,3 +147,42 @@ SET enable_bitmapscan TO true;
 \set ON_ERROR_STOP 0
 CREATE INDEX ON partial_index_test (time) WITH (timescaledb.transaction_per_chunk, timescaledb.max_chunks='1');
 \set ON_ERROR_STOP 1
+
+\c  :TEST_DBNAME :ROLE_DEFAULT_PERM_USER
+-- resume an interrupted index creation on the chunks that lack the index
+CREATE INDEX partial_index_test_time_idx ON partial_index_test (time) WITH (timescaledb.transaction_per_chunk, timescaledb.max_chunks='1');
+SELECT indisvalid FROM pg_index WHERE indexrelid = 'partial_index_test_time_idx'::regclass;
+CREATE INDEX IF NOT EXISTS partial_index_test_time_idx ON partial_index_test (time) WITH (timescaledb.transaction_per_chunk);
+SELECT indisvalid FROM pg_index WHERE indexrelid = 'partial_index_test_time_idx'::regclass;
+SELECT * FROM test.show_indexesp('_timescaledb_internal._hyper%_chunk') ORDER BY 1,2;
+-- a valid index is not recreated
+CREATE INDEX IF NOT EXISTS partial_index_test_time_idx ON partial_index_test (time) WITH (timescaledb.transaction_per_chunk);
+DROP INDEX partial_index_test_time_idx;
+
+\set ON_ERROR_STOP 0
+-- parallel index creation requires transaction_per_chunk
+CREATE INDEX ON partial_index_test (time) WITH (timescaledb.parallel_workers = 2);
+CREATE INDEX ON partial_index_test (time) WITH (timescaledb.transaction_per_chunk, timescaledb.parallel_workers = -1);
+CREATE INDEX ON partial_index_test (time) WITH (timescaledb.transaction_per_chunk, timescaledb.parallel_workers = 2, timescaledb.max_chunks='1');
+\set ON_ERROR_STOP 1
+
+-- resuming an interrupted index creation requires the same index definition
+CREATE INDEX partial_index_test_expr_idx ON partial_index_test ((time + 1)) WHERE time > 0 WITH (timescaledb.transaction_per_chunk, timescaledb.max_chunks='1');
+\set ON_ERROR_STOP 0
+CREATE INDEX IF NOT EXISTS partial_index_test_expr_idx ON partial_index_test ((time + 2)) WHERE time > 0 WITH (timescaledb.transaction_per_chunk);
+CREATE INDEX IF NOT EXISTS partial_index_test_expr_idx ON partial_index_test ((time + 1)) WITH (timescaledb.transaction_per_chunk);
+CREATE INDEX IF NOT EXISTS partial_index_test_expr_idx ON partial_index_test (time) WHERE time > 0 WITH (timescaledb.transaction_per_chunk);
+CREATE INDEX IF NOT EXISTS partial_index_test_expr_idx ON partial_index_test USING hash ((time + 1)) WHERE time > 0 WITH (timescaledb.transaction_per_chunk);
+\set ON_ERROR_STOP 1
+CREATE INDEX IF NOT EXISTS partial_index_test_expr_idx ON partial_index_test ((time + 1)) WHERE time > 0 WITH (timescaledb.transaction_per_chunk);
+SELECT count(*), bool_and(indisvalid) FROM pg_index i JOIN pg_class c ON (c.oid = i.indexrelid)
+WHERE c.relname LIKE '%partial_index_test_expr_idx';
+DROP INDEX partial_index_test_expr_idx;
+
+-- build the chunk indexes in parallel workers, the index is valid on the
+-- hypertable and on every chunk. Falling back to the serial build would
+-- show up as a notice here.
+CREATE INDEX partial_index_test_parallel_idx ON partial_index_test (time) WITH (timescaledb.transaction_per_chunk, timescaledb.parallel_workers = 2);
+SELECT count(*), bool_and(indisvalid) FROM pg_index i JOIN pg_class c ON (c.oid = i.indexrelid)
+WHERE c.relname LIKE '%partial_index_test_parallel_idx';
+DROP INDEX partial_index_test_parallel_idx;
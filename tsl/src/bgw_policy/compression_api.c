@@ -68,6 +68,38 @@ policy_compression_get_hypertable_id(const Jsonb *config)
 	return hypertable_id;
 }
 
+bool
+policy_compression_get_recompress(const Jsonb *config)
+{
+	bool found;
+	bool recompress = ts_jsonb_get_bool_field(config, POL_COMPRESSION_CONF_KEY_RECOMPRESS, &found);
+
+	return found ? recompress : true;
+}
+
+UseAccessMethod
+policy_compression_get_use_access_method(const Jsonb *config)
+{
+	bool found;
+	bool useam =
+		ts_jsonb_get_bool_field(config, POL_COMPRESSION_CONF_KEY_USE_ACCESS_METHOD, &found);
+
+	if (!found)
+		return USE_AM_NULL;
+
+	return useam ? USE_AM_TRUE : USE_AM_FALSE;
+}
+
+/*
+ * Get the time budget for a single run of the compression policy. Returns
+ * NULL if the policy has no time budget.
+ */
+Interval *
+policy_compression_get_time_budget(const Jsonb *config)
+{
+	return ts_jsonb_get_interval_field(config, POL_COMPRESSION_CONF_KEY_TIME_BUDGET);
+}
+
 int64
 policy_recompression_get_recompress_after_int(const Jsonb *config)
 {
@@ -113,6 +145,24 @@ policy_recompression_proc(PG_FUNCTION_ARGS)
 	PG_RETURN_VOID();
 }
 
+Datum
+policy_compression_proc(PG_FUNCTION_ARGS)
+{
+	if (PG_NARGS() != 2 || PG_ARGISNULL(0))
+		PG_RETURN_VOID();
+
+	if (PG_ARGISNULL(1))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("job %d has null config", PG_GETARG_INT32(0))));
+
+	ts_feature_flag_check(FEATURE_POLICY);
+
+	policy_compression_execute(PG_GETARG_INT32(0), PG_GETARG_JSONB_P(1));
+
+	PG_RETURN_VOID();
+}
+
 static void
 validate_compress_after_type(const Dimension *dim, Oid partitioning_type, Oid compress_after_type)
 {
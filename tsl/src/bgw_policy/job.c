@@ -7,8 +7,10 @@
 #include <postgres.h>
 #include <access/xact.h>
 #include <catalog/namespace.h>
+#include <catalog/pg_class.h>
 #include <catalog/pg_type.h>
 #include <commands/defrem.h>
+#include <executor/spi.h>
 #include <extension.h>
 #include <funcapi.h>
 #include <hypertable_cache.h>
@@ -18,10 +20,12 @@
 #include <parser/parse_func.h>
 #include <parser/parser.h>
 #include <tcop/pquery.h>
+#include <tcop/utility.h>
 #include <utils/builtins.h>
 #include <utils/guc.h>
 #include <utils/lsyscache.h>
 #include <utils/portal.h>
+#include <utils/resowner.h>
 #include <utils/snapmgr.h>
 #include <utils/syscache.h>
 #include <utils/timestamp.h>
@@ -33,6 +37,7 @@
 #include "bgw_policy/chunk_stats.h"
 #include "bgw_policy/compression_api.h"
 #include "bgw_policy/continuous_aggregate_api.h"
+#include "bgw_policy/policies_v2.h"
 #include "bgw_policy/policy_utils.h"
 #include "bgw_policy/reorder_api.h"
 #include "bgw_policy/retention_api.h"
@@ -54,7 +59,9 @@
 #include "errors.h"
 #include "guc.h"
 #include "job.h"
+#include "jsonb_utils.h"
 #include "reorder.h"
+#include "time_utils.h"
 #include "utils.h"
 
 #define REORDER_SKIP_RECENT_DIM_SLICES_N 3
@@ -617,6 +624,341 @@ policy_recompression_execute(int32 job_id, Jsonb *config)
 	return true;
 }
 
+/*
+ * A chunk selected for compression by the compression policy.
+ */
+typedef struct CompressionPolicyChunk
+{
+	int32 chunk_id;
+	int32 status;
+	int64 range_start;
+	BlockNumber relpages;
+	Oid relid;
+	NameData schema_name;
+	NameData table_name;
+} CompressionPolicyChunk;
+
+/*
+ * Compress the oldest chunks first since they are the least likely to see
+ * new writes. Among chunks covering the same range, the largest chunks go
+ * first since they free up the most space.
+ */
+static int
+compression_policy_chunk_cmp(const void *left, const void *right)
+{
+	const CompressionPolicyChunk *lhs = left;
+	const CompressionPolicyChunk *rhs = right;
+
+	if (lhs->range_start != rhs->range_start)
+		return lhs->range_start < rhs->range_start ? -1 : 1;
+
+	if (lhs->relpages != rhs->relpages)
+		return lhs->relpages > rhs->relpages ? -1 : 1;
+
+	if (lhs->relid != rhs->relid)
+		return lhs->relid < rhs->relid ? -1 : 1;
+
+	return 0;
+}
+
+/*
+ * Get the size of a relation in pages as recorded in pg_class. This is only an
+ * estimate, but it does not require opening and locking the relation.
+ */
+static BlockNumber
+get_relation_pages(Oid relid)
+{
+	HeapTuple tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(relid));
+	BlockNumber relpages = 0;
+
+	if (HeapTupleIsValid(tuple))
+	{
+		relpages = ((Form_pg_class) GETSTRUCT(tuple))->relpages;
+		ReleaseSysCache(tuple);
+	}
+
+	return relpages;
+}
+
+/*
+ * Compute the boundary of the compression policy in internal time. Chunks
+ * entirely before the boundary are candidates for compression.
+ */
+static int64
+get_compression_policy_boundary(int32 job_id, const Dimension *dim, const Jsonb *config,
+								bool *use_creation_time)
+{
+	Oid partitioning_type = ts_dimension_get_partition_type(dim);
+	Interval *lag;
+
+	*use_creation_time = false;
+
+	if (IS_INTEGER_TYPE(partitioning_type))
+	{
+		bool found;
+		int64 lag_int =
+			ts_jsonb_get_int64_field(config, POL_COMPRESSION_CONF_KEY_COMPRESS_AFTER, &found);
+
+		if (found)
+		{
+			Oid now_func = ts_get_integer_now_func(dim, false);
+
+			if (!OidIsValid(now_func))
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("could not find valid integer_now function for hypertable")));
+
+			return ts_sub_integer_from_now(lag_int, partitioning_type, now_func);
+		}
+	}
+	else
+	{
+		lag = ts_jsonb_get_interval_field(config, POL_COMPRESSION_CONF_KEY_COMPRESS_AFTER);
+		if (lag != NULL)
+			return ts_time_value_from_arg(IntervalPGetDatum(lag),
+										  INTERVALOID,
+										  partitioning_type,
+										  true);
+	}
+
+	lag = ts_jsonb_get_interval_field(config, POL_COMPRESSION_CONF_KEY_COMPRESS_CREATED_BEFORE);
+	if (lag == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("job %d config must have compress_after or compress_created_before",
+						job_id)));
+
+	*use_creation_time = true;
+
+	/* Chunk creation time is stored in PostgreSQL timestamp format */
+	return ts_internal_to_time_int64(ts_time_value_from_arg(IntervalPGetDatum(lag),
+															INTERVALOID,
+															TIMESTAMPTZOID,
+															false),
+									 TIMESTAMPTZOID);
+}
+
+/*
+ * Get the chunks that the compression policy should process, in the order
+ * they should be processed.
+ *
+ * The candidates are found with a single scan of the chunk catalog instead
+ * of going through show_chunks() and joining with the catalog per chunk.
+ * Fully compressed, frozen, dropped and OSM chunks are skipped, as are
+ * partially compressed chunks unless recompression is enabled.
+ */
+static CompressionPolicyChunk *
+get_chunks_to_compress(Hypertable *ht, int64 boundary, bool use_creation_time,
+					   bool recompress_enabled, int *num_candidates)
+{
+	uint64 num_chunks = 0;
+	Chunk *chunks = ts_chunk_get_chunks_older_than(ht,
+												   boundary,
+												   use_creation_time,
+												   CurrentMemoryContext,
+												   &num_chunks);
+	CompressionPolicyChunk *candidates =
+		palloc(sizeof(CompressionPolicyChunk) * Max(num_chunks, 1));
+	int n = 0;
+
+	for (uint64 i = 0; i < num_chunks; i++)
+	{
+		const Chunk *chunk = &chunks[i];
+
+		if (chunk->fd.dropped || chunk->fd.osm_chunk)
+			continue;
+
+		if (chunk->fd.status == CHUNK_STATUS_COMPRESSED ||
+			ts_flags_are_set_32(chunk->fd.status, CHUNK_STATUS_FROZEN))
+			continue;
+
+		if (ts_flags_are_set_32(chunk->fd.status, CHUNK_STATUS_COMPRESSED) && !recompress_enabled)
+			continue;
+
+		candidates[n] = (CompressionPolicyChunk){
+			.chunk_id = chunk->fd.id,
+			.status = chunk->fd.status,
+			.range_start = ts_chunk_primary_dimension_start(chunk),
+			.relpages = get_relation_pages(chunk->table_id),
+			.relid = chunk->table_id,
+			.schema_name = chunk->fd.schema_name,
+			.table_name = chunk->fd.table_name,
+		};
+		n++;
+	}
+
+	qsort(candidates, n, sizeof(CompressionPolicyChunk), compression_policy_chunk_cmp);
+
+	*num_candidates = n;
+	return candidates;
+}
+
+/*
+ * Compress a single chunk for the compression policy.
+ *
+ * The chunk is compressed in a subtransaction so that a failure to compress
+ * one chunk is reported as a warning and does not prevent the policy from
+ * processing the remaining chunks. Returns true if the chunk was compressed.
+ */
+static bool
+policy_compression_compress_chunk(const CompressionPolicyChunk *candidate, UseAccessMethod useam)
+{
+	MemoryContext oldcontext = CurrentMemoryContext;
+	ResourceOwner oldowner = CurrentResourceOwner;
+	bool success = true;
+
+	BeginInternalSubTransaction(NULL);
+
+	PG_TRY();
+	{
+		Chunk *chunk;
+
+		PreventCommandIfReadOnly("compress_chunk()");
+
+		/* The chunk might have been dropped since we looked it up */
+		chunk = ts_chunk_get_by_id(candidate->chunk_id, false);
+		if (chunk != NULL)
+			tsl_compress_chunk_with_access_method(chunk, true, false, useam);
+
+		ReleaseCurrentSubTransaction();
+		MemoryContextSwitchTo(oldcontext);
+		CurrentResourceOwner = oldowner;
+	}
+	PG_CATCH();
+	{
+		ErrorData *edata;
+
+		MemoryContextSwitchTo(oldcontext);
+		edata = CopyErrorData();
+		FlushErrorState();
+
+		RollbackAndReleaseCurrentSubTransaction();
+		MemoryContextSwitchTo(oldcontext);
+		CurrentResourceOwner = oldowner;
+
+		ereport(WARNING,
+				(errcode(edata->sqlerrcode),
+				 errmsg("compressing chunk \"%s\" failed when compression policy is executed",
+						quote_qualified_identifier(NameStr(candidate->schema_name),
+												   NameStr(candidate->table_name))),
+				 errdetail("Message: (%s), Detail: (%s).",
+						   edata->message,
+						   edata->detail ? edata->detail : "")));
+		FreeErrorData(edata);
+		success = false;
+	}
+	PG_END_TRY();
+
+	return success;
+}
+
+/*
+ * Execute the compression policy.
+ *
+ * Each chunk is compressed and committed in a separate transaction so that
+ * locks are only held while the chunk is processed. If the policy has a time
+ * budget, it stops when the budget is spent and reschedules itself to run
+ * again immediately to pick up the remaining chunks.
+ */
+bool
+policy_compression_execute(int32 job_id, Jsonb *config)
+{
+	bool found;
+	int32 hypertable_id =
+		ts_jsonb_get_int32_field(config, POL_COMPRESSION_CONF_KEY_HYPERTABLE_ID, &found);
+
+	if (!found)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("job %d config must have hypertable_id", job_id)));
+
+	bool verbose_log = policy_get_verbose_log(config);
+	int32 maxchunks = policy_compression_get_maxchunks_per_job(config);
+	bool recompress_enabled = policy_compression_get_recompress(config);
+	UseAccessMethod useam = policy_compression_get_use_access_method(config);
+	Interval *time_budget = policy_compression_get_time_budget(config);
+	int64 time_budget_usecs =
+		time_budget ? ts_interval_value_to_internal(IntervalPGetDatum(time_budget), INTERVALOID) :
+					  0;
+
+	/* The candidate list is allocated in the SPI procedure context so that it
+	 * survives the commits between chunks. */
+	int rc = SPI_connect_ext(SPI_OPT_NONATOMIC);
+	if (rc != SPI_OK_CONNECT)
+		elog(ERROR, "SPI_connect failed: %s", SPI_result_code_string(rc));
+
+	Cache *hcache;
+	Hypertable *ht =
+		ts_hypertable_cache_get_cache_and_entry(ts_hypertable_id_to_relid(hypertable_id, false),
+												CACHE_FLAG_NONE,
+												&hcache);
+	const Dimension *dim = hyperspace_get_open_dimension(ht->space, 0);
+	bool use_creation_time;
+	int64 boundary = get_compression_policy_boundary(job_id, dim, config, &use_creation_time);
+	int num_candidates;
+	CompressionPolicyChunk *candidates = get_chunks_to_compress(ht,
+																boundary,
+																use_creation_time,
+																recompress_enabled,
+																&num_candidates);
+	ts_cache_release(hcache);
+
+	TimestampTz start_time = GetCurrentTimestamp();
+	int num_compressed = 0;
+	int num_failed = 0;
+
+	for (int i = 0; i < num_candidates; i++)
+	{
+		const CompressionPolicyChunk *candidate = &candidates[i];
+
+		/* The failed chunks count as well, so that the work per run is bounded */
+		if (maxchunks > 0 && i >= maxchunks)
+			break;
+
+		/* Always make progress on at least one chunk per run */
+		if (time_budget != NULL && i > 0 &&
+			GetCurrentTimestamp() - start_time >= time_budget_usecs)
+		{
+			elog(LOG,
+				 "job %d exceeded its time budget with %d chunks left to process",
+				 job_id,
+				 num_candidates - i);
+			enable_fast_restart(job_id, "compression");
+			break;
+		}
+
+		PushActiveSnapshot(GetTransactionSnapshot());
+		if (policy_compression_compress_chunk(candidate, useam))
+			num_compressed++;
+		else
+			num_failed++;
+		PopActiveSnapshot();
+
+		SPI_commit();
+
+		if (verbose_log)
+			elog(LOG,
+				 "job %d completed processing chunk %s.%s",
+				 job_id,
+				 NameStr(candidate->schema_name),
+				 NameStr(candidate->table_name));
+	}
+
+	if (num_failed > 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("compression policy failure"),
+				 errdetail("Failed to compress '%d' chunks. Successfully compressed '%d' chunks.",
+						   num_failed,
+						   num_compressed)));
+
+	rc = SPI_finish();
+	if (rc != SPI_OK_FINISH)
+		elog(ERROR, "SPI_finish failed: %s", SPI_result_code_string(rc));
+
+	return true;
+}
+
 static void
 job_execute_function(FuncExpr *funcexpr)
 {
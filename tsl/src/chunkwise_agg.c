@@ -5,12 +5,15 @@
  */
 #include <postgres.h>
 
+#include <catalog/pg_aggregate.h>
+#include <nodes/nodeFuncs.h>
 #include <optimizer/appendinfo.h>
 #include <optimizer/cost.h>
 #include <optimizer/pathnode.h>
 #include <optimizer/paths.h>
 #include <optimizer/prep.h>
 #include <optimizer/tlist.h>
+#include <utils/selfuncs.h>
 
 #include "chunkwise_agg.h"
 
@@ -21,6 +24,27 @@
 #include "nodes/decompress_chunk/decompress_chunk.h"
 #include "planner.h"
 
+/*
+ * The grouping of the pushed-down partial aggregation. This is the GROUP BY
+ * clause of an aggregation query, or the DISTINCT clause of a query without
+ * aggregates, which is computed as a grouping without aggregate functions.
+ */
+typedef struct PushdownGrouping
+{
+	List *clauses;
+	List *pathkeys;
+
+	/* AGG_SORTED if the query has a grouping clause, AGG_PLAIN otherwise. */
+	AggStrategy sorted_strategy;
+
+	/* GROUPING_CAN_USE_SORT and GROUPING_CAN_USE_HASH */
+	int flags;
+
+	const AggClauseCosts *partial_costs;
+	const AggClauseCosts *final_costs;
+	List *having_qual;
+} PushdownGrouping;
+
 /* Helper function to find the first node of the provided type in the pathlist of the relation */
 static Node *
 find_node(const RelOptInfo *relation, NodeTag type)
@@ -117,6 +141,13 @@ get_subpaths_from_append_path(Path *path, List **subpaths, Path **append, Path *
 		return;
 	}
 
+	if (IsA(path, GroupPath))
+	{
+		/* The sorted grouping without aggregates. */
+		get_subpaths_from_append_path(castNode(GroupPath, path)->subpath, subpaths, append, gather);
+		return;
+	}
+
 	if (IsA(path, ProjectionPath))
 	{
 		ProjectionPath *projection = castNode(ProjectionPath, path);
@@ -208,33 +239,24 @@ copy_append_like_path(PlannerInfo *root, Path *path, List *new_subpaths, PathTar
  */
 static AggPath *
 create_sorted_partial_agg_path(PlannerInfo *root, Path *path, PathTarget *target,
-							   double d_num_groups, GroupPathExtraData *extra_data)
+							   double d_num_groups, const PushdownGrouping *grouping)
 {
-	Query *parse = root->parse;
-
-	/* Determine costs for aggregations */
-	AggClauseCosts *agg_partial_costs = &extra_data->agg_partial_costs;
-
-	bool is_sorted = pathkeys_contained_in(root->group_pathkeys, path->pathkeys);
+	bool is_sorted = pathkeys_contained_in(grouping->pathkeys, path->pathkeys);
 
 	if (!is_sorted)
 	{
-		path = (Path *) create_sort_path(root, path->parent, path, root->group_pathkeys, -1.0);
+		path = (Path *) create_sort_path(root, path->parent, path, grouping->pathkeys, -1.0);
 	}
 
 	AggPath *sorted_agg_path = create_agg_path(root,
 											   path->parent,
 											   path,
 											   target,
-											   parse->groupClause ? AGG_SORTED : AGG_PLAIN,
+											   grouping->sorted_strategy,
 											   AGGSPLIT_INITIAL_SERIAL,
-#if PG16_LT
-											   parse->groupClause,
-#else
-											   root->processed_groupClause,
-#endif
+											   grouping->clauses,
 											   NIL,
-											   agg_partial_costs,
+											   grouping->partial_costs,
 											   d_num_groups);
 
 	return sorted_agg_path;
@@ -245,24 +267,17 @@ create_sorted_partial_agg_path(PlannerInfo *root, Path *path, PathTarget *target
  */
 static AggPath *
 create_hashed_partial_agg_path(PlannerInfo *root, Path *path, PathTarget *target,
-							   double d_num_groups, GroupPathExtraData *extra_data)
+							   double d_num_groups, const PushdownGrouping *grouping)
 {
-	/* Determine costs for aggregations */
-	AggClauseCosts *agg_partial_costs = &extra_data->agg_partial_costs;
-
 	AggPath *hash_path = create_agg_path(root,
 										 path->parent,
 										 path,
 										 target,
 										 AGG_HASHED,
 										 AGGSPLIT_INITIAL_SERIAL,
-#if PG16_LT
-										 root->parse->groupClause,
-#else
-										 root->processed_groupClause,
-#endif
+										 grouping->clauses,
 										 NIL,
-										 agg_partial_costs,
+										 grouping->partial_costs,
 										 d_num_groups);
 	return hash_path;
 }
@@ -273,7 +288,7 @@ create_hashed_partial_agg_path(PlannerInfo *root, Path *path, PathTarget *target
 static void
 add_partially_aggregated_subpaths(PlannerInfo *root, PathTarget *input_target,
 								  PathTarget *partial_grouping_target, double d_num_groups,
-								  GroupPathExtraData *extra_data, Path *subpath,
+								  const PushdownGrouping *grouping, Path *subpath,
 								  List **sorted_paths, List **hashed_paths)
 {
 	/* Translate targetlist for partition */
@@ -321,24 +336,24 @@ add_partially_aggregated_subpaths(PlannerInfo *root, PathTarget *input_target,
 			create_projection_path(root, subpath->parent, subpath, chunk_target_before_grouping);
 	}
 
-	if (extra_data->flags & GROUPING_CAN_USE_SORT)
+	if (grouping->flags & GROUPING_CAN_USE_SORT)
 	{
 		AggPath *agg_path = create_sorted_partial_agg_path(root,
 														   subpath,
 														   chunk_grouped_target,
 														   d_num_groups,
-														   extra_data);
+														   grouping);
 
 		*sorted_paths = lappend(*sorted_paths, (Path *) agg_path);
 	}
 
-	if (extra_data->flags & GROUPING_CAN_USE_HASH)
+	if (grouping->flags & GROUPING_CAN_USE_HASH)
 	{
 		AggPath *agg_path = create_hashed_partial_agg_path(root,
 														   subpath,
 														   chunk_grouped_target,
 														   d_num_groups,
-														   extra_data);
+														   grouping);
 
 		*hashed_paths = lappend(*hashed_paths, (Path *) agg_path);
 	}
@@ -356,9 +371,8 @@ add_partially_aggregated_subpaths(PlannerInfo *root, PathTarget *input_target,
  */
 static void
 generate_agg_pushdown_path(PlannerInfo *root, Path *cheapest_total_path, RelOptInfo *input_rel,
-						   RelOptInfo *output_rel, RelOptInfo *partially_grouped_rel,
-						   PathTarget *grouping_target, PathTarget *partial_grouping_target,
-						   double d_num_groups, GroupPathExtraData *extra_data)
+						   RelOptInfo *partially_grouped_rel, PathTarget *partial_grouping_target,
+						   double d_num_groups, const PushdownGrouping *grouping)
 {
 	/* Get subpaths */
 	List *subpaths = NIL;
@@ -422,13 +436,13 @@ generate_agg_pushdown_path(PlannerInfo *root, Path *cheapest_total_path, RelOptI
 												  input_rel->reltarget,
 												  partial_grouping_target,
 												  d_num_groups,
-												  extra_data,
+												  grouping,
 												  partially_compressed_path,
 												  &partially_compressed_sorted /* Result path */,
 												  &partially_compressed_hashed /* Result path */);
 			}
 
-			if (extra_data->flags & GROUPING_CAN_USE_SORT)
+			if (grouping->flags & GROUPING_CAN_USE_SORT)
 			{
 				sorted_subpaths = lappend(sorted_subpaths,
 										  copy_append_like_path(root,
@@ -437,7 +451,7 @@ generate_agg_pushdown_path(PlannerInfo *root, Path *cheapest_total_path, RelOptI
 																partial_grouping_target));
 			}
 
-			if (extra_data->flags & GROUPING_CAN_USE_HASH)
+			if (grouping->flags & GROUPING_CAN_USE_HASH)
 			{
 				hashed_subpaths = lappend(hashed_subpaths,
 										  copy_append_like_path(root,
@@ -452,7 +466,7 @@ generate_agg_pushdown_path(PlannerInfo *root, Path *cheapest_total_path, RelOptI
 											  input_rel->reltarget,
 											  partial_grouping_target,
 											  d_num_groups,
-											  extra_data,
+											  grouping,
 											  subpath,
 											  &sorted_subpaths /* Result paths */,
 											  &hashed_subpaths /* Result paths */);
@@ -564,6 +578,326 @@ contains_path_plain_or_sorted_agg(Path *path)
 	return true;
 }
 
+/*
+ * Whether any of the given chunk paths, or the paths of partially compressed
+ * chunks under them, is a DecompressChunk path.
+ */
+static bool
+has_decompress_chunk_subpath(List *subpaths)
+{
+	ListCell *lc;
+	foreach (lc, subpaths)
+	{
+		List *chunk_subpaths = NIL;
+		Path *chunk_append = NULL;
+		Path *chunk_gather = NULL;
+		get_subpaths_from_append_path(lfirst(lc), &chunk_subpaths, &chunk_append, &chunk_gather);
+		if (chunk_append == NULL)
+			chunk_subpaths = list_make1(lfirst(lc));
+
+		ListCell *lc2;
+		foreach (lc2, chunk_subpaths)
+		{
+			if (ts_is_decompress_chunk_path(lfirst(lc2)))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Create the upper relation for the partially grouped paths.
+ */
+static RelOptInfo *
+make_partially_grouped_rel(PlannerInfo *root, UpperRelationKind kind, RelOptInfo *input_rel,
+						   PathTarget *partial_grouping_target)
+{
+	RelOptInfo *partially_grouped_rel = fetch_upper_rel(root, kind, input_rel->relids);
+	partially_grouped_rel->consider_parallel = input_rel->consider_parallel;
+	partially_grouped_rel->consider_startup = input_rel->consider_startup;
+	partially_grouped_rel->reloptkind = input_rel->reloptkind;
+	partially_grouped_rel->serverid = input_rel->serverid;
+	partially_grouped_rel->userid = input_rel->userid;
+	partially_grouped_rel->useridiscurrent = input_rel->useridiscurrent;
+	partially_grouped_rel->fdwroutine = input_rel->fdwroutine;
+	partially_grouped_rel->reltarget = partial_grouping_target;
+	return partially_grouped_rel;
+}
+
+/*
+ * Finalize the created partially aggregated paths by adding a 'Finalize
+ * Aggregate' node on top of them, and adding Sort and Gather nodes as required.
+ */
+static void
+add_finalized_paths(PlannerInfo *root, RelOptInfo *output_rel, RelOptInfo *partially_grouped_rel,
+					PathTarget *grouping_target, double d_num_groups,
+					const PushdownGrouping *grouping)
+{
+	List *partially_grouped_paths =
+		list_concat(partially_grouped_rel->pathlist, partially_grouped_rel->partial_pathlist);
+
+	ListCell *lc;
+	foreach (lc, partially_grouped_paths)
+	{
+		Path *partially_aggregated_path = lfirst(lc);
+		AggStrategy final_strategy;
+		if (contains_path_plain_or_sorted_agg(partially_aggregated_path))
+		{
+			const bool is_sorted =
+				pathkeys_contained_in(grouping->pathkeys, partially_aggregated_path->pathkeys);
+			if (!is_sorted)
+			{
+				partially_aggregated_path = (Path *) create_sort_path(root,
+																	  output_rel,
+																	  partially_aggregated_path,
+																	  grouping->pathkeys,
+																	  -1.0);
+			}
+
+			final_strategy = grouping->sorted_strategy;
+		}
+		else
+		{
+			final_strategy = AGG_HASHED;
+		}
+
+		/*
+		 * We have to add a Gather or Gather Merge on top of parallel plans. It
+		 * goes above the Sort we might have added just before, so that the Sort
+		 * is parallelized as well.
+		 */
+		if (partially_aggregated_path->parallel_workers > 0)
+		{
+			double total_groups =
+				partially_aggregated_path->rows * partially_aggregated_path->parallel_workers;
+			if (partially_aggregated_path->pathkeys == NIL)
+			{
+				partially_aggregated_path =
+					(Path *) create_gather_path(root,
+												partially_grouped_rel,
+												partially_aggregated_path,
+												partially_grouped_rel->reltarget,
+												/* required_outer = */ NULL,
+												&total_groups);
+			}
+			else
+			{
+				partially_aggregated_path =
+					(Path *) create_gather_merge_path(root,
+													  partially_grouped_rel,
+													  partially_aggregated_path,
+													  partially_grouped_rel->reltarget,
+													  partially_aggregated_path->pathkeys,
+													  /* required_outer = */ NULL,
+													  &total_groups);
+			}
+		}
+
+		add_path(output_rel,
+				 (Path *) create_agg_path(root,
+										  output_rel,
+										  partially_aggregated_path,
+										  grouping_target,
+										  final_strategy,
+										  AGGSPLIT_FINAL_DESERIAL,
+										  grouping->clauses,
+										  grouping->having_qual,
+										  grouping->final_costs,
+										  d_num_groups));
+	}
+}
+
+typedef struct DistinctAggrefContext
+{
+	/* The argument and the DISTINCT clause shared by all aggregates. */
+	Expr *argument;
+	SortGroupClause *distinct_clause;
+} DistinctAggrefContext;
+
+/*
+ * Check that all aggregates in the expression are DISTINCT aggregates of the
+ * same argument, e.g. count(DISTINCT x) and sum(DISTINCT x).
+ */
+static bool
+distinct_aggref_walker(Node *node, DistinctAggrefContext *context)
+{
+	if (node == NULL)
+		return false;
+
+	if (!IsA(node, Aggref))
+		return expression_tree_walker(node, distinct_aggref_walker, context);
+
+	Aggref *aggref = castNode(Aggref, node);
+	if (aggref->aggkind != AGGKIND_NORMAL || aggref->agglevelsup != 0 ||
+		aggref->aggdirectargs != NIL || aggref->aggorder != NIL || aggref->aggfilter != NULL ||
+		list_length(aggref->aggdistinct) != 1 || list_length(aggref->args) != 1)
+		return true;
+
+	Expr *argument = castNode(TargetEntry, linitial(aggref->args))->expr;
+	if (context->argument == NULL)
+	{
+		/* The vectorized grouping works only with the plain columns. */
+		if (!IsA(argument, Var) || castNode(Var, argument)->varattno <= 0)
+			return true;
+
+		context->argument = argument;
+		context->distinct_clause = linitial_node(SortGroupClause, aggref->aggdistinct);
+		return false;
+	}
+
+	/* The deduplication must be the same as for the first aggregate. */
+	SortGroupClause *distinct_clause = linitial_node(SortGroupClause, aggref->aggdistinct);
+	return !equal(argument, context->argument) ||
+		   distinct_clause->eqop != context->distinct_clause->eqop;
+}
+
+/*
+ * Push down the deduplication of the argument of DISTINCT aggregates to the
+ * chunks. The DISTINCT aggregates can't be partially aggregated, but when all
+ * aggregates of the query are DISTINCT aggregates of the same argument, e.g.
+ * count(DISTINCT x) and sum(DISTINCT x) GROUP BY g, the result doesn't change
+ * if the duplicate (g, x) pairs are removed before the aggregation. This is
+ * computed as a partial grouping by (g, x) without aggregate functions:
+ *
+ * Aggregate
+ *   -> Sort
+ *      -> Append
+ *         -> Partial HashAggregate
+ *            - Chunk 1
+ *         ...
+ *
+ * For compressed chunks, the partial grouping is performed by the vectorized
+ * aggregation, which keeps the distinct values in its hash tables. It emits
+ * the partial results when the hash table grows too large, and the regular
+ * hash aggregation spills to disk, so the memory usage is bounded in both
+ * cases.
+ */
+static void
+pushdown_distinct_aggregates(PlannerInfo *root, RelOptInfo *input_rel, RelOptInfo *output_rel,
+							 double d_num_groups)
+{
+	Query *parse = root->parse;
+
+	if (!ts_guc_enable_vectorized_aggregation)
+		return;
+
+	DistinctAggrefContext context = { 0 };
+	if (distinct_aggref_walker((Node *) output_rel->reltarget->exprs, &context) ||
+		distinct_aggref_walker(parse->havingQual, &context) || context.argument == NULL)
+		return;
+
+	List *subpaths = NIL;
+	Path *append = NULL;
+	Path *gather = NULL;
+	get_subpaths_from_append_path(input_rel->cheapest_total_path, &subpaths, &append, &gather);
+	if (gather != NULL || list_length(subpaths) < 2 || !has_decompress_chunk_subpath(subpaths))
+		return;
+
+#if PG16_LT
+	List *group_clauses = parse->groupClause;
+#else
+	List *group_clauses = root->processed_groupClause;
+#endif
+
+	/*
+	 * The partial grouping is by the grouping clauses and the aggregate
+	 * argument, which gets a new sort group reference.
+	 */
+	Index max_sortgroupref = 0;
+	ListCell *lc;
+	foreach (lc, root->processed_tlist)
+	{
+		max_sortgroupref = Max(max_sortgroupref, lfirst_node(TargetEntry, lc)->ressortgroupref);
+	}
+
+	PathTarget *partial_target = create_empty_pathtarget();
+	foreach (lc, group_clauses)
+	{
+		SortGroupClause *clause = lfirst_node(SortGroupClause, lc);
+		add_column_to_pathtarget(partial_target,
+								 (Expr *) get_sortgroupclause_expr(clause, root->processed_tlist),
+								 clause->tleSortGroupRef);
+	}
+
+	SortGroupClause *argument_clause = copyObject(context.distinct_clause);
+	argument_clause->tleSortGroupRef = max_sortgroupref + 1;
+	add_column_to_pathtarget(partial_target, context.argument, argument_clause->tleSortGroupRef);
+	List *partial_clauses = lappend(list_copy(group_clauses), argument_clause);
+
+	/* The hash aggregation can spill to disk, so we only use it. */
+	if (!grouping_is_hashable(partial_clauses))
+		return;
+
+	AggClauseCosts no_agg_costs;
+	MemSet(&no_agg_costs, 0, sizeof(AggClauseCosts));
+
+	PushdownGrouping partial_grouping = {
+		.clauses = partial_clauses,
+		.pathkeys = NIL,
+		.sorted_strategy = AGG_SORTED,
+		.flags = GROUPING_CAN_USE_HASH,
+		.partial_costs = &no_agg_costs,
+		.final_costs = &no_agg_costs,
+		.having_qual = NIL,
+	};
+
+	const double d_num_partial_groups = estimate_num_groups(root,
+															partial_target->exprs,
+															input_rel->cheapest_total_path->rows,
+															/* pgset = */ NULL,
+															/* estinfo = */ NULL);
+
+	RelOptInfo *partially_grouped_rel = make_partially_grouped_rel(root,
+																   UPPERREL_PARTIAL_GROUP_AGG,
+																   input_rel,
+																   partial_target);
+	generate_agg_pushdown_path(root,
+							   input_rel->cheapest_total_path,
+							   input_rel,
+							   partially_grouped_rel,
+							   partial_target,
+							   d_num_partial_groups,
+							   &partial_grouping);
+
+	if (partially_grouped_rel->pathlist == NIL)
+		return;
+
+	/*
+	 * The DISTINCT aggregates are computed by the sorted or plain aggregation.
+	 * Starting with PG 16, the group pathkeys also include the aggregate
+	 * argument, and the aggregates rely on the input being sorted by it.
+	 */
+	AggClauseCosts agg_costs;
+	MemSet(&agg_costs, 0, sizeof(AggClauseCosts));
+	get_agg_clause_costs(root, AGGSPLIT_SIMPLE, &agg_costs);
+
+	output_rel->pathlist = NIL;
+	output_rel->partial_pathlist = NIL;
+
+	foreach (lc, partially_grouped_rel->pathlist)
+	{
+		Path *path = lfirst(lc);
+		if (root->group_pathkeys != NIL &&
+			!pathkeys_contained_in(root->group_pathkeys, path->pathkeys))
+		{
+			path = (Path *) create_sort_path(root, output_rel, path, root->group_pathkeys, -1.0);
+		}
+
+		add_path(output_rel,
+				 (Path *) create_agg_path(root,
+										  output_rel,
+										  path,
+										  output_rel->reltarget,
+										  group_clauses ? AGG_SORTED : AGG_PLAIN,
+										  AGGSPLIT_SIMPLE,
+										  group_clauses,
+										  (List *) parse->havingQual,
+										  &agg_costs,
+										  d_num_groups));
+	}
+}
+
 /*
  * Replan the aggregation and create a partial aggregation at chunk level and finalize the
  * aggregation on top of an append node.
@@ -596,8 +930,11 @@ tsl_pushdown_partial_agg(PlannerInfo *root, Hypertable *ht, RelOptInfo *input_re
 	if (!ht)
 		return;
 
-	/* Perform partial aggregation planning only if there is an aggregation is requested */
-	if (!parse->hasAggs)
+	/*
+	 * Perform partial aggregation planning only if there is an aggregation or
+	 * a grouping without aggregates requested.
+	 */
+	if (!parse->hasAggs && parse->groupClause == NIL)
 		return;
 
 	/* Grouping sets are not supported by the partial aggregation pushdown */
@@ -623,28 +960,40 @@ tsl_pushdown_partial_agg(PlannerInfo *root, Hypertable *ht, RelOptInfo *input_re
 	if (existing_agg_path->aggsplit == AGGSPLIT_INITIAL_SERIAL)
 		return;
 
-	/* Don't replan aggregation if it contains already partials or non-serializable aggregates */
-	if (root->hasNonPartialAggs || root->hasNonSerialAggs)
-		return;
-
 	double d_num_groups = existing_agg_path->numGroups;
 	Assert(d_num_groups > 0);
 
-	/* Construct partial group agg upper relation */
-	RelOptInfo *partially_grouped_rel =
-		fetch_upper_rel(root, UPPERREL_PARTIAL_GROUP_AGG, input_rel->relids);
-	partially_grouped_rel->consider_parallel = input_rel->consider_parallel;
-	partially_grouped_rel->consider_startup = input_rel->consider_startup;
-	partially_grouped_rel->reloptkind = input_rel->reloptkind;
-	partially_grouped_rel->serverid = input_rel->serverid;
-	partially_grouped_rel->userid = input_rel->userid;
-	partially_grouped_rel->useridiscurrent = input_rel->useridiscurrent;
-	partially_grouped_rel->fdwroutine = input_rel->fdwroutine;
+	/*
+	 * The grouping without aggregates only benefits from the pushdown when the
+	 * vectorized aggregation can deduplicate the compressed batches.
+	 */
+	if (!parse->hasAggs)
+	{
+		List *subpaths = NIL;
+		Path *append = NULL;
+		Path *gather = NULL;
+		get_subpaths_from_append_path(input_rel->cheapest_total_path, &subpaths, &append, &gather);
+		if (!has_decompress_chunk_subpath(subpaths))
+			return;
+	}
+
+	/* Don't replan aggregation if it contains already partials or non-serializable aggregates */
+	if (root->hasNonPartialAggs || root->hasNonSerialAggs)
+	{
+		/* We can still deduplicate the argument of the DISTINCT aggregates. */
+		pushdown_distinct_aggregates(root, input_rel, output_rel, d_num_groups);
+		return;
+	}
 
 	/* Build target list for partial aggregate paths */
 	PathTarget *grouping_target = output_rel->reltarget;
 	PathTarget *partial_grouping_target = ts_make_partial_grouping_target(root, grouping_target);
-	partially_grouped_rel->reltarget = partial_grouping_target;
+
+	/* Construct partial group agg upper relation */
+	RelOptInfo *partially_grouped_rel = make_partially_grouped_rel(root,
+																   UPPERREL_PARTIAL_GROUP_AGG,
+																   input_rel,
+																   partial_grouping_target);
 
 	/* Calculate aggregation costs */
 	if (!extra_data->partial_costs_set)
@@ -662,16 +1011,31 @@ tsl_pushdown_partial_agg(PlannerInfo *root, Hypertable *ht, RelOptInfo *input_re
 		extra_data->partial_costs_set = true;
 	}
 
+	PushdownGrouping grouping = {
+#if PG16_LT
+		.clauses = parse->groupClause,
+#else
+		.clauses = root->processed_groupClause,
+#endif
+		.pathkeys = root->group_pathkeys,
+		.sorted_strategy = parse->groupClause ? AGG_SORTED : AGG_PLAIN,
+		.flags = extra_data->flags,
+		.partial_costs = &extra_data->agg_partial_costs,
+		.final_costs = &extra_data->agg_final_costs,
+		.having_qual = (List *) parse->havingQual,
+	};
+
 	/*
 	 * For queries with LIMIT, the aggregated relation can have a path with low
 	 * total cost, and a path with low startup cost. We must partialize both, so
-	 * loop through the entire pathlist.
+	 * loop through the entire pathlist. The sorted grouping without aggregates
+	 * is planned as a GroupPath.
 	 */
 	ListCell *lc;
 	foreach (lc, output_rel->pathlist)
 	{
 		Node *path = lfirst(lc);
-		if (!IsA(path, AggPath))
+		if (!IsA(path, AggPath) && !IsA(path, GroupPath))
 		{
 			/*
 			 * Shouldn't happen, but here we work with arbitrary paths we don't
@@ -684,100 +1048,129 @@ tsl_pushdown_partial_agg(PlannerInfo *root, Hypertable *ht, RelOptInfo *input_re
 		generate_agg_pushdown_path(root,
 								   (Path *) path,
 								   input_rel,
-								   output_rel,
 								   partially_grouped_rel,
-								   grouping_target,
 								   partial_grouping_target,
 								   d_num_groups,
-								   extra_data);
+								   &grouping);
 	}
 
 	/* Replan aggregation if we were able to generate partially grouped rel paths */
-	List *partially_grouped_paths =
-		list_concat(partially_grouped_rel->pathlist, partially_grouped_rel->partial_pathlist);
-	if (partially_grouped_paths == NIL)
+	if (partially_grouped_rel->pathlist == NIL && partially_grouped_rel->partial_pathlist == NIL)
 		return;
 
-	/* Prefer our paths */
-	output_rel->pathlist = NIL;
-	output_rel->partial_pathlist = NIL;
-
 	/*
-	 * Finalize the created partially aggregated paths by adding a
-	 * 'Finalize Aggregate' node on top of them, and adding Sort and Gather
-	 * nodes as required.
+	 * Prefer our paths for the aggregation. The grouping without aggregates
+	 * competes with the existing paths on cost.
 	 */
-	AggClauseCosts *agg_final_costs = &extra_data->agg_final_costs;
-	foreach (lc, partially_grouped_paths)
+	if (parse->hasAggs)
 	{
-		Path *partially_aggregated_path = lfirst(lc);
-		AggStrategy final_strategy;
-		if (contains_path_plain_or_sorted_agg(partially_aggregated_path))
-		{
-			const bool is_sorted =
-				pathkeys_contained_in(root->group_pathkeys, partially_aggregated_path->pathkeys);
-			if (!is_sorted)
-			{
-				partially_aggregated_path = (Path *) create_sort_path(root,
-																	  output_rel,
-																	  partially_aggregated_path,
-																	  root->group_pathkeys,
-																	  -1.0);
-			}
+		output_rel->pathlist = NIL;
+		output_rel->partial_pathlist = NIL;
+	}
 
-			final_strategy = parse->groupClause ? AGG_SORTED : AGG_PLAIN;
-		}
-		else
-		{
-			final_strategy = AGG_HASHED;
-		}
+	add_finalized_paths(root,
+						output_rel,
+						partially_grouped_rel,
+						grouping_target,
+						d_num_groups,
+						&grouping);
+}
 
-		/*
-		 * We have to add a Gather or Gather Merge on top of parallel plans. It
-		 * goes above the Sort we might have added just before, so that the Sort
-		 * is parallelized as well.
-		 */
-		if (partially_aggregated_path->parallel_workers > 0)
-		{
-			double total_groups =
-				partially_aggregated_path->rows * partially_aggregated_path->parallel_workers;
-			if (partially_aggregated_path->pathkeys == NIL)
-			{
-				partially_aggregated_path =
-					(Path *) create_gather_path(root,
-												partially_grouped_rel,
-												partially_aggregated_path,
-												partially_grouped_rel->reltarget,
-												/* required_outer = */ NULL,
-												&total_groups);
-			}
-			else
-			{
-				partially_aggregated_path =
-					(Path *) create_gather_merge_path(root,
-													  partially_grouped_rel,
-													  partially_aggregated_path,
-													  partially_grouped_rel->reltarget,
-													  partially_aggregated_path->pathkeys,
-													  /* required_outer = */ NULL,
-													  &total_groups);
-			}
-		}
+/*
+ * Push down the deduplication of a SELECT DISTINCT query without aggregates to
+ * the chunks, as a partial grouping by the DISTINCT clause:
+ *
+ * Finalize Aggregate
+ *   -> Append
+ *      -> Partial Aggregation
+ *        - Chunk 1
+ *      ...
+ *
+ * For compressed chunks, the partial grouping can be performed by the
+ * vectorized aggregation, which deduplicates the batches with constant
+ * segmentby values as a whole. The paths compete with the existing ones on
+ * cost, so we only add them when some chunks are compressed.
+ */
+void
+tsl_pushdown_partial_distinct(PlannerInfo *root, Hypertable *ht, RelOptInfo *input_rel,
+							  RelOptInfo *output_rel)
+{
+	Query *parse = root->parse;
 
-		add_path(output_rel,
-				 (Path *) create_agg_path(root,
-										  output_rel,
-										  partially_aggregated_path,
-										  grouping_target,
-										  final_strategy,
-										  AGGSPLIT_FINAL_DESERIAL,
+	if (!ht || !ts_guc_enable_vectorized_aggregation)
+		return;
+
+	/* The distinct clauses without the ones that are redundant by equivalence */
 #if PG16_LT
-										  parse->groupClause,
+	List *distinct_clauses = parse->distinctClause;
 #else
-										  root->processed_groupClause,
+	List *distinct_clauses = root->processed_distinctClause;
 #endif
-										  (List *) parse->havingQual,
-										  agg_final_costs,
-										  d_num_groups));
-	}
+
+	if (distinct_clauses == NIL || parse->hasDistinctOn || parse->hasAggs ||
+		parse->groupClause != NIL || parse->groupingSets != NIL || parse->hasWindowFuncs ||
+		parse->hasTargetSRFs || root->hasHavingQual)
+		return;
+
+	if (input_rel->cheapest_total_path == NULL || output_rel->pathlist == NIL)
+		return;
+
+	List *subpaths = NIL;
+	Path *append = NULL;
+	Path *gather = NULL;
+	get_subpaths_from_append_path(input_rel->cheapest_total_path, &subpaths, &append, &gather);
+	if (gather != NULL || list_length(subpaths) < 2)
+		return;
+
+	if (!has_decompress_chunk_subpath(subpaths))
+		return;
+
+	/* The number of distinct rows estimated for the existing paths. */
+	const double d_num_groups = ((Path *) linitial(output_rel->pathlist))->rows;
+
+	int flags = 0;
+	if (grouping_is_sortable(distinct_clauses))
+		flags |= GROUPING_CAN_USE_SORT;
+	if (grouping_is_hashable(distinct_clauses))
+		flags |= GROUPING_CAN_USE_HASH;
+
+	AggClauseCosts no_agg_costs;
+	MemSet(&no_agg_costs, 0, sizeof(AggClauseCosts));
+
+	PushdownGrouping grouping = {
+		.clauses = distinct_clauses,
+		.pathkeys = root->distinct_pathkeys,
+		.sorted_strategy = AGG_SORTED,
+		.flags = flags,
+		.partial_costs = &no_agg_costs,
+		.final_costs = &no_agg_costs,
+		.having_qual = NIL,
+	};
+
+	/*
+	 * PostgreSQL uses the same relation for the parallel partial distinct
+	 * paths. We don't push down the parallel plans anyway.
+	 */
+	RelOptInfo *existing_rel = fetch_upper_rel(root, UPPERREL_PARTIAL_DISTINCT, input_rel->relids);
+	if (existing_rel->pathlist != NIL || existing_rel->partial_pathlist != NIL)
+		return;
+
+	PathTarget *distinct_target = input_rel->reltarget;
+	RelOptInfo *partially_distinct_rel =
+		make_partially_grouped_rel(root, UPPERREL_PARTIAL_DISTINCT, input_rel, distinct_target);
+
+	generate_agg_pushdown_path(root,
+							   input_rel->cheapest_total_path,
+							   input_rel,
+							   partially_distinct_rel,
+							   distinct_target,
+							   d_num_groups,
+							   &grouping);
+
+	add_finalized_paths(root,
+						output_rel,
+						partially_distinct_rel,
+						distinct_target,
+						d_num_groups,
+						&grouping);
 }
@@ -14,3 +14,5 @@
 
 void tsl_pushdown_partial_agg(PlannerInfo *root, Hypertable *ht, RelOptInfo *input_rel,
 							  RelOptInfo *output_rel, void *extra);
+void tsl_pushdown_partial_distinct(PlannerInfo *root, Hypertable *ht, RelOptInfo *input_rel,
+								   RelOptInfo *output_rel);
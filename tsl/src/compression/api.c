@@ -905,16 +905,29 @@ tsl_compress_chunk(PG_FUNCTION_ARGS)
 
 	TS_PREVENT_FUNC_IF_READ_ONLY();
 	Chunk *chunk = ts_chunk_get_by_relid(uncompressed_chunk_id, true);
+	useam = PG_ARGISNULL(3) ? USE_AM_NULL : PG_GETARG_BOOL(3);
+	uncompressed_chunk_id =
+		tsl_compress_chunk_with_access_method(chunk, if_not_compressed, recompress, useam);
+
+	PG_RETURN_OID(uncompressed_chunk_id);
+}
+
+/*
+ * Compress the chunk either with the Hypercore access method or into a
+ * separate compressed chunk, depending on the current access method of the
+ * chunk and the requested one.
+ */
+Oid
+tsl_compress_chunk_with_access_method(Chunk *chunk, bool if_not_compressed, bool recompress,
+									  UseAccessMethod useam)
+{
 	bool rel_is_hypercore = get_table_am_oid(TS_HYPERCORE_TAM_NAME, false) == chunk->amoid;
-	useam = check_useam(PG_ARGISNULL(3) ? USE_AM_NULL : PG_GETARG_BOOL(3), rel_is_hypercore);
+	useam = check_useam(useam, rel_is_hypercore);
 
 	if (rel_is_hypercore || useam == USE_AM_TRUE)
-		uncompressed_chunk_id =
-			compress_hypercore(chunk, rel_is_hypercore, useam, if_not_compressed, recompress);
-	else
-		uncompressed_chunk_id = tsl_compress_chunk_wrapper(chunk, if_not_compressed, recompress);
+		return compress_hypercore(chunk, rel_is_hypercore, useam, if_not_compressed, recompress);
 
-	PG_RETURN_OID(uncompressed_chunk_id);
+	return tsl_compress_chunk_wrapper(chunk, if_not_compressed, recompress);
 }
 
 Oid
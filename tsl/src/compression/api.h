@@ -10,11 +10,14 @@
 #include <utils.h>
 
 #include "chunk.h"
+#include "guc.h"
 
 extern Datum tsl_create_compressed_chunk(PG_FUNCTION_ARGS);
 extern Datum tsl_compress_chunk(PG_FUNCTION_ARGS);
 extern Datum tsl_decompress_chunk(PG_FUNCTION_ARGS);
 extern Oid tsl_compress_chunk_wrapper(Chunk *chunk, bool if_not_compressed, bool recompress);
+extern Oid tsl_compress_chunk_with_access_method(Chunk *chunk, bool if_not_compressed,
+												 bool recompress, UseAccessMethod useam);
 
 extern Datum tsl_get_compressed_chunk_index_for_recompression(
 	PG_FUNCTION_ARGS); // arg is oid of uncompressed chunk
@@ -27,6 +27,7 @@
 #include "batch_metadata_builder.h"
 #include "chunk.h"
 #include "compression.h"
+#include "compression_parallel.h"
 #include "create.h"
 #include "custom_type_cache.h"
 #include "debug_assert.h"
@@ -499,9 +500,24 @@ compress_chunk(Oid in_table, Oid out_table, int insert_options)
 			 "using tuplesort to scan rows from \"%s\" for compression",
 			 RelationGetRelationName(in_rel));
 
-		Tuplesortstate *sorted_rel = compress_chunk_sort_relation(settings, in_rel);
-		row_compressor_append_sorted_rows(&row_compressor, sorted_rel, in_desc, in_rel);
-		tuplesort_end(sorted_rel);
+		int nworkers = compress_chunk_parallel_workers(settings, in_rel);
+		bool compressed_in_parallel = false;
+
+		if (nworkers > 0)
+		{
+			elog(ts_guc_debug_compression_path_info ? INFO : DEBUG1,
+				 "using parallel workers to compress rows from \"%s\"",
+				 RelationGetRelationName(in_rel));
+			compressed_in_parallel =
+				compress_chunk_parallel(settings, in_rel, &row_compressor, nworkers);
+		}
+
+		if (!compressed_in_parallel)
+		{
+			Tuplesortstate *sorted_rel = compress_chunk_sort_relation(settings, in_rel);
+			row_compressor_append_sorted_rows(&row_compressor, sorted_rel, in_desc, in_rel);
+			tuplesort_end(sorted_rel);
+		}
 	}
 
 	row_compressor_close(&row_compressor);
@@ -531,7 +547,7 @@ compress_chunk(Oid in_table, Oid out_table, int insert_options)
 }
 
 Tuplesortstate *
-compression_create_tuplesort_state(CompressionSettings *settings, Relation rel)
+compression_create_tuplesort_state(CompressionSettings *settings, Relation rel, int sort_mem)
 {
 	TupleDesc tupdesc = RelationGetDescr(rel);
 	int num_segmentby = ts_array_length(settings->fd.segmentby);
@@ -575,7 +591,7 @@ compression_create_tuplesort_state(CompressionSettings *settings, Relation rel)
 								sort_operators,
 								sort_collations,
 								nulls_first,
-								maintenance_work_mem,
+								sort_mem,
 								NULL,
 								false /*=randomAccess*/);
 }
@@ -586,7 +602,7 @@ compress_chunk_sort_relation(CompressionSettings *settings, Relation in_rel)
 	Tuplesortstate *tuplesortstate;
 	TableScanDesc scan;
 	TupleTableSlot *slot;
-	tuplesortstate = compression_create_tuplesort_state(settings, in_rel);
+	tuplesortstate = compression_create_tuplesort_state(settings, in_rel, maintenance_work_mem);
 	scan = table_beginscan(in_rel, GetLatestSnapshot(), 0, NULL);
 	hypercore_scan_set_skip_compressed(scan, true);
 	slot = table_slot_create(in_rel, NULL);
@@ -843,7 +859,7 @@ void
 row_compressor_append_sorted_rows(RowCompressor *row_compressor, Tuplesortstate *sorted_rel,
 								  TupleDesc sorted_desc, Relation in_rel)
 {
-	CommandId mycid = GetCurrentCommandId(true);
+	CommandId mycid = GetCurrentCommandId(row_compressor->send_tuple == NULL);
 	TupleTableSlot *slot = MakeTupleTableSlot(sorted_desc, &TTSOpsMinimalTuple);
 	bool got_tuple;
 	int64 nrows_processed = 0;
@@ -1004,6 +1020,22 @@ row_compressor_append_row(RowCompressor *row_compressor, TupleTableSlot *row)
 	row_compressor->rows_compressed_into_current_value += 1;
 }
 
+static void
+row_compressor_insert_tuple(RowCompressor *row_compressor, HeapTuple compressed_tuple,
+							CommandId mycid)
+{
+	Assert(row_compressor->bistate != NULL);
+	heap_insert(row_compressor->compressed_table,
+				compressed_tuple,
+				mycid,
+				row_compressor->insert_options /*=options*/,
+				row_compressor->bistate);
+	if (row_compressor->resultRelInfo->ri_NumIndices > 0)
+	{
+		ts_catalog_index_insert(row_compressor->resultRelInfo, compressed_tuple);
+	}
+}
+
 static void
 row_compressor_flush(RowCompressor *row_compressor, CommandId mycid, bool changed_groups)
 {
@@ -1060,16 +1092,10 @@ row_compressor_flush(RowCompressor *row_compressor, CommandId mycid, bool change
 	compressed_tuple = heap_form_tuple(RelationGetDescr(row_compressor->compressed_table),
 									   row_compressor->compressed_values,
 									   row_compressor->compressed_is_null);
-	Assert(row_compressor->bistate != NULL);
-	heap_insert(row_compressor->compressed_table,
-				compressed_tuple,
-				mycid,
-				row_compressor->insert_options /*=options*/,
-				row_compressor->bistate);
-	if (row_compressor->resultRelInfo->ri_NumIndices > 0)
-	{
-		ts_catalog_index_insert(row_compressor->resultRelInfo, compressed_tuple);
-	}
+	if (row_compressor->send_tuple != NULL)
+		row_compressor->send_tuple(row_compressor, compressed_tuple);
+	else
+		row_compressor_insert_tuple(row_compressor, compressed_tuple, mycid);
 
 	heap_freetuple(compressed_tuple);
 
@@ -1114,6 +1140,32 @@ row_compressor_flush(RowCompressor *row_compressor, CommandId mycid, bool change
 	MemoryContextReset(row_compressor->per_row_ctx);
 }
 
+/*
+ * Insert a compressed tuple that was formed by another row compressor, e.g.
+ * in a parallel compression worker, and account for it in the statistics of
+ * this one.
+ */
+void
+row_compressor_insert_compressed_tuple(RowCompressor *row_compressor, HeapTuple compressed_tuple,
+									   CommandId mycid)
+{
+	bool is_null;
+	Datum count =
+		heap_getattr(compressed_tuple,
+					 AttrOffsetGetAttrNumber(row_compressor->count_metadata_column_offset),
+					 RelationGetDescr(row_compressor->compressed_table),
+					 &is_null);
+	Ensure(!is_null, "missing row count in compressed tuple");
+
+	row_compressor_insert_tuple(row_compressor, compressed_tuple, mycid);
+
+	if (NULL != row_compressor->on_flush)
+		row_compressor->on_flush(row_compressor, DatumGetInt32(count));
+
+	row_compressor->rowcnt_pre_compression += DatumGetInt32(count);
+	row_compressor->num_compressed_rows++;
+}
+
 void
 row_compressor_reset(RowCompressor *row_compressor)
 {
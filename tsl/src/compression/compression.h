@@ -270,6 +270,11 @@ typedef struct RowCompressor
 	/* Callback called on every flush. The ntuples argument is the number of
 	 * tuples flushed. Typically used for progress reporting. */
 	void (*on_flush)(struct RowCompressor *rowcompress, uint64 ntuples);
+
+	/* Callback called with every compressed tuple instead of inserting it
+	 * into the compressed table. Used by the parallel compression workers,
+	 * which cannot insert tuples themselves. */
+	void (*send_tuple)(struct RowCompressor *rowcompress, HeapTuple compressed_tuple);
 } RowCompressor;
 
 /*
@@ -365,7 +370,7 @@ extern void compress_chunk_populate_sort_info_for_column(const CompressionSettin
 														 AttrNumber *att_nums, Oid *sort_operator,
 														 Oid *collation, bool *nulls_first);
 extern Tuplesortstate *compression_create_tuplesort_state(CompressionSettings *settings,
-														  Relation rel);
+														  Relation rel, int sort_mem);
 extern void row_compressor_init(const CompressionSettings *settings, RowCompressor *row_compressor,
 								Relation uncompressed_table, Relation compressed_table,
 								int16 num_columns_in_compressed_table, bool need_bistate,
@@ -375,6 +380,8 @@ extern void row_compressor_close(RowCompressor *row_compressor);
 extern void row_compressor_append_sorted_rows(RowCompressor *row_compressor,
 											  Tuplesortstate *sorted_rel, TupleDesc sorted_desc,
 											  Relation in_rel);
+extern void row_compressor_insert_compressed_tuple(RowCompressor *row_compressor,
+												   HeapTuple compressed_tuple, CommandId mycid);
 extern Oid get_compressed_chunk_index(ResultRelInfo *resultRelInfo,
 									  const CompressionSettings *settings);
 
@@ -0,0 +1,512 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * Parallel compression of a chunk.
+ *
+ * The rows of the chunk are partitioned by the hash of their segmentby
+ * values, so that every segmentby group belongs to exactly one partition, and
+ * each parallel worker compresses one partition. The leader scans the chunk
+ * once and sends every row to the worker of its partition through a shared
+ * memory queue. The workers sort the rows of their partition and compress
+ * them with their own row compressor. The workers cannot insert tuples, so the
+ * compressed tuples are sent back to the leader through another set of
+ * queues. The leader collects them once it has sent all the rows, and inserts
+ * them into the compressed chunk after leaving the parallel mode, because
+ * toasting the compressed values requires assigning new OIDs, which is not
+ * allowed in the parallel mode. Until then, they are kept in a tuplestore,
+ * which spills to disk above work_mem.
+ */
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <access/parallel.h>
+#include <access/relation.h>
+#include <access/tableam.h>
+#include <common/hashfn.h>
+#include <executor/tuptable.h>
+#include <miscadmin.h>
+#include <port/atomics.h>
+#include <storage/latch.h>
+#include <storage/shm_mq.h>
+#include <utils/lsyscache.h>
+#include <utils/snapmgr.h>
+#include <utils/tuplesort.h>
+#include <utils/tuplestore.h>
+#include <utils/typcache.h>
+#include <utils/wait_event.h>
+
+#include "compression.h"
+#include "compression_parallel.h"
+#include "debug_assert.h"
+#include "extension_constants.h"
+#include "guc.h"
+#include "hypercore/hypercore_handler.h"
+#include "ts_catalog/array_utils.h"
+#include "ts_catalog/compression_settings.h"
+
+#define PARALLEL_KEY_COMPRESS_SHARED UINT64CONST(0xB000000000000001)
+#define PARALLEL_KEY_ROW_QUEUE UINT64CONST(0xB000000000000002)
+#define PARALLEL_KEY_TUPLE_QUEUE UINT64CONST(0xB000000000000003)
+
+#define PARALLEL_COMPRESS_QUEUE_SIZE 65536
+
+typedef struct ParallelCompressShared
+{
+	Oid in_relid;
+	Oid out_relid;
+
+	/* Sort memory of each worker, in kilobytes. */
+	int sort_mem;
+
+	/* The number of partitions compressed by the workers. */
+	pg_atomic_uint32 partitions_done;
+} ParallelCompressShared;
+
+typedef struct SegmentbyHashColumn
+{
+	AttrNumber attno;
+	Oid collation;
+	FmgrInfo *hash_finfo;
+} SegmentbyHashColumn;
+
+/* The queue to the leader, in a parallel worker. */
+static shm_mq_handle *worker_tuple_queue = NULL;
+
+/*
+ * Look up the hash functions of the segmentby columns. Returns false if some
+ * of the columns don't have a hash function, and the chunk cannot be
+ * partitioned by them.
+ */
+static bool
+segmentby_hash_columns_init(const CompressionSettings *settings, Relation in_rel,
+							SegmentbyHashColumn *columns)
+{
+	TupleDesc tupdesc = RelationGetDescr(in_rel);
+	int num_segmentby = ts_array_length(settings->fd.segmentby);
+
+	for (int i = 0; i < num_segmentby; i++)
+	{
+		const char *attname = ts_array_get_element_text(settings->fd.segmentby, i + 1);
+		AttrNumber attno = get_attnum(RelationGetRelid(in_rel), attname);
+		Ensure(attno != InvalidAttrNumber,
+			   "table \"%s\" does not have column \"%s\"",
+			   RelationGetRelationName(in_rel),
+			   attname);
+
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, AttrNumberGetAttrOffset(attno));
+		TypeCacheEntry *tentry = lookup_type_cache(attr->atttypid, TYPECACHE_HASH_PROC_FINFO);
+		if (!OidIsValid(tentry->hash_proc))
+			return false;
+
+		columns[i] = (SegmentbyHashColumn){
+			.attno = attno,
+			.collation = attr->attcollation,
+			.hash_finfo = &tentry->hash_proc_finfo,
+		};
+	}
+
+	return true;
+}
+
+static uint32
+segmentby_hash(const SegmentbyHashColumn *columns, int num_columns, TupleTableSlot *slot)
+{
+	uint32 hash = 0;
+
+	for (int i = 0; i < num_columns; i++)
+	{
+		bool is_null;
+		Datum value = slot_getattr(slot, columns[i].attno, &is_null);
+		uint32 value_hash = 0;
+
+		if (!is_null)
+			value_hash = DatumGetUInt32(
+				FunctionCall1Coll(columns[i].hash_finfo, columns[i].collation, value));
+
+		hash = hash_combine(hash, value_hash);
+	}
+
+	return murmurhash32(hash);
+}
+
+/*
+ * The number of parallel workers to use for compressing the given chunk, or
+ * zero if it should be compressed serially.
+ */
+int
+compress_chunk_parallel_workers(const CompressionSettings *settings, Relation in_rel)
+{
+	int num_segmentby = ts_array_length(settings->fd.segmentby);
+	int nworkers = Min(ts_guc_compress_chunk_parallel_workers, max_parallel_maintenance_workers);
+
+	/*
+	 * Without segmentby columns, the chunk cannot be partitioned without
+	 * splitting the compressed batches.
+	 */
+	if (nworkers <= 0 || num_segmentby == 0)
+		return 0;
+
+	/*
+	 * Hypercore keeps the compressed data in the same relation, and the
+	 * workers don't know how to skip it.
+	 */
+	if (REL_IS_HYPERCORE(in_rel))
+		return 0;
+
+	if (IsInParallelMode())
+		return 0;
+
+	SegmentbyHashColumn *columns = palloc(sizeof(SegmentbyHashColumn) * num_segmentby);
+	bool hashable = segmentby_hash_columns_init(settings, in_rel, columns);
+	pfree(columns);
+
+	return hashable ? nworkers : 0;
+}
+
+static void
+send_compressed_tuple(RowCompressor *row_compressor, HeapTuple compressed_tuple)
+{
+	shm_mq_result result = shm_mq_send(worker_tuple_queue,
+									   compressed_tuple->t_len,
+									   compressed_tuple->t_data,
+									   /* nowait = */ false,
+									   /* force_flush = */ false);
+	if (result != SHM_MQ_SUCCESS)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("could not send compressed tuple to parallel compression leader")));
+}
+
+/*
+ * Receive the rows of the partition from the leader and sort them.
+ */
+static Tuplesortstate *
+receive_partition(CompressionSettings *settings, Relation in_rel, shm_mq_handle *row_queue,
+				  int sort_mem)
+{
+	Tuplesortstate *tuplesortstate =
+		compression_create_tuplesort_state(settings, in_rel, sort_mem);
+	TupleTableSlot *slot = MakeSingleTupleTableSlot(RelationGetDescr(in_rel), &TTSOpsHeapTuple);
+
+	for (;;)
+	{
+		Size nbytes;
+		void *data;
+
+		CHECK_FOR_INTERRUPTS();
+
+		/* The leader detaches from the queue after sending all the rows. */
+		shm_mq_result result = shm_mq_receive(row_queue, &nbytes, &data, /* nowait = */ false);
+		if (result == SHM_MQ_DETACHED)
+			break;
+
+		Assert(result == SHM_MQ_SUCCESS);
+
+		HeapTupleData tuple = {
+			.t_len = nbytes,
+			.t_data = (HeapTupleHeader) data,
+			.t_tableOid = RelationGetRelid(in_rel),
+		};
+		ItemPointerSetInvalid(&tuple.t_self);
+
+		/* This copies the tuple, so that the queue can be reused. */
+		ExecStoreHeapTuple(&tuple, slot, false);
+		tuplesort_puttupleslot(tuplesortstate, slot);
+		ExecClearTuple(slot);
+	}
+
+	ExecDropSingleTupleTableSlot(slot);
+
+	tuplesort_performsort(tuplesortstate);
+
+	return tuplesortstate;
+}
+
+/*
+ * Entry point of the parallel compression worker.
+ */
+void
+compress_chunk_parallel_main(dsm_segment *seg, shm_toc *toc)
+{
+	ParallelCompressShared *shared = shm_toc_lookup(toc, PARALLEL_KEY_COMPRESS_SHARED, false);
+	char *row_queues = shm_toc_lookup(toc, PARALLEL_KEY_ROW_QUEUE, false);
+	char *tuple_queues = shm_toc_lookup(toc, PARALLEL_KEY_TUPLE_QUEUE, false);
+	const Size queue_offset = ParallelWorkerNumber * PARALLEL_COMPRESS_QUEUE_SIZE;
+
+	shm_mq *row_mq = (shm_mq *) (row_queues + queue_offset);
+	shm_mq_set_receiver(row_mq, MyProc);
+	shm_mq_handle *row_queue = shm_mq_attach(row_mq, seg, NULL);
+
+	shm_mq *tuple_mq = (shm_mq *) (tuple_queues + queue_offset);
+	shm_mq_set_sender(tuple_mq, MyProc);
+	worker_tuple_queue = shm_mq_attach(tuple_mq, seg, NULL);
+
+	/*
+	 * The leader holds the stronger locks, and the workers are in its lock
+	 * group, so these don't conflict with them.
+	 */
+	Relation in_rel = table_open(shared->in_relid, AccessShareLock);
+	Relation out_rel = table_open(shared->out_relid, AccessShareLock);
+	CompressionSettings *settings =
+		ts_compression_settings_get_by_compress_relid(shared->out_relid);
+	Ensure(settings != NULL,
+		   "missing compression settings for \"%s\"",
+		   RelationGetRelationName(out_rel));
+
+	RowCompressor row_compressor;
+	row_compressor_init(settings,
+						&row_compressor,
+						in_rel,
+						out_rel,
+						RelationGetDescr(out_rel)->natts,
+						false /*need_bistate*/,
+						0 /*insert options*/);
+	row_compressor.send_tuple = send_compressed_tuple;
+
+	Tuplesortstate *sorted_rel = receive_partition(settings, in_rel, row_queue, shared->sort_mem);
+	row_compressor_append_sorted_rows(&row_compressor,
+									  sorted_rel,
+									  RelationGetDescr(in_rel),
+									  in_rel);
+	tuplesort_end(sorted_rel);
+	pg_atomic_fetch_add_u32(&shared->partitions_done, 1);
+
+	row_compressor_close(&row_compressor);
+	shm_mq_detach(row_queue);
+	shm_mq_detach(worker_tuple_queue);
+	worker_tuple_queue = NULL;
+
+	table_close(out_rel, AccessShareLock);
+	table_close(in_rel, AccessShareLock);
+}
+
+/*
+ * Scan the chunk and send every row to the worker of its partition. There is
+ * one partition per launched worker.
+ */
+static void
+send_partitioned_rows(Relation in_rel, const SegmentbyHashColumn *columns, int num_columns,
+					  shm_mq_handle **row_queues, int npartitions)
+{
+	TableScanDesc scan = table_beginscan(in_rel, GetLatestSnapshot(), 0, NULL);
+	TupleTableSlot *slot = table_slot_create(in_rel, NULL);
+
+	while (table_scan_getnextslot(scan, ForwardScanDirection, slot))
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		uint32 partition = segmentby_hash(columns, num_columns, slot) % npartitions;
+		bool should_free;
+		HeapTuple tuple = ExecFetchSlotHeapTuple(slot, false, &should_free);
+
+		shm_mq_result result = shm_mq_send(row_queues[partition],
+										   tuple->t_len,
+										   tuple->t_data,
+										   /* nowait = */ false,
+										   /* force_flush = */ false);
+		if (result != SHM_MQ_SUCCESS)
+			ereport(ERROR,
+					(errcode(ERRCODE_INTERNAL_ERROR),
+					 errmsg("could not send row to parallel compression worker")));
+
+		if (should_free)
+			heap_freetuple(tuple);
+	}
+
+	table_endscan(scan);
+	ExecDropSingleTupleTableSlot(slot);
+
+	/* Tell the workers that they have all the rows of their partitions. */
+	for (int i = 0; i < npartitions; i++)
+		shm_mq_detach(row_queues[i]);
+}
+
+/*
+ * Receive the compressed tuples from the workers until all of them are done.
+ */
+static void
+receive_compressed_tuples(ParallelContext *pcxt, shm_mq_handle **queues,
+						  Tuplestorestate *tuplestore)
+{
+	int nactive = pcxt->nworkers_launched;
+	bool *detached = palloc0(sizeof(bool) * pcxt->nworkers_launched);
+
+	while (nactive > 0)
+	{
+		bool progress = false;
+
+		CHECK_FOR_INTERRUPTS();
+
+		for (int i = 0; i < pcxt->nworkers_launched; i++)
+		{
+			Size nbytes;
+			void *data;
+
+			if (detached[i])
+				continue;
+
+			shm_mq_result result = shm_mq_receive(queues[i], &nbytes, &data, /* nowait = */ true);
+			if (result == SHM_MQ_SUCCESS)
+			{
+				HeapTupleData tuple = {
+					.t_len = nbytes,
+					.t_data = (HeapTupleHeader) data,
+					.t_tableOid = InvalidOid,
+				};
+				ItemPointerSetInvalid(&tuple.t_self);
+
+				/* This copies the tuple, so that the queue can be reused. */
+				tuplestore_puttuple(tuplestore, &tuple);
+				progress = true;
+			}
+			else if (result == SHM_MQ_DETACHED)
+			{
+				detached[i] = true;
+				nactive--;
+				progress = true;
+			}
+		}
+
+		if (!progress)
+		{
+			(void) WaitLatch(MyLatch,
+							 WL_LATCH_SET | WL_EXIT_ON_PM_DEATH,
+							 -1,
+							 WAIT_EVENT_MQ_RECEIVE);
+			ResetLatch(MyLatch);
+		}
+	}
+
+	pfree(detached);
+}
+
+/*
+ * Compress the chunk using the parallel workers, and insert the compressed
+ * tuples using the given row compressor. Returns false if no workers could be
+ * launched and nothing was done, so the chunk has to be compressed serially.
+ */
+bool
+compress_chunk_parallel(CompressionSettings *settings, Relation in_rel,
+						RowCompressor *row_compressor, int nworkers)
+{
+	Relation out_rel = row_compressor->compressed_table;
+	int num_segmentby = ts_array_length(settings->fd.segmentby);
+	SegmentbyHashColumn *columns = palloc(sizeof(SegmentbyHashColumn) * num_segmentby);
+	if (!segmentby_hash_columns_init(settings, in_rel, columns))
+		elog(ERROR, "cannot hash segmentby columns for parallel compression");
+
+	EnterParallelMode();
+	ParallelContext *pcxt =
+		CreateParallelContext(EXTENSION_TSL_SO, "compress_chunk_parallel_main", nworkers);
+
+	Size queues_size = mul_size(PARALLEL_COMPRESS_QUEUE_SIZE, pcxt->nworkers);
+	shm_toc_estimate_chunk(&pcxt->estimator, sizeof(ParallelCompressShared));
+	shm_toc_estimate_chunk(&pcxt->estimator, queues_size);
+	shm_toc_estimate_chunk(&pcxt->estimator, queues_size);
+	shm_toc_estimate_keys(&pcxt->estimator, 3);
+
+	InitializeParallelDSM(pcxt);
+
+	ParallelCompressShared *shared =
+		shm_toc_allocate(pcxt->toc, sizeof(ParallelCompressShared));
+	*shared = (ParallelCompressShared){
+		.in_relid = RelationGetRelid(in_rel),
+		.out_relid = RelationGetRelid(out_rel),
+		.sort_mem = Max(maintenance_work_mem / nworkers, 64),
+	};
+	pg_atomic_init_u32(&shared->partitions_done, 0);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_COMPRESS_SHARED, shared);
+
+	char *row_queues = shm_toc_allocate(pcxt->toc, queues_size);
+	char *tuple_queues = shm_toc_allocate(pcxt->toc, queues_size);
+	for (int i = 0; i < pcxt->nworkers; i++)
+	{
+		shm_mq *row_mq = shm_mq_create(row_queues + i * PARALLEL_COMPRESS_QUEUE_SIZE,
+									   PARALLEL_COMPRESS_QUEUE_SIZE);
+		shm_mq_set_sender(row_mq, MyProc);
+
+		shm_mq *tuple_mq = shm_mq_create(tuple_queues + i * PARALLEL_COMPRESS_QUEUE_SIZE,
+										 PARALLEL_COMPRESS_QUEUE_SIZE);
+		shm_mq_set_receiver(tuple_mq, MyProc);
+	}
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_ROW_QUEUE, row_queues);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_TUPLE_QUEUE, tuple_queues);
+
+	LaunchParallelWorkers(pcxt);
+
+	elog(DEBUG1,
+		 "launched %d of %d parallel workers to compress rows from \"%s\"",
+		 pcxt->nworkers_launched,
+		 nworkers,
+		 RelationGetRelationName(in_rel));
+
+	if (pcxt->nworkers_launched == 0)
+	{
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+		return false;
+	}
+
+	/*
+	 * The workers are launched in the order of their numbers, so the launched
+	 * ones use the first queues.
+	 */
+	shm_mq_handle **row_mqh = palloc(sizeof(shm_mq_handle *) * pcxt->nworkers_launched);
+	shm_mq_handle **tuple_mqh = palloc(sizeof(shm_mq_handle *) * pcxt->nworkers_launched);
+	for (int i = 0; i < pcxt->nworkers_launched; i++)
+	{
+		shm_mq *row_mq = (shm_mq *) (row_queues + i * PARALLEL_COMPRESS_QUEUE_SIZE);
+		row_mqh[i] = shm_mq_attach(row_mq, pcxt->seg, pcxt->worker[i].bgwhandle);
+
+		shm_mq *tuple_mq = (shm_mq *) (tuple_queues + i * PARALLEL_COMPRESS_QUEUE_SIZE);
+		tuple_mqh[i] = shm_mq_attach(tuple_mq, pcxt->seg, pcxt->worker[i].bgwhandle);
+	}
+
+	/*
+	 * The workers only start sending the compressed tuples after they have
+	 * received all the rows of their partition, so we can send all the rows
+	 * before receiving anything.
+	 */
+	send_partitioned_rows(in_rel, columns, num_segmentby, row_mqh, pcxt->nworkers_launched);
+
+	Tuplestorestate *tuplestore = tuplestore_begin_heap(false, false, work_mem);
+	receive_compressed_tuples(pcxt, tuple_mqh, tuplestore);
+
+	WaitForParallelWorkersToFinish(pcxt);
+
+	/* Every launched worker compresses one partition. */
+	uint32 partitions_done = pg_atomic_read_u32(&shared->partitions_done);
+	Ensure(partitions_done == (uint32) pcxt->nworkers_launched,
+		   "parallel compression of \"%s\" did not process all partitions",
+		   RelationGetRelationName(in_rel));
+
+	elog(ts_guc_debug_compression_path_info ? INFO : DEBUG1,
+		 "compressed %u partitions of \"%s\" in parallel workers",
+		 partitions_done,
+		 RelationGetRelationName(in_rel));
+
+	DestroyParallelContext(pcxt);
+	ExitParallelMode();
+
+	CommandId mycid = GetCurrentCommandId(true);
+	TupleTableSlot *slot =
+		MakeSingleTupleTableSlot(RelationGetDescr(out_rel), &TTSOpsMinimalTuple);
+	while (tuplestore_gettupleslot(tuplestore, true /*forward*/, false /*copy*/, slot))
+	{
+		bool should_free;
+		HeapTuple compressed_tuple = ExecFetchSlotHeapTuple(slot, false, &should_free);
+
+		row_compressor_insert_compressed_tuple(row_compressor, compressed_tuple, mycid);
+
+		if (should_free)
+			heap_freetuple(compressed_tuple);
+	}
+
+	ExecDropSingleTupleTableSlot(slot);
+	tuplestore_end(tuplestore);
+
+	return true;
+}
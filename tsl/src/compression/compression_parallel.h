@@ -0,0 +1,20 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+#include <storage/dsm.h>
+#include <storage/shm_toc.h>
+#include <utils/rel.h>
+
+#include "compression.h"
+#include "export.h"
+#include "ts_catalog/compression_settings.h"
+
+extern int compress_chunk_parallel_workers(const CompressionSettings *settings, Relation in_rel);
+extern bool compress_chunk_parallel(CompressionSettings *settings, Relation in_rel,
+									RowCompressor *row_compressor, int nworkers);
+extern PGDLLEXPORT void compress_chunk_parallel_main(dsm_segment *seg, shm_toc *toc);
@@ -0,0 +1,485 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * The percentile_sketch(float8) and percentile_sketch_merge(bytea) aggregates,
+ * which build a DDSketch of the values, and the approx_percentile(bytea,
+ * float8) function, which estimates a percentile from the sketch.
+ *
+ * The result of the aggregates is the serialized sketch, which is also the
+ * serialized aggregate state. The sketches can be stored in a continuous
+ * aggregate and merged at query time, for example to compute the daily
+ * percentiles from an hourly continuous aggregate.
+ */
+
+#include <postgres.h>
+
+#include <math.h>
+
+#include <libpq/pqformat.h>
+
+#include "compression/arrow_c_data_interface.h"
+#include "ddsketch.h"
+
+#define DDSKETCH_FORMAT_VERSION 1
+
+/*
+ * The bucket with the key k contains the values in (gamma^(k-1), gamma^k],
+ * where gamma = (1 + a) / (1 - a) for the relative accuracy a.
+ */
+#define DDSKETCH_GAMMA ((1.0 + DDSKETCH_RELATIVE_ACCURACY) / (1.0 - DDSKETCH_RELATIVE_ACCURACY))
+
+static float8 ddsketch_log_gamma = 0;
+
+static inline int32
+ddsketch_key(float8 abs_value)
+{
+	if (unlikely(ddsketch_log_gamma == 0))
+		ddsketch_log_gamma = log(DDSKETCH_GAMMA);
+
+	return (int32) ceil(log(abs_value) / ddsketch_log_gamma);
+}
+
+/* The value of the bucket, which has the same relative error for its bounds. */
+static float8
+ddsketch_key_value(int32 key)
+{
+	return 2.0 * pow(DDSKETCH_GAMMA, key) / (1.0 + DDSKETCH_GAMMA);
+}
+
+void
+ddsketch_init(DDSketch *sketch)
+{
+	memset(sketch, 0, sizeof(DDSketch));
+}
+
+/*
+ * Make the store cover the keys from lo to hi. The buckets below the
+ * DDSKETCH_MAX_KEYS highest ones are collapsed into the lowest remaining one.
+ */
+static void
+store_extend(DDSketchStore *store, int32 lo, int32 hi, MemoryContext mcxt)
+{
+	const int32 old_hi = store->min_key + store->nkeys - 1;
+
+	if (store->nkeys > 0)
+	{
+		lo = Min(lo, store->min_key);
+		hi = Max(hi, old_hi);
+	}
+
+	if ((int64) hi - lo + 1 > DDSKETCH_MAX_KEYS)
+		lo = hi - DDSKETCH_MAX_KEYS + 1;
+
+	if (store->nkeys > 0 && lo == store->min_key && hi == old_hi)
+		return;
+
+	uint64 *counts = MemoryContextAllocZero(mcxt, sizeof(uint64) * (hi - lo + 1));
+	for (int i = 0; i < store->nkeys; i++)
+		counts[Max(store->min_key + i, lo) - lo] += store->counts[i];
+
+	if (store->counts != NULL)
+		pfree(store->counts);
+
+	store->counts = counts;
+	store->min_key = lo;
+	store->nkeys = hi - lo + 1;
+}
+
+static inline void
+store_add(DDSketchStore *store, int32 key, uint64 n, MemoryContext mcxt)
+{
+	if (unlikely(store->nkeys == 0 || key < store->min_key ||
+				 key >= store->min_key + store->nkeys))
+		store_extend(store, key, key, mcxt);
+
+	/* The key is below the store if it has been collapsed. */
+	store->counts[Max(key, store->min_key) - store->min_key] += n;
+}
+
+static void
+store_merge(DDSketchStore *into, const DDSketchStore *from, MemoryContext mcxt)
+{
+	if (from->nkeys == 0)
+		return;
+
+	store_extend(into, from->min_key, from->min_key + from->nkeys - 1, mcxt);
+	for (int i = 0; i < from->nkeys; i++)
+	{
+		const int32 key = Max(from->min_key + i, into->min_key);
+		into->counts[key - into->min_key] += from->counts[i];
+	}
+}
+
+void
+ddsketch_add(DDSketch *sketch, float8 value, uint64 n, MemoryContext mcxt)
+{
+	/*
+	 * NaN and the infinities don't fall into any bucket, so they are skipped
+	 * like the null values.
+	 */
+	if (unlikely(!isfinite(value)))
+		return;
+
+	if (sketch->count == 0)
+	{
+		sketch->min = value;
+		sketch->max = value;
+	}
+	else
+	{
+		sketch->min = Min(sketch->min, value);
+		sketch->max = Max(sketch->max, value);
+	}
+	sketch->count += n;
+
+	if (value > 0)
+		store_add(&sketch->positive, ddsketch_key(value), n, mcxt);
+	else if (value < 0)
+		store_add(&sketch->negative, ddsketch_key(-value), n, mcxt);
+	else
+		sketch->zero_count += n;
+}
+
+/*
+ * Add the rows of a float8 Arrow array that pass the filter.
+ */
+void
+ddsketch_add_many(DDSketch *sketch, const float8 *values, const uint64 *filter, int nrows,
+				  MemoryContext mcxt)
+{
+	for (int row = 0; row < nrows; row++)
+	{
+		if (arrow_row_is_valid(filter, row))
+			ddsketch_add(sketch, values[row], 1, mcxt);
+	}
+}
+
+void
+ddsketch_merge(DDSketch *into, const DDSketch *from, MemoryContext mcxt)
+{
+	if (from->count == 0)
+		return;
+
+	if (into->count == 0)
+	{
+		into->min = from->min;
+		into->max = from->max;
+	}
+	else
+	{
+		into->min = Min(into->min, from->min);
+		into->max = Max(into->max, from->max);
+	}
+	into->count += from->count;
+	into->zero_count += from->zero_count;
+
+	store_merge(&into->positive, &from->positive, mcxt);
+	store_merge(&into->negative, &from->negative, mcxt);
+}
+
+static void
+store_serialize(StringInfo buf, const DDSketchStore *store)
+{
+	pq_sendint32(buf, store->min_key);
+	pq_sendint32(buf, store->nkeys);
+	for (int i = 0; i < store->nkeys; i++)
+		pq_sendint64(buf, store->counts[i]);
+}
+
+/*
+ * Serialize the sketch. This is the result of the aggregates, and the format
+ * of the partial results of the vectorized aggregation.
+ */
+bytea *
+ddsketch_serialize(const DDSketch *sketch)
+{
+	StringInfoData buf;
+
+	pq_begintypsend(&buf);
+	pq_sendbyte(&buf, DDSKETCH_FORMAT_VERSION);
+	pq_sendfloat8(&buf, DDSKETCH_RELATIVE_ACCURACY);
+	pq_sendint64(&buf, sketch->count);
+	pq_sendint64(&buf, sketch->zero_count);
+	pq_sendfloat8(&buf, sketch->min);
+	pq_sendfloat8(&buf, sketch->max);
+	store_serialize(&buf, &sketch->positive);
+	store_serialize(&buf, &sketch->negative);
+
+	return pq_endtypsend(&buf);
+}
+
+static void
+store_deserialize(StringInfo buf, DDSketchStore *store, MemoryContext mcxt)
+{
+	store->min_key = pq_getmsgint(buf, 4);
+	store->nkeys = pq_getmsgint(buf, 4);
+
+	if (store->nkeys < 0 || store->nkeys > DDSKETCH_MAX_KEYS ||
+		(int64) store->min_key + store->nkeys - 1 > PG_INT32_MAX)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid number of buckets %d in percentile sketch", store->nkeys)));
+
+	store->counts = NULL;
+	if (store->nkeys == 0)
+		return;
+
+	store->counts = MemoryContextAlloc(mcxt, sizeof(uint64) * store->nkeys);
+	for (int i = 0; i < store->nkeys; i++)
+		store->counts[i] = pq_getmsgint64(buf);
+}
+
+void
+ddsketch_deserialize(DDSketch *sketch, const bytea *serialized, MemoryContext mcxt)
+{
+	StringInfoData buf;
+
+	buf.data = (char *) VARDATA_ANY(serialized);
+	buf.len = VARSIZE_ANY_EXHDR(serialized);
+	buf.maxlen = buf.len;
+	buf.cursor = 0;
+
+	const int version = pq_getmsgbyte(&buf);
+	const float8 accuracy = pq_getmsgfloat8(&buf);
+
+	if (version != DDSKETCH_FORMAT_VERSION || accuracy != DDSKETCH_RELATIVE_ACCURACY)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("unsupported percentile sketch version %d with relative accuracy %g",
+						version,
+						accuracy)));
+
+	sketch->count = pq_getmsgint64(&buf);
+	sketch->zero_count = pq_getmsgint64(&buf);
+	sketch->min = pq_getmsgfloat8(&buf);
+	sketch->max = pq_getmsgfloat8(&buf);
+	store_deserialize(&buf, &sketch->positive, mcxt);
+	store_deserialize(&buf, &sketch->negative, mcxt);
+
+	pq_getmsgend(&buf);
+}
+
+/*
+ * The value of the bucket that contains the value with the given rank in the
+ * sorted values.
+ */
+static float8
+ddsketch_rank_value(const DDSketch *sketch, float8 rank)
+{
+	uint64 seen = 0;
+
+	/* The negative values, from the highest key, which is the lowest value. */
+	for (int i = sketch->negative.nkeys - 1; i >= 0; i--)
+	{
+		seen += sketch->negative.counts[i];
+		if (seen > rank)
+			return -ddsketch_key_value(sketch->negative.min_key + i);
+	}
+
+	seen += sketch->zero_count;
+	if (seen > rank)
+		return 0;
+
+	for (int i = 0; i < sketch->positive.nkeys; i++)
+	{
+		seen += sketch->positive.counts[i];
+		if (seen > rank)
+			return ddsketch_key_value(sketch->positive.min_key + i);
+	}
+
+	return sketch->max;
+}
+
+/*
+ * Estimate the value at the given fraction of the sorted values. The estimate
+ * is clamped to the exact minimum and maximum, which are also returned for the
+ * fractions 0 and 1.
+ */
+float8
+ddsketch_quantile(const DDSketch *sketch, float8 quantile)
+{
+	Assert(sketch->count > 0);
+
+	if (quantile <= 0)
+		return sketch->min;
+
+	if (quantile >= 1)
+		return sketch->max;
+
+	const float8 rank = quantile * (sketch->count - 1);
+	return Max(sketch->min, Min(sketch->max, ddsketch_rank_value(sketch, rank)));
+}
+
+static DDSketch *
+ddsketch_state_create(MemoryContext aggcontext)
+{
+	DDSketch *state = MemoryContextAlloc(aggcontext, sizeof(DDSketch));
+	ddsketch_init(state);
+	return state;
+}
+
+/* ddsketch_sfunc(internal, float8) => internal */
+Datum
+tsl_ddsketch_sfunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	DDSketch *state = (DDSketch *) (PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "ddsketch_sfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(1))
+	{
+		if (state == NULL)
+			PG_RETURN_NULL();
+
+		PG_RETURN_POINTER(state);
+	}
+
+	if (state == NULL)
+		state = ddsketch_state_create(aggcontext);
+
+	ddsketch_add(state, PG_GETARG_FLOAT8(1), 1, aggcontext);
+
+	PG_RETURN_POINTER(state);
+}
+
+/* ddsketch_merge_sfunc(internal, bytea) => internal */
+Datum
+tsl_ddsketch_merge_sfunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	DDSketch *state = (DDSketch *) (PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+	DDSketch sketch;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "ddsketch_merge_sfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(1))
+	{
+		if (state == NULL)
+			PG_RETURN_NULL();
+
+		PG_RETURN_POINTER(state);
+	}
+
+	if (state == NULL)
+		state = ddsketch_state_create(aggcontext);
+
+	ddsketch_deserialize(&sketch, PG_GETARG_BYTEA_PP(1), CurrentMemoryContext);
+	ddsketch_merge(state, &sketch, aggcontext);
+
+	PG_RETURN_POINTER(state);
+}
+
+/* ddsketch_combinefunc(internal, internal) => internal */
+Datum
+tsl_ddsketch_combinefunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	DDSketch *state1 = (DDSketch *) (PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+	DDSketch *state2 = (DDSketch *) (PG_ARGISNULL(1) ? NULL : PG_GETARG_POINTER(1));
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "ddsketch_combinefunc called in non-aggregate context");
+	}
+
+	if (state2 == NULL)
+	{
+		if (state1 == NULL)
+			PG_RETURN_NULL();
+
+		PG_RETURN_POINTER(state1);
+	}
+
+	if (state1 == NULL)
+		state1 = ddsketch_state_create(aggcontext);
+
+	ddsketch_merge(state1, state2, aggcontext);
+
+	PG_RETURN_POINTER(state1);
+}
+
+/* ddsketch_serializefunc(internal) => bytea */
+Datum
+tsl_ddsketch_serializefunc(PG_FUNCTION_ARGS)
+{
+	DDSketch *state;
+
+	Assert(!PG_ARGISNULL(0));
+	state = (DDSketch *) PG_GETARG_POINTER(0);
+
+	PG_RETURN_BYTEA_P(ddsketch_serialize(state));
+}
+
+/* ddsketch_deserializefunc(bytea *, internal) => internal */
+Datum
+tsl_ddsketch_deserializefunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	DDSketch *state;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		elog(ERROR, "ddsketch_deserializefunc called in non-aggregate context");
+
+	Assert(!PG_ARGISNULL(0));
+
+	state = MemoryContextAlloc(aggcontext, sizeof(DDSketch));
+	ddsketch_deserialize(state, PG_GETARG_BYTEA_PP(0), aggcontext);
+
+	PG_RETURN_POINTER(state);
+}
+
+/* ddsketch_finalfunc(internal) => bytea */
+Datum
+tsl_ddsketch_finalfunc(PG_FUNCTION_ARGS)
+{
+	DDSketch *state;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "ddsketch_finalfunc called in non-aggregate context");
+
+	/* No non-null values. */
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	state = (DDSketch *) PG_GETARG_POINTER(0);
+
+	/* No finite values, same as in the vectorized aggregation. */
+	if (state->count == 0)
+		PG_RETURN_NULL();
+
+	PG_RETURN_BYTEA_P(ddsketch_serialize(state));
+}
+
+/* approx_percentile(bytea, float8) => float8 */
+Datum
+tsl_approx_percentile(PG_FUNCTION_ARGS)
+{
+	const float8 percentile = PG_GETARG_FLOAT8(1);
+	DDSketch sketch;
+
+	if (isnan(percentile) || percentile < 0 || percentile > 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("percentile value %g is not between 0 and 1", percentile)));
+
+	ddsketch_deserialize(&sketch, PG_GETARG_BYTEA_PP(0), CurrentMemoryContext);
+
+	if (sketch.count == 0)
+		PG_RETURN_NULL();
+
+	PG_RETURN_FLOAT8(ddsketch_quantile(&sketch, percentile));
+}
@@ -0,0 +1,60 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+#include <fmgr.h>
+
+/*
+ * DDSketch, a mergeable quantile sketch with the relative error guarantee,
+ * used by the percentile_sketch() aggregates.
+ *
+ * The values are counted in logarithmically sized buckets, so that the value
+ * of a bucket is within DDSKETCH_RELATIVE_ACCURACY of all values in it. The
+ * positive and the negative values have separate bucket stores. When a store
+ * would span more than DDSKETCH_MAX_KEYS buckets, its lowest buckets are
+ * collapsed into one. This only depends on the highest bucket, so the result
+ * does not depend on the order in which the values are added and the sketches
+ * are merged, and the vectorized and the row-by-row aggregation produce the
+ * same sketches. NaN and infinite values are skipped like nulls.
+ */
+#define DDSKETCH_RELATIVE_ACCURACY 0.01
+#define DDSKETCH_MAX_KEYS 2048
+
+typedef struct DDSketchStore
+{
+	/* The key of counts[0], and the number of the counts. */
+	int32 min_key;
+	int32 nkeys;
+	uint64 *counts;
+} DDSketchStore;
+
+typedef struct DDSketch
+{
+	uint64 count;
+	uint64 zero_count;
+	float8 min;
+	float8 max;
+	DDSketchStore positive;
+	DDSketchStore negative;
+} DDSketch;
+
+extern void ddsketch_init(DDSketch *sketch);
+extern void ddsketch_add(DDSketch *sketch, float8 value, uint64 n, MemoryContext mcxt);
+extern void ddsketch_add_many(DDSketch *sketch, const float8 *values, const uint64 *filter,
+							  int nrows, MemoryContext mcxt);
+extern void ddsketch_merge(DDSketch *into, const DDSketch *from, MemoryContext mcxt);
+extern bytea *ddsketch_serialize(const DDSketch *sketch);
+extern void ddsketch_deserialize(DDSketch *sketch, const bytea *serialized, MemoryContext mcxt);
+extern float8 ddsketch_quantile(const DDSketch *sketch, float8 quantile);
+
+extern Datum tsl_ddsketch_sfunc(PG_FUNCTION_ARGS);
+extern Datum tsl_ddsketch_merge_sfunc(PG_FUNCTION_ARGS);
+extern Datum tsl_ddsketch_combinefunc(PG_FUNCTION_ARGS);
+extern Datum tsl_ddsketch_serializefunc(PG_FUNCTION_ARGS);
+extern Datum tsl_ddsketch_deserializefunc(PG_FUNCTION_ARGS);
+extern Datum tsl_ddsketch_finalfunc(PG_FUNCTION_ARGS);
+extern Datum tsl_approx_percentile(PG_FUNCTION_ARGS);
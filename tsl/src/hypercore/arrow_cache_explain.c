@@ -13,6 +13,7 @@
 
 #include <compat/compat.h>
 #include "arrow_cache_explain.h"
+#include "nodes/decompress_chunk/decompress_stats.h"
 
 bool decompress_cache_print = false;
 struct DecompressCacheStats decompress_cache_stats;
@@ -119,6 +120,9 @@ explain_decompression(Query *query, int cursorOptions, IntoClause *into, Explain
 		decompress_cache_print = false;
 		memset(&decompress_cache_stats, 0, sizeof(struct DecompressCacheStats));
 	}
+
+	/* The DecompressChunk nodes have already shown their statistics. */
+	decompress_stats_print = false;
 }
 
 bool
@@ -129,6 +133,11 @@ tsl_process_explain_def(DefElem *opt)
 		decompress_cache_print = defGetBoolean(opt);
 		return true; /* Remove this option as processed and used */
 	}
+	if (strcmp(opt->defname, "decompress_stats") == 0)
+	{
+		decompress_stats_print = defGetBoolean(opt);
+		return true;
+	}
 	return false; /* Keep this option  */
 }
 
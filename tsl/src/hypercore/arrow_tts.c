@@ -93,6 +93,9 @@ tts_arrow_init(TupleTableSlot *slot)
 	aslot->tuple_index = InvalidTupleIndex;
 	aslot->total_row_count = 0;
 	aslot->referenced_attrs = NULL;
+	aslot->referenced_attoffs = NULL;
+	aslot->num_referenced_attrs = 0;
+	aslot->index_vector_quals = NIL;
 	aslot->arrow_qual_result = NULL;
 
 	/*
@@ -269,7 +272,7 @@ tts_arrow_clear(TupleTableSlot *slot)
 	clear_arrow_parent(slot);
 
 	/* Clear arrow slot fields */
-	memset(aslot->valid_attrs, 0, sizeof(bool) * slot->tts_tupleDescriptor->natts);
+	arrow_slot_reset_valid_attrs(slot);
 	aslot->arrow_cache_entry = NULL;
 	aslot->arrow_qual_result = NULL;
 	MemoryContextReset(aslot->per_segment_mcxt);
@@ -343,7 +346,7 @@ tts_arrow_store_tuple(TupleTableSlot *slot, TupleTableSlot *child_slot, uint16 t
 	aslot->tuple_index = tuple_index;
 	aslot->arrow_cache_entry = NULL;
 	/* Clear valid attributes */
-	memset(aslot->valid_attrs, 0, sizeof(bool) * slot->tts_tupleDescriptor->natts);
+	arrow_slot_reset_valid_attrs(slot);
 	MemoryContextReset(aslot->per_segment_mcxt);
 }
 
@@ -568,10 +571,29 @@ tts_arrow_getsomeattrs(TupleTableSlot *slot, int natts)
 	}
 
 	/* Build the non-compressed tuple values array from the cached data. */
-	for (int attoff = slot->tts_nvalid; attoff < natts; attoff++)
+	if (aslot->referenced_attoffs != NULL)
 	{
-		if (!aslot->valid_attrs[attoff] && is_used_attr(slot, attoff))
-			set_attr_value(slot, attoff);
+		/* Only visit the referenced attributes, so that the cost of
+		 * scanning a few columns of a wide relation does not depend on the
+		 * number of columns. The offsets are sorted. */
+		for (int i = 0; i < aslot->num_referenced_attrs; i++)
+		{
+			const int16 attoff = aslot->referenced_attoffs[i];
+
+			if (attoff >= natts)
+				break;
+
+			if (!aslot->valid_attrs[attoff])
+				set_attr_value(slot, attoff);
+		}
+	}
+	else
+	{
+		for (int attoff = slot->tts_nvalid; attoff < natts; attoff++)
+		{
+			if (!aslot->valid_attrs[attoff])
+				set_attr_value(slot, attoff);
+		}
 	}
 
 	slot->tts_nvalid = natts;
@@ -836,11 +858,25 @@ arrow_slot_set_referenced_attrs(TupleTableSlot *slot, Bitmapset *attrs)
 	ArrowTupleTableSlot *aslot = (ArrowTupleTableSlot *) slot;
 	if (aslot->referenced_attrs == NULL)
 	{
-		aslot->referenced_attrs =
-			MemoryContextAlloc(aslot->arrow_cache.mcxt,
-							   sizeof(bool) * slot->tts_tupleDescriptor->natts);
-		for (int i = 0; i < slot->tts_tupleDescriptor->natts; i++)
+		const int natts = slot->tts_tupleDescriptor->natts;
+
+		aslot->referenced_attrs = MemoryContextAlloc(aslot->arrow_cache.mcxt, sizeof(bool) * natts);
+		aslot->referenced_attoffs =
+			MemoryContextAlloc(aslot->arrow_cache.mcxt, sizeof(int16) * natts);
+		aslot->num_referenced_attrs = 0;
+
+		for (int i = 0; i < natts; i++)
+		{
 			aslot->referenced_attrs[i] = bms_is_member(AttrOffsetGetAttrNumber(i), attrs);
+
+			if (aslot->referenced_attrs[i])
+				aslot->referenced_attoffs[aslot->num_referenced_attrs++] = i;
+		}
+
+		/* Attributes could have been set before the referenced attributes
+		 * were known, so reset all of them. */
+		memset(aslot->valid_attrs, 0, sizeof(bool) * natts);
+		slot->tts_nvalid = 0;
 	}
 }
 
@@ -855,6 +891,24 @@ arrow_slot_set_index_attrs(TupleTableSlot *slot, Bitmapset *attrs)
 	MemoryContextSwitchTo(oldmcxt);
 }
 
+/*
+ * Store the vectorized quals of an index scan.
+ *
+ * The quals are used by the index fetch to filter the rows of a compressed
+ * segment in one go rather than returning each row for evaluation by the
+ * index scan node.
+ */
+void
+arrow_slot_set_index_vector_quals(TupleTableSlot *slot, List *quals)
+{
+	Assert(TTS_IS_ARROWTUPLE(slot));
+
+	ArrowTupleTableSlot *aslot = (ArrowTupleTableSlot *) slot;
+	MemoryContext oldmcxt = MemoryContextSwitchTo(aslot->arrow_cache.mcxt);
+	aslot->index_vector_quals = copyObject(quals);
+	MemoryContextSwitchTo(oldmcxt);
+}
+
 const TupleTableSlotOps TTSOpsArrowTuple = {
 	.base_slot_size = sizeof(ArrowTupleTableSlot),
 	.init = tts_arrow_init,
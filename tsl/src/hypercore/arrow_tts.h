@@ -74,9 +74,14 @@ typedef struct ArrowTupleTableSlot
 	ArrowColumnCache arrow_cache;
 	ArrowColumnCacheEntry *arrow_cache_entry;
 	bool *referenced_attrs;
+	int16 *referenced_attoffs; /* Sorted offsets of the referenced attributes,
+								* NULL if all attributes are referenced */
+	int16 num_referenced_attrs;
 	bool *segmentby_attrs;
 	bool *valid_attrs;		 /* Per-column validity up to "tts_nvalid" */
 	Bitmapset *index_attrs;	 /* Columns in index during index scan */
+	List *index_vector_quals; /* Vectorized quals of the index scan, used
+							   * to filter rows when fetching tuples */
 	int16 *attrs_offset_map; /* Offset number mappings between the
 							  * non-compressed and compressed
 							  * relation */
@@ -312,6 +317,27 @@ arrow_slot_get_qual_result(const TupleTableSlot *slot)
 	return aslot->arrow_qual_result;
 }
 
+/*
+ * Reset the validity of the attributes in the slot.
+ *
+ * Only referenced attributes are ever set, so it is enough to reset those,
+ * which keeps the per-row cost independent of the width of the relation.
+ */
+static inline void
+arrow_slot_reset_valid_attrs(TupleTableSlot *slot)
+{
+	ArrowTupleTableSlot *aslot = (ArrowTupleTableSlot *) slot;
+
+	if (aslot->referenced_attoffs == NULL)
+	{
+		memset(aslot->valid_attrs, 0, sizeof(bool) * slot->tts_tupleDescriptor->natts);
+		return;
+	}
+
+	for (int i = 0; i < aslot->num_referenced_attrs; i++)
+		aslot->valid_attrs[aslot->referenced_attoffs[i]] = false;
+}
+
 /*
  * Increment or decrement an arrow slot to point to a subsequent row.
  *
@@ -353,7 +379,7 @@ ExecIncrOrDecrArrowTuple(TupleTableSlot *slot, int32 amount)
 	aslot->tuple_index = (uint16) tuple_index;
 	slot->tts_flags &= ~TTS_FLAG_EMPTY;
 	slot->tts_nvalid = 0;
-	memset(aslot->valid_attrs, 0, sizeof(bool) * slot->tts_tupleDescriptor->natts);
+	arrow_slot_reset_valid_attrs(slot);
 
 	return slot;
 }
@@ -422,6 +448,7 @@ extern const ArrowArray *arrow_slot_get_array(TupleTableSlot *slot, AttrNumber a
 
 extern bool is_compressed_col(const TupleDesc tupdesc, AttrNumber attno);
 extern void arrow_slot_set_referenced_attrs(TupleTableSlot *slot, Bitmapset *attrs);
+extern void arrow_slot_set_index_vector_quals(TupleTableSlot *slot, List *quals);
 extern void arrow_slot_set_index_attrs(TupleTableSlot *slot, Bitmapset *attrs);
 
 extern Datum tsl_is_compressed_tid(PG_FUNCTION_ARGS);
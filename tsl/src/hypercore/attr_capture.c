@@ -18,6 +18,9 @@
 
 #include "arrow_tts.h"
 #include "attr_capture.h"
+#include "guc.h"
+#include "hypercore_handler.h"
+#include "nodes/decompress_chunk/vector_quals.h"
 #include <utils.h>
 
 struct CaptureAttributesContext
@@ -129,6 +132,62 @@ capture_index_attributes(ScanState *state, Relation indexrel)
 	arrow_slot_set_index_attrs(state->ss_ScanTupleSlot, attrs);
 }
 
+/*
+ * Capture the vectorizable quals of an index scan.
+ *
+ * The hypercore TAM evaluates these quals once per compressed segment when
+ * fetching tuples for the index scan, and only returns the rows that pass
+ * them. The quals stay in the plan node, so the index scan still evaluates
+ * them, but only for the rows that passed.
+ */
+static void
+capture_index_vector_quals(ScanState *state)
+{
+	const List *quals = state->ps.plan->qual;
+	List *vector_quals = NIL;
+	ListCell *lc;
+
+	if (!ts_guc_enable_hypercore_index_vector_quals || quals == NIL)
+		return;
+
+	const HypercoreInfo *hcinfo = RelationGetHypercoreInfo(state->ss_currentRelation);
+	VectorQualInfo vqinfo = {
+		.rti = ((Scan *) state->ps.plan)->scanrelid,
+		.vector_attrs = palloc0(sizeof(bool) * (hcinfo->num_columns + 1)),
+		.segmentby_attrs = palloc0(sizeof(bool) * (hcinfo->num_columns + 1)),
+	};
+
+	/* The arrow slot decompresses all columns into arrow arrays, so all
+	 * columns are vectorizable. */
+	for (int i = 0; i < hcinfo->num_columns; i++)
+	{
+		AttrNumber attno = AttrOffsetGetAttrNumber(i);
+
+		if (!hcinfo->columns[i].is_dropped)
+		{
+			vqinfo.vector_attrs[attno] = true;
+			vqinfo.segmentby_attrs[attno] = hcinfo->columns[i].is_segmentby;
+		}
+	}
+
+	PlannerGlobal glob = {
+		.boundParams = state->ps.state->es_param_list_info,
+	};
+	PlannerInfo root = {
+		.glob = &glob,
+	};
+
+	foreach (lc, quals)
+	{
+		Node *vector_qual = vector_qual_make(lfirst(lc), &vqinfo);
+
+		if (vector_qual)
+			vector_quals = lappend(vector_quals, estimate_expression_value(&root, vector_qual));
+	}
+
+	arrow_slot_set_index_vector_quals(state->ss_ScanTupleSlot, vector_quals);
+}
+
 static void
 collect_refs_and_targets(ScanState *state, struct CaptureAttributesContext *context)
 {
@@ -176,6 +235,7 @@ capture_attributes(PlanState *planstate, void *ptr)
 			{
 				const IndexScanState *istate = castNode(IndexScanState, planstate);
 				capture_index_attributes(state, istate->iss_RelationDesc);
+				capture_index_vector_quals(state);
 				collect_refs_and_targets(state, context);
 			}
 			break;
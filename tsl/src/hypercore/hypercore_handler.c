@@ -75,6 +75,7 @@
 #include "ts_catalog/catalog.h"
 #include "ts_catalog/compression_chunk_size.h"
 #include "ts_catalog/compression_settings.h"
+#include "vector_quals.h"
 
 #if PG17_GE
 #include "import/analyze.h"
@@ -397,6 +398,7 @@ typedef struct HypercoreScanDescData
 	HypercoreScanState hs_scan_state;
 	bool reset;
 	bool skip_compressed; /* Skip compressed data when scanning */
+	Bitmapset *referenced_attrs; /* Columns needed by the scan, NULL for all */
 #if PG17_GE
 	/* These fields are only used for ANALYZE */
 	ReadStream *canalyze_read_stream;
@@ -795,12 +797,33 @@ hypercore_endscan(TableScanDesc sscan)
 	if (scan->rs_base.rs_key)
 		pfree(scan->rs_base.rs_key);
 
+	bms_free(scan->referenced_attrs);
 	pfree(scan);
 
 	/* Clear the COPY TO filter state */
 	hypercore_skip_compressed_data_relid = InvalidOid;
 }
 
+/*
+ * Set the columns that the scan needs to return.
+ *
+ * The columns are derived from the target list and quals of the plan node
+ * that runs the scan, and are set directly after table_beginscan(). Only the
+ * given columns are detoasted and decompressed in the arrow slots that the
+ * scan returns, while the other columns are left unset.
+ */
+void
+hypercore_scan_set_referenced_attrs(TableScanDesc scan, const Bitmapset *attrs)
+{
+	HypercoreScanDesc hscan;
+
+	if (!REL_IS_HYPERCORE(scan->rs_rd))
+		return;
+
+	hscan = (HypercoreScanDesc) scan;
+	hscan->referenced_attrs = bms_copy(attrs);
+}
+
 static bool
 hypercore_getnextslot(TableScanDesc sscan, ScanDirection direction, TupleTableSlot *slot)
 {
@@ -812,6 +835,11 @@ hypercore_getnextslot(TableScanDesc sscan, ScanDirection direction, TupleTableSl
 
 	HypercoreScanDesc scan = (HypercoreScanDesc) sscan;
 
+	/* Only done when moving to a new tuple in the child scans, so this is
+	 * not on the per-row path for compressed data. */
+	if (scan->referenced_attrs != NULL)
+		arrow_slot_set_referenced_attrs(slot, scan->referenced_attrs);
+
 	TS_DEBUG_LOG("relid: %d, relation: %s, reset: %s, scan_state: %s",
 				 sscan->rs_rd->rd_id,
 				 get_rel_name(sscan->rs_rd->rd_id),
@@ -1032,6 +1060,14 @@ typedef struct IndexFetchComprData
 	bool call_again;		  /* Used to remember the previous value of call_again in
 							   * index_fetch_tuple */
 	bool internal_call_again; /* Call again passed on to compressed heap */
+
+	/* Vectorized quals of the index scan, evaluated once for each fetched
+	 * compressed tuple. The result is kept in a memory context of its own
+	 * since the per-segment memory of the slot is reset every time a row
+	 * is stored. */
+	VectorQualState vqstate;
+	VectorQualSummary vector_qual_summary;
+	MemoryContext vector_qual_mcxt;
 } IndexFetchComprData;
 
 /* ------------------------------------------------------------------------
@@ -1050,6 +1086,9 @@ hypercore_index_fetch_begin(Relation rel)
 	cscan->h_base.rel = rel;
 	cscan->compr_rel = crel;
 	cscan->compr_hscan = crel->rd_tableam->index_fetch_begin(crel);
+	cscan->vector_qual_summary = AllRowsPass;
+	cscan->vector_qual_mcxt =
+		AllocSetContextCreate(CurrentMemoryContext, "Index vector quals", ALLOCSET_DEFAULT_SIZES);
 
 	const TableAmRoutine *oldtam = switch_to_heapam(rel);
 	cscan->uncompr_hscan = rel->rd_tableam->index_fetch_begin(rel);
@@ -1091,6 +1130,7 @@ hypercore_index_fetch_end(IndexFetchTableData *scan)
 	const TableAmRoutine *oldtam = switch_to_heapam(rel);
 	rel->rd_tableam->index_fetch_end(cscan->uncompr_hscan);
 	rel->rd_tableam = oldtam;
+	MemoryContextDelete(cscan->vector_qual_mcxt);
 	pfree(cscan);
 }
 
@@ -1144,6 +1184,76 @@ is_segmentby_index_scan(IndexFetchComprData *cscan, TupleTableSlot *slot)
 	return (segindex == SEGMENTBY_INDEX_TRUE);
 }
 
+/*
+ * Compute the vectorized quals of the index scan for the compressed tuple
+ * that was just stored in the slot.
+ *
+ * The quals are captured from the index scan node at executor start, and
+ * evaluated over the whole compressed tuple in one go, so that the rows that
+ * do not pass them are never returned to the index scan.
+ */
+static void
+index_fetch_compute_vector_quals(IndexFetchComprData *cscan, TupleTableSlot *slot)
+{
+	const ArrowTupleTableSlot *aslot = (const ArrowTupleTableSlot *) slot;
+
+	if (aslot->index_vector_quals == NIL)
+	{
+		cscan->vector_qual_summary = AllRowsPass;
+		return;
+	}
+
+	if (cscan->vqstate.slot == NULL)
+	{
+		vector_qual_state_init(&cscan->vqstate, aslot->index_vector_quals, slot);
+		cscan->vqstate.per_vector_mcxt = cscan->vector_qual_mcxt;
+	}
+
+	vector_qual_state_reset(&cscan->vqstate);
+	MemoryContext oldmcxt = MemoryContextSwitchTo(cscan->vector_qual_mcxt);
+	cscan->vector_qual_summary = vector_qual_compute(&cscan->vqstate);
+	MemoryContextSwitchTo(oldmcxt);
+}
+
+static inline bool
+index_fetch_row_passes_vector_quals(const IndexFetchComprData *cscan, const TupleTableSlot *slot)
+{
+	switch (cscan->vector_qual_summary)
+	{
+		case AllRowsPass:
+			return true;
+		case NoRowsPass:
+			return false;
+		case SomeRowsPass:
+			break;
+	}
+
+	return arrow_row_is_valid(cscan->vqstate.vector_qual_result, arrow_slot_arrow_offset(slot));
+}
+
+/*
+ * Move a segmentby index scan forward to the first row of the current
+ * compressed tuple that passes the vectorized quals.
+ *
+ * Returns false if there is no such row.
+ */
+static bool
+index_fetch_skip_filtered_rows(const IndexFetchComprData *cscan, TupleTableSlot *slot)
+{
+	if (cscan->vector_qual_summary == NoRowsPass)
+		return false;
+
+	while (!index_fetch_row_passes_vector_quals(cscan, slot))
+	{
+		if (arrow_slot_is_last(slot))
+			return false;
+
+		ExecStoreNextArrowTuple(slot);
+	}
+
+	return true;
+}
+
 /*
  * Return tuple for given TID via index scan.
  *
@@ -1158,6 +1268,10 @@ is_segmentby_index_scan(IndexFetchComprData *cscan, TupleTableSlot *slot)
  * that case, the "call_again" parameter is used to make sure the index scan
  * calls this function until all the rows in a compressed tuple is
  * returned. This "unwrapping" only happens in the case of segmentby indexes.
+ *
+ * Rows of compressed tuples that do not pass the vectorized quals of the
+ * index scan are reported as not found, so the index scan moves on to the
+ * next TID without evaluating its quals for them.
  */
 static bool
 hypercore_index_fetch_tuple(struct IndexFetchTableData *scan, ItemPointer tid, Snapshot snapshot,
@@ -1206,10 +1320,15 @@ hypercore_index_fetch_tuple(struct IndexFetchTableData *scan, ItemPointer tid, S
 	{
 		ExecStoreNextArrowTuple(slot);
 		slot->tts_tableOid = RelationGetRelid(scan->rel);
-		cscan->call_again = !arrow_slot_is_last(slot);
+
+		bool found = index_fetch_skip_filtered_rows(cscan, slot);
+		cscan->call_again = found && !arrow_slot_is_last(slot);
 		*call_again = cscan->call_again || cscan->internal_call_again;
-		cscan->return_count++;
-		return true;
+
+		if (found)
+			cscan->return_count++;
+
+		return found;
 	}
 
 	/* Recreate the original TID for the compressed table */
@@ -1237,6 +1356,10 @@ hypercore_index_fetch_tuple(struct IndexFetchTableData *scan, ItemPointer tid, S
 		 * return the same Arrow slot */
 		ExecStoreArrowTuple(slot, tuple_index);
 		slot->tts_tableOid = RelationGetRelid(scan->rel);
+
+		if (!index_fetch_row_passes_vector_quals(cscan, slot))
+			return false;
+
 		cscan->return_count++;
 		return true;
 	}
@@ -1255,15 +1378,20 @@ hypercore_index_fetch_tuple(struct IndexFetchTableData *scan, ItemPointer tid, S
 		/* Save the current compressed TID */
 		ItemPointerCopy(&decoded_tid, &cscan->tid);
 		cscan->num_decompressions++;
+		index_fetch_compute_vector_quals(cscan, slot);
 
 		if (is_segmentby_index)
 		{
 			Assert(tuple_index == 1);
-			cscan->call_again = !arrow_slot_is_last(slot);
+			result = index_fetch_skip_filtered_rows(cscan, slot);
+			cscan->call_again = result && !arrow_slot_is_last(slot);
 			*call_again = cscan->call_again || cscan->internal_call_again;
 		}
+		else
+			result = index_fetch_row_passes_vector_quals(cscan, slot);
 
-		cscan->return_count++;
+		if (result)
+			cscan->return_count++;
 	}
 
 	return result;
@@ -2294,7 +2422,8 @@ hypercore_relation_copy_for_cluster(Relation OldHypercore, Relation NewCompressi
 				 errdetail("A hypercore table is already ordered by compression.")));
 
 	CompressionSettings *settings = ts_compression_settings_get(RelationGetRelid(OldHypercore));
-	tuplesort = compression_create_tuplesort_state(settings, OldHypercore);
+	tuplesort =
+		compression_create_tuplesort_state(settings, OldHypercore, maintenance_work_mem);
 
 	/* In scan-and-sort mode and also VACUUM FULL, set phase */
 	pgstat_progress_update_param(PROGRESS_CLUSTER_PHASE, PROGRESS_CLUSTER_PHASE_SEQ_SCAN_HEAP);
@@ -3000,6 +3129,14 @@ hypercore_index_build_callback(Relation index, ItemPointer tid, Datum *values, b
  * non-indexed predicate columns will be included in the values array passed
  * on to the "our" index build callback. Then we can reconstruct a table tuple
  * from those values in order to do the predicate check.
+ *
+ * In a parallel index build, each participant calls this function with its
+ * own hypercore scan descriptor on the shared parallel scan state, which
+ * contains separate parallel block scans of the non-compressed and compressed
+ * relations. Each participant therefore decompresses a disjoint set of
+ * compressed tuples and feeds the values to the shared sort of the index
+ * build through the original callback. The number of participants is planned
+ * by PostgreSQL based on hypercore_relation_estimate_size().
  */
 static double
 hypercore_index_build_range_scan(Relation relation, Relation indexRelation, IndexInfo *indexInfo,
@@ -3457,6 +3594,12 @@ relation_number_of_disk_blocks(Relation rel)
  * be mostly (if not completely) compressed. When compressing or
  * decompressing, relstats should also be updated. Therefore, the relstats
  * should be quite accurate.
+ *
+ * The estimate is also used to plan the number of workers for a parallel
+ * index build, in which case PostgreSQL passes no attribute widths. Since most
+ * of the compressed data is stored in the TOAST table of the compressed
+ * relation, the relation pages alone underestimate the amount of data that an
+ * index build needs to decompress, so the TOAST pages are added in this case.
  */
 static void
 hypercore_relation_estimate_size(Relation rel, int32 *attr_widths, BlockNumber *pages,
@@ -3484,6 +3627,14 @@ hypercore_relation_estimate_size(Relation rel, int32 *attr_widths, BlockNumber *
 	Relation crel = table_open(hsinfo->compressed_relid, AccessShareLock);
 	BlockNumber nblocks = relation_number_of_disk_blocks(rel);
 	BlockNumber cnblocks = relation_number_of_disk_blocks(crel);
+	BlockNumber ctoastblocks = 0;
+
+	if (attr_widths == NULL && OidIsValid(crel->rd_rel->reltoastrelid))
+	{
+		Relation toastrel = table_open(crel->rd_rel->reltoastrelid, AccessShareLock);
+		ctoastblocks = RelationGetNumberOfBlocks(toastrel);
+		table_close(toastrel, AccessShareLock);
+	}
 
 	table_close(crel, AccessShareLock);
 
@@ -3502,7 +3653,7 @@ hypercore_relation_estimate_size(Relation rel, int32 *attr_widths, BlockNumber *
 		/*
 		 * There's stats, use it.
 		 */
-		*pages = form->relpages;
+		*pages = form->relpages + ctoastblocks;
 		*tuples = form->reltuples;
 		*allvisfrac = calc_allvisfrac(nblocks + cnblocks, form->relallvisible);
 
@@ -3548,6 +3699,7 @@ hypercore_relation_estimate_size(Relation rel, int32 *attr_widths, BlockNumber *
 
 	*tuples =
 		(*tuples * frac_noncompressed) + ((1 - frac_noncompressed) * TARGET_COMPRESSED_BATCH_SIZE);
+	*pages += ctoastblocks;
 
 	TS_DEBUG_LOG("(estimated) pages %u tuples %lf allvisfrac %f frac_noncompressed %lf",
 				 *pages,
@@ -3642,7 +3794,7 @@ conversionstate_create(const HypercoreInfo *hcinfo, const Relation rel)
 	 * context callback for the conversion state can. in case of error, call
 	 * tuplesort_end() before the tuplesort is freed.
 	 */
-	tuplesortstate = compression_create_tuplesort_state(settings, rel);
+	tuplesortstate = compression_create_tuplesort_state(settings, rel, maintenance_work_mem);
 	mcxt = AllocSetContextCreate(PortalContext, "Hypercore conversion", ALLOCSET_DEFAULT_SIZES);
 
 	state = MemoryContextAlloc(mcxt, sizeof(ConversionState));
@@ -0,0 +1,355 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * The approx_count_distinct(anyelement) aggregate, which estimates the number
+ * of distinct non-null values with a HyperLogLog sketch.
+ *
+ * The sketches are combined by taking the maximum of each register, so the
+ * aggregate supports the partial aggregation. The serialized sketch uses a
+ * sparse encoding when most registers are empty, which is the common case for
+ * the partial results of small groups.
+ */
+
+#include <postgres.h>
+
+#include <math.h>
+
+#include <libpq/pqformat.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+
+#include "hyperloglog.h"
+
+#define HLL_FORMAT_VERSION 1
+#define HLL_ENCODING_DENSE 0
+#define HLL_ENCODING_SPARSE 1
+
+/* Use the sparse encoding when it is smaller than the dense one. */
+#define HLL_SPARSE_ENTRY_BYTES 3
+#define HLL_MAX_SPARSE_ENTRIES (HLL_REGISTERS / HLL_SPARSE_ENTRY_BYTES)
+
+#ifdef TS_USE_UMASH
+struct umash_params *hll_umash_params = NULL;
+
+void
+hll_umash_params_init(void)
+{
+	struct umash_params *params =
+		MemoryContextAllocZero(TopMemoryContext, sizeof(struct umash_params));
+	umash_params_derive(params, 0x9e3779b97f4a7c15ull, NULL);
+	hll_umash_params = params;
+}
+#endif
+
+typedef struct HllState
+{
+	/* The type of the aggregated values, only known in the transition function. */
+	int16 typlen;
+	bool typbyval;
+	uint8 registers[HLL_REGISTERS];
+} HllState;
+
+uint64
+hll_hash_datum(Datum value, int16 typlen, bool typbyval)
+{
+	if (typbyval)
+	{
+		switch (typlen)
+		{
+			case 1:
+			{
+				const uint8 v = DatumGetUInt8(value);
+				return hll_hash_bytes(&v, sizeof(v));
+			}
+			case 2:
+			{
+				const int16 v = DatumGetInt16(value);
+				return hll_hash_bytes(&v, sizeof(v));
+			}
+			case 4:
+			{
+				const int32 v = DatumGetInt32(value);
+				return hll_hash_bytes(&v, sizeof(v));
+			}
+			case 8:
+			{
+				const int64 v = DatumGetInt64(value);
+				return hll_hash_bytes(&v, sizeof(v));
+			}
+			default:
+				elog(ERROR, "unsupported length %d of by-value type", typlen);
+				pg_unreachable();
+		}
+	}
+
+	if (typlen == -1)
+	{
+		struct varlena *v = PG_DETOAST_DATUM_PACKED(value);
+		uint64 hash = hll_hash_bytes(VARDATA_ANY(v), VARSIZE_ANY_EXHDR(v));
+
+		if ((Pointer) v != DatumGetPointer(value))
+			pfree(v);
+
+		return hash;
+	}
+
+	if (typlen == -2)
+	{
+		const char *str = DatumGetCString(value);
+		return hll_hash_bytes(str, strlen(str));
+	}
+
+	return hll_hash_bytes(DatumGetPointer(value), typlen);
+}
+
+static HllState *
+hll_state_create(MemoryContext aggcontext)
+{
+	return MemoryContextAllocZero(aggcontext, sizeof(HllState));
+}
+
+/* approx_count_distinct(state, val) */
+Datum
+tsl_hll_sfunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	HllState *state = (HllState *) (PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "hll_sfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(1))
+	{
+		if (state == NULL)
+			PG_RETURN_NULL();
+
+		PG_RETURN_POINTER(state);
+	}
+
+	if (state == NULL)
+	{
+		Oid argtype = get_fn_expr_argtype(fcinfo->flinfo, 1);
+
+		if (!OidIsValid(argtype))
+			elog(ERROR, "could not determine the type of the aggregated value");
+
+		state = hll_state_create(aggcontext);
+		get_typlenbyval(argtype, &state->typlen, &state->typbyval);
+	}
+
+	hll_add_hash(state->registers,
+				 hll_hash_datum(PG_GETARG_DATUM(1), state->typlen, state->typbyval));
+
+	PG_RETURN_POINTER(state);
+}
+
+/* hll_combinefunc(internal, internal) => internal */
+Datum
+tsl_hll_combinefunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	HllState *state1 = (HllState *) (PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+	HllState *state2 = (HllState *) (PG_ARGISNULL(1) ? NULL : PG_GETARG_POINTER(1));
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "hll_combinefunc called in non-aggregate context");
+	}
+
+	if (state2 == NULL)
+	{
+		if (state1 == NULL)
+			PG_RETURN_NULL();
+
+		PG_RETURN_POINTER(state1);
+	}
+
+	if (state1 == NULL)
+	{
+		state1 = hll_state_create(aggcontext);
+		memcpy(state1, state2, sizeof(HllState));
+		PG_RETURN_POINTER(state1);
+	}
+
+	for (int i = 0; i < HLL_REGISTERS; i++)
+		state1->registers[i] = Max(state1->registers[i], state2->registers[i]);
+
+	PG_RETURN_POINTER(state1);
+}
+
+/*
+ * Serialize the registers. This is also the format of the partial results of
+ * the vectorized aggregation.
+ */
+bytea *
+hll_serialize(const uint8 *registers)
+{
+	StringInfoData buf;
+	int nonempty = 0;
+
+	for (int i = 0; i < HLL_REGISTERS; i++)
+		nonempty += registers[i] != 0;
+
+	pq_begintypsend(&buf);
+	pq_sendbyte(&buf, HLL_FORMAT_VERSION);
+	pq_sendbyte(&buf, HLL_PRECISION);
+	pq_sendbyte(&buf, HLL_HASH);
+
+	if (nonempty <= HLL_MAX_SPARSE_ENTRIES)
+	{
+		pq_sendbyte(&buf, HLL_ENCODING_SPARSE);
+		pq_sendint16(&buf, nonempty);
+		for (int i = 0; i < HLL_REGISTERS; i++)
+		{
+			if (registers[i] != 0)
+			{
+				pq_sendint16(&buf, i);
+				pq_sendbyte(&buf, registers[i]);
+			}
+		}
+	}
+	else
+	{
+		pq_sendbyte(&buf, HLL_ENCODING_DENSE);
+		pq_sendbytes(&buf, (const char *) registers, HLL_REGISTERS);
+	}
+
+	return pq_endtypsend(&buf);
+}
+
+/* hll_serializefunc(internal) => bytea */
+Datum
+tsl_hll_serializefunc(PG_FUNCTION_ARGS)
+{
+	HllState *state;
+
+	Assert(!PG_ARGISNULL(0));
+	state = (HllState *) PG_GETARG_POINTER(0);
+
+	PG_RETURN_BYTEA_P(hll_serialize(state->registers));
+}
+
+/* hll_deserializefunc(bytea *, internal) => internal */
+Datum
+tsl_hll_deserializefunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	bytea *serialized;
+	StringInfoData buf;
+	HllState *state;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		elog(ERROR, "hll_deserializefunc called in non-aggregate context");
+
+	Assert(!PG_ARGISNULL(0));
+	serialized = PG_GETARG_BYTEA_P(0);
+
+	buf.data = VARDATA(serialized);
+	buf.len = VARSIZE(serialized) - VARHDRSZ;
+	buf.maxlen = VARSIZE(serialized) - VARHDRSZ;
+	buf.cursor = 0;
+
+	const int version = pq_getmsgbyte(&buf);
+	const int precision = pq_getmsgbyte(&buf);
+	const int hash = pq_getmsgbyte(&buf);
+	const int encoding = pq_getmsgbyte(&buf);
+
+	if (version != HLL_FORMAT_VERSION || precision != HLL_PRECISION)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("unsupported approx_count_distinct state version %d with precision %d",
+						version,
+						precision)));
+
+	if (hash != HLL_HASH)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("approx_count_distinct state uses a different hash function"),
+				 errdetail("The state was computed by a build of TimescaleDB with different "
+						   "hashing support.")));
+
+	state = hll_state_create(aggcontext);
+
+	if (encoding == HLL_ENCODING_SPARSE)
+	{
+		const int nonempty = pq_getmsgint(&buf, 2);
+		for (int i = 0; i < nonempty; i++)
+		{
+			const int index = pq_getmsgint(&buf, 2);
+			const int rank = pq_getmsgbyte(&buf);
+
+			if (index >= HLL_REGISTERS)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+						 errmsg("invalid register %d in approx_count_distinct state", index)));
+
+			state->registers[index] = rank;
+		}
+	}
+	else if (encoding == HLL_ENCODING_DENSE)
+	{
+		pq_copymsgbytes(&buf, (char *) state->registers, HLL_REGISTERS);
+	}
+	else
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid approx_count_distinct state encoding %d", encoding)));
+	}
+
+	pq_getmsgend(&buf);
+
+	PG_RETURN_POINTER(state);
+}
+
+/*
+ * The HyperLogLog estimate, with the linear counting for the small
+ * cardinalities. The hash is 64-bit, so no correction is needed for the large
+ * ones.
+ */
+static int64
+hll_estimate(const uint8 *registers)
+{
+	const double m = HLL_REGISTERS;
+	const double alpha = 0.7213 / (1.0 + 1.079 / m);
+	double sum = 0;
+	int empty = 0;
+
+	for (int i = 0; i < HLL_REGISTERS; i++)
+	{
+		sum += ldexp(1.0, -registers[i]);
+		empty += registers[i] == 0;
+	}
+
+	double estimate = alpha * m * m / sum;
+	if (estimate <= 2.5 * m && empty > 0)
+		estimate = m * log(m / empty);
+
+	return (int64) rint(estimate);
+}
+
+/* hll_finalfunc(internal) => bigint */
+Datum
+tsl_hll_finalfunc(PG_FUNCTION_ARGS)
+{
+	HllState *state;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "hll_finalfunc called in non-aggregate context");
+
+	/* No non-null values. */
+	if (PG_ARGISNULL(0))
+		PG_RETURN_INT64(0);
+
+	state = (HllState *) PG_GETARG_POINTER(0);
+
+	PG_RETURN_INT64(hll_estimate(state->registers));
+}
@@ -0,0 +1,89 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+#include <common/hashfn.h>
+#include <fmgr.h>
+#include <port/pg_bitutils.h>
+
+#ifdef TS_USE_UMASH
+#include "import/umash.h"
+#endif
+
+/*
+ * HyperLogLog sketch used by the approx_count_distinct() aggregate. The
+ * sketch has 2^HLL_PRECISION registers of one byte, which gives the standard
+ * error of about 1.6%. The registers are shared by the row-by-row and the
+ * vectorized implementations, which must hash the values in the same way so
+ * that their partial results can be combined.
+ */
+#define HLL_PRECISION 12
+#define HLL_REGISTERS (1 << HLL_PRECISION)
+
+/*
+ * The hash function of the values, which is recorded in the serialized
+ * sketch, because the sketches computed with the different hash functions
+ * cannot be combined.
+ */
+#define HLL_HASH_UMASH 1
+#define HLL_HASH_PG 2
+
+#ifdef TS_USE_UMASH
+#define HLL_HASH HLL_HASH_UMASH
+#else
+#define HLL_HASH HLL_HASH_PG
+#endif
+
+#define HLL_HASH_SEED UINT64CONST(0x5f3a2b1c9d8e7f60)
+
+#ifdef TS_USE_UMASH
+extern struct umash_params *hll_umash_params;
+extern void hll_umash_params_init(void);
+#endif
+
+/*
+ * Hash the binary representation of a value. The by-value types are hashed
+ * as their bytes in memory, which is the same as the values in the Arrow
+ * arrays, and the varlena types are hashed without the header.
+ */
+static pg_attribute_always_inline uint64
+hll_hash_bytes(const void *data, size_t len)
+{
+#ifdef TS_USE_UMASH
+	if (unlikely(hll_umash_params == NULL))
+		hll_umash_params_init();
+
+	return umash_full(hll_umash_params, HLL_HASH_SEED, 0, data, len);
+#else
+	return hash_bytes_extended((const unsigned char *) data, (int) len, HLL_HASH_SEED);
+#endif
+}
+
+/*
+ * Add the value with the given hash to the registers. The leading bits of the
+ * hash select the register, and the register keeps the maximum position of the
+ * first set bit in the rest of the hash.
+ */
+static pg_attribute_always_inline void
+hll_add_hash(uint8 *restrict registers, uint64 hash)
+{
+	const uint32 index = hash >> (64 - HLL_PRECISION);
+	const uint64 rest = (hash << HLL_PRECISION) | (UINT64CONST(1) << (HLL_PRECISION - 1));
+	const uint8 rank = 64 - pg_leftmost_one_pos64(rest);
+
+	if (rank > registers[index])
+		registers[index] = rank;
+}
+
+extern uint64 hll_hash_datum(Datum value, int16 typlen, bool typbyval);
+extern bytea *hll_serialize(const uint8 *registers);
+
+extern Datum tsl_hll_sfunc(PG_FUNCTION_ARGS);
+extern Datum tsl_hll_combinefunc(PG_FUNCTION_ARGS);
+extern Datum tsl_hll_serializefunc(PG_FUNCTION_ARGS);
+extern Datum tsl_hll_deserializefunc(PG_FUNCTION_ARGS);
+extern Datum tsl_hll_finalfunc(PG_FUNCTION_ARGS);
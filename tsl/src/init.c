@@ -34,6 +34,7 @@
 #include "continuous_aggs/repair.h"
 #include "continuous_aggs/utils.h"
 #include "cross_module_fn.h"
+#include "ddsketch.h"
 #include "export.h"
 #include "hypercore/arrow_cache_explain.h"
 #include "hypercore/arrow_tts.h"
@@ -41,10 +42,13 @@
 #include "hypercore/hypercore_handler.h"
 #include "hypercore/hypercore_proxy.h"
 #include "hypertable.h"
+#include "hyperloglog.h"
 #include "license_guc.h"
 #include "nodes/columnar_scan/columnar_scan.h"
+#include "nodes/decompress_chunk/decompress_stats.h"
 #include "nodes/decompress_chunk/planner.h"
 #include "nodes/gapfill/gapfill_functions.h"
+#include "nodes/runtime_filter/runtime_filter.h"
 #include "nodes/skip_scan/skip_scan.h"
 #include "nodes/vector_agg/plan.h"
 #include "partialize_finalize.h"
@@ -90,6 +94,7 @@ CrossModuleFunctions tsl_cm_functions = {
 	/* bgw policies */
 	.policy_compression_add = policy_compression_add,
 	.policy_compression_remove = policy_compression_remove,
+	.policy_compression_proc = policy_compression_proc,
 	.policy_recompression_proc = policy_recompression_proc,
 	.policy_compression_check = policy_compression_check,
 	.policy_refresh_cagg_add = policy_refresh_cagg_add,
@@ -138,6 +143,18 @@ CrossModuleFunctions tsl_cm_functions = {
 	.partialize_agg = tsl_partialize_agg,
 	.finalize_agg_sfunc = tsl_finalize_agg_sfunc,
 	.finalize_agg_ffunc = tsl_finalize_agg_ffunc,
+	.hll_sfunc = tsl_hll_sfunc,
+	.hll_combinefunc = tsl_hll_combinefunc,
+	.hll_serializefunc = tsl_hll_serializefunc,
+	.hll_deserializefunc = tsl_hll_deserializefunc,
+	.hll_finalfunc = tsl_hll_finalfunc,
+	.ddsketch_sfunc = tsl_ddsketch_sfunc,
+	.ddsketch_merge_sfunc = tsl_ddsketch_merge_sfunc,
+	.ddsketch_combinefunc = tsl_ddsketch_combinefunc,
+	.ddsketch_serializefunc = tsl_ddsketch_serializefunc,
+	.ddsketch_deserializefunc = tsl_ddsketch_deserializefunc,
+	.ddsketch_finalfunc = tsl_ddsketch_finalfunc,
+	.approx_percentile = tsl_approx_percentile,
 	.process_cagg_viewstmt = tsl_process_continuous_agg_viewstmt,
 	.continuous_agg_invalidation_trigger = continuous_agg_trigfn,
 	.continuous_agg_call_invalidation_trigger = execute_cagg_trigger,
@@ -160,6 +177,8 @@ CrossModuleFunctions tsl_cm_functions = {
 	.compressed_data_out = tsl_compressed_data_out,
 	.compressed_data_info = tsl_compressed_data_info,
 	.compressed_data_has_nulls = tsl_compressed_data_has_nulls,
+	.session_decompression_stats = tsl_session_decompression_stats,
+	.session_decompression_stats_reset = tsl_session_decompression_stats_reset,
 	.deltadelta_compressor_append = tsl_deltadelta_compressor_append,
 	.deltadelta_compressor_finish = tsl_deltadelta_compressor_finish,
 	.gorilla_compressor_append = tsl_gorilla_compressor_append,
@@ -220,6 +239,7 @@ ts_module_init(PG_FUNCTION_ARGS)
 	_attr_capture_init();
 	_skip_scan_init();
 	_vector_agg_init();
+	_runtime_filter_init();
 
 	/* Register a cleanup function to be called when the backend exits */
 	if (register_proc_exit)
@@ -7,6 +7,7 @@
 #include <access/attnum.h>
 #include <access/sdir.h>
 #include <access/skey.h>
+#include <access/sysattr.h>
 #include <access/tableam.h>
 #include <catalog/pg_attribute.h>
 #include <executor/tuptable.h>
@@ -58,6 +59,7 @@ typedef struct ColumnarScanState
 	List *quals_orig;
 	List *vectorized_quals_orig;
 	List *segmentby_quals;
+	Bitmapset *referenced_attrs;
 	SimpleProjInfo sprojinfo;
 } ColumnarScanState;
 
@@ -529,6 +531,7 @@ columnar_scan_exec(CustomScanState *state)
 								   estate->es_snapshot,
 								   cstate->nscankeys,
 								   cstate->scankeys);
+		hypercore_scan_set_referenced_attrs(scandesc, cstate->referenced_attrs);
 		state->ss.ss_currentScanDesc = scandesc;
 	}
 
@@ -756,6 +759,13 @@ columnar_scan_begin(CustomScanState *state, EState *estate, int eflags)
 #endif
 	List *vectorized_quals_constified = NIL;
 
+	/*
+	 * Set the columns computed by the planner before the executor start hook
+	 * captures the referenced attributes from the plan, which is the union
+	 * over all the scans of the relation in the query.
+	 */
+	arrow_slot_set_referenced_attrs(state->ss.ss_ScanTupleSlot, cstate->referenced_attrs);
+
 	if (cstate->nscankeys > 0)
 	{
 		const HypercoreInfo *hsinfo = RelationGetHypercoreInfo(state->ss.ss_currentRelation);
@@ -931,6 +941,7 @@ columnar_scan_initialize_dsm(CustomScanState *node, ParallelContext *pcxt, void
 															  pscan,
 															  cstate->nscankeys,
 															  cstate->scankeys);
+	hypercore_scan_set_referenced_attrs(node->ss.ss_currentScanDesc, cstate->referenced_attrs);
 }
 
 static void
@@ -951,6 +962,7 @@ columnar_scan_initialize_worker(CustomScanState *node, shm_toc *toc, void *arg)
 															  pscan,
 															  cstate->nscankeys,
 															  cstate->scankeys);
+	hypercore_scan_set_referenced_attrs(node->ss.ss_currentScanDesc, cstate->referenced_attrs);
 }
 
 static CustomExecMethods columnar_scan_state_methods = {
@@ -970,6 +982,7 @@ static Node *
 columnar_scan_state_create(CustomScan *cscan)
 {
 	ColumnarScanState *cstate;
+	ListCell *lc;
 
 	cstate = (ColumnarScanState *) newNode(sizeof(ColumnarScanState), T_CustomScanState);
 	cstate->css.methods = &columnar_scan_state_methods;
@@ -978,6 +991,10 @@ columnar_scan_state_create(CustomScan *cscan)
 	cstate->segmentby_quals = lthird(cscan->custom_exprs);
 	cstate->nscankeys = list_length(cstate->scankey_quals);
 	cstate->scankeys = NULL;
+	cstate->referenced_attrs = NULL;
+
+	foreach (lc, linitial(cscan->custom_private))
+		cstate->referenced_attrs = bms_add_member(cstate->referenced_attrs, lfirst_int(lc));
 #if PG16_GE
 	cstate->css.slotOps = &TTSOpsArrowTuple;
 #endif
@@ -1023,6 +1040,41 @@ columnar_scan_build_vector_attrs(const ColumnCompressionSettings *columns, int n
 	return vector_attrs;
 }
 
+/*
+ * Get the attribute numbers of the columns that the scan needs to return,
+ * which are the columns referenced in the target list and the quals.
+ *
+ * A whole-row reference needs all the columns. System columns are not
+ * stored in the arrow slot, so they are not included.
+ */
+static List *
+columnar_scan_referenced_attrs(Index relid, int natts, List *tlist, List *clauses)
+{
+	Bitmapset *attrs = NULL;
+	List *attnos = NIL;
+	int i = -1;
+
+	pull_varattnos((Node *) tlist, relid, &attrs);
+	pull_varattnos((Node *) clauses, relid, &attrs);
+
+	if (bms_is_member(InvalidAttrNumber - FirstLowInvalidHeapAttributeNumber, attrs))
+	{
+		for (AttrNumber attno = 1; attno <= natts; attno++)
+			attnos = lappend_int(attnos, attno);
+		return attnos;
+	}
+
+	while ((i = bms_next_member(attrs, i)) >= 0)
+	{
+		AttrNumber attno = i + FirstLowInvalidHeapAttributeNumber;
+
+		if (AttrNumberIsForUserDefinedAttr(attno))
+			attnos = lappend_int(attnos, attno);
+	}
+
+	return attnos;
+}
+
 static Plan *
 columnar_scan_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *best_path, List *tlist,
 						  List *scan_clauses, List *custom_plans)
@@ -1054,6 +1106,16 @@ columnar_scan_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *best_p
 	scan_clauses = extract_actual_clauses(scan_clauses, false);
 	classify_quals(&qpi, &vqih.vqinfo, scan_clauses);
 
+	/*
+	 * Pass the columns needed by the scan to the executor, so that the
+	 * hypercore scan only detoasts and decompresses those columns.
+	 */
+	columnar_scan_plan->custom_private = list_make1(
+		columnar_scan_referenced_attrs(rel->relid,
+									   RelationGetNumberOfAttributes(relation),
+									   tlist,
+									   scan_clauses));
+
 	columnar_scan_plan->scan.plan.qual = qpi.nonsegmentby_quals;
 	columnar_scan_plan->custom_exprs =
 		list_make3(qpi.vectorized_quals, qpi.scankey_quals, qpi.segmentby_quals);
@@ -46,6 +46,23 @@ typedef struct BatchQueueHeap
 	 */
 	TupleTableSlot *last_batch_first_tuple_slot;
 	HeapEntryColumn *last_batch_first_tuple_entry;
+
+	/*
+	 * The compressed tuples arrive in the order of the metadata column that
+	 * gives the first value of the leading sort key in the batch. If the next
+	 * compressed batch starts after the current top tuple, it can't contribute
+	 * to the output until the top tuple reaches its start, so we defer its
+	 * decompression until then. Under a LIMIT, this means that we don't
+	 * decompress the batch at all when the limit is reached first, and don't
+	 * read the subsequent compressed tuples either, because they all start
+	 * after the deferred one.
+	 *
+	 * The attribute number of this metadata column in the compressed tuple is
+	 * InvalidAttrNumber if the deferral is not possible.
+	 */
+	AttrNumber first_key_metadata_attno;
+	TupleTableSlot *pending_compressed_slot;
+	HeapEntryColumn pending_first_key;
 } BatchQueueHeap;
 
 /*
@@ -176,6 +193,7 @@ batch_queue_heap_pop(BatchQueue *bq, DecompressContext *dcontext)
 	if (binaryheap_empty(queue->merge_heap))
 	{
 		/* Allow this function to be called on the initial empty heap. */
+		batch_queue_heap_add_pending_batch(queue, dcontext);
 		return;
 	}
 
@@ -214,6 +232,12 @@ batch_queue_heap_pop(BatchQueue *bq, DecompressContext *dcontext)
 		/* Place this batch on the heap according to its new decompressed tuple. */
 		binaryheap_replace_first(queue->merge_heap, Int32GetDatum(top_batch_index));
 	}
+
+	/*
+	 * The top tuple has changed, so we might have to decompress the deferred
+	 * batch now.
+	 */
+	batch_queue_heap_add_pending_batch(queue, dcontext);
 }
 
 static bool
@@ -221,6 +245,16 @@ batch_queue_heap_needs_next_batch(BatchQueue *_queue)
 {
 	BatchQueueHeap *queue = (BatchQueueHeap *) _queue;
 
+	if (queue->pending_compressed_slot != NULL && !TupIsNull(queue->pending_compressed_slot))
+	{
+		/*
+		 * We have a deferred batch that starts after the current top tuple, so
+		 * the top tuple is the next one in the output, see pop().
+		 */
+		Assert(!pending_batch_is_needed(queue));
+		return false;
+	}
+
 	if (binaryheap_empty(queue->merge_heap))
 	{
 		return true;
@@ -247,11 +281,13 @@ batch_queue_heap_needs_next_batch(BatchQueue *_queue)
 	return comparison_result <= 0;
 }
 
+/*
+ * Decompress the given compressed batch and put it on the heap.
+ */
 static void
-batch_queue_heap_push_batch(BatchQueue *_queue, DecompressContext *dcontext,
-							TupleTableSlot *compressed_slot)
+batch_queue_heap_add_batch(BatchQueueHeap *queue, DecompressContext *dcontext,
+						   TupleTableSlot *compressed_slot)
 {
-	BatchQueueHeap *queue = (BatchQueueHeap *) _queue;
 	BatchArray *batch_array = &queue->queue.batch_array;
 
 	Assert(!TupIsNull(compressed_slot));
@@ -318,6 +354,96 @@ batch_queue_heap_push_batch(BatchQueue *_queue, DecompressContext *dcontext,
 	queue->merge_heap = binaryheap_add_unordered_autoresize(queue->merge_heap, new_batch_index);
 }
 
+/*
+ * Check whether the pending compressed batch can contribute to the output at
+ * the current top tuple, that is, whether its first value of the leading sort
+ * key doesn't sort after the current top tuple.
+ */
+static bool
+pending_batch_is_needed(BatchQueueHeap *queue)
+{
+	Assert(!TupIsNull(queue->pending_compressed_slot));
+
+	if (binaryheap_empty(queue->merge_heap))
+	{
+		return true;
+	}
+
+	const int top_batch_index = DatumGetInt32(binaryheap_first(queue->merge_heap));
+	const HeapEntryColumn *top_entry = &queue->heap_entries[queue->nkeys * top_batch_index];
+	return ApplySortComparator(queue->pending_first_key.value,
+							   queue->pending_first_key.null,
+							   top_entry->value,
+							   top_entry->null,
+							   &queue->sortkeys[0]) <= 0;
+}
+
+/*
+ * Decompress the pending compressed batch if the output has reached its start.
+ */
+static void
+batch_queue_heap_add_pending_batch(BatchQueueHeap *queue, DecompressContext *dcontext)
+{
+	if (queue->pending_compressed_slot == NULL || TupIsNull(queue->pending_compressed_slot) ||
+		!pending_batch_is_needed(queue))
+	{
+		return;
+	}
+
+	batch_queue_heap_add_batch(queue, dcontext, queue->pending_compressed_slot);
+	ExecClearTuple(queue->pending_compressed_slot);
+}
+
+static void
+batch_queue_heap_push_batch(BatchQueue *_queue, DecompressContext *dcontext,
+							TupleTableSlot *compressed_slot)
+{
+	BatchQueueHeap *queue = (BatchQueueHeap *) _queue;
+
+	Assert(!TupIsNull(compressed_slot));
+	Assert(queue->pending_compressed_slot == NULL || TupIsNull(queue->pending_compressed_slot));
+
+	if (queue->first_key_metadata_attno != InvalidAttrNumber &&
+		!binaryheap_empty(queue->merge_heap))
+	{
+		bool isnull;
+		Datum value = slot_getattr(compressed_slot, queue->first_key_metadata_attno, &isnull);
+		if (!isnull)
+		{
+			/*
+			 * The compressed slot will be reused for the next compressed
+			 * tuple, so we have to copy it if we decide to defer this batch.
+			 * Check the sort order first to avoid the copying in the common
+			 * case.
+			 */
+			const int top_batch_index = DatumGetInt32(binaryheap_first(queue->merge_heap));
+			const HeapEntryColumn *top_entry =
+				&queue->heap_entries[queue->nkeys * top_batch_index];
+			if (ApplySortComparator(value,
+									false,
+									top_entry->value,
+									top_entry->null,
+									&queue->sortkeys[0]) > 0)
+			{
+				if (queue->pending_compressed_slot == NULL)
+				{
+					queue->pending_compressed_slot =
+						MakeSingleTupleTableSlot(compressed_slot->tts_tupleDescriptor,
+												 &TTSOpsMinimalTuple);
+				}
+				ExecCopySlot(queue->pending_compressed_slot, compressed_slot);
+				queue->pending_first_key.value =
+					slot_getattr(queue->pending_compressed_slot,
+								 queue->first_key_metadata_attno,
+								 &queue->pending_first_key.null);
+				return;
+			}
+		}
+	}
+
+	batch_queue_heap_add_batch(queue, dcontext, compressed_slot);
+}
+
 static TupleTableSlot *
 batch_queue_heap_top_tuple(BatchQueue *bq)
 {
@@ -341,6 +467,11 @@ batch_queue_heap_reset(BatchQueue *bq)
 {
 	BatchQueueHeap *bqh = (BatchQueueHeap *) bq;
 	binaryheap_reset(bqh->merge_heap);
+
+	if (bqh->pending_compressed_slot != NULL)
+	{
+		ExecClearTuple(bqh->pending_compressed_slot);
+	}
 }
 
 /*
@@ -360,6 +491,10 @@ batch_queue_heap_free(BatchQueue *_queue)
 	queue->merge_heap = NULL;
 	pfree(queue->sortkeys);
 	ExecDropSingleTupleTableSlot(queue->last_batch_first_tuple_slot);
+	if (queue->pending_compressed_slot != NULL)
+	{
+		ExecDropSingleTupleTableSlot(queue->pending_compressed_slot);
+	}
 	pfree(queue->last_batch_first_tuple_entry);
 	batch_array_destroy(batch_array);
 	pfree(queue);
@@ -419,7 +554,8 @@ build_batch_sorted_merge_info(const List *sortinfo, int *nkeys)
 
 BatchQueue *
 batch_queue_heap_create(int num_compressed_cols, const List *sortinfo,
-						const TupleDesc result_tupdesc, const BatchQueueFunctions *funcs)
+						const TupleDesc result_tupdesc, AttrNumber first_key_metadata_attno,
+						const BatchQueueFunctions *funcs)
 {
 	BatchQueueHeap *queue = palloc0(sizeof(BatchQueueHeap));
 
@@ -451,6 +587,7 @@ batch_queue_heap_create(int num_compressed_cols, const List *sortinfo,
 	queue->merge_heap = binaryheap_allocate(INITIAL_BATCH_CAPACITY, comparator, queue);
 	queue->last_batch_first_tuple_slot = MakeSingleTupleTableSlot(result_tupdesc, &TTSOpsVirtual);
 	queue->last_batch_first_tuple_entry = palloc(sizeof(HeapEntryColumn) * queue->nkeys);
+	queue->first_key_metadata_attno = first_key_metadata_attno;
 	queue->queue.funcs = funcs;
 
 	return &queue->queue;
@@ -9,6 +9,7 @@
 
 extern BatchQueue *batch_queue_heap_create(int num_compressed_cols, const List *sortinfo,
 										   const TupleDesc result_tupdesc,
+										   AttrNumber first_key_metadata_attno,
 										   const BatchQueueFunctions *funcs);
 
 extern const struct BatchQueueFunctions BatchQueueFunctionsHeap;
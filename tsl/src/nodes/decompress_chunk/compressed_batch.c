@@ -19,6 +19,7 @@
 #include "nodes/decompress_chunk/compressed_batch.h"
 #include "nodes/decompress_chunk/vector_predicates.h"
 #include "nodes/decompress_chunk/vector_quals.h"
+#include "nodes/runtime_filter/runtime_filter.h"
 
 /*
  * Create a single-value ArrowArray of an arithmetic type. This is a specialized
@@ -157,6 +158,26 @@ get_max_text_datum_size(ArrowArray *text_array)
 	return maxbytes;
 }
 
+/*
+ * Account the decompression of the given column to the runtime statistics, if
+ * they are collected.
+ */
+static void
+decompress_column_stats(DecompressContext *dcontext, int i, const CompressedDataHeader *header,
+						const instr_time *start)
+{
+	DecompressStats *stats = dcontext->stats;
+	if (likely(stats == NULL))
+	{
+		return;
+	}
+
+	const int64 bytes = VARSIZE(header);
+	decompress_stats_count(&stats->phases[DSP_Decompress], start, bytes);
+	decompress_stats_count(&stats->algorithms[header->compression_algorithm], start, bytes);
+	decompress_stats_count(&stats->columns[i], start, bytes);
+}
+
 static void
 decompress_column(DecompressContext *dcontext, DecompressBatchState *batch_state,
 				  TupleTableSlot *compressed_slot, int i)
@@ -199,12 +220,16 @@ decompress_column(DecompressContext *dcontext, DecompressBatchState *batch_state
 
 	CompressedDataHeader *header = (CompressedDataHeader *) value;
 
+	instr_time start;
+	decompress_stats_start(dcontext->stats, &start);
+
 	/* First check if this is a block of NULL values. */
 	if (header->compression_algorithm == COMPRESSION_ALGORITHM_NULL)
 	{
 		column_values->decompression_type = DT_Scalar;
 		*column_values->output_isnull = true;
 		*column_values->output_value = (Datum) NULL;
+		decompress_column_stats(dcontext, i, header, &start);
 		return;
 	}
 
@@ -245,6 +270,7 @@ decompress_column(DecompressContext *dcontext, DecompressBatchState *batch_state
 												dcontext->reverse)(PointerGetDatum(header),
 																   column_description->typid);
 		MemoryContextSwitchTo(old_context);
+		decompress_column_stats(dcontext, i, header, &start);
 		return;
 	}
 
@@ -257,6 +283,8 @@ decompress_column(DecompressContext *dcontext, DecompressBatchState *batch_state
 
 	column_values->arrow = arrow;
 
+	decompress_column_stats(dcontext, i, header, &start);
+
 	if (value_bytes > 0)
 	{
 		/* Fixed-width column. */
@@ -733,17 +761,12 @@ compute_one_qual(VectorQualState *vqstate, TupleTableSlot *compressed_slot, Node
 }
 
 /*
- * Compute the vectorized filters. Returns true if we have any passing rows. If not,
- * it means the entire batch is filtered out, and we use this for further
- * optimizations.
+ * Allocate the bitmap that will hold the vectorized qual results. We
+ * initialize it to all ones and AND the individual quals to it.
  */
-VectorQualSummary
-vector_qual_compute(VectorQualState *vqstate)
+static void
+vector_qual_result_init(VectorQualState *vqstate)
 {
-	/*
-	 * Allocate the bitmap that will hold the vectorized qual results. We will
-	 * initialize it to all ones and AND the individual quals to it.
-	 */
 	const size_t n_rows = vqstate->num_results;
 	const int bitmap_bytes = sizeof(uint64) * ((n_rows + 63) / 64);
 	vqstate->vector_qual_result = MemoryContextAlloc(vqstate->per_vector_mcxt, bitmap_bytes);
@@ -759,6 +782,18 @@ vector_qual_compute(VectorQualState *vqstate)
 		const uint64 mask = ((uint64) -1) >> (64 - vqstate->num_results % 64);
 		vqstate->vector_qual_result[vqstate->num_results / 64] = mask;
 	}
+}
+
+/*
+ * Compute the vectorized filters. Returns true if we have any passing rows. If not,
+ * it means the entire batch is filtered out, and we use this for further
+ * optimizations.
+ */
+VectorQualSummary
+vector_qual_compute(VectorQualState *vqstate)
+{
+	const size_t n_rows = vqstate->num_results;
+	vector_qual_result_init(vqstate);
 
 	/*
 	 * Compute the quals.
@@ -855,12 +890,17 @@ compressed_batch_lazy_init(DecompressContext *dcontext, DecompressBatchState *ba
 }
 
 /*
- * Initialize the batch decompression state with the new compressed  tuple.
+ * Initialize the batch state with the new compressed tuple, reading only the
+ * values that are constant for the entire batch, i.e. the segmentby columns
+ * and the row count. The compressed columns are left for decompression on
+ * demand.
+ *
+ * This is enough for the callers that can compute their results from the
+ * batch metadata, e.g. the vectorized aggregation.
  */
 void
-compressed_batch_set_compressed_tuple(DecompressContext *dcontext,
-									  DecompressBatchState *batch_state,
-									  TupleTableSlot *compressed_slot)
+compressed_batch_read_scalars(DecompressContext *dcontext, DecompressBatchState *batch_state,
+							  TupleTableSlot *compressed_slot)
 {
 	Assert(TupIsNull(compressed_batch_current_tuple(batch_state)));
 
@@ -979,6 +1019,177 @@ compressed_batch_set_compressed_tuple(DecompressContext *dcontext,
 		}
 	}
 
+	batch_state->vector_qual_result = NULL;
+}
+
+/*
+ * Check whether the runtime join filter was built for the current execution of
+ * this node and can be used.
+ */
+static inline bool
+runtime_filter_is_current(const DecompressRuntimeFilter *rf)
+{
+	return rf->filter->complete && rf->filter->generation > rf->stale_generation;
+}
+
+/*
+ * Check the runtime join filters on the segmentby values and the min/max
+ * metadata of the compressed batch. Returns false if the batch can't have
+ * any rows that have a join partner.
+ */
+static bool
+runtime_filters_check_batch(DecompressContext *dcontext, DecompressBatchState *batch_state,
+							TupleTableSlot *compressed_slot)
+{
+	for (int i = 0; i < dcontext->num_runtime_filters; i++)
+	{
+		const DecompressRuntimeFilter *rf = &dcontext->runtime_filters[i];
+		if (!runtime_filter_is_current(rf))
+		{
+			continue;
+		}
+
+		const CompressedColumnValues *column_values =
+			&batch_state->compressed_columns[rf->column_index];
+		if (column_values->decompression_type == DT_Scalar)
+		{
+			if (*column_values->output_isnull ||
+				!runtime_filter_check_value(rf->filter, *column_values->output_value))
+			{
+				return false;
+			}
+			continue;
+		}
+
+		if (rf->min_metadata_attno == InvalidAttrNumber)
+		{
+			continue;
+		}
+
+		bool min_isnull;
+		bool max_isnull;
+		Datum min = slot_getattr(compressed_slot, rf->min_metadata_attno, &min_isnull);
+		Datum max = slot_getattr(compressed_slot, rf->max_metadata_attno, &max_isnull);
+		if (min_isnull || max_isnull)
+		{
+			/* This happens when all rows of the batch are null. */
+			continue;
+		}
+
+		if (!runtime_filter_check_range(rf->filter, min, max))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Compute the runtime join filters for the individual rows of the compressed
+ * batch, ANDing them into the vectorized qual result. This is only possible
+ * for the integer-like columns that are bulk-decompressed into arrow arrays.
+ */
+static VectorQualSummary
+runtime_filters_compute(DecompressContext *dcontext, DecompressBatchState *batch_state,
+						TupleTableSlot *compressed_slot, VectorQualState *vqstate,
+						VectorQualSummary summary)
+{
+	bool have_result = false;
+	for (int i = 0; i < dcontext->num_runtime_filters; i++)
+	{
+		const DecompressRuntimeFilter *rf = &dcontext->runtime_filters[i];
+		if (!runtime_filter_is_current(rf) || !rf->filter->is_integer ||
+			dcontext->compressed_chunk_columns[rf->column_index].type != COMPRESSED_COLUMN)
+		{
+			continue;
+		}
+
+		CompressedColumnValues *column_values = &batch_state->compressed_columns[rf->column_index];
+		if (column_values->decompression_type == DT_Invalid)
+		{
+			decompress_column(dcontext, batch_state, compressed_slot, rf->column_index);
+			Assert(column_values->decompression_type != DT_Invalid);
+		}
+
+		if (column_values->decompression_type == DT_Scalar)
+		{
+			/* The column is not there in this batch, and has a default value. */
+			if (*column_values->output_isnull ||
+				!runtime_filter_check_value(rf->filter, *column_values->output_value))
+			{
+				return NoRowsPass;
+			}
+			continue;
+		}
+
+		if (column_values->decompression_type != rf->filter->typlen ||
+			column_values->arrow == NULL)
+		{
+			/* Not bulk-decompressed. */
+			continue;
+		}
+
+		if (vqstate->vector_qual_result == NULL)
+		{
+			vector_qual_result_init(vqstate);
+		}
+
+		runtime_filter_compute_vector(rf->filter,
+									  column_values->arrow,
+									  column_values->decompression_type,
+									  vqstate->vector_qual_result);
+		have_result = true;
+	}
+
+	if (!have_result)
+	{
+		return summary;
+	}
+
+	return get_vector_qual_summary(vqstate->vector_qual_result, vqstate->num_results);
+}
+
+/*
+ * The total time spent in detoasting and decompressing the columns.
+ */
+static instr_time
+column_processing_time(const DecompressStats *stats)
+{
+	instr_time result = stats->phases[DSP_Detoast].time;
+	INSTR_TIME_ADD(result, stats->phases[DSP_Decompress].time);
+	return result;
+}
+
+/*
+ * Initialize the batch decompression state with the new compressed  tuple.
+ */
+void
+compressed_batch_set_compressed_tuple(DecompressContext *dcontext,
+									  DecompressBatchState *batch_state,
+									  TupleTableSlot *compressed_slot)
+{
+	compressed_batch_read_scalars(dcontext, batch_state, compressed_slot);
+
+	dcontext->batches_read++;
+	dcontext->rows_read += batch_state->total_batch_rows;
+
+	if (dcontext->num_runtime_filters > 0 &&
+		!runtime_filters_check_batch(dcontext, batch_state, compressed_slot))
+	{
+		/*
+		 * The batch can't have any rows with a join partner, so we don't have
+		 * to decompress it at all. Note that the runtime filters are never used
+		 * with batch sorted merge.
+		 */
+		Assert(!dcontext->batch_sorted_merge);
+		compressed_batch_discard_tuples(batch_state);
+
+		InstrCountTuples2(dcontext->ps, 1);
+		InstrCountFiltered1(dcontext->ps, batch_state->total_batch_rows);
+		return;
+	}
+
 	CompressedBatchVectorQualState cbvqstate = {
 		.vqstate = {
 			.vectorized_quals_constified = dcontext->vectorized_quals_constified,
@@ -992,9 +1203,40 @@ compressed_batch_set_compressed_tuple(DecompressContext *dcontext,
 	};
 	VectorQualState *vqstate = &cbvqstate.vqstate;
 
+	instr_time vector_qual_start = { 0 };
+	instr_time column_time_before = { 0 };
+	if (unlikely(dcontext->stats != NULL))
+	{
+		INSTR_TIME_SET_CURRENT(vector_qual_start);
+		column_time_before = column_processing_time(dcontext->stats);
+	}
+
 	VectorQualSummary vector_qual_summary =
 		vqstate->vectorized_quals_constified != NIL ? vector_qual_compute(vqstate) : AllRowsPass;
 
+	if (vector_qual_summary != NoRowsPass && dcontext->num_runtime_filters > 0)
+	{
+		vector_qual_summary = runtime_filters_compute(dcontext,
+													  batch_state,
+													  compressed_slot,
+													  vqstate,
+													  vector_qual_summary);
+	}
+
+	if (unlikely(dcontext->stats != NULL))
+	{
+		/*
+		 * The columns referenced by the quals are detoasted and decompressed
+		 * on demand during their evaluation, so we have to exclude this time
+		 * which is already accounted separately.
+		 */
+		DecompressStatsCounter *counter = &dcontext->stats->phases[DSP_VectorQuals];
+		instr_time column_time = column_processing_time(dcontext->stats);
+		INSTR_TIME_SUBTRACT(column_time, column_time_before);
+		decompress_stats_count(counter, &vector_qual_start, 0);
+		INSTR_TIME_SUBTRACT(counter->time, column_time);
+	}
+
 	batch_state->vector_qual_result = vqstate->vector_qual_result;
 
 	if (vector_qual_summary == NoRowsPass && !dcontext->batch_sorted_merge)
@@ -1153,6 +1395,21 @@ make_next_tuple(DecompressBatchState *batch_state, uint16 arrow_row, int num_dat
 	}
 }
 
+/*
+ * Construct the next tuple and account the time to the materialization phase
+ * of the decompression statistics. Separate from make_next_tuple(), so that
+ * the per-row path doesn't read the clock when the statistics are disabled.
+ */
+static pg_noinline void
+make_next_tuple_timed(DecompressContext *dcontext, DecompressBatchState *batch_state,
+					  uint16 arrow_row, int num_data_columns)
+{
+	instr_time start;
+	INSTR_TIME_SET_CURRENT(start);
+	make_next_tuple(batch_state, arrow_row, num_data_columns);
+	decompress_stats_count(&dcontext->stats->phases[DSP_Materialize], &start, 0);
+}
+
 static bool
 vector_qual(DecompressBatchState *batch_state, uint16 arrow_row)
 {
@@ -1229,7 +1486,14 @@ compressed_batch_advance(DecompressContext *dcontext, DecompressBatchState *batc
 			continue;
 		}
 
-		make_next_tuple(batch_state, arrow_row, num_data_columns);
+		if (likely(dcontext->stats == NULL))
+		{
+			make_next_tuple(batch_state, arrow_row, num_data_columns);
+		}
+		else
+		{
+			make_next_tuple_timed(dcontext, batch_state, arrow_row, num_data_columns);
+		}
 
 		if (!postgres_qual(dcontext, batch_state))
 		{
@@ -1300,7 +1564,14 @@ compressed_batch_save_first_tuple(DecompressContext *dcontext, DecompressBatchSt
 	/* Make the first tuple and save it. */
 	Assert(batch_state->next_batch_row == 0);
 	const uint16 arrow_row = dcontext->reverse ? batch_state->total_batch_rows - 1 : 0;
-	make_next_tuple(batch_state, arrow_row, dcontext->num_data_columns);
+	if (likely(dcontext->stats == NULL))
+	{
+		make_next_tuple(batch_state, arrow_row, dcontext->num_data_columns);
+	}
+	else
+	{
+		make_next_tuple_timed(dcontext, batch_state, arrow_row, dcontext->num_data_columns);
+	}
 	ExecCopySlot(first_tuple_slot, &batch_state->decompressed_scan_slot_data.base);
 
 	/*
@@ -114,6 +114,10 @@ typedef struct DecompressBatchState
 	CompressedColumnValues compressed_columns[FLEXIBLE_ARRAY_MEMBER];
 } DecompressBatchState;
 
+extern void compressed_batch_read_scalars(DecompressContext *dcontext,
+										  DecompressBatchState *batch_state,
+										  TupleTableSlot *compressed_slot);
+
 extern void compressed_batch_set_compressed_tuple(DecompressContext *dcontext,
 												  DecompressBatchState *batch_state,
 												  TupleTableSlot *compressed_slot);
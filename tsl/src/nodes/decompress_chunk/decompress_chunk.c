@@ -5,9 +5,12 @@
  */
 
 #include <postgres.h>
+#include <access/sysattr.h>
 #include "chunk.h"
 #include "hypertable_cache.h"
+#include <catalog/pg_class.h>
 #include <catalog/pg_operator.h>
+#include <catalog/pg_statistic.h>
 #include <math.h>
 #include <miscadmin.h>
 #include <nodes/bitmapset.h>
@@ -22,6 +25,7 @@
 #include <planner/planner.h>
 #include <utils/builtins.h>
 #include <utils/lsyscache.h>
+#include <utils/syscache.h>
 #include <utils/typcache.h>
 
 #include <planner.h>
@@ -58,6 +62,12 @@ typedef struct SortInfo
 	QualCost decompressed_sort_pathkeys_cost;
 } SortInfo;
 
+/*
+ * The cost of decompressing one value of a compressed column, relative to
+ * cpu_operator_cost, in addition to the cost per compressed byte.
+ */
+#define DECOMPRESSION_COST_PER_VALUE 0.25
+
 static RangeTblEntry *decompress_chunk_make_rte(Oid compressed_relid, LOCKMODE lockmode,
 												Query *parse);
 static void create_compressed_scan_paths(PlannerInfo *root, RelOptInfo *compressed_rel,
@@ -368,6 +378,231 @@ copy_decompress_chunk_path(DecompressChunkPath *src)
 	return dst;
 }
 
+/*
+ * Estimate the average number of rows per compressed batch from the ANALYZE
+ * statistics of the count metadata column of the compressed chunk. This only
+ * uses the syscache, so it doesn't add catalog scans at plan time. Returns
+ * false if the compressed chunk wasn't analyzed.
+ */
+static bool
+estimate_batch_rows(Oid compressed_relid, double *batch_rows)
+{
+	const AttrNumber count_attno =
+		get_attnum(compressed_relid, COMPRESSION_COLUMN_METADATA_COUNT_NAME);
+	if (count_attno == InvalidAttrNumber)
+	{
+		return false;
+	}
+
+	HeapTuple stats_tuple = SearchSysCache3(STATRELATTINH,
+											ObjectIdGetDatum(compressed_relid),
+											Int16GetDatum(count_attno),
+											BoolGetDatum(false));
+	if (!HeapTupleIsValid(stats_tuple))
+	{
+		return false;
+	}
+
+	/*
+	 * The most common values are weighted by their frequencies, and the rest
+	 * of the values are assumed to be uniformly distributed over the
+	 * histogram buckets.
+	 */
+	double sum = 0;
+	double mcv_fraction = 0;
+	AttStatsSlot sslot;
+	if (get_attstatsslot(&sslot,
+						 stats_tuple,
+						 STATISTIC_KIND_MCV,
+						 InvalidOid,
+						 ATTSTATSSLOT_VALUES | ATTSTATSSLOT_NUMBERS))
+	{
+		for (int i = 0; i < sslot.nvalues; i++)
+		{
+			sum += DatumGetInt32(sslot.values[i]) * sslot.numbers[i];
+			mcv_fraction += sslot.numbers[i];
+		}
+		free_attstatsslot(&sslot);
+	}
+
+	double histogram_mean = -1;
+	if (get_attstatsslot(&sslot,
+						 stats_tuple,
+						 STATISTIC_KIND_HISTOGRAM,
+						 InvalidOid,
+						 ATTSTATSSLOT_VALUES))
+	{
+		if (sslot.nvalues > 1)
+		{
+			double bucket_sum = 0;
+			for (int i = 0; i < sslot.nvalues - 1; i++)
+			{
+				bucket_sum +=
+					(DatumGetInt32(sslot.values[i]) + DatumGetInt32(sslot.values[i + 1])) / 2.0;
+			}
+			histogram_mean = bucket_sum / (sslot.nvalues - 1);
+		}
+		free_attstatsslot(&sslot);
+	}
+
+	ReleaseSysCache(stats_tuple);
+
+	if (histogram_mean >= 0)
+	{
+		sum += (1 - mcv_fraction) * histogram_mean;
+		mcv_fraction = 1;
+	}
+
+	if (mcv_fraction <= 0)
+	{
+		return false;
+	}
+
+	*batch_rows = sum / mcv_fraction;
+	return true;
+}
+
+/*
+ * Get the size in bytes of the TOAST relation of the given relation, where
+ * most of the compressed data is stored. We use the size recorded in pg_class
+ * by VACUUM, so that planning doesn't have to open the TOAST relation.
+ */
+static double
+get_toast_bytes(Oid relid)
+{
+	HeapTuple tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(relid));
+	if (!HeapTupleIsValid(tuple))
+	{
+		return 0;
+	}
+
+	const Oid toast_relid = ((Form_pg_class) GETSTRUCT(tuple))->reltoastrelid;
+	ReleaseSysCache(tuple);
+
+	if (!OidIsValid(toast_relid))
+	{
+		return 0;
+	}
+
+	tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(toast_relid));
+	if (!HeapTupleIsValid(tuple))
+	{
+		return 0;
+	}
+
+	/* The relpages is -1 if the relation was never vacuumed. */
+	const int32 pages = ((Form_pg_class) GETSTRUCT(tuple))->relpages;
+	ReleaseSysCache(tuple);
+
+	return (double) Max(pages, 0) * BLCKSZ;
+}
+
+/*
+ * Estimate the number of rows per compressed batch and the cost of
+ * decompressing the columns required by the query, using the statistics
+ * gathered by ANALYZE on the compressed chunk.
+ *
+ * The decompression cost of a column is estimated from the compressed size of
+ * its values per row. The ANALYZE average width of a compressed column only
+ * covers the part stored in the compressed chunk itself, which is just the
+ * TOAST pointer for the larger values, so we add an equal share of the TOAST
+ * relation size for every compressed column. This accounts for the
+ * compression algorithms used and for the batch fill: e.g. delta-delta
+ * compressed timestamps take a fraction of a byte per value, while the
+ * dictionary-compressed text takes much more.
+ */
+static void
+estimate_decompression_costs(CompressionInfo *info, RelOptInfo *chunk_rel)
+{
+	info->has_cost_stats = false;
+	info->batch_rows = TARGET_COMPRESSED_BATCH_SIZE;
+	info->decompression_cost_per_row = 0;
+
+	if (!ts_guc_enable_decompression_cost_stats)
+	{
+		return;
+	}
+
+	const Oid compressed_relid = info->settings->fd.compress_relid;
+	double batch_rows;
+	if (!estimate_batch_rows(compressed_relid, &batch_rows))
+	{
+		return;
+	}
+
+	info->has_cost_stats = true;
+	info->batch_rows = Max(1, Min(batch_rows, TARGET_COMPRESSED_BATCH_SIZE));
+
+	/*
+	 * Find the chunk columns required by the query.
+	 */
+	Bitmapset *attnos = NULL;
+	pull_varattnos((Node *) chunk_rel->reltarget->exprs, chunk_rel->relid, &attnos);
+	ListCell *lc;
+	foreach (lc, chunk_rel->baserestrictinfo)
+	{
+		RestrictInfo *ri = lfirst_node(RestrictInfo, lc);
+		pull_varattnos((Node *) ri->clause, chunk_rel->relid, &attnos);
+	}
+
+	const bool whole_row =
+		bms_is_member(0 - FirstLowInvalidHeapAttributeNumber, attnos);
+	const int natts = get_relnatts(info->chunk_rte->relid);
+	int num_compressed_columns = 0;
+	double required_width = 0;
+	int num_required_columns = 0;
+	for (AttrNumber chunk_attno = 1; chunk_attno <= natts; chunk_attno++)
+	{
+		if (bms_is_member(chunk_attno, info->chunk_segmentby_attnos))
+		{
+			/* The segmentby values are not compressed. */
+			continue;
+		}
+
+		char *attname = get_attname(info->chunk_rte->relid, chunk_attno, /* missing_ok = */ true);
+		if (attname == NULL)
+		{
+			/* Dropped column. */
+			continue;
+		}
+
+		AttrNumber compressed_attno = get_attnum(compressed_relid, attname);
+		if (compressed_attno == InvalidAttrNumber)
+		{
+			continue;
+		}
+
+		num_compressed_columns++;
+
+		if (!whole_row &&
+			!bms_is_member(chunk_attno - FirstLowInvalidHeapAttributeNumber, attnos))
+		{
+			continue;
+		}
+
+		num_required_columns++;
+		required_width += Max(0, get_attavgwidth(compressed_relid, compressed_attno));
+	}
+
+	if (num_required_columns == 0)
+	{
+		return;
+	}
+
+	/*
+	 * The compressed relation was already opened by the planner, so its
+	 * number of tuples is the estimated number of batches.
+	 */
+	const double batches = Max(1, info->compressed_rel->tuples);
+	const double toast_bytes_per_column =
+		get_toast_bytes(compressed_relid) / batches / num_compressed_columns;
+	const double bytes_per_row =
+		(required_width + toast_bytes_per_column * num_required_columns) / info->batch_rows;
+
+	info->decompression_cost_per_row =
+		cpu_operator_cost * (DECOMPRESSION_COST_PER_VALUE * num_required_columns + bytes_per_row);
+}
+
 static CompressionInfo *
 build_compressioninfo(PlannerInfo *root, const Hypertable *ht, const Chunk *chunk,
 					  RelOptInfo *chunk_rel)
@@ -440,12 +675,26 @@ build_compressioninfo(PlannerInfo *root, const Hypertable *ht, const Chunk *chun
  * we put cost of 1 tuple of compressed_scan as startup cost
  */
 static void
-cost_decompress_chunk(PlannerInfo *root, Path *path, Path *compressed_path)
+cost_decompress_chunk(PlannerInfo *root, const CompressionInfo *info, Path *path,
+					  Path *compressed_path)
 {
 	/* startup_cost is cost before fetching first tuple */
 	if (compressed_path->rows > 0)
 		path->startup_cost = compressed_path->total_cost / compressed_path->rows;
 
+	if (info->has_cost_stats)
+	{
+		/*
+		 * With the decompression cost statistics, we know the actual batch
+		 * fill and the cost of decompressing the required columns.
+		 */
+		path->rows = compressed_path->rows * info->batch_rows;
+		path->total_cost = compressed_path->total_cost +
+						   path->rows * (cpu_tuple_cost + info->decompression_cost_per_row);
+		path->startup_cost += info->batch_rows * info->decompression_cost_per_row;
+		return;
+	}
+
 	/* total_cost is cost for fetching all tuples */
 	path->total_cost = compressed_path->total_cost + path->rows * cpu_tuple_cost;
 	path->rows = compressed_path->rows * TARGET_COMPRESSED_BATCH_SIZE;
@@ -599,7 +848,7 @@ cost_batch_sorted_merge(PlannerInfo *root, const CompressionInfo *compression_in
 	 * compressed chunk is never projected so we can't use it for that.
 	 */
 	const double work_mem_bytes = work_mem * 1024.0;
-	const double needed_memory_bytes = open_batches_clamped * TARGET_COMPRESSED_BATCH_SIZE *
+	const double needed_memory_bytes = open_batches_clamped * compression_info->batch_rows *
 									   dcpath->custom_path.path.pathtarget->width;
 
 	/*
@@ -637,7 +886,8 @@ cost_batch_sorted_merge(PlannerInfo *root, const CompressionInfo *compression_in
 	 */
 	const double sort_path_cost_rest = sort_path.total_cost - sort_path_cost_for_startup;
 	Assert(sort_path_cost_rest >= 0);
-	const double uncompressed_row_cost = 1.5 * log(open_batches_clamped + 1) * cpu_tuple_cost;
+	const double uncompressed_row_cost = 1.5 * log(open_batches_clamped + 1) * cpu_tuple_cost +
+										 compression_info->decompression_cost_per_row;
 	Assert(uncompressed_row_cost > 0);
 	dcpath->custom_path.path.total_cost = dcpath->custom_path.path.startup_cost +
 										  sort_path_cost_rest +
@@ -834,11 +1084,13 @@ ts_decompress_chunk_generate_paths(PlannerInfo *root, RelOptInfo *chunk_rel, con
 
 	compressed_rel = compression_info->compressed_rel;
 
+	estimate_decompression_costs(compression_info, chunk_rel);
+
 	compressed_rel->consider_parallel = chunk_rel->consider_parallel;
 	/* translate chunk_rel->baserestrictinfo */
 	pushdown_quals(root, compression_info->settings, chunk_rel, compressed_rel, consider_partial);
 	set_baserel_size_estimates(root, compressed_rel);
-	double new_row_estimate = compressed_rel->rows * TARGET_COMPRESSED_BATCH_SIZE;
+	double new_row_estimate = compressed_rel->rows * compression_info->batch_rows;
 
 	if (!compression_info->single_chunk)
 	{
@@ -1009,7 +1261,10 @@ ts_decompress_chunk_generate_paths(PlannerInfo *root, RelOptInfo *chunk_rel, con
 						  work_mem,
 						  -1);
 
-				cost_decompress_chunk(root, &path_copy->custom_path.path, &sort_path);
+				cost_decompress_chunk(root,
+									  compression_info,
+									  &path_copy->custom_path.path,
+									  &sort_path);
 			}
 
 			chunk_path = &path_copy->custom_path.path;
@@ -1912,7 +2167,7 @@ decompress_chunk_path_create(PlannerInfo *root, const CompressionInfo *info, int
 	path->custom_path.custom_paths = list_make1(compressed_path);
 	path->reverse = false;
 	path->required_compressed_pathkeys = NIL;
-	cost_decompress_chunk(root, &path->custom_path.path, compressed_path);
+	cost_decompress_chunk(root, info, &path->custom_path.path, compressed_path);
 
 	return path;
 }
@@ -41,6 +41,16 @@ typedef struct CompressionInfo
 	/* compressed chunk attribute numbers for columns that are compressed */
 	Bitmapset *compressed_attnos_in_compressed_chunk;
 
+	/*
+	 * The estimated number of rows per compressed batch, and the estimated
+	 * cost of decompressing the columns required by the query per row. These
+	 * are based on the decompression cost statistics if they are enabled, see
+	 * estimate_decompression_costs().
+	 */
+	bool has_cost_stats;
+	double batch_rows;
+	double decompression_cost_per_row;
+
 	bool single_chunk;	  /* query on explicit chunk */
 	bool has_seq_num;	  /* legacy sequence number support */
 	Relids parent_relids; /* relids of the parent hypertable and UNION */
@@ -13,6 +13,7 @@
 #include <nodes/pg_list.h>
 
 #include "batch_array.h"
+#include "decompress_stats.h"
 #include "detoaster.h"
 
 typedef enum CompressionColumnType
@@ -52,6 +53,33 @@ typedef struct CompressionColumnDescription
 	bool bulk_decompression_supported;
 } CompressionColumnDescription;
 
+/*
+ * A runtime join filter built by a hash join above the DecompressChunk node,
+ * applied to the given data column.
+ */
+typedef struct DecompressRuntimeFilter
+{
+	struct RuntimeFilter *filter;
+
+	/* Index of the column in DecompressContext.compressed_chunk_columns. */
+	int column_index;
+
+	/*
+	 * Attnos of the min/max metadata of the column in the input compressed
+	 * chunk scan, or InvalidAttrNumber if we don't have them.
+	 */
+	AttrNumber min_metadata_attno;
+	AttrNumber max_metadata_attno;
+
+	/*
+	 * Generation of the filter at the last rescan of this node. The filter
+	 * can only be used once it is completed again after that, because the
+	 * hash join might read the first outer tuple before it rebuilds the hash
+	 * table and the filter for the new parameter values.
+	 */
+	uint64 stale_generation;
+} DecompressRuntimeFilter;
+
 typedef struct DecompressContext
 {
 	/*
@@ -76,6 +104,10 @@ typedef struct DecompressContext
 	bool batch_sorted_merge; /* Batch sorted merge optimization enabled. */
 	bool enable_bulk_decompression;
 
+	/* The runtime join filters built by the hash joins above this node. */
+	int num_runtime_filters;
+	DecompressRuntimeFilter *runtime_filters;
+
 	/*
 	 * Scratch space for bulk decompression which might need a lot of temporary
 	 * data.
@@ -94,6 +126,20 @@ typedef struct DecompressContext
 
 	PlanState *ps; /* Set for filtering and instrumentation */
 
+	/*
+	 * The actual batch sizes, to compare with the planner estimates in EXPLAIN
+	 * ANALYZE.
+	 */
+	int64 batches_read;
+	int64 rows_read;
+
+	/*
+	 * The runtime statistics of the batch processing, NULL if they are not
+	 * collected, because it requires reading the clock several times per
+	 * batch and per row.
+	 */
+	DecompressStats *stats;
+
 	Detoaster detoaster;
 } DecompressContext;
 
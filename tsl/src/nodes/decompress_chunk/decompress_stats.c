@@ -0,0 +1,226 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * Runtime statistics of the compressed batch processing in DecompressChunk.
+ *
+ * The statistics are collected per node when requested with the
+ * EXPLAIN (ANALYZE, DECOMPRESS_STATS) option or with the
+ * timescaledb.enable_decompression_stats GUC, and are also accumulated in the
+ * statistics of the session, which can be inspected through the
+ * timescaledb_information.session_decompression_stats view. The session
+ * statistics are kept in backend-local memory, so they are not shared with
+ * the other sessions and don't include the work of the parallel workers.
+ */
+
+#include <postgres.h>
+#include <funcapi.h>
+#include <lib/stringinfo.h>
+#include <utils/builtins.h>
+#include <utils/tuplestore.h>
+
+#include "nodes/decompress_chunk/decompress_stats.h"
+
+bool decompress_stats_print = false;
+
+/* The statistics of all the DecompressChunk nodes that ran in this session. */
+static DecompressStats session_stats;
+
+static const char *phase_names[_DSP_Count] = {
+	[DSP_Fetch] = "fetch",
+	[DSP_Detoast] = "detoast",
+	[DSP_Decompress] = "decompress",
+	[DSP_VectorQuals] = "vector quals",
+	[DSP_Materialize] = "materialize",
+};
+
+/*
+ * Create the statistics for a DecompressChunk node with the given number of
+ * compressed data columns.
+ */
+DecompressStats *
+decompress_stats_create(int num_columns)
+{
+	DecompressStats *stats = palloc0(sizeof(DecompressStats));
+	stats->num_columns = num_columns;
+	stats->columns = palloc0(sizeof(DecompressStatsCounter) * num_columns);
+	return stats;
+}
+
+static void
+counter_accumulate(DecompressStatsCounter *dst, const DecompressStatsCounter *src)
+{
+	dst->count += src->count;
+	dst->bytes += src->bytes;
+	INSTR_TIME_ADD(dst->time, src->time);
+}
+
+void
+decompress_stats_accumulate(const DecompressStats *stats)
+{
+	for (int i = 0; i < _DSP_Count; i++)
+	{
+		counter_accumulate(&session_stats.phases[i], &stats->phases[i]);
+	}
+
+	for (int i = 0; i < _END_COMPRESSION_ALGORITHMS; i++)
+	{
+		counter_accumulate(&session_stats.algorithms[i], &stats->algorithms[i]);
+	}
+}
+
+/*
+ * Format the counter for the text EXPLAIN output. The time is omitted with
+ * EXPLAIN (TIMING OFF), so that the output is stable.
+ */
+static void
+explain_counter_text(StringInfo str, const char *count_name, const DecompressStatsCounter *counter,
+					 ExplainState *es)
+{
+	appendStringInfo(str, " %s=" INT64_FORMAT, count_name, counter->count);
+
+	if (counter->bytes > 0)
+	{
+		appendStringInfo(str, " bytes=" INT64_FORMAT, counter->bytes);
+	}
+
+	if (es->timing)
+	{
+		appendStringInfo(str, " time=%.3f", INSTR_TIME_GET_MILLISEC(counter->time));
+	}
+}
+
+static void
+explain_counter(const char *label, const char *count_name, const DecompressStatsCounter *counter,
+				ExplainState *es)
+{
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+	{
+		StringInfoData str;
+		initStringInfo(&str);
+		explain_counter_text(&str, count_name, counter, es);
+
+		/* Skip the leading space. */
+		ExplainPropertyText(label, str.data + 1, es);
+		pfree(str.data);
+		return;
+	}
+
+	ExplainOpenGroup(label, label, true, es);
+	ExplainPropertyInteger(count_name, NULL, counter->count, es);
+	ExplainPropertyInteger("Bytes", NULL, counter->bytes, es);
+	if (es->timing)
+	{
+		ExplainPropertyFloat("Time", "ms", INSTR_TIME_GET_MILLISEC(counter->time), 3, es);
+	}
+	ExplainCloseGroup(label, label, true, es);
+}
+
+/*
+ * Show the statistics of a DecompressChunk node in EXPLAIN ANALYZE. The
+ * per-column statistics are only shown with VERBOSE, and use the given column
+ * names.
+ */
+void
+decompress_stats_explain(const DecompressStats *stats, List *column_names, ExplainState *es)
+{
+	ExplainOpenGroup("Decompression Stats", "Decompression Stats", true, es);
+
+	for (int i = 0; i < _DSP_Count; i++)
+	{
+		char *label = psprintf("Decompression %s", phase_names[i]);
+		explain_counter(label, "calls", &stats->phases[i], es);
+	}
+
+	for (int i = 0; i < _END_COMPRESSION_ALGORITHMS; i++)
+	{
+		if (stats->algorithms[i].count == 0)
+		{
+			continue;
+		}
+
+		char *label = psprintf("Algorithm %s",
+							   NameStr(*compression_get_algorithm_name((CompressionAlgorithm) i)));
+		explain_counter(label, "columns", &stats->algorithms[i], es);
+	}
+
+	if (es->verbose)
+	{
+		Assert(list_length(column_names) == stats->num_columns);
+		for (int i = 0; i < stats->num_columns; i++)
+		{
+			if (stats->columns[i].count == 0)
+			{
+				continue;
+			}
+
+			char *label = psprintf("Column %s", (char *) list_nth(column_names, i));
+			explain_counter(label, "batches", &stats->columns[i], es);
+		}
+	}
+
+	ExplainCloseGroup("Decompression Stats", "Decompression Stats", true, es);
+}
+
+static void
+put_counter(Tuplestorestate *tupstore, TupleDesc tupdesc, const char *kind, const char *name,
+			const DecompressStatsCounter *counter)
+{
+	Datum values[5] = {
+		CStringGetTextDatum(kind),
+		CStringGetTextDatum(name),
+		Int64GetDatum(counter->count),
+		Int64GetDatum(counter->bytes),
+		Float8GetDatum(INSTR_TIME_GET_MILLISEC(counter->time)),
+	};
+	bool nulls[5] = { false };
+
+	tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+}
+
+/*
+ * Return the decompression statistics of the current session, one row per
+ * processing phase and per compression algorithm.
+ */
+Datum
+tsl_session_decompression_stats(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+
+	InitMaterializedSRF(fcinfo, 0);
+
+	for (int i = 0; i < _DSP_Count; i++)
+	{
+		put_counter(rsinfo->setResult,
+					rsinfo->setDesc,
+					"phase",
+					phase_names[i],
+					&session_stats.phases[i]);
+	}
+
+	for (int i = 0; i < _END_COMPRESSION_ALGORITHMS; i++)
+	{
+		if (session_stats.algorithms[i].count == 0)
+		{
+			continue;
+		}
+
+		put_counter(rsinfo->setResult,
+					rsinfo->setDesc,
+					"algorithm",
+					NameStr(*compression_get_algorithm_name((CompressionAlgorithm) i)),
+					&session_stats.algorithms[i]);
+	}
+
+	return (Datum) 0;
+}
+
+Datum
+tsl_session_decompression_stats_reset(PG_FUNCTION_ARGS)
+{
+	memset(&session_stats, 0, sizeof(session_stats));
+	PG_RETURN_VOID();
+}
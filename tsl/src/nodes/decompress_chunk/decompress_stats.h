@@ -0,0 +1,99 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+#include <commands/explain.h>
+#include <fmgr.h>
+#include <portability/instr_time.h>
+
+#include "compression/compression.h"
+
+/*
+ * The phases of the compressed batch processing that we measure separately.
+ */
+typedef enum DecompressStatsPhase
+{
+	/* Fetching the compressed tuples from the compressed chunk scan. */
+	DSP_Fetch = 0,
+	/* Detoasting the compressed column values. */
+	DSP_Detoast,
+	/* Decompressing the columns, either in bulk or by setting up iterators. */
+	DSP_Decompress,
+	/* Evaluating the vectorized quals and runtime filters. */
+	DSP_VectorQuals,
+	/* Building the decompressed tuples. */
+	DSP_Materialize,
+	_DSP_Count,
+} DecompressStatsPhase;
+
+typedef struct DecompressStatsCounter
+{
+	int64 count;
+	int64 bytes;
+	instr_time time;
+} DecompressStatsCounter;
+
+/*
+ * Runtime statistics of the compressed batch processing, collected per
+ * DecompressChunk node and accumulated in the backend-local session
+ * statistics when the node finishes.
+ */
+typedef struct DecompressStats
+{
+	DecompressStatsCounter phases[_DSP_Count];
+	DecompressStatsCounter algorithms[_END_COMPRESSION_ALGORITHMS];
+
+	/*
+	 * The per-column statistics, indexed like the
+	 * DecompressContext.compressed_chunk_columns. They are only shown in
+	 * EXPLAIN (ANALYZE, VERBOSE) and are not accumulated.
+	 */
+	int num_columns;
+	DecompressStatsCounter *columns;
+} DecompressStats;
+
+static inline void
+decompress_stats_start(const DecompressStats *stats, instr_time *start)
+{
+	if (unlikely(stats != NULL))
+	{
+		INSTR_TIME_SET_CURRENT(*start);
+	}
+}
+
+/*
+ * Account the time elapsed since the given start to the given counter.
+ */
+static inline void
+decompress_stats_count(DecompressStatsCounter *counter, const instr_time *start, int64 bytes)
+{
+	instr_time end;
+	INSTR_TIME_SET_CURRENT(end);
+	INSTR_TIME_ACCUM_DIFF(counter->time, end, *start);
+	counter->count++;
+	counter->bytes += bytes;
+}
+
+static inline void
+decompress_stats_end(DecompressStats *stats, DecompressStatsPhase phase, const instr_time *start)
+{
+	if (unlikely(stats != NULL))
+	{
+		decompress_stats_count(&stats->phases[phase], start, 0);
+	}
+}
+
+/* Set by the EXPLAIN (DECOMPRESS_STATS) option. */
+extern bool decompress_stats_print;
+
+extern DecompressStats *decompress_stats_create(int num_columns);
+extern void decompress_stats_accumulate(const DecompressStats *stats);
+extern void decompress_stats_explain(const DecompressStats *stats, List *column_names,
+									 ExplainState *es);
+
+extern Datum tsl_session_decompression_stats(PG_FUNCTION_ARGS);
+extern Datum tsl_session_decompression_stats_reset(PG_FUNCTION_ARGS);
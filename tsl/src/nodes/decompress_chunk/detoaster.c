@@ -23,6 +23,7 @@
 #include <compat/compat.h>
 #include "debug_assert.h"
 #include <compression/compression.h>
+#include "nodes/decompress_chunk/decompress_stats.h"
 
 /* We redefine this postgres macro to fix a warning about signed integer comparison. */
 #define TS_VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer)                                            \
@@ -221,6 +222,7 @@ detoaster_init(Detoaster *detoaster, MemoryContext mctx)
 {
 	detoaster->toastrel = NULL;
 	detoaster->mctx = mctx;
+	detoaster->stats = NULL;
 }
 
 void
@@ -305,8 +307,8 @@ ts_toast_decompress_datum(struct varlena *attr)
  * the data is inline and no detoasting is needed, copies it into the destination
  * memory context.
  */
-struct varlena *
-detoaster_detoast_attr_copy(struct varlena *attr, Detoaster *detoaster, MemoryContext dest_mctx)
+static struct varlena *
+detoast_attr_copy_impl(struct varlena *attr, Detoaster *detoaster, MemoryContext dest_mctx)
 {
 	if (!VARATT_IS_EXTENDED(attr))
 	{
@@ -397,3 +399,22 @@ detoaster_detoast_attr_copy(struct varlena *attr, Detoaster *detoaster, MemoryCo
 
 	return attr;
 }
+
+/*
+ * Detoast the compressed data, accounting for the time spent and the size of
+ * the result if the statistics are collected.
+ */
+struct varlena *
+detoaster_detoast_attr_copy(struct varlena *attr, Detoaster *detoaster, MemoryContext dest_mctx)
+{
+	if (likely(detoaster->stats == NULL))
+	{
+		return detoast_attr_copy_impl(attr, detoaster, dest_mctx);
+	}
+
+	instr_time start;
+	INSTR_TIME_SET_CURRENT(start);
+	struct varlena *result = detoast_attr_copy_impl(attr, detoaster, dest_mctx);
+	decompress_stats_count(detoaster->stats, &start, VARSIZE(result));
+	return result;
+}
@@ -14,6 +14,7 @@
 #include <utils/snapshot.h>
 
 typedef struct RelationData *Relation;
+typedef struct DecompressStatsCounter DecompressStatsCounter;
 
 typedef struct Detoaster
 {
@@ -23,6 +24,12 @@ typedef struct Detoaster
 	SnapshotData SnapshotToast;
 	ScanKeyData toastkey;
 	SysScanDesc toastscan;
+
+	/*
+	 * Where to account the time spent in detoasting and the size of the
+	 * detoasted data, NULL if the statistics are not collected.
+	 */
+	DecompressStatsCounter *stats;
 } Detoaster;
 
 void detoaster_init(Detoaster *detoaster, MemoryContext mctx);
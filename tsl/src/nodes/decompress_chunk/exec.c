@@ -15,6 +15,7 @@
 #include <parser/parsetree.h>
 #include <rewrite/rewriteManip.h>
 #include <utils/datum.h>
+#include <utils/lsyscache.h>
 #include <utils/memutils.h>
 #include <utils/typcache.h>
 
@@ -31,6 +32,7 @@
 #include "nodes/decompress_chunk/decompress_chunk.h"
 #include "nodes/decompress_chunk/exec.h"
 #include "nodes/decompress_chunk/planner.h"
+#include "nodes/runtime_filter/runtime_filter.h"
 
 static void decompress_chunk_begin(CustomScanState *node, EState *estate, int eflags);
 static void decompress_chunk_end(CustomScanState *node);
@@ -69,6 +71,8 @@ decompress_chunk_state_create(CustomScan *cscan)
 	chunk_state->bulk_decompression_column =
 		list_nth(cscan->custom_private, DCP_BulkDecompressionColumn);
 	chunk_state->sortinfo = list_nth(cscan->custom_private, DCP_SortInfo);
+	chunk_state->runtime_filters = list_nth(cscan->custom_private, DCP_RuntimeFilters);
+	chunk_state->cost_stats = list_nth(cscan->custom_private, DCP_CostStats);
 
 	chunk_state->custom_scan_tlist = cscan->custom_scan_tlist;
 
@@ -171,6 +175,94 @@ decompress_chunk_exec_heap(CustomScanState *node)
 	return decompress_chunk_exec_impl(chunk_state, &BatchQueueFunctionsHeap);
 }
 
+/*
+ * For batch sorted merge, find the compressed tuple attribute of the metadata
+ * column by which the compressed batches are sorted, i.e. the first value of
+ * the leading sort key in the batch. The batch queue uses it to defer the
+ * decompression of batches that start after the current output position.
+ *
+ * The metadata doesn't tell whether the batch has null values, so with nulls
+ * first, the batch might start before its metadata value. We can't use it in
+ * this case unless the column is NOT NULL.
+ */
+static AttrNumber
+get_first_key_metadata_attno(DecompressChunkState *chunk_state)
+{
+	CustomScan *cscan = castNode(CustomScan, chunk_state->csstate.ss.ps.plan);
+	Plan *compressed_plan = linitial(cscan->custom_plans);
+	if (!IsA(compressed_plan, Sort))
+	{
+		return InvalidAttrNumber;
+	}
+
+	List *sort_col_idx = linitial(chunk_state->sortinfo);
+	List *sort_nulls = lfourth(chunk_state->sortinfo);
+	if (list_nth_oid(sort_nulls, 0))
+	{
+		AttrNumber chunk_attno = list_nth_oid(sort_col_idx, 0);
+		if (cscan->custom_scan_tlist != NIL)
+		{
+			TargetEntry *tle = list_nth_node(TargetEntry,
+											 cscan->custom_scan_tlist,
+											 AttrNumberGetAttrOffset(chunk_attno));
+			if (!IsA(tle->expr, Var))
+			{
+				return InvalidAttrNumber;
+			}
+			chunk_attno = castNode(Var, tle->expr)->varattno;
+		}
+
+		Relation chunk_rel = chunk_state->csstate.ss.ss_currentRelation;
+		if (chunk_rel == NULL || chunk_attno <= 0 ||
+			!TupleDescAttr(RelationGetDescr(chunk_rel), AttrNumberGetAttrOffset(chunk_attno))
+				 ->attnotnull)
+		{
+			return InvalidAttrNumber;
+		}
+	}
+
+	return castNode(Sort, compressed_plan)->sortColIdx[0];
+}
+
+/*
+ * Set up the runtime join filters built by the hash joins above this node.
+ */
+static void
+init_runtime_filters(DecompressChunkState *chunk_state, EState *estate)
+{
+	DecompressContext *dcontext = &chunk_state->decompress_context;
+
+	if (chunk_state->runtime_filters == NIL || dcontext->batch_sorted_merge)
+	{
+		return;
+	}
+
+	dcontext->runtime_filters =
+		palloc0(sizeof(DecompressRuntimeFilter) * list_length(chunk_state->runtime_filters));
+
+	ListCell *lc;
+	foreach (lc, chunk_state->runtime_filters)
+	{
+		List *entry = lfirst(lc);
+		const AttrNumber chunk_attno = list_nth_int(entry, 1);
+
+		for (int i = 0; i < dcontext->num_data_columns; i++)
+		{
+			if (dcontext->compressed_chunk_columns[i].uncompressed_chunk_attno != chunk_attno)
+			{
+				continue;
+			}
+
+			DecompressRuntimeFilter *rf = &dcontext->runtime_filters[dcontext->num_runtime_filters++];
+			rf->filter = runtime_filter_get(estate, list_nth_int(entry, 0));
+			rf->column_index = i;
+			rf->min_metadata_attno = list_nth_int(entry, 2);
+			rf->max_metadata_attno = list_nth_int(entry, 3);
+			break;
+		}
+	}
+}
+
 /*
  * Complete initialization of the supplied CustomScanState.
  *
@@ -369,6 +461,7 @@ decompress_chunk_begin(CustomScanState *node, EState *estate, int eflags)
 			batch_queue_heap_create(num_data_columns,
 									chunk_state->sortinfo,
 									dcontext->custom_scan_slot->tts_tupleDescriptor,
+									get_first_key_metadata_attno(chunk_state),
 									&BatchQueueFunctionsHeap);
 		chunk_state->exec_methods.ExecCustomScan = decompress_chunk_exec_heap;
 	}
@@ -379,6 +472,18 @@ decompress_chunk_begin(CustomScanState *node, EState *estate, int eflags)
 		chunk_state->exec_methods.ExecCustomScan = decompress_chunk_exec_fifo;
 	}
 
+	init_runtime_filters(chunk_state, estate);
+
+	/*
+	 * Collect the runtime statistics if they are requested by the EXPLAIN
+	 * option or for the session statistics.
+	 */
+	chunk_state->explain_stats = decompress_stats_print;
+	if (decompress_stats_print || ts_guc_enable_decompression_stats)
+	{
+		dcontext->stats = decompress_stats_create(num_data_columns);
+	}
+
 	if (ts_guc_debug_require_batch_sorted_merge && !dcontext->batch_sorted_merge)
 	{
 		elog(ERROR, "debug: batch sorted merge is required but not used");
@@ -401,6 +506,10 @@ decompress_chunk_begin(CustomScanState *node, EState *estate, int eflags)
 	}
 
 	detoaster_init(&dcontext->detoaster, CurrentMemoryContext);
+	if (dcontext->stats != NULL)
+	{
+		dcontext->detoaster.stats = &dcontext->stats->phases[DSP_Detoast];
+	}
 }
 
 /*
@@ -421,7 +530,10 @@ decompress_chunk_exec_impl(DecompressChunkState *chunk_state, const BatchQueueFu
 
 	while (bqfuncs->needs_next_batch(bq))
 	{
+		instr_time start;
+		decompress_stats_start(dcontext->stats, &start);
 		TupleTableSlot *subslot = ExecProcNode(linitial(chunk_state->csstate.custom_ps));
+		decompress_stats_end(dcontext->stats, DSP_Fetch, &start);
 		if (TupIsNull(subslot))
 		{
 			/* Won't have more compressed tuples. */
@@ -458,10 +570,22 @@ static void
 decompress_chunk_rescan(CustomScanState *node)
 {
 	DecompressChunkState *chunk_state = (DecompressChunkState *) node;
+	DecompressContext *dcontext = &chunk_state->decompress_context;
 	BatchQueue *bq = chunk_state->batch_queue;
 
 	bq->funcs->reset(bq);
 
+	/*
+	 * The runtime filters might still be complete from the previous execution
+	 * if the hash join has not rebuilt them yet, so don't use them until they
+	 * are completed again.
+	 */
+	for (int i = 0; i < dcontext->num_runtime_filters; i++)
+	{
+		DecompressRuntimeFilter *rf = &dcontext->runtime_filters[i];
+		rf->stale_generation = rf->filter->generation;
+	}
+
 	if (node->ss.ps.chgParam != NULL)
 		UpdateChangedParamSet(linitial(node->custom_ps), node->ss.ps.chgParam);
 
@@ -479,6 +603,11 @@ decompress_chunk_end(CustomScanState *node)
 	ExecEndNode(linitial(node->custom_ps));
 
 	detoaster_close(&chunk_state->decompress_context.detoaster);
+
+	if (chunk_state->decompress_context.stats != NULL)
+	{
+		decompress_stats_accumulate(chunk_state->decompress_context.stats);
+	}
 }
 
 /*
@@ -522,6 +651,11 @@ decompress_chunk_explain(CustomScanState *node, List *ancestors, ExplainState *e
 			ExplainPropertyBool("Batch Sorted Merge", dcontext->batch_sorted_merge, es);
 		}
 
+		if (dcontext->num_runtime_filters > 0)
+		{
+			ExplainPropertyInteger("Runtime Join Filters", NULL, dcontext->num_runtime_filters, es);
+		}
+
 		if (es->analyze && (es->verbose || es->format != EXPLAIN_FORMAT_TEXT))
 		{
 			ExplainPropertyBool("Bulk Decompression",
@@ -529,4 +663,52 @@ decompress_chunk_explain(CustomScanState *node, List *ancestors, ExplainState *e
 								es);
 		}
 	}
+
+	if (chunk_state->explain_stats && chunk_state->cost_stats != NIL)
+	{
+		/*
+		 * Compare the estimates based on the decompression cost statistics with
+		 * the actual values.
+		 */
+		ExplainPropertyFloat("Estimated Rows per Batch",
+							 NULL,
+							 floatVal(linitial(chunk_state->cost_stats)),
+							 1,
+							 es);
+		ExplainPropertyFloat("Estimated Decompression Cost",
+							 NULL,
+							 floatVal(lsecond(chunk_state->cost_stats)),
+							 2,
+							 es);
+
+		if (es->analyze && dcontext->batches_read > 0)
+		{
+			ExplainPropertyFloat("Actual Rows per Batch",
+								 NULL,
+								 (double) dcontext->rows_read / dcontext->batches_read,
+								 1,
+								 es);
+		}
+
+		if (es->analyze && es->timing && dcontext->stats != NULL)
+		{
+			instr_time time = dcontext->stats->phases[DSP_Detoast].time;
+			INSTR_TIME_ADD(time, dcontext->stats->phases[DSP_Decompress].time);
+			ExplainPropertyFloat("Decompression Time", "ms", INSTR_TIME_GET_MILLISEC(time), 3, es);
+		}
+	}
+
+	if (es->analyze && chunk_state->explain_stats && dcontext->stats != NULL)
+	{
+		List *column_names = NIL;
+		for (int i = 0; i < dcontext->stats->num_columns; i++)
+		{
+			const CompressionColumnDescription *column = &dcontext->compressed_chunk_columns[i];
+			column_names = lappend(column_names,
+								   get_attname(chunk_state->chunk_relid,
+											   column->uncompressed_chunk_attno,
+											   /* missing_ok = */ false));
+		}
+		decompress_stats_explain(dcontext->stats, column_names, es);
+	}
 }
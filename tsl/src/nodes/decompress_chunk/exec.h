@@ -33,6 +33,23 @@ typedef struct DecompressChunkState
 
 	List *sortinfo;
 
+	/*
+	 * The runtime join filters to apply, as a list of the parameter id of the
+	 * filter, the uncompressed chunk attno of the column, and the compressed
+	 * scan attnos of its min/max metadata.
+	 */
+	List *runtime_filters;
+
+	/*
+	 * The planner estimates of the rows per compressed batch and the total
+	 * decompression cost, when the decompression cost statistics were used
+	 * for planning. NIL otherwise.
+	 */
+	List *cost_stats;
+
+	/* Show the runtime statistics in EXPLAIN ANALYZE. */
+	bool explain_stats;
+
 	/*
 	 * For some predicates, we have more efficient implementation that work on
 	 * the entire compressed batch in one go. They go to this list, and the rest
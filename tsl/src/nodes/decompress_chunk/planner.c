@@ -1381,6 +1381,23 @@ decompress_chunk_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *pat
 	lfirst(list_nth_cell(decompress_plan->custom_private, DCP_BulkDecompressionColumn)) =
 		context.bulk_decompression_column;
 	lfirst(list_nth_cell(decompress_plan->custom_private, DCP_SortInfo)) = sort_options;
+	/* Filled in at plan postprocessing, see try_insert_runtime_filters(). */
+	lfirst(list_nth_cell(decompress_plan->custom_private, DCP_RuntimeFilters)) = NIL;
+
+	/*
+	 * The estimates based on the decompression cost statistics, to be compared
+	 * with the actual values in EXPLAIN ANALYZE.
+	 */
+	List *cost_stats = NIL;
+	if (dcpath->info->has_cost_stats)
+	{
+		cost_stats =
+			list_make2(makeFloat(psprintf("%g", dcpath->info->batch_rows)),
+					   makeFloat(psprintf("%g",
+										  dcpath->custom_path.path.rows *
+											  dcpath->info->decompression_cost_per_row)));
+	}
+	lfirst(list_nth_cell(decompress_plan->custom_private, DCP_CostStats)) = cost_stats;
 
 	/*
 	 * We might be using a custom scan tuple if it allows us to avoid the
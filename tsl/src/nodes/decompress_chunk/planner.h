@@ -25,6 +25,8 @@ typedef enum
 	DCP_IsSegmentbyColumn = 2,
 	DCP_BulkDecompressionColumn = 3,
 	DCP_SortInfo = 4,
+	DCP_RuntimeFilters = 5,
+	DCP_CostStats = 6,
 	DCP_Count
 } DecompressChunkPrivateIndex;
 
@@ -0,0 +1,149 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * The RuntimeFilter build node sits between the Hash node and its input, and
+ * passes the inner tuples of a hash join through unchanged, adding their join
+ * keys to the runtime filters on the way. When the input is exhausted, the
+ * filters become available to the DecompressChunk nodes on the outer side of
+ * the join.
+ */
+
+#include <postgres.h>
+#include <executor/executor.h>
+#include <nodes/extensible.h>
+#include <nodes/nodeFuncs.h>
+
+#include "nodes/runtime_filter/runtime_filter.h"
+
+typedef struct RuntimeFilterBuildState
+{
+	CustomScanState custom;
+
+	int num_filters;
+	RuntimeFilter **filters;
+	ExprState **key_exprs;
+
+	bool input_done;
+} RuntimeFilterBuildState;
+
+static void
+runtime_filter_build_begin(CustomScanState *node, EState *estate, int eflags)
+{
+	RuntimeFilterBuildState *state = (RuntimeFilterBuildState *) node;
+	CustomScan *cscan = castNode(CustomScan, node->ss.ps.plan);
+
+	/*
+	 * We return the tuples of the child node as is, so the result slot type is
+	 * not fixed.
+	 */
+	node->ss.ps.resultopsfixed = false;
+
+	outerPlanState(node) = ExecInitNode(outerPlan(cscan), estate, eflags);
+
+	List *paramids = linitial(cscan->custom_private);
+	List *keys = cscan->custom_exprs;
+	Assert(list_length(paramids) == list_length(keys));
+
+	state->num_filters = list_length(paramids);
+	state->filters = palloc(sizeof(RuntimeFilter *) * state->num_filters);
+	state->key_exprs = palloc(sizeof(ExprState *) * state->num_filters);
+	for (int i = 0; i < state->num_filters; i++)
+	{
+		Expr *key = list_nth(keys, i);
+		RuntimeFilter *filter = runtime_filter_get(estate, list_nth_int(paramids, i));
+		runtime_filter_init_type(filter, exprType((Node *) key), exprCollation((Node *) key));
+		runtime_filter_reset(filter);
+
+		state->filters[i] = filter;
+		state->key_exprs[i] = ExecInitExpr(key, &node->ss.ps);
+	}
+
+	state->input_done = false;
+}
+
+static TupleTableSlot *
+runtime_filter_build_exec(CustomScanState *node)
+{
+	RuntimeFilterBuildState *state = (RuntimeFilterBuildState *) node;
+	TupleTableSlot *slot = ExecProcNode(outerPlanState(node));
+
+	if (TupIsNull(slot))
+	{
+		if (!state->input_done)
+		{
+			for (int i = 0; i < state->num_filters; i++)
+			{
+				runtime_filter_finish(state->filters[i]);
+			}
+			state->input_done = true;
+		}
+		return slot;
+	}
+
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+	ResetExprContext(econtext);
+	econtext->ecxt_outertuple = slot;
+
+	for (int i = 0; i < state->num_filters; i++)
+	{
+		bool isnull;
+		Datum value = ExecEvalExprSwitchContext(state->key_exprs[i], econtext, &isnull);
+
+		/* The null keys never match. */
+		if (!isnull)
+		{
+			runtime_filter_add(state->filters[i], value);
+		}
+	}
+
+	return slot;
+}
+
+static void
+runtime_filter_build_rescan(CustomScanState *node)
+{
+	RuntimeFilterBuildState *state = (RuntimeFilterBuildState *) node;
+
+	for (int i = 0; i < state->num_filters; i++)
+	{
+		runtime_filter_reset(state->filters[i]);
+	}
+	state->input_done = false;
+
+	/*
+	 * If chgParam of the child is not null, it will be rescanned by the first
+	 * ExecProcNode.
+	 */
+	if (outerPlanState(node)->chgParam == NULL)
+	{
+		ExecReScan(outerPlanState(node));
+	}
+}
+
+static void
+runtime_filter_build_end(CustomScanState *node)
+{
+	ExecEndNode(outerPlanState(node));
+}
+
+static CustomExecMethods runtime_filter_build_exec_methods = {
+	.CustomName = RUNTIME_FILTER_NODE_NAME,
+	.BeginCustomScan = runtime_filter_build_begin,
+	.ExecCustomScan = runtime_filter_build_exec,
+	.EndCustomScan = runtime_filter_build_end,
+	.ReScanCustomScan = runtime_filter_build_rescan,
+};
+
+Node *
+runtime_filter_build_state_create(CustomScan *cscan)
+{
+	RuntimeFilterBuildState *state =
+		(RuntimeFilterBuildState *) newNode(sizeof(RuntimeFilterBuildState),
+											T_CustomScanState);
+	state->custom.methods = &runtime_filter_build_exec_methods;
+	return (Node *) state;
+}
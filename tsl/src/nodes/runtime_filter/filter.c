@@ -0,0 +1,511 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * The runtime join filter data structure: the min/max range of the inner join
+ * keys and either their exact set or a bloom filter of their hashes.
+ */
+
+#include <postgres.h>
+#include <catalog/pg_type_d.h>
+#include <common/hashfn.h>
+#include <utils/datum.h>
+#include <utils/memutils.h>
+#include <utils/typcache.h>
+
+#include "nodes/runtime_filter/runtime_filter.h"
+
+/*
+ * We don't build the bloom filter for more keys than this, because it becomes
+ * too big to be efficiently probed, and the join is probably not selective
+ * anyway. Only the min/max range is used in this case.
+ */
+#define MAX_BLOOM_KEYS (1024 * 1024)
+
+/* The number of bloom filter bits per key, gives about 5% false positives. */
+#define BLOOM_BITS_PER_KEY 8
+
+/*
+ * For a small inner side with integer keys, we build the exact set of the
+ * keys, so that the outer rows without a join partner are filtered out
+ * completely.
+ */
+#define MAX_EXACT_KEYS (64 * 1024)
+
+/*
+ * Get the runtime filter stored in the given executor parameter slot, creating
+ * it if it's not there yet. Both the build node and the DecompressChunk nodes
+ * call this at initialization, in no particular order.
+ */
+RuntimeFilter *
+runtime_filter_get(EState *estate, int paramid)
+{
+	ParamExecData *prm = &estate->es_param_exec_vals[paramid];
+	Assert(prm->execPlan == NULL);
+
+	if (DatumGetPointer(prm->value) == NULL)
+	{
+		RuntimeFilter *filter = MemoryContextAllocZero(estate->es_query_cxt, sizeof(RuntimeFilter));
+		filter->mcxt =
+			AllocSetContextCreate(estate->es_query_cxt, "runtime filter", ALLOCSET_DEFAULT_SIZES);
+		prm->value = PointerGetDatum(filter);
+		prm->isnull = false;
+	}
+
+	return (RuntimeFilter *) DatumGetPointer(prm->value);
+}
+
+/*
+ * Set up the type of the filter values. Called by the build node.
+ */
+void
+runtime_filter_init_type(RuntimeFilter *filter, Oid typid, Oid collation)
+{
+	filter->typid = typid;
+	filter->collation = collation;
+	get_typlenbyval(typid, &filter->typlen, &filter->typbyval);
+
+	switch (typid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case DATEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			filter->is_integer = true;
+			break;
+		default:
+			filter->is_integer = false;
+			break;
+	}
+
+	TypeCacheEntry *tce =
+		lookup_type_cache(typid, TYPECACHE_CMP_PROC_FINFO | TYPECACHE_HASH_PROC_FINFO);
+	filter->cmp_finfo = OidIsValid(tce->cmp_proc_finfo.fn_oid) ? &tce->cmp_proc_finfo : NULL;
+	filter->hash_finfo = OidIsValid(tce->hash_proc_finfo.fn_oid) ? &tce->hash_proc_finfo : NULL;
+}
+
+static pg_attribute_always_inline int64
+datum_get_integer(Datum value, int16 typlen)
+{
+	switch (typlen)
+	{
+		case 2:
+			return DatumGetInt16(value);
+		case 4:
+			return DatumGetInt32(value);
+		default:
+			Assert(typlen == 8);
+			return DatumGetInt64(value);
+	}
+}
+
+static pg_attribute_always_inline uint64
+integer_hash(int64 value)
+{
+	return murmurhash64((uint64) value);
+}
+
+static uint64
+datum_hash(const RuntimeFilter *filter, Datum value)
+{
+	if (filter->is_integer)
+	{
+		return integer_hash(datum_get_integer(value, filter->typlen));
+	}
+
+	Assert(filter->hash_finfo != NULL);
+	const uint32 hash =
+		DatumGetUInt32(FunctionCall1Coll(filter->hash_finfo, filter->collation, value));
+	return murmurhash64(hash);
+}
+
+static pg_attribute_always_inline bool
+exact_check(const int64 *keys, const uint64 *occupied, uint64 mask, int64 value)
+{
+	for (uint64 index = integer_hash(value) & mask;; index = (index + 1) & mask)
+	{
+		if (!(occupied[index / 64] & (1ULL << (index % 64))))
+		{
+			return false;
+		}
+
+		if (keys[index] == value)
+		{
+			return true;
+		}
+	}
+}
+
+static pg_attribute_always_inline bool
+bloom_check(const uint64 *bloom, uint64 mask, uint64 hash)
+{
+	/*
+	 * Two probes derived from the lower and upper halves of the hash.
+	 */
+	const uint64 bit1 = hash & mask;
+	const uint64 bit2 = (hash >> 32) & mask;
+	return (bloom[bit1 / 64] & (1ULL << (bit1 % 64))) && (bloom[bit2 / 64] & (1ULL << (bit2 % 64)));
+}
+
+static int
+compare_values(const RuntimeFilter *filter, Datum a, Datum b)
+{
+	Assert(filter->cmp_finfo != NULL);
+	return DatumGetInt32(FunctionCall2Coll(filter->cmp_finfo, filter->collation, a, b));
+}
+
+/*
+ * Forget all the values, before the inner side is read again on rescan.
+ */
+void
+runtime_filter_reset(RuntimeFilter *filter)
+{
+	filter->complete = false;
+	filter->has_values = false;
+	filter->min = (Datum) 0;
+	filter->max = (Datum) 0;
+	filter->accumulated = NULL;
+	filter->num_accumulated = 0;
+	filter->accumulated_capacity = 0;
+	filter->exact_keys = NULL;
+	filter->exact_occupied = NULL;
+	filter->exact_mask = 0;
+	filter->bloom = NULL;
+	filter->bloom_bits_mask = 0;
+	MemoryContextReset(filter->mcxt);
+}
+
+/*
+ * Add a non-null inner join key to the filter.
+ */
+void
+runtime_filter_add(RuntimeFilter *filter, Datum value)
+{
+	Assert(!filter->complete);
+
+	if (filter->is_integer)
+	{
+		const int64 integer = datum_get_integer(value, filter->typlen);
+		if (!filter->has_values)
+		{
+			filter->min_integer = integer;
+			filter->max_integer = integer;
+		}
+		else
+		{
+			filter->min_integer = Min(filter->min_integer, integer);
+			filter->max_integer = Max(filter->max_integer, integer);
+		}
+	}
+	else if (filter->cmp_finfo != NULL)
+	{
+		MemoryContext old = MemoryContextSwitchTo(filter->mcxt);
+		if (!filter->has_values)
+		{
+			filter->min = datumCopy(value, filter->typbyval, filter->typlen);
+			filter->max = datumCopy(value, filter->typbyval, filter->typlen);
+		}
+		else if (compare_values(filter, value, filter->min) < 0)
+		{
+			if (!filter->typbyval)
+				pfree(DatumGetPointer(filter->min));
+			filter->min = datumCopy(value, filter->typbyval, filter->typlen);
+		}
+		else if (compare_values(filter, value, filter->max) > 0)
+		{
+			if (!filter->typbyval)
+				pfree(DatumGetPointer(filter->max));
+			filter->max = datumCopy(value, filter->typbyval, filter->typlen);
+		}
+		MemoryContextSwitchTo(old);
+	}
+
+	filter->has_values = true;
+
+	if (!filter->is_integer && filter->hash_finfo == NULL)
+	{
+		return;
+	}
+
+	if (filter->num_accumulated > MAX_BLOOM_KEYS)
+	{
+		/* Too many keys, the bloom filter is not going to be built. */
+		return;
+	}
+
+	if (filter->num_accumulated >= filter->accumulated_capacity)
+	{
+		if (filter->accumulated == NULL)
+		{
+			filter->accumulated_capacity = 1024;
+			filter->accumulated =
+				MemoryContextAlloc(filter->mcxt, sizeof(uint64) * filter->accumulated_capacity);
+		}
+		else
+		{
+			filter->accumulated_capacity *= 2;
+			filter->accumulated =
+				repalloc(filter->accumulated, sizeof(uint64) * filter->accumulated_capacity);
+		}
+	}
+
+	filter->accumulated[filter->num_accumulated++] =
+		filter->is_integer ? (uint64) datum_get_integer(value, filter->typlen) :
+							 datum_hash(filter, value);
+}
+
+/*
+ * Build the open-addressing hash set of the accumulated integer keys.
+ */
+static void
+build_exact_set(RuntimeFilter *filter)
+{
+	uint64 num_slots = 64;
+	while (num_slots < (uint64) filter->num_accumulated * 2)
+	{
+		num_slots *= 2;
+	}
+
+	filter->exact_keys = MemoryContextAlloc(filter->mcxt, sizeof(int64) * num_slots);
+	filter->exact_occupied = MemoryContextAllocZero(filter->mcxt, num_slots / 8);
+	filter->exact_mask = num_slots - 1;
+
+	for (int i = 0; i < filter->num_accumulated; i++)
+	{
+		const int64 value = (int64) filter->accumulated[i];
+		uint64 index = integer_hash(value) & filter->exact_mask;
+		while (filter->exact_occupied[index / 64] & (1ULL << (index % 64)))
+		{
+			if (filter->exact_keys[index] == value)
+			{
+				break;
+			}
+			index = (index + 1) & filter->exact_mask;
+		}
+
+		filter->exact_keys[index] = value;
+		filter->exact_occupied[index / 64] |= 1ULL << (index % 64);
+	}
+}
+
+/*
+ * Build the exact set or the bloom filter from the accumulated keys after the
+ * inner side was read completely, and allow the filter to be used.
+ */
+void
+runtime_filter_finish(RuntimeFilter *filter)
+{
+	if (filter->accumulated != NULL && filter->is_integer &&
+		filter->num_accumulated <= MAX_EXACT_KEYS)
+	{
+		build_exact_set(filter);
+	}
+	else if (filter->accumulated != NULL && filter->num_accumulated <= MAX_BLOOM_KEYS)
+	{
+		uint64 num_bits = 512;
+		while (num_bits < (uint64) filter->num_accumulated * BLOOM_BITS_PER_KEY)
+		{
+			num_bits *= 2;
+		}
+
+		filter->bloom = MemoryContextAllocZero(filter->mcxt, num_bits / 8);
+		filter->bloom_bits_mask = num_bits - 1;
+
+		for (int i = 0; i < filter->num_accumulated; i++)
+		{
+			const uint64 hash = filter->is_integer ?
+									integer_hash((int64) filter->accumulated[i]) :
+									filter->accumulated[i];
+			const uint64 bit1 = hash & filter->bloom_bits_mask;
+			const uint64 bit2 = (hash >> 32) & filter->bloom_bits_mask;
+			filter->bloom[bit1 / 64] |= 1ULL << (bit1 % 64);
+			filter->bloom[bit2 / 64] |= 1ULL << (bit2 % 64);
+		}
+	}
+
+	if (filter->accumulated != NULL)
+	{
+		pfree(filter->accumulated);
+		filter->accumulated = NULL;
+		filter->accumulated_capacity = 0;
+	}
+
+	filter->complete = true;
+	filter->generation++;
+}
+
+/*
+ * Check whether the given non-null value might have a match on the inner side.
+ */
+bool
+runtime_filter_check_value(const RuntimeFilter *filter, Datum value)
+{
+	Assert(filter->complete);
+
+	if (!filter->has_values)
+	{
+		return false;
+	}
+
+	if (filter->is_integer)
+	{
+		const int64 integer = datum_get_integer(value, filter->typlen);
+		if (integer < filter->min_integer || integer > filter->max_integer)
+		{
+			return false;
+		}
+
+		if (filter->exact_keys != NULL)
+		{
+			return exact_check(filter->exact_keys,
+							   filter->exact_occupied,
+							   filter->exact_mask,
+							   integer);
+		}
+	}
+	else if (filter->cmp_finfo != NULL)
+	{
+		if (compare_values(filter, value, filter->min) < 0 ||
+			compare_values(filter, value, filter->max) > 0)
+		{
+			return false;
+		}
+	}
+
+	if (filter->bloom == NULL)
+	{
+		return true;
+	}
+
+	return bloom_check(filter->bloom, filter->bloom_bits_mask, datum_hash(filter, value));
+}
+
+/*
+ * Check whether the value range [min, max] of a compressed batch overlaps with
+ * the range of the inner join keys.
+ */
+bool
+runtime_filter_check_range(const RuntimeFilter *filter, Datum min, Datum max)
+{
+	Assert(filter->complete);
+
+	if (!filter->has_values)
+	{
+		return false;
+	}
+
+	if (filter->is_integer)
+	{
+		return datum_get_integer(max, filter->typlen) >= filter->min_integer &&
+			   datum_get_integer(min, filter->typlen) <= filter->max_integer;
+	}
+
+	if (filter->cmp_finfo == NULL)
+	{
+		return true;
+	}
+
+	return compare_values(filter, max, filter->min) >= 0 &&
+		   compare_values(filter, min, filter->max) <= 0;
+}
+
+static pg_attribute_always_inline void
+compute_vector_impl(const RuntimeFilter *filter, const ArrowArray *arrow, int value_bytes,
+					uint64 *restrict result)
+{
+	const size_t n = arrow->length;
+	const uint64 *validity = (const uint64 *) arrow->buffers[0];
+	const char *values = (const char *) arrow->buffers[1];
+	const int64 min = filter->min_integer;
+	const int64 max = filter->max_integer;
+	const uint64 *bloom = filter->bloom;
+	const uint64 mask = filter->bloom_bits_mask;
+	const int64 *exact_keys = filter->exact_keys;
+	const uint64 *exact_occupied = filter->exact_occupied;
+	const uint64 exact_mask = filter->exact_mask;
+
+	for (size_t outer = 0; outer < (n + 63) / 64; outer++)
+	{
+		if (result[outer] == 0)
+		{
+			/* The rows are already filtered out by other quals. */
+			continue;
+		}
+
+		const size_t end = Min(n, (outer + 1) * 64);
+		uint64 word = 0;
+		for (size_t row = outer * 64; row < end; row++)
+		{
+			int64 value;
+			switch (value_bytes)
+			{
+				case 2:
+					value = *(const int16 *) &values[row * 2];
+					break;
+				case 4:
+					value = *(const int32 *) &values[row * 4];
+					break;
+				default:
+					value = *(const int64 *) &values[row * 8];
+					break;
+			}
+
+			bool valid = value >= min && value <= max;
+			if (exact_keys != NULL)
+			{
+				valid = valid && exact_check(exact_keys, exact_occupied, exact_mask, value);
+			}
+			else if (bloom != NULL)
+			{
+				valid = valid && bloom_check(bloom, mask, integer_hash(value));
+			}
+			word |= ((uint64) valid) << (row % 64);
+		}
+
+		result[outer] &= word;
+		if (validity != NULL)
+		{
+			result[outer] &= validity[outer];
+		}
+	}
+}
+
+/*
+ * Compute the filter for a decompressed arrow array of an integer-like type,
+ * ANDing the result into the given bitmap. The null rows don't pass.
+ */
+void
+runtime_filter_compute_vector(const RuntimeFilter *filter, const ArrowArray *arrow,
+							  int value_bytes, uint64 *restrict result)
+{
+	Assert(filter->complete);
+	Assert(filter->is_integer);
+	Assert(value_bytes == filter->typlen);
+
+	if (!filter->has_values)
+	{
+		memset(result, 0, sizeof(uint64) * ((arrow->length + 63) / 64));
+		return;
+	}
+
+	switch (value_bytes)
+	{
+		case 2:
+			compute_vector_impl(filter, arrow, 2, result);
+			break;
+		case 4:
+			compute_vector_impl(filter, arrow, 4, result);
+			break;
+		case 8:
+			compute_vector_impl(filter, arrow, 8, result);
+			break;
+		default:
+			Ensure(false, "unexpected value size %d for runtime filter", value_bytes);
+			break;
+	}
+}
@@ -0,0 +1,418 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * Insertion of the runtime join filters into the finished plan.
+ *
+ * For a hash join that can only produce the outer rows that have a join
+ * partner, we can build a filter on the join keys from the inner side when the
+ * hash table is built, and use it to skip the outer rows that cannot have a
+ * match. When the outer side is a scan of compressed chunks, entire compressed
+ * batches can be skipped based on their segmentby values and min/max metadata,
+ * before they are decompressed.
+ *
+ * The Postgres Hash node can't be extended, so the filters are built by a
+ * separate RuntimeFilter node that is inserted between the Hash node and its
+ * input. The filters are shared with the DecompressChunk nodes through the
+ * executor parameter slots that we allocate for this purpose. These slots are
+ * not referenced by any Param expressions.
+ */
+
+#include <postgres.h>
+#include <catalog/pg_type_d.h>
+#include <nodes/extensible.h>
+#include <nodes/makefuncs.h>
+#include <nodes/nodeFuncs.h>
+#include <nodes/plannodes.h>
+#include <parser/parsetree.h>
+#include <utils/lsyscache.h>
+#include <utils/typcache.h>
+
+#include "compression/create.h"
+#include "nodes/decompress_chunk/planner.h"
+#include "nodes/runtime_filter/runtime_filter.h"
+#include "ts_catalog/compression_settings.h"
+
+static CustomScanMethods runtime_filter_build_plan_methods = {
+	.CustomName = RUNTIME_FILTER_NODE_NAME,
+	.CreateCustomScanState = runtime_filter_build_state_create,
+};
+
+void
+_runtime_filter_init(void)
+{
+	TryRegisterCustomScanMethods(&runtime_filter_build_plan_methods);
+}
+
+/*
+ * Find the compressed chunk scan under the DecompressChunk node, possibly
+ * under a Sort node.
+ */
+static Scan *
+find_compressed_scan(CustomScan *decompress_chunk)
+{
+	Plan *compressed_plan = linitial(decompress_chunk->custom_plans);
+	while (IsA(compressed_plan, Sort))
+	{
+		compressed_plan = compressed_plan->lefttree;
+	}
+
+	if (!IsA(compressed_plan, SeqScan) && !IsA(compressed_plan, IndexScan) &&
+		!IsA(compressed_plan, BitmapHeapScan))
+	{
+		return NULL;
+	}
+
+	return (Scan *) compressed_plan;
+}
+
+/*
+ * Find the position of the given compressed chunk column in the targetlist of
+ * the compressed scan. Returns InvalidAttrNumber if it is not there.
+ */
+static AttrNumber
+find_compressed_scan_resno(const List *compressed_scan_tlist, AttrNumber compressed_attno)
+{
+	if (compressed_attno == InvalidAttrNumber)
+	{
+		return InvalidAttrNumber;
+	}
+
+	ListCell *lc;
+	foreach (lc, compressed_scan_tlist)
+	{
+		TargetEntry *target_entry = lfirst_node(TargetEntry, lc);
+		if (IsA(target_entry->expr, Var) &&
+			castNode(Var, target_entry->expr)->varattno == compressed_attno)
+		{
+			return target_entry->resno;
+		}
+	}
+
+	return InvalidAttrNumber;
+}
+
+/*
+ * Attach the runtime filter with the given parameter id to the DecompressChunk
+ * node, if the given output column of this node is a chunk column of the
+ * required type.
+ */
+static bool
+attach_to_decompress_chunk(CustomScan *decompress_chunk, const List *rtable, AttrNumber attno,
+						   Oid typid, int paramid)
+{
+	List *settings = linitial(decompress_chunk->custom_private);
+	if (list_nth_int(settings, DCS_BatchSortedMerge))
+	{
+		/*
+		 * Batch sorted merge has to decompress the batches to sort them, so it
+		 * doesn't benefit from the filters much.
+		 */
+		return false;
+	}
+
+	TargetEntry *tle = get_tle_by_resno(decompress_chunk->scan.plan.targetlist, attno);
+	if (tle == NULL || !IsA(tle->expr, Var))
+	{
+		return false;
+	}
+
+	Var *var = castNode(Var, tle->expr);
+	if (var->varno == INDEX_VAR)
+	{
+		TargetEntry *scan_tle = get_tle_by_resno(decompress_chunk->custom_scan_tlist, var->varattno);
+		if (scan_tle == NULL || !IsA(scan_tle->expr, Var))
+		{
+			return false;
+		}
+		var = castNode(Var, scan_tle->expr);
+	}
+
+	if ((Index) var->varno != decompress_chunk->scan.scanrelid || var->varattno <= 0 ||
+		var->vartype != typid)
+	{
+		return false;
+	}
+
+	/*
+	 * We can use the min/max metadata of the compressed batches, if the column
+	 * has it. For collatable types, the metadata might use a different
+	 * collation, so don't bother.
+	 */
+	AttrNumber min_resno = InvalidAttrNumber;
+	AttrNumber max_resno = InvalidAttrNumber;
+	Scan *compressed_scan = find_compressed_scan(decompress_chunk);
+	if (compressed_scan != NULL && !OidIsValid(var->varcollid))
+	{
+		const Oid compressed_relid = rt_fetch(compressed_scan->scanrelid, rtable)->relid;
+		const Oid chunk_relid = rt_fetch(decompress_chunk->scan.scanrelid, rtable)->relid;
+		CompressionSettings *compression_settings = ts_compression_settings_get(chunk_relid);
+		if (compression_settings != NULL)
+		{
+			min_resno =
+				find_compressed_scan_resno(compressed_scan->plan.targetlist,
+										   compressed_column_metadata_attno(compression_settings,
+																			chunk_relid,
+																			var->varattno,
+																			compressed_relid,
+																			"min"));
+			max_resno =
+				find_compressed_scan_resno(compressed_scan->plan.targetlist,
+										   compressed_column_metadata_attno(compression_settings,
+																			chunk_relid,
+																			var->varattno,
+																			compressed_relid,
+																			"max"));
+			if (min_resno == InvalidAttrNumber || max_resno == InvalidAttrNumber)
+			{
+				min_resno = InvalidAttrNumber;
+				max_resno = InvalidAttrNumber;
+			}
+		}
+	}
+
+	List *filters = list_nth(decompress_chunk->custom_private, DCP_RuntimeFilters);
+	filters = lappend(filters, list_make4_int(paramid, var->varattno, min_resno, max_resno));
+	lfirst(list_nth_cell(decompress_chunk->custom_private, DCP_RuntimeFilters)) = filters;
+
+	return true;
+}
+
+/*
+ * Attach the runtime filter to all DecompressChunk nodes that produce the
+ * given output column of the given outer plan of the hash join, looking
+ * through the append nodes.
+ */
+static bool
+attach_runtime_filter(Plan *plan, const List *rtable, AttrNumber attno, Oid typid, int paramid)
+{
+	List *children = NIL;
+	switch (nodeTag(plan))
+	{
+		case T_Append:
+			children = castNode(Append, plan)->appendplans;
+			break;
+		case T_MergeAppend:
+			children = castNode(MergeAppend, plan)->mergeplans;
+			break;
+		case T_CustomScan:
+		{
+			CustomScan *custom = castNode(CustomScan, plan);
+			if (strcmp(custom->methods->CustomName, "DecompressChunk") == 0)
+			{
+				return attach_to_decompress_chunk(custom, rtable, attno, typid, paramid);
+			}
+
+			if (strcmp(custom->methods->CustomName, "ChunkAppend") != 0 &&
+				strcmp(custom->methods->CustomName, "ConstraintAwareAppend") != 0)
+			{
+				return false;
+			}
+
+			/*
+			 * These nodes output the tuples of their children, possibly
+			 * projected with the references to the custom scan targetlist,
+			 * which matches the targetlists of the children.
+			 */
+			TargetEntry *tle = get_tle_by_resno(plan->targetlist, attno);
+			if (tle == NULL || !IsA(tle->expr, Var) || castNode(Var, tle->expr)->varno != INDEX_VAR)
+			{
+				return false;
+			}
+			attno = castNode(Var, tle->expr)->varattno;
+			children = custom->custom_plans;
+			break;
+		}
+		default:
+			return false;
+	}
+
+	bool attached = false;
+	ListCell *lc;
+	foreach (lc, children)
+	{
+		attached |= attach_runtime_filter(lfirst(lc), rtable, attno, typid, paramid);
+	}
+	return attached;
+}
+
+/*
+ * Try to add the runtime filters on the join keys of the given hash join.
+ */
+static void
+add_hash_join_filters(PlannedStmt *stmt, HashJoin *hash_join)
+{
+	switch (hash_join->join.jointype)
+	{
+		case JOIN_INNER:
+		case JOIN_SEMI:
+		case JOIN_RIGHT:
+			/* Only the outer rows that have a match can be returned. */
+			break;
+		default:
+			return;
+	}
+
+	Hash *hash = castNode(Hash, innerPlan(hash_join));
+	if (hash_join->join.plan.parallel_aware || hash->plan.parallel_aware)
+	{
+		/*
+		 * With parallel hash, the inner side is read by all workers together,
+		 * so no single worker sees all the keys.
+		 */
+		return;
+	}
+
+	Plan *outer = outerPlan(hash_join);
+	List *paramids = NIL;
+	List *keys = NIL;
+	for (int i = 0; i < list_length(hash_join->hashkeys); i++)
+	{
+		Expr *outer_key = list_nth(hash_join->hashkeys, i);
+		Expr *inner_key = list_nth(hash->hashkeys, i);
+		if (!IsA(outer_key, Var) || castNode(Var, outer_key)->varno != OUTER_VAR)
+		{
+			continue;
+		}
+
+		const Oid typid = exprType((Node *) outer_key);
+		if (exprType((Node *) inner_key) != typid)
+		{
+			continue;
+		}
+
+		/*
+		 * The filters use the default comparison and hash functions of the
+		 * type, so they are only valid for its default equality operator.
+		 */
+		TypeCacheEntry *tce = lookup_type_cache(typid, TYPECACHE_EQ_OPR);
+		if (tce->eq_opr != list_nth_oid(hash_join->hashoperators, i))
+		{
+			continue;
+		}
+
+		const Oid collation = list_nth_oid(hash_join->hashcollations, i);
+		if (OidIsValid(collation) && !get_collation_isdeterministic(collation))
+		{
+			continue;
+		}
+
+		const int paramid = list_length(stmt->paramExecTypes);
+		if (!attach_runtime_filter(outer,
+								   stmt->rtable,
+								   castNode(Var, outer_key)->varattno,
+								   typid,
+								   paramid))
+		{
+			continue;
+		}
+
+		stmt->paramExecTypes = lappend_oid(stmt->paramExecTypes, INTERNALOID);
+		paramids = lappend_int(paramids, paramid);
+		keys = lappend(keys, inner_key);
+	}
+
+	if (paramids == NIL)
+	{
+		return;
+	}
+
+	/*
+	 * Insert the build node between the Hash node and its input. It returns
+	 * the input tuples as is, so it has the same output targetlist, and the
+	 * Hash node references don't change. The key expressions reference the
+	 * input tuples just as they do in the Hash node.
+	 */
+	Plan *child = outerPlan(hash);
+	CustomScan *build = makeNode(CustomScan);
+	build->methods = &runtime_filter_build_plan_methods;
+	build->custom_private = list_make1(paramids);
+	build->custom_exprs = keys;
+	build->scan.scanrelid = 0;
+
+	ListCell *lc;
+	foreach (lc, child->targetlist)
+	{
+		TargetEntry *child_tle = lfirst_node(TargetEntry, lc);
+		Var *var = makeVarFromTargetEntry(OUTER_VAR, child_tle);
+		build->scan.plan.targetlist =
+			lappend(build->scan.plan.targetlist,
+					makeTargetEntry((Expr *) var, child_tle->resno, NULL, child_tle->resjunk));
+	}
+
+	/*
+	 * The input is stored in the lefttree and not in the custom_plans, so that
+	 * the key expressions and the targetlist referencing it with OUTER_VAR can
+	 * be shown by EXPLAIN.
+	 */
+	build->scan.plan.lefttree = child;
+	build->scan.plan.startup_cost = child->startup_cost;
+	build->scan.plan.total_cost = child->total_cost;
+	build->scan.plan.plan_rows = child->plan_rows;
+	build->scan.plan.plan_width = child->plan_width;
+	build->scan.plan.parallel_safe = child->parallel_safe;
+	build->scan.plan.extParam = bms_copy(child->extParam);
+	build->scan.plan.allParam = bms_copy(child->allParam);
+
+	hash->plan.lefttree = &build->scan.plan;
+}
+
+static void
+insert_runtime_filters_walker(PlannedStmt *stmt, Plan *plan)
+{
+	if (plan == NULL)
+	{
+		return;
+	}
+
+	if (IsA(plan, HashJoin))
+	{
+		add_hash_join_filters(stmt, castNode(HashJoin, plan));
+	}
+
+	insert_runtime_filters_walker(stmt, plan->lefttree);
+	insert_runtime_filters_walker(stmt, plan->righttree);
+
+	List *children = NIL;
+	switch (nodeTag(plan))
+	{
+		case T_Append:
+			children = castNode(Append, plan)->appendplans;
+			break;
+		case T_MergeAppend:
+			children = castNode(MergeAppend, plan)->mergeplans;
+			break;
+		case T_CustomScan:
+			children = castNode(CustomScan, plan)->custom_plans;
+			break;
+		case T_SubqueryScan:
+			children = list_make1(castNode(SubqueryScan, plan)->subplan);
+			break;
+		default:
+			break;
+	}
+
+	ListCell *lc;
+	foreach (lc, children)
+	{
+		insert_runtime_filters_walker(stmt, lfirst(lc));
+	}
+}
+
+/*
+ * Insert the runtime filters for the hash joins in the given finished plan.
+ */
+void
+try_insert_runtime_filters(PlannedStmt *stmt)
+{
+	insert_runtime_filters_walker(stmt, stmt->planTree);
+
+	ListCell *lc;
+	foreach (lc, stmt->subplans)
+	{
+		insert_runtime_filters_walker(stmt, lfirst(lc));
+	}
+}
@@ -0,0 +1,101 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+#include <fmgr.h>
+#include <nodes/execnodes.h>
+#include <nodes/plannodes.h>
+
+#include "compression/arrow_c_data_interface.h"
+
+#define RUNTIME_FILTER_NODE_NAME "RuntimeFilter"
+
+/*
+ * Filter on a join key, built from the inner side of a hash join while the
+ * hash table is built, and used by the DecompressChunk nodes on the outer side
+ * to skip the compressed batches and rows that cannot have a join partner.
+ *
+ * The filter consists of the min/max range of the inner join keys, and either
+ * the exact set of the keys when there are few of them, or a bloom filter of
+ * their hashes. With the exact set, the DecompressChunk nodes only produce the
+ * rows that have a join partner. The filter is shared between the build node and the
+ * DecompressChunk nodes through an executor parameter slot that is allocated
+ * for it at planning time.
+ */
+typedef struct RuntimeFilter
+{
+	/*
+	 * The inner side was read to the end, so the filter is complete and can
+	 * be used for filtering.
+	 */
+	bool complete;
+
+	/*
+	 * Number of times the filter was completed. The DecompressChunk nodes use
+	 * it to tell a filter built for the current execution from one left over
+	 * from before they were rescanned.
+	 */
+	uint64 generation;
+
+	Oid typid;
+	int16 typlen;
+	bool typbyval;
+	Oid collation;
+
+	/*
+	 * For the integer-like types we use our own inline hash function and range
+	 * comparison, so that the filter can be applied to the decompressed arrow
+	 * arrays row by row. Other types use the default btree comparison and hash
+	 * functions of the type.
+	 */
+	bool is_integer;
+	FmgrInfo *cmp_finfo;
+	FmgrInfo *hash_finfo;
+
+	MemoryContext mcxt;
+
+	bool has_values;
+	Datum min;
+	Datum max;
+	int64 min_integer;
+	int64 max_integer;
+
+	/*
+	 * The inner keys accumulated before building the exact set or the bloom
+	 * filter. These are the values for the integer-like types, and the hashes
+	 * for the rest.
+	 */
+	uint64 *accumulated;
+	int num_accumulated;
+	int accumulated_capacity;
+
+	/*
+	 * The open-addressing hash set of the integer keys, NULL if there are too
+	 * many of them.
+	 */
+	int64 *exact_keys;
+	uint64 *exact_occupied;
+	uint64 exact_mask;
+
+	/* NULL if there are too many inner keys to build a useful bloom filter. */
+	uint64 *bloom;
+	uint64 bloom_bits_mask;
+} RuntimeFilter;
+
+extern RuntimeFilter *runtime_filter_get(EState *estate, int paramid);
+extern void runtime_filter_init_type(RuntimeFilter *filter, Oid typid, Oid collation);
+extern void runtime_filter_reset(RuntimeFilter *filter);
+extern void runtime_filter_add(RuntimeFilter *filter, Datum value);
+extern void runtime_filter_finish(RuntimeFilter *filter);
+extern bool runtime_filter_check_value(const RuntimeFilter *filter, Datum value);
+extern bool runtime_filter_check_range(const RuntimeFilter *filter, Datum min, Datum max);
+extern void runtime_filter_compute_vector(const RuntimeFilter *filter, const ArrowArray *arrow,
+										  int value_bytes, uint64 *restrict result);
+
+extern Node *runtime_filter_build_state_create(CustomScan *cscan);
+extern void try_insert_runtime_filters(PlannedStmt *stmt);
+extern void _runtime_filter_init(void);
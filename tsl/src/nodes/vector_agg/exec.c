@@ -8,12 +8,14 @@
 
 #include <commands/explain.h>
 #include <executor/executor.h>
+#include <executor/instrument.h>
 #include <executor/tuptable.h>
 #include <nodes/extensible.h>
 #include <nodes/makefuncs.h>
 #include <nodes/nodeFuncs.h>
 #include <nodes/pg_list.h>
 #include <optimizer/optimizer.h>
+#include <utils/lsyscache.h>
 
 #include "nodes/vector_agg/exec.h"
 
@@ -26,6 +28,8 @@
 #include "nodes/decompress_chunk/vector_quals.h"
 #include "nodes/vector_agg.h"
 #include "nodes/vector_agg/plan.h"
+#include "nodes/vector_agg/vector_expr.h"
+#include "nodes/vector_agg/vector_slot.h"
 
 static int
 get_input_offset_decompress_chunk(const DecompressChunkState *decompress_state, const Var *var)
@@ -113,6 +117,92 @@ get_column_storage_properties(const CustomScanState *state, int input_offset,
 												   result);
 }
 
+/*
+ * Prepare the checks of the vectorized quals against the compressed batch
+ * metadata. The metadata columns are given by the planner for each vectorized
+ * qual of the DecompressChunk node, and the constants are taken from the
+ * constified quals, so this has to be done after the DecompressChunk node is
+ * initialized.
+ */
+static void
+init_metadata_quals(VectorAggState *vector_agg_state, DecompressChunkState *decompress_state,
+					List *metadata_qual_columns)
+{
+	const DecompressContext *dcontext = &decompress_state->decompress_context;
+	List *quals = dcontext->vectorized_quals_constified;
+	const int nquals = list_length(quals);
+	Assert(list_length(metadata_qual_columns) == 2 * nquals);
+
+	vector_agg_state->use_batch_metadata = true;
+	vector_agg_state->num_metadata_quals = nquals;
+	vector_agg_state->metadata_quals =
+		palloc0(sizeof(*vector_agg_state->metadata_quals) * Max(nquals, 1));
+
+	for (int i = 0; i < nquals; i++)
+	{
+		VectorAggMetadataQual *mq = &vector_agg_state->metadata_quals[i];
+		OpExpr *opexpr = list_nth_node(OpExpr, quals, i);
+
+		mq->min_attno = list_nth_int(metadata_qual_columns, 2 * i);
+		mq->max_attno = list_nth_int(metadata_qual_columns, 2 * i + 1);
+
+		Node *arg2 = lsecond(opexpr->args);
+		if (!IsA(arg2, Const) || castNode(Const, arg2)->constisnull)
+		{
+			/*
+			 * Not a runtime constant or a null constant, so we can't say that
+			 * all rows pass. Such batches go the normal way.
+			 */
+			mq->unusable = true;
+			continue;
+		}
+
+		mq->constvalue = castNode(Const, arg2)->constvalue;
+		fmgr_info(get_opcode(opexpr->opno), &mq->opfunc);
+	}
+}
+
+/*
+ * Check whether the metadata of the compressed batch shows that all its rows
+ * pass the vectorized quals.
+ */
+static bool
+metadata_quals_pass_all(VectorAggState *vector_agg_state, TupleTableSlot *compressed_slot)
+{
+	const int nquals = vector_agg_state->num_metadata_quals;
+	for (int i = 0; i < nquals; i++)
+	{
+		VectorAggMetadataQual *mq = &vector_agg_state->metadata_quals[i];
+		if (mq->unusable)
+		{
+			return false;
+		}
+
+		const AttrNumber attnos[] = { mq->min_attno, mq->max_attno };
+		for (size_t j = 0; j < lengthof(attnos); j++)
+		{
+			if (attnos[j] == InvalidAttrNumber)
+			{
+				continue;
+			}
+
+			bool isnull;
+			Datum value = slot_getattr(compressed_slot, attnos[j], &isnull);
+			if (isnull)
+			{
+				return false;
+			}
+
+			if (!DatumGetBool(FunctionCall2(&mq->opfunc, value, mq->constvalue)))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
 static void
 vector_agg_begin(CustomScanState *node, EState *estate, int eflags)
 {
@@ -148,6 +238,7 @@ vector_agg_begin(CustomScanState *node, EState *estate, int eflags)
 	 */
 	List *aggregated_tlist =
 		castNode(CustomScan, vector_agg_state->custom.ss.ps.plan)->custom_scan_tlist;
+	List *metadata_agg_columns = list_nth(cscan->custom_private, VASI_MetadataAggColumns);
 	const int tlist_length = list_length(aggregated_tlist);
 
 	/*
@@ -199,19 +290,44 @@ vector_agg_begin(CustomScanState *node, EState *estate, int eflags)
 
 			Aggref *aggref = castNode(Aggref, tlentry->expr);
 
-			VectorAggFunctions *func = get_vector_aggregate(aggref->aggfnoid);
+			const Oid argtype =
+				aggref->aggargtypes != NIL ? linitial_oid(aggref->aggargtypes) : InvalidOid;
+			VectorAggFunctions *func = get_vector_aggregate(aggref->aggfnoid, argtype);
 			Assert(func != NULL);
 			def->func = *func;
 
 			if (list_length(aggref->args) > 0)
 			{
-				Assert(list_length(aggref->args) == 1);
-
 				/* The aggregate should be a partial aggregate */
 				Assert(aggref->aggsplit == AGGSPLIT_INITIAL_SERIAL);
 
-				Var *var = castNode(Var, castNode(TargetEntry, linitial(aggref->args))->expr);
-				def->input_offset = get_input_offset(childstate, var);
+				Expr *argument = castNode(TargetEntry, linitial(aggref->args))->expr;
+				if (IsA(argument, Var))
+				{
+					def->input_offset = get_input_offset(childstate, castNode(Var, argument));
+				}
+				else
+				{
+					/*
+					 * An arithmetic expression over the columns, it is
+					 * computed for each batch before aggregating it.
+					 */
+					def->input_offset = -1;
+					def->argument_expr = argument;
+				}
+
+				/* The planner has checked that the other arguments are constants. */
+				const int num_const_args = list_length(aggref->args) - 1;
+				if (num_const_args > 0)
+				{
+					Assert(func->agg_init_args != NULL);
+					def->const_args = palloc(sizeof(Datum) * num_const_args);
+					for (int j = 0; j < num_const_args; j++)
+					{
+						TargetEntry *arg = list_nth_node(TargetEntry, aggref->args, j + 1);
+						def->const_args[j] = castNode(Const, arg->expr)->constvalue;
+					}
+				}
 			}
 			else
 			{
@@ -223,6 +339,11 @@ vector_agg_begin(CustomScanState *node, EState *estate, int eflags)
 				Node *constified = estimate_expression_value(&root, (Node *) aggref->aggfilter);
 				def->filter_clauses = list_make1(constified);
 			}
+
+			if (metadata_agg_columns != NIL)
+			{
+				def->metadata_attno = list_nth_int(metadata_agg_columns, i);
+			}
 		}
 		else
 		{
@@ -238,6 +359,13 @@ vector_agg_begin(CustomScanState *node, EState *estate, int eflags)
 		}
 	}
 
+	if (metadata_agg_columns != NIL)
+	{
+		init_metadata_quals(vector_agg_state,
+							(DecompressChunkState *) childstate,
+							list_nth(cscan->custom_private, VASI_MetadataQualColumns));
+	}
+
 	/*
 	 * Create the grouping policy chosen at plan time.
 	 */
@@ -307,6 +435,18 @@ compressed_batch_get_next_slot(VectorAggState *vector_agg_state)
 	BatchQueue *batch_queue = decompress_state->batch_queue;
 	DecompressBatchState *batch_state = batch_array_get_at(&batch_queue->batch_array, 0);
 
+	/*
+	 * The DecompressChunk node is not run through ExecProcNode() here, so we
+	 * have to maintain its instrumentation ourselves.
+	 */
+	Instrumentation *instrument = dcontext->ps->instrument;
+	if (instrument)
+	{
+		InstrStartNode(instrument);
+	}
+
+	vector_agg_state->metadata_compressed_slot = NULL;
+
 	do
 	{
 		/*
@@ -324,9 +464,35 @@ compressed_batch_get_next_slot(VectorAggState *vector_agg_state)
 		if (TupIsNull(compressed_slot))
 		{
 			vector_agg_state->input_ended = true;
+
+			if (instrument)
+			{
+				InstrStopNode(instrument, 0);
+			}
+
 			return NULL;
 		}
 
+		if (vector_agg_state->use_batch_metadata &&
+			metadata_quals_pass_all(vector_agg_state, compressed_slot))
+		{
+			/*
+			 * All rows of this batch pass the quals, so the aggregate functions
+			 * can be computed from the batch metadata, and we don't have to
+			 * decompress it.
+			 */
+			compressed_batch_read_scalars(dcontext, batch_state, compressed_slot);
+			vector_agg_state->metadata_compressed_slot = compressed_slot;
+			vector_agg_state->metadata_batches++;
+
+			if (instrument)
+			{
+				InstrStopNode(instrument, batch_state->total_batch_rows);
+			}
+
+			return &batch_state->decompressed_scan_slot_data.base;
+		}
+
 		compressed_batch_set_compressed_tuple(dcontext, batch_state, compressed_slot);
 
 		/* If the entire batch is filtered out, then immediately read the next
@@ -344,14 +510,9 @@ compressed_batch_get_next_slot(VectorAggState *vector_agg_state)
 	const int not_filtered_rows =
 		arrow_num_valid(batch_state->vector_qual_result, batch_state->total_batch_rows);
 	InstrCountFiltered1(dcontext->ps, batch_state->total_batch_rows - not_filtered_rows);
-	if (dcontext->ps->instrument)
+	if (instrument)
 	{
-		/*
-		 * These values are normally updated by InstrStopNode(), and are
-		 * required so that the calculations in InstrEndLoop() run properly.
-		 */
-		dcontext->ps->instrument->running = true;
-		dcontext->ps->instrument->tuplecount += not_filtered_rows;
+		InstrStopNode(instrument, not_filtered_rows);
 	}
 
 	return &batch_state->decompressed_scan_slot_data.base;
@@ -441,6 +602,38 @@ arrow_init_vector_quals(VectorAggState *agg_state, VectorAggDef *agg_def, TupleT
 	return &agg_state->vqual_state.vqstate;
 }
 
+/*
+ * Compute the aggregate function argument expression for the given batch. The
+ * temporary arrays are allocated in the per-batch memory context of the vector
+ * slot.
+ */
+static void
+compute_argument_expression(VectorAggState *vector_agg_state, VectorAggDef *agg_def,
+							TupleTableSlot *slot)
+{
+	VectorQualState *vqstate = vector_agg_state->init_vector_quals(vector_agg_state, agg_def, slot);
+	MemoryContext old_context = MemoryContextSwitchTo(vqstate->per_vector_mcxt);
+
+	uint16 total_batch_rows = 0;
+	const uint64 *vector_qual_result = vector_slot_get_qual_result(slot, &total_batch_rows);
+	const size_t num_words = (total_batch_rows + 63) / 64;
+	const uint64 *rows = arrow_combine_validity(num_words,
+												palloc(sizeof(uint64) * num_words),
+												vector_qual_result,
+												agg_def->filter_result,
+												NULL);
+
+	const ArrowArray *arrow = vector_expr_compute(vqstate, agg_def->argument_expr, rows);
+
+	MemoryContextSwitchTo(old_context);
+
+	agg_def->argument_values = (CompressedColumnValues){
+		.decompression_type = get_typlen(exprType((Node *) agg_def->argument_expr)),
+		.buffers = { arrow->buffers[0], arrow->buffers[1] },
+		.arrow = (ArrowArray *) arrow,
+	};
+}
+
 static TupleTableSlot *
 vector_agg_exec(CustomScanState *node)
 {
@@ -502,6 +695,18 @@ vector_agg_exec(CustomScanState *node)
 		if (vector_agg_state->input_ended)
 			break;
 
+		if (vector_agg_state->metadata_compressed_slot != NULL)
+		{
+			/*
+			 * This batch is aggregated from its metadata. There are no FILTER
+			 * clauses in this case, the planner checks this.
+			 */
+			grouping->gp_add_batch_metadata(grouping,
+											slot,
+											vector_agg_state->metadata_compressed_slot);
+			continue;
+		}
+
 		/*
 		 * Compute the vectorized filters for the aggregate function FILTER
 		 * clauses.
@@ -521,6 +726,22 @@ vector_agg_exec(CustomScanState *node)
 			agg_def->filter_result = vqstate->vector_qual_result;
 		}
 
+		/*
+		 * Compute the aggregate function arguments that are expressions over
+		 * the columns. This has to be done after the FILTER clauses, because
+		 * the arguments are computed only for the rows that are aggregated.
+		 */
+		for (int i = 0; i < naggs; i++)
+		{
+			VectorAggDef *agg_def = &vector_agg_state->agg_defs[i];
+			if (agg_def->argument_expr == NULL)
+			{
+				continue;
+			}
+
+			compute_argument_expression(vector_agg_state, agg_def, slot);
+		}
+
 		/*
 		 * Finally, pass the compressed batch to the grouping policy.
 		 */
@@ -566,6 +787,14 @@ vector_agg_explain(CustomScanState *node, List *ancestors, ExplainState *es)
 	{
 		ExplainPropertyText("Grouping Policy", state->grouping->gp_explain(state->grouping), es);
 	}
+
+	if (es->analyze && state->use_batch_metadata)
+	{
+		ExplainPropertyInteger("Batches Aggregated from Metadata",
+							   NULL,
+							   state->metadata_batches,
+							   es);
+	}
 }
 
 static struct CustomExecMethods exec_methods = {
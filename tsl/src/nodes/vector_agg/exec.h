@@ -19,10 +19,48 @@ typedef struct VectorAggDef
 	VectorAggFunctions func;
 	int input_offset;
 	int output_offset;
+
+	/*
+	 * The values of the constant arguments that follow the aggregated column,
+	 * or NULL if the function has only one argument.
+	 */
+	Datum *const_args;
+
+	/*
+	 * The argument expression, when the aggregate function argument is an
+	 * arithmetic expression over the columns and not a bare column. It is
+	 * computed for each batch, and the result is stored in argument_values.
+	 */
+	Expr *argument_expr;
+	CompressedColumnValues argument_values;
+
 	List *filter_clauses;
 	uint64 *filter_result;
+
+	/*
+	 * When aggregating a compressed batch from its metadata, the compressed
+	 * scan attribute number of the metadata column that is the aggregate
+	 * result for this batch. Invalid if the aggregate is computed from the
+	 * batch row count and segmentby values instead.
+	 */
+	AttrNumber metadata_attno;
 } VectorAggDef;
 
+/*
+ * A vectorized qual that can be checked using the compressed batch metadata,
+ * to determine that all the rows of the batch pass it.
+ */
+typedef struct VectorAggMetadataQual
+{
+	AttrNumber min_attno;
+	AttrNumber max_attno;
+	FmgrInfo opfunc;
+	Datum constvalue;
+
+	/* The constant is not known or is null, can't check the metadata. */
+	bool unusable;
+} VectorAggMetadataQual;
+
 typedef struct GroupingColumn
 {
 	int input_offset;
@@ -51,6 +89,19 @@ typedef struct VectorAggState
 
 	GroupingPolicy *grouping;
 
+	/*
+	 * Whether we can aggregate some compressed batches from their metadata
+	 * without decompressing them, the quals we have to check for this, and
+	 * the compressed tuple of the current batch if it is aggregated this way.
+	 */
+	bool use_batch_metadata;
+	int num_metadata_quals;
+	VectorAggMetadataQual *metadata_quals;
+	TupleTableSlot *metadata_compressed_slot;
+
+	/* The number of batches aggregated from their metadata, for EXPLAIN. */
+	int64 metadata_batches;
+
 	/*
 	 * State to compute vector quals for FILTER clauses.
 	 */
@@ -0,0 +1,295 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * Vectorized implementation of the approx_count_distinct(anyelement) aggregate
+ * function for the fixed-width by-value types and text. The values are hashed
+ * the same way as in the row-by-row transition function, and the partial result
+ * has the serialized format of _timescaledb_functions.hll_serializefunc(), so
+ * that it can be combined and finalized by the regular aggregate functions.
+ */
+
+#include <postgres.h>
+
+#include <catalog/pg_type_d.h>
+#include <utils/lsyscache.h>
+
+#include "functions.h"
+#include "hyperloglog.h"
+
+typedef struct
+{
+	/* The HLL_REGISTERS registers, allocated on the first aggregated value. */
+	uint8 *registers;
+} ApproxCountDistinctState;
+
+static void
+approx_count_distinct_init(void *restrict agg_states, int n)
+{
+	ApproxCountDistinctState *states = (ApproxCountDistinctState *) agg_states;
+	for (int i = 0; i < n; i++)
+	{
+		states[i].registers = NULL;
+	}
+}
+
+static uint8 *
+approx_count_distinct_get_registers(ApproxCountDistinctState *state, MemoryContext agg_extra_mctx)
+{
+	if (likely(state->registers != NULL))
+	{
+		return state->registers;
+	}
+
+	state->registers = MemoryContextAllocZero(agg_extra_mctx, HLL_REGISTERS);
+	return state->registers;
+}
+
+static void
+approx_count_distinct_emit(void *agg_state, Datum *out_result, bool *out_isnull)
+{
+	ApproxCountDistinctState *state = (ApproxCountDistinctState *) agg_state;
+
+	if (state->registers == NULL)
+	{
+		*out_result = (Datum) 0;
+		*out_isnull = true;
+		return;
+	}
+
+	*out_result = PointerGetDatum(hll_serialize(state->registers));
+	*out_isnull = false;
+}
+
+/*
+ * The hash of the given row of an Arrow array. The text arrays are either
+ * plain, with the offsets and the bodies, or dictionary-encoded with the int16
+ * indexes into the dictionary.
+ */
+static pg_attribute_always_inline uint64
+hash_text_value(const ArrowArray *text_array, int index)
+{
+	const uint32 *offsets = (const uint32 *) text_array->buffers[1];
+	const uint8 *bodies = (const uint8 *) text_array->buffers[2];
+	return hll_hash_bytes(&bodies[offsets[index]], offsets[index + 1] - offsets[index]);
+}
+
+static pg_attribute_always_inline uint64
+hash_fixed_value(const ArrowArray *vector, int row, int value_bytes)
+{
+	const uint8 *values = (const uint8 *) vector->buffers[1];
+	return hll_hash_bytes(&values[(size_t) row * value_bytes], value_bytes);
+}
+
+/*
+ * Hash the dictionary entries once, so that the rows only have to look up the
+ * hash of their entry.
+ */
+static uint64 *
+hash_dictionary(const ArrowArray *dictionary)
+{
+	uint64 *hashes = palloc(sizeof(uint64) * dictionary->length);
+	for (int i = 0; i < dictionary->length; i++)
+	{
+		hashes[i] = hash_text_value(dictionary, i);
+	}
+	return hashes;
+}
+
+static pg_attribute_always_inline void
+approx_count_distinct_vector_impl(void *agg_state, const ArrowArray *vector, const uint64 *filter,
+								  MemoryContext agg_extra_mctx, int value_bytes)
+{
+	ApproxCountDistinctState *state = (ApproxCountDistinctState *) agg_state;
+	const int n = vector->length;
+	uint64 *dictionary_hashes = NULL;
+	uint8 *registers = NULL;
+
+	if (value_bytes < 0 && vector->dictionary != NULL)
+	{
+		dictionary_hashes = hash_dictionary(vector->dictionary);
+	}
+
+	for (int row = 0; row < n; row++)
+	{
+		if (!arrow_row_is_valid(filter, row))
+		{
+			continue;
+		}
+
+		if (unlikely(registers == NULL))
+		{
+			registers = approx_count_distinct_get_registers(state, agg_extra_mctx);
+		}
+
+		uint64 hash;
+		if (value_bytes > 0)
+		{
+			hash = hash_fixed_value(vector, row, value_bytes);
+		}
+		else if (dictionary_hashes != NULL)
+		{
+			hash = dictionary_hashes[((const int16 *) vector->buffers[1])[row]];
+		}
+		else
+		{
+			hash = hash_text_value(vector, row);
+		}
+
+		hll_add_hash(registers, hash);
+	}
+
+	if (dictionary_hashes != NULL)
+	{
+		pfree(dictionary_hashes);
+	}
+}
+
+static pg_attribute_always_inline void
+approx_count_distinct_many_vector_impl(void *restrict agg_states, const uint32 *offsets,
+									   const uint64 *filter, int start_row, int end_row,
+									   const ArrowArray *vector, MemoryContext agg_extra_mctx,
+									   int value_bytes)
+{
+	ApproxCountDistinctState *states = (ApproxCountDistinctState *) agg_states;
+
+	for (int row = start_row; row < end_row; row++)
+	{
+		if (!arrow_row_is_valid(filter, row))
+		{
+			continue;
+		}
+
+		uint64 hash;
+		if (value_bytes > 0)
+		{
+			hash = hash_fixed_value(vector, row, value_bytes);
+		}
+		else if (vector->dictionary != NULL)
+		{
+			const int16 index = ((const int16 *) vector->buffers[1])[row];
+			hash = hash_text_value(vector->dictionary, index);
+		}
+		else
+		{
+			hash = hash_text_value(vector, row);
+		}
+
+		ApproxCountDistinctState *state = &states[offsets[row]];
+		hll_add_hash(approx_count_distinct_get_registers(state, agg_extra_mctx), hash);
+	}
+}
+
+/*
+ * The scalar values are the same for all rows, so they are added once.
+ */
+static pg_attribute_always_inline void
+approx_count_distinct_scalar_impl(void *agg_state, Datum constvalue, bool constisnull,
+								  MemoryContext agg_extra_mctx, int value_bytes)
+{
+	if (constisnull)
+	{
+		return;
+	}
+
+	ApproxCountDistinctState *state = (ApproxCountDistinctState *) agg_state;
+	const uint64 hash = value_bytes > 0 ? hll_hash_datum(constvalue, value_bytes, true) :
+										  hll_hash_datum(constvalue, -1, false);
+	hll_add_hash(approx_count_distinct_get_registers(state, agg_extra_mctx), hash);
+}
+
+/*
+ * Generate the functions for the given width of the values in bytes, or -1 for
+ * text.
+ */
+#define APPROX_COUNT_DISTINCT_FUNCTIONS(NAME, VALUE_BYTES)                                         \
+	static void approx_count_distinct_vector_##NAME(void *agg_state,                               \
+													const ArrowArray *vector,                      \
+													const uint64 *filter,                          \
+													MemoryContext agg_extra_mctx)                  \
+	{                                                                                              \
+		approx_count_distinct_vector_impl(agg_state, vector, filter, agg_extra_mctx, VALUE_BYTES); \
+	}                                                                                              \
+                                                                                                   \
+	static void approx_count_distinct_many_vector_##NAME(void *restrict agg_states,                \
+														 const uint32 *offsets,                    \
+														 const uint64 *filter,                     \
+														 int start_row,                            \
+														 int end_row,                              \
+														 const ArrowArray *vector,                 \
+														 MemoryContext agg_extra_mctx)             \
+	{                                                                                              \
+		approx_count_distinct_many_vector_impl(agg_states,                                         \
+											   offsets,                                            \
+											   filter,                                             \
+											   start_row,                                          \
+											   end_row,                                            \
+											   vector,                                             \
+											   agg_extra_mctx,                                     \
+											   VALUE_BYTES);                                       \
+	}                                                                                              \
+                                                                                                   \
+	static void approx_count_distinct_scalar_##NAME(void *agg_state,                               \
+													Datum constvalue,                              \
+													bool constisnull,                              \
+													int n,                                         \
+													MemoryContext agg_extra_mctx)                  \
+	{                                                                                              \
+		approx_count_distinct_scalar_impl(agg_state,                                               \
+										  constvalue,                                              \
+										  constisnull,                                             \
+										  agg_extra_mctx,                                          \
+										  VALUE_BYTES);                                            \
+	}                                                                                              \
+                                                                                                   \
+	static VectorAggFunctions approx_count_distinct_##NAME##_agg = {                               \
+		.state_bytes = sizeof(ApproxCountDistinctState),                                           \
+		.agg_init = approx_count_distinct_init,                                                    \
+		.agg_vector = approx_count_distinct_vector_##NAME,                                         \
+		.agg_scalar = approx_count_distinct_scalar_##NAME,                                         \
+		.agg_many_vector = approx_count_distinct_many_vector_##NAME,                               \
+		.agg_emit = approx_count_distinct_emit,                                                    \
+	};
+
+APPROX_COUNT_DISTINCT_FUNCTIONS(2, 2)
+APPROX_COUNT_DISTINCT_FUNCTIONS(4, 4)
+APPROX_COUNT_DISTINCT_FUNCTIONS(8, 8)
+APPROX_COUNT_DISTINCT_FUNCTIONS(text, -1)
+
+/*
+ * Return the implementation for the given argument type. The arguments of the
+ * by-value types are the Arrow arrays with the values of the same width, and
+ * the text arguments are the plain or dictionary-encoded Arrow arrays.
+ */
+VectorAggFunctions *
+get_approx_count_distinct_agg(Oid argtype)
+{
+	int16 typlen;
+	bool typbyval;
+
+	if (argtype == TEXTOID)
+	{
+		return &approx_count_distinct_text_agg;
+	}
+
+	get_typlenbyval(argtype, &typlen, &typbyval);
+	if (!typbyval)
+	{
+		return NULL;
+	}
+
+	switch (typlen)
+	{
+		case 2:
+			return &approx_count_distinct_2_agg;
+		case 4:
+			return &approx_count_distinct_4_agg;
+		case 8:
+			return &approx_count_distinct_8_agg;
+		default:
+			return NULL;
+	}
+}
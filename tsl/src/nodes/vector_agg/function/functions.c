@@ -17,6 +17,7 @@
 #include "functions.h"
 
 #include "compat/compat.h"
+#include "func_cache.h"
 
 /*
  * Aggregate function count(*).
@@ -193,12 +194,48 @@ VectorAggFunctions count_any_agg = {
 	.agg_many_vector = count_any_many_vector,
 };
 
+extern VectorAggFunctions histogram_agg;
+extern VectorAggFunctions percentile_sketch_agg;
+
+/*
+ * Return the vectorized implementation of an aggregate function provided by
+ * the extension.
+ */
+static VectorAggFunctions *
+get_extension_vector_aggregate(Oid aggfnoid, Oid argtype)
+{
+	FuncInfo *finfo = ts_func_cache_get(aggfnoid);
+
+	if (finfo == NULL || finfo->origin != ORIGIN_TIMESCALE)
+	{
+		return NULL;
+	}
+
+	if (strcmp(finfo->funcname, "histogram") == 0)
+	{
+		return &histogram_agg;
+	}
+
+	if (strcmp(finfo->funcname, "approx_count_distinct") == 0)
+	{
+		return get_approx_count_distinct_agg(argtype);
+	}
+
+	if (strcmp(finfo->funcname, "percentile_sketch") == 0)
+	{
+		return &percentile_sketch_agg;
+	}
+
+	return NULL;
+}
+
 /*
  * Return the vector aggregate definition corresponding to the given
- * PG aggregate function Oid.
+ * PG aggregate function Oid and the type of its first argument, which is
+ * needed for the polymorphic functions.
  */
 VectorAggFunctions *
-get_vector_aggregate(Oid aggfnoid)
+get_vector_aggregate(Oid aggfnoid, Oid argtype)
 {
 	switch (aggfnoid)
 	{
@@ -215,6 +252,6 @@ get_vector_aggregate(Oid aggfnoid)
 #include "sum_float_templates.c"
 #undef GENERATE_DISPATCH_TABLE
 		default:
-			return NULL;
+			return get_extension_vector_aggregate(aggfnoid, argtype);
 	}
 }
@@ -23,12 +23,27 @@ typedef struct
 	/* Size of the aggregate function state. */
 	size_t state_bytes;
 
+	/*
+	 * The function aggregates the null values of the argument as well, like
+	 * histogram() does, instead of skipping them. The filter passed to the
+	 * function then doesn't include the validity of the argument, and the
+	 * function has to check it itself.
+	 */
+	bool aggregates_nulls;
+
 	/*
 	 * Initialize the n aggregate function states stored contiguously at the
 	 * given pointer.
 	 */
 	void (*agg_init)(void *restrict agg_states, int n);
 
+	/*
+	 * Set the constant arguments of the aggregate function that follow the
+	 * aggregated column, like the bounds of histogram(), in the n initialized
+	 * states. Can be NULL for the functions with one argument.
+	 */
+	void (*agg_init_args)(void *restrict agg_states, int n, const Datum *args);
+
 	/* Aggregate a given arrow array. */
 	void (*agg_vector)(void *restrict agg_state, const ArrowArray *vector, const uint64 *filter,
 					   MemoryContext agg_extra_mctx);
@@ -57,4 +72,5 @@ typedef struct
 	void (*agg_emit)(void *restrict agg_state, Datum *out_result, bool *out_isnull);
 } VectorAggFunctions;
 
-VectorAggFunctions *get_vector_aggregate(Oid aggfnoid);
+VectorAggFunctions *get_vector_aggregate(Oid aggfnoid, Oid argtype);
+VectorAggFunctions *get_approx_count_distinct_agg(Oid argtype);
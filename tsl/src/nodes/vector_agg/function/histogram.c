@@ -0,0 +1,262 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * Vectorized implementation of the histogram(float8, float8, float8, int4)
+ * aggregate function. The bounds and the number of buckets are constant
+ * arguments, and the partial result has the same serialized format as
+ * _timescaledb_functions.hist_serializefunc(), so that it can be combined
+ * and finalized by the regular aggregate functions.
+ *
+ * The row-based histogram() reads the null values as 0.0 and counts them in
+ * the respective bucket, so we do the same here.
+ */
+
+#include <postgres.h>
+
+#include <math.h>
+
+#include <common/int.h>
+#include <libpq/pqformat.h>
+#include <utils/fmgrprotos.h>
+
+#include "functions.h"
+
+typedef struct
+{
+	float8 min;
+	float8 max;
+	int32 nbuckets;
+
+	/*
+	 * The counts of the nbuckets + 2 buckets, including the ones below and
+	 * above the range. Allocated on the first aggregated value.
+	 */
+	int64 *counts;
+} HistogramState;
+
+static void
+histogram_init(void *restrict agg_states, int n)
+{
+	HistogramState *states = (HistogramState *) agg_states;
+	for (int i = 0; i < n; i++)
+	{
+		states[i].min = 0;
+		states[i].max = 0;
+		states[i].nbuckets = 0;
+		states[i].counts = NULL;
+	}
+}
+
+static void
+histogram_init_args(void *restrict agg_states, int n, const Datum *args)
+{
+	HistogramState *states = (HistogramState *) agg_states;
+	for (int i = 0; i < n; i++)
+	{
+		states[i].min = DatumGetFloat8(args[0]);
+		states[i].max = DatumGetFloat8(args[1]);
+		states[i].nbuckets = DatumGetInt32(args[2]);
+	}
+}
+
+static int64 *
+histogram_get_counts(HistogramState *state, MemoryContext agg_extra_mctx)
+{
+	if (likely(state->counts != NULL))
+	{
+		return state->counts;
+	}
+
+	if (state->min > state->max)
+	{
+		elog(ERROR, "lower bound cannot exceed upper bound");
+	}
+
+	state->counts =
+		MemoryContextAllocZero(agg_extra_mctx, sizeof(int64) * ((Size) state->nbuckets + 2));
+	return state->counts;
+}
+
+/*
+ * Whether the bucket can be computed inline. Otherwise, width_bucket_float8()
+ * is called, which reports the errors for the invalid arguments.
+ */
+static inline bool
+histogram_has_simple_bounds(const HistogramState *state)
+{
+	return state->min < state->max && isfinite(state->max - state->min) && state->nbuckets > 0 &&
+		   state->nbuckets < PG_INT32_MAX;
+}
+
+static pg_noinline int32
+histogram_bucket_slow(const HistogramState *state, float8 value)
+{
+	int32 bucket = DatumGetInt32(DirectFunctionCall4(width_bucket_float8,
+													 Float8GetDatum(value),
+													 Float8GetDatum(state->min),
+													 Float8GetDatum(state->max),
+													 Int32GetDatum(state->nbuckets)));
+
+	if (bucket < 0 || bucket > (int64) state->nbuckets + 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("index %d from \"width_bucket\" out of range", bucket),
+				 errhint("You probably have a floating point overflow.")));
+
+	return bucket;
+}
+
+/*
+ * Same as width_bucket_float8() for the simple bounds. The rare values where
+ * the quotient rounds up to 1.0 are passed to width_bucket_float8(), whose
+ * handling of them differs between the PostgreSQL versions.
+ */
+static pg_attribute_always_inline int32
+histogram_bucket(const HistogramState *state, bool simple_bounds, float8 value)
+{
+	if (unlikely(!simple_bounds || isnan(value)))
+	{
+		return histogram_bucket_slow(state, value);
+	}
+
+	if (value < state->min)
+	{
+		return 0;
+	}
+
+	if (value >= state->max)
+	{
+		return state->nbuckets + 1;
+	}
+
+	const int32 bucket = state->nbuckets * ((value - state->min) / (state->max - state->min));
+	if (unlikely(bucket >= state->nbuckets))
+	{
+		return histogram_bucket_slow(state, value);
+	}
+
+	return bucket + 1;
+}
+
+static void
+histogram_vector(void *agg_state, const ArrowArray *vector, const uint64 *filter,
+				 MemoryContext agg_extra_mctx)
+{
+	HistogramState *state = (HistogramState *) agg_state;
+	const bool simple_bounds = histogram_has_simple_bounds(state);
+	const uint64 *validity = vector->buffers[0];
+	const float8 *values = vector->buffers[1];
+	const int n = vector->length;
+	int64 *counts = NULL;
+
+	for (int row = 0; row < n; row++)
+	{
+		if (!arrow_row_is_valid(filter, row))
+		{
+			continue;
+		}
+
+		if (unlikely(counts == NULL))
+		{
+			counts = histogram_get_counts(state, agg_extra_mctx);
+		}
+
+		const float8 value = arrow_row_is_valid(validity, row) ? values[row] : 0.0;
+		counts[histogram_bucket(state, simple_bounds, value)]++;
+	}
+}
+
+static void
+histogram_scalar(void *agg_state, Datum constvalue, bool constisnull, int n,
+				 MemoryContext agg_extra_mctx)
+{
+	HistogramState *state = (HistogramState *) agg_state;
+	const float8 value = constisnull ? 0.0 : DatumGetFloat8(constvalue);
+	int64 *counts = histogram_get_counts(state, agg_extra_mctx);
+	counts[histogram_bucket(state, histogram_has_simple_bounds(state), value)] += n;
+}
+
+static void
+histogram_many_vector(void *restrict agg_states, const uint32 *offsets, const uint64 *filter,
+					  int start_row, int end_row, const ArrowArray *vector,
+					  MemoryContext agg_extra_mctx)
+{
+	HistogramState *states = (HistogramState *) agg_states;
+	const uint64 *validity = vector->buffers[0];
+	const float8 *values = vector->buffers[1];
+
+	/*
+	 * The offsets are only set for the rows that pass the filter, so look up
+	 * the bounds in the state of the first such row. The arguments are the
+	 * same constants for all the states.
+	 */
+	int row = start_row;
+	while (row < end_row && !arrow_row_is_valid(filter, row))
+	{
+		row++;
+	}
+
+	if (row == end_row)
+	{
+		return;
+	}
+
+	const bool simple_bounds = histogram_has_simple_bounds(&states[offsets[row]]);
+
+	for (; row < end_row; row++)
+	{
+		if (!arrow_row_is_valid(filter, row))
+		{
+			continue;
+		}
+
+		HistogramState *state = &states[offsets[row]];
+		const float8 value = arrow_row_is_valid(validity, row) ? values[row] : 0.0;
+		int64 *counts = histogram_get_counts(state, agg_extra_mctx);
+		counts[histogram_bucket(state, simple_bounds, value)]++;
+	}
+}
+
+static void
+histogram_emit(void *agg_state, Datum *out_result, bool *out_isnull)
+{
+	HistogramState *state = (HistogramState *) agg_state;
+
+	if (state->counts == NULL)
+	{
+		*out_result = (Datum) 0;
+		*out_isnull = true;
+		return;
+	}
+
+	const int32 nbuckets = state->nbuckets + 2;
+	StringInfoData buf;
+	pq_begintypsend(&buf);
+	pq_sendint32(&buf, nbuckets);
+
+	for (int32 i = 0; i < nbuckets; i++)
+	{
+		if (state->counts[i] >= PG_INT32_MAX)
+			elog(ERROR, "overflow in histogram");
+
+		pq_sendint32(&buf, (int32) state->counts[i]);
+	}
+
+	*out_result = PointerGetDatum(pq_endtypsend(&buf));
+	*out_isnull = false;
+}
+
+VectorAggFunctions histogram_agg = {
+	.state_bytes = sizeof(HistogramState),
+	.aggregates_nulls = true,
+	.agg_init = histogram_init,
+	.agg_init_args = histogram_init_args,
+	.agg_vector = histogram_vector,
+	.agg_scalar = histogram_scalar,
+	.agg_many_vector = histogram_many_vector,
+	.agg_emit = histogram_emit,
+};
@@ -0,0 +1,94 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * Vectorized implementation of the percentile_sketch(float8) aggregate
+ * function. The partial result has the serialized format of
+ * _timescaledb_functions.ddsketch_serializefunc(), so that it can be combined
+ * and finalized by the regular aggregate functions.
+ */
+
+#include <postgres.h>
+
+#include "ddsketch.h"
+#include "functions.h"
+
+static void
+percentile_sketch_init(void *restrict agg_states, int n)
+{
+	DDSketch *states = (DDSketch *) agg_states;
+	for (int i = 0; i < n; i++)
+	{
+		ddsketch_init(&states[i]);
+	}
+}
+
+static void
+percentile_sketch_vector(void *agg_state, const ArrowArray *vector, const uint64 *filter,
+						 MemoryContext agg_extra_mctx)
+{
+	ddsketch_add_many((DDSketch *) agg_state,
+					  (const float8 *) vector->buffers[1],
+					  filter,
+					  vector->length,
+					  agg_extra_mctx);
+}
+
+static void
+percentile_sketch_scalar(void *agg_state, Datum constvalue, bool constisnull, int n,
+						 MemoryContext agg_extra_mctx)
+{
+	if (constisnull)
+	{
+		return;
+	}
+
+	ddsketch_add((DDSketch *) agg_state, DatumGetFloat8(constvalue), n, agg_extra_mctx);
+}
+
+static void
+percentile_sketch_many_vector(void *restrict agg_states, const uint32 *offsets,
+							  const uint64 *filter, int start_row, int end_row,
+							  const ArrowArray *vector, MemoryContext agg_extra_mctx)
+{
+	DDSketch *states = (DDSketch *) agg_states;
+	const float8 *values = vector->buffers[1];
+
+	for (int row = start_row; row < end_row; row++)
+	{
+		if (!arrow_row_is_valid(filter, row))
+		{
+			continue;
+		}
+
+		ddsketch_add(&states[offsets[row]], values[row], 1, agg_extra_mctx);
+	}
+}
+
+static void
+percentile_sketch_emit(void *agg_state, Datum *out_result, bool *out_isnull)
+{
+	DDSketch *state = (DDSketch *) agg_state;
+
+	if (state->count == 0)
+	{
+		*out_result = (Datum) 0;
+		*out_isnull = true;
+		return;
+	}
+
+	*out_result = PointerGetDatum(ddsketch_serialize(state));
+	*out_isnull = false;
+}
+
+VectorAggFunctions percentile_sketch_agg = {
+	.state_bytes = sizeof(DDSketch),
+	.agg_init = percentile_sketch_init,
+	.agg_vector = percentile_sketch_vector,
+	.agg_scalar = percentile_sketch_scalar,
+	.agg_many_vector = percentile_sketch_many_vector,
+	.agg_emit = percentile_sketch_emit,
+};
@@ -34,6 +34,14 @@ typedef struct GroupingPolicy
 	 */
 	void (*gp_add_batch)(GroupingPolicy *gp, TupleTableSlot *vector_slot);
 
+	/*
+	 * Aggregate a single compressed batch without decompressing it, using the
+	 * batch metadata columns from the given compressed tuple as the aggregate
+	 * arguments. Not all policies support this, so it can be NULL.
+	 */
+	void (*gp_add_batch_metadata)(GroupingPolicy *gp, TupleTableSlot *vector_slot,
+								  TupleTableSlot *compressed_slot);
+
 	/*
 	 * Is a partial aggregation result ready?
 	 */
@@ -101,6 +101,10 @@ gp_batch_reset(GroupingPolicy *obj)
 		VectorAggDef *agg_def = &policy->agg_defs[i];
 		void *agg_state = policy->agg_states[i];
 		agg_def->func.agg_init(agg_state, 1);
+		if (agg_def->func.agg_init_args != NULL)
+		{
+			agg_def->func.agg_init_args(agg_state, 1, agg_def->const_args);
+		}
 	}
 
 	const int ngrp = policy->num_grouping_columns;
@@ -128,7 +132,15 @@ compute_single_aggregate(GroupingPolicyBatch *policy, TupleTableSlot *vector_slo
 	 * We have functions with one argument, and one function with no arguments
 	 * (count(*)). Collect the arguments.
 	 */
-	if (agg_def->input_offset >= 0)
+	if (agg_def->argument_expr != NULL)
+	{
+		/*
+		 * The argument expression was computed for this batch by the caller.
+		 */
+		arg_arrow = agg_def->argument_values.arrow;
+		arg_validity_bitmap = agg_def->argument_values.buffers[0];
+	}
+	else if (agg_def->input_offset >= 0)
 	{
 		const AttrNumber attnum = AttrOffsetGetAttrNumber(agg_def->input_offset);
 		const CompressedColumnValues *values =
@@ -153,6 +165,11 @@ compute_single_aggregate(GroupingPolicyBatch *policy, TupleTableSlot *vector_slo
 	/*
 	 * Compute the unified validity bitmap.
 	 */
+	if (agg_def->func.aggregates_nulls)
+	{
+		arg_validity_bitmap = NULL;
+	}
+
 	const size_t num_words = (total_batch_rows + 63) / 64;
 	const uint64 *filter = arrow_combine_validity(num_words,
 												  policy->tmp_filter,
@@ -186,6 +203,35 @@ compute_single_aggregate(GroupingPolicyBatch *policy, TupleTableSlot *vector_slo
 	}
 }
 
+/*
+ * Save the values of the grouping columns.
+ */
+static void
+save_grouping_values(GroupingPolicyBatch *policy, TupleTableSlot *vector_slot)
+{
+	const int ngrp = policy->num_grouping_columns;
+	for (int i = 0; i < ngrp; i++)
+	{
+		GroupingColumn *col = &policy->grouping_columns[i];
+		const AttrNumber attnum = AttrOffsetGetAttrNumber(col->input_offset);
+		Assert(col->input_offset >= 0);
+		Assert(col->output_offset >= 0);
+
+		const CompressedColumnValues *values =
+			vector_slot_get_compressed_column_values(vector_slot, attnum);
+		Assert(values->decompression_type == DT_Scalar);
+
+		/*
+		 * By sheer luck, we can avoid generically copying the Datum here,
+		 * because if we have any output grouping columns in this policy, it
+		 * means we're grouping by segmentby, and these values will be valid
+		 * until the next call to the vector agg node.
+		 */
+		policy->output_grouping_values[i] = *values->output_value;
+		policy->output_grouping_isnull[i] = *values->output_isnull;
+	}
+}
+
 static void
 gp_batch_add_batch(GroupingPolicy *gp, TupleTableSlot *vector_slot)
 {
@@ -221,31 +267,70 @@ gp_batch_add_batch(GroupingPolicy *gp, TupleTableSlot *vector_slot)
 		compute_single_aggregate(policy, vector_slot, agg_def, agg_state, policy->agg_extra_mctx);
 	}
 
-	/*
-	 * Save the values of the grouping columns.
-	 */
-	const int ngrp = policy->num_grouping_columns;
-	for (int i = 0; i < ngrp; i++)
-	{
-		GroupingColumn *col = &policy->grouping_columns[i];
-		const AttrNumber attnum = AttrOffsetGetAttrNumber(col->input_offset);
-		Assert(col->input_offset >= 0);
-		Assert(col->output_offset >= 0);
+	save_grouping_values(policy, vector_slot);
 
-		const CompressedColumnValues *values =
-			vector_slot_get_compressed_column_values(vector_slot, attnum);
-		Assert(values->decompression_type == DT_Scalar);
+	policy->have_results = true;
+}
 
-		/*
-		 * By sheer luck, we can avoid generically copying the Datum here,
-		 * because if we have any output grouping columns in this policy, it
-		 * means we're grouping by segmentby, and these values will be valid
-		 * until the next call to the vector agg node.
-		 */
-		policy->output_grouping_values[i] = *values->output_value;
-		policy->output_grouping_isnull[i] = *values->output_isnull;
+/*
+ * Aggregate the compressed batch using only its metadata. The planner has
+ * verified that every aggregate function can be computed this way: the
+ * count(*) and the aggregates of segmentby columns use the per-batch scalar
+ * values, and min() and max() use the respective min/max metadata column.
+ */
+static void
+gp_batch_add_batch_metadata(GroupingPolicy *gp, TupleTableSlot *vector_slot,
+							TupleTableSlot *compressed_slot)
+{
+	GroupingPolicyBatch *policy = (GroupingPolicyBatch *) gp;
+	uint16 total_batch_rows = 0;
+	const uint64 *vector_qual_result = vector_slot_get_qual_result(vector_slot, &total_batch_rows);
+	Assert(vector_qual_result == NULL);
+	(void) vector_qual_result;
+
+	const int naggs = policy->num_agg_defs;
+	for (int i = 0; i < naggs; i++)
+	{
+		VectorAggDef *agg_def = &policy->agg_defs[i];
+		void *agg_state = policy->agg_states[i];
+		Assert(agg_def->filter_clauses == NIL);
+
+		if (agg_def->metadata_attno != InvalidAttrNumber)
+		{
+			/*
+			 * The min or max metadata value, which is the result of the
+			 * aggregate function for the entire batch.
+			 */
+			bool isnull;
+			Datum value = slot_getattr(compressed_slot, agg_def->metadata_attno, &isnull);
+			agg_def->func.agg_scalar(agg_state, value, isnull, 1, policy->agg_extra_mctx);
+		}
+		else
+		{
+			/* count(*) or an aggregate of a segmentby column. */
+			Datum arg_datum = 0;
+			bool arg_isnull = true;
+			if (agg_def->input_offset >= 0)
+			{
+				const CompressedColumnValues *values =
+					vector_slot_get_compressed_column_values(vector_slot,
+															 AttrOffsetGetAttrNumber(
+																 agg_def->input_offset));
+				Assert(values->decompression_type == DT_Scalar);
+				arg_datum = *values->output_value;
+				arg_isnull = *values->output_isnull;
+			}
+
+			agg_def->func.agg_scalar(agg_state,
+									 arg_datum,
+									 arg_isnull,
+									 total_batch_rows,
+									 policy->agg_extra_mctx);
+		}
 	}
 
+	save_grouping_values(policy, vector_slot);
+
 	policy->have_results = true;
 }
 
@@ -315,6 +400,7 @@ gp_batch_explain(GroupingPolicy *gp)
 static const GroupingPolicy grouping_policy_batch_functions = {
 	.gp_reset = gp_batch_reset,
 	.gp_add_batch = gp_batch_add_batch,
+	.gp_add_batch_metadata = gp_batch_add_batch_metadata,
 	.gp_should_emit = gp_batch_should_emit,
 	.gp_do_emit = gp_batch_do_emit,
 	.gp_explain = gp_batch_explain,
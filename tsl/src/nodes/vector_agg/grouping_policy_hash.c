@@ -137,7 +137,15 @@ compute_single_aggregate(GroupingPolicyHash *policy, TupleTableSlot *vector_slot
 	 * We have functions with one argument, and one function with no arguments
 	 * (count(*)). Collect the arguments.
 	 */
-	if (agg_def->input_offset >= 0)
+	if (agg_def->argument_expr != NULL)
+	{
+		/*
+		 * The argument expression was computed for this batch by the caller.
+		 */
+		arg_arrow = agg_def->argument_values.arrow;
+		arg_validity_bitmap = agg_def->argument_values.buffers[0];
+	}
+	else if (agg_def->input_offset >= 0)
 	{
 		const AttrNumber attnum = AttrOffsetGetAttrNumber(agg_def->input_offset);
 		const CompressedColumnValues *values =
@@ -162,6 +170,11 @@ compute_single_aggregate(GroupingPolicyHash *policy, TupleTableSlot *vector_slot
 	/*
 	 * Compute the unified validity bitmap.
 	 */
+	if (agg_def->func.aggregates_nulls)
+	{
+		arg_validity_bitmap = NULL;
+	}
+
 	const size_t num_words = (total_batch_rows + 63) / 64;
 	const uint64 *filter = arrow_combine_validity(num_words,
 												  policy->tmp_filter,
@@ -264,9 +277,15 @@ add_one_range(GroupingPolicyHash *policy, TupleTableSlot *vector_slot, const int
 			void *first_uninitialized_state =
 				agg_def->func.state_bytes * (last_initialized_key_index + 1) +
 				(char *) policy->per_agg_per_key_states[agg_index];
-			agg_def->func.agg_init(first_uninitialized_state,
-								   policy->hashing.last_used_key_index -
-									   last_initialized_key_index);
+			const int num_new_states =
+				policy->hashing.last_used_key_index - last_initialized_key_index;
+			agg_def->func.agg_init(first_uninitialized_state, num_new_states);
+			if (agg_def->func.agg_init_args != NULL)
+			{
+				agg_def->func.agg_init_args(first_uninitialized_state,
+											num_new_states,
+											agg_def->const_args);
+			}
 		}
 
 		/*
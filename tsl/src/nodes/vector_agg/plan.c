@@ -17,11 +17,13 @@
 #include "plan.h"
 
 #include "exec.h"
+#include "guc.h"
 #include "import/list.h"
 #include "nodes/columnar_scan/columnar_scan.h"
 #include "nodes/decompress_chunk/vector_quals.h"
 #include "nodes/vector_agg.h"
 #include "utils.h"
+#include "vector_expr.h"
 
 static struct CustomScanMethods scan_methods = { .CustomName = VECTOR_AGG_NODE_NAME,
 												 .CreateCustomScanState = vector_agg_state_create };
@@ -134,7 +136,8 @@ resolve_outer_special_vars(List *agg_tlist, Plan *childplan)
  */
 static Plan *
 vector_agg_plan_create(Plan *childplan, Agg *agg, List *resolved_targetlist,
-					   VectorAggGroupingType grouping_type)
+					   VectorAggGroupingType grouping_type, List *metadata_agg_columns,
+					   List *metadata_qual_columns)
 {
 	CustomScan *vector_agg = (CustomScan *) makeNode(CustomScan);
 	vector_agg->custom_plans = list_make1(childplan);
@@ -177,6 +180,10 @@ vector_agg_plan_create(Plan *childplan, Agg *agg, List *resolved_targetlist,
 	vector_agg->custom_private = ts_new_list(T_List, VASI_Count);
 	lfirst(list_nth_cell(vector_agg->custom_private, VASI_GroupingType)) =
 		makeInteger(grouping_type);
+	lfirst(list_nth_cell(vector_agg->custom_private, VASI_MetadataAggColumns)) =
+		metadata_agg_columns;
+	lfirst(list_nth_cell(vector_agg->custom_private, VASI_MetadataQualColumns)) =
+		metadata_qual_columns;
 
 	if (is_columnar_scan(childplan))
 	{
@@ -209,7 +216,7 @@ is_vector_var(const VectorQualInfo *vqinfo, Expr *expr)
 {
 	if (!IsA(expr, Var))
 	{
-		/* Can aggregate only a bare decompressed column, not an expression. */
+		/* Can group only by a bare decompressed column, not an expression. */
 		return false;
 	}
 
@@ -224,6 +231,58 @@ is_vector_var(const VectorQualInfo *vqinfo, Expr *expr)
 	return vqinfo->vector_attrs[var->varattno];
 }
 
+/*
+ * Whether the aggregate function argument can be computed by the vectorized
+ * expression evaluation: arithmetic operators and abs() over the vectorizable
+ * columns and non-null constants.
+ */
+static bool
+is_vector_expression(const VectorQualInfo *vqinfo, Expr *expr)
+{
+	if (IsA(expr, Var))
+	{
+		return is_vector_var(vqinfo, expr);
+	}
+
+	if (IsA(expr, Const))
+	{
+		return !castNode(Const, expr)->constisnull;
+	}
+
+	Oid funcid = InvalidOid;
+	List *args = NIL;
+	if (IsA(expr, OpExpr))
+	{
+		funcid = castNode(OpExpr, expr)->opfuncid;
+		args = castNode(OpExpr, expr)->args;
+	}
+	else if (IsA(expr, FuncExpr))
+	{
+		funcid = castNode(FuncExpr, expr)->funcid;
+		args = castNode(FuncExpr, expr)->args;
+	}
+
+	/*
+	 * The supported functions only accept the integer and float arguments, so
+	 * we don't have to check the types of the constants and columns.
+	 */
+	if (!vector_expr_function_is_supported(funcid))
+	{
+		return false;
+	}
+
+	ListCell *lc;
+	foreach (lc, args)
+	{
+		if (!is_vector_expression(vqinfo, (Expr *) lfirst(lc)))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
 /*
  * Whether we can vectorize this particular aggregate.
  */
@@ -259,7 +318,8 @@ can_vectorize_aggref(const VectorQualInfo *vqi, Aggref *aggref)
 		aggref->aggfilter = (Expr *) aggfilter_vectorized;
 	}
 
-	if (get_vector_aggregate(aggref->aggfnoid) == NULL)
+	const Oid argtype = aggref->aggargtypes != NIL ? linitial_oid(aggref->aggargtypes) : InvalidOid;
+	if (get_vector_aggregate(aggref->aggfnoid, argtype) == NULL)
 	{
 		/*
 		 * We don't have a vectorized implementation for this particular
@@ -274,11 +334,22 @@ can_vectorize_aggref(const VectorQualInfo *vqi, Aggref *aggref)
 		return true;
 	}
 
-	/* The function must have one argument, check it. */
-	Assert(list_length(aggref->args) == 1);
+	/*
+	 * The first argument must be a vectorizable column, or an arithmetic
+	 * expression over such columns. The functions with more arguments, like
+	 * histogram(), require them to be non-null constants.
+	 */
 	TargetEntry *argument = castNode(TargetEntry, linitial(aggref->args));
+	for (int i = 1; i < list_length(aggref->args); i++)
+	{
+		Expr *expr = list_nth_node(TargetEntry, aggref->args, i)->expr;
+		if (!IsA(expr, Const) || castNode(Const, expr)->constisnull)
+		{
+			return false;
+		}
+	}
 
-	return is_vector_var(vqi, argument->expr);
+	return is_vector_expression(vqi, argument->expr);
 }
 
 /*
@@ -669,9 +740,35 @@ try_insert_vector_agg_node(Plan *plan, List *rtable)
 		}
 	}
 
+	/*
+	 * Check whether we can aggregate some compressed batches using only their
+	 * metadata, without decompressing them.
+	 */
+	List *metadata_agg_columns = NIL;
+	List *metadata_qual_columns = NIL;
+	if (ts_guc_enable_batch_metadata_aggregation && grouping_type == VAGT_Batch &&
+		!is_columnar_scan(childplan) &&
+		strcmp(castNode(CustomScan, childplan)->methods->CustomName, "DecompressChunk") == 0)
+	{
+		if (!vectoragg_plan_decompress_chunk_metadata(castNode(CustomScan, childplan),
+													  rtable,
+													  resolved_targetlist,
+													  &metadata_agg_columns,
+													  &metadata_qual_columns))
+		{
+			metadata_agg_columns = NIL;
+			metadata_qual_columns = NIL;
+		}
+	}
+
 	/*
 	 * Finally, all requirements are satisfied and we can vectorize this partial
 	 * aggregation node.
 	 */
-	return vector_agg_plan_create(childplan, agg, resolved_targetlist, grouping_type);
+	return vector_agg_plan_create(childplan,
+								  agg,
+								  resolved_targetlist,
+								  grouping_type,
+								  metadata_agg_columns,
+								  metadata_qual_columns);
 }
@@ -20,11 +20,16 @@ typedef struct VectorAggPlan
 typedef enum
 {
 	VASI_GroupingType = 0,
+	VASI_MetadataAggColumns,
+	VASI_MetadataQualColumns,
 	VASI_Count
 } VectorAggSettingsIndex;
 
 extern void _vector_agg_init(void);
 extern void vectoragg_plan_decompress_chunk(Plan *childplan, VectorQualInfo *vqi);
+extern bool vectoragg_plan_decompress_chunk_metadata(const CustomScan *custom, const List *rtable,
+													 List *resolved_targetlist, List **agg_columns,
+													 List **qual_columns);
 extern void vectoragg_plan_tam(Plan *childplan, const List *rtable, VectorQualInfo *vqi);
 Plan *try_insert_vector_agg_node(Plan *plan, List *rtable);
 bool has_vector_agg_node(Plan *plan, bool *has_normal_agg);
@@ -4,11 +4,21 @@
  * LICENSE-TIMESCALE for a copy of the license.
  */
 #include <postgres.h>
+#include <access/htup_details.h>
+#include <access/stratnum.h>
+#include <catalog/pg_aggregate.h>
+#include <nodes/nodeFuncs.h>
 #include <nodes/pathnodes.h>
 #include <nodes/plannodes.h>
+#include <parser/parsetree.h>
+#include <utils/lsyscache.h>
+#include <utils/syscache.h>
+#include <utils/typcache.h>
 
+#include "compression/create.h"
 #include "nodes/decompress_chunk/planner.h"
 #include "plan.h"
+#include "ts_catalog/compression_settings.h"
 
 /*
  * Whether the given compressed column index corresponds to a vector variable.
@@ -135,3 +145,318 @@ vectoragg_plan_decompress_chunk(Plan *childplan, VectorQualInfo *vqi)
 	List *settings = linitial(custom->custom_private);
 	vqi->reverse = list_nth_int(settings, DCS_Reverse);
 }
+
+/*
+ * Find the resno of the given compressed relation attribute in the targetlist
+ * of the compressed scan. Returns InvalidAttrNumber if it is not there.
+ */
+static AttrNumber
+find_compressed_scan_resno(const List *compressed_scan_tlist, AttrNumber compressed_attno)
+{
+	if (compressed_attno == InvalidAttrNumber)
+	{
+		return InvalidAttrNumber;
+	}
+
+	ListCell *lc;
+	foreach (lc, compressed_scan_tlist)
+	{
+		TargetEntry *target_entry = lfirst_node(TargetEntry, lc);
+		if (IsA(target_entry->expr, Var) &&
+			castNode(Var, target_entry->expr)->varattno == compressed_attno)
+		{
+			return target_entry->resno;
+		}
+	}
+
+	return InvalidAttrNumber;
+}
+
+/*
+ * Get the btree strategy of the given operator in the default btree operator
+ * family of the column type, which is the one used to compute the min/max
+ * batch metadata. Returns InvalidStrategy if the operator is not there.
+ */
+static int
+get_metadata_strategy(Oid opno, Oid column_type)
+{
+	TypeCacheEntry *tce = lookup_type_cache(column_type, TYPECACHE_BTREE_OPFAMILY);
+	if (!OidIsValid(tce->btree_opf))
+	{
+		return InvalidStrategy;
+	}
+
+	return get_op_opfamily_strategy(opno, tce->btree_opf);
+}
+
+/*
+ * Check whether the partial aggregation on top of the given DecompressChunk
+ * node can use the min/max metadata of the compressed batches instead of
+ * decompressing them, for the batches where the metadata shows that all rows
+ * pass the vectorized quals.
+ *
+ * This is possible when all aggregate functions are count(*), aggregates of
+ * segmentby columns, or min() and max() of columns that have the min/max
+ * metadata. The vectorized quals must be simple comparisons of such columns
+ * with constants.
+ *
+ * On success, returns the list of compressed scan resnos of the metadata
+ * columns for every entry of the resolved targetlist, 0 if the aggregate uses
+ * the batch row count or segmentby values, and the list of compressed scan
+ * resnos of the min and max metadata columns to check for each vectorized
+ * qual, 0 if the respective metadata doesn't have to be checked.
+ */
+bool
+vectoragg_plan_decompress_chunk_metadata(const CustomScan *custom, const List *rtable,
+										 List *resolved_targetlist, List **agg_columns,
+										 List **qual_columns)
+{
+	List *settings = linitial(custom->custom_private);
+	if (list_nth_int(settings, DCS_BatchSortedMerge))
+	{
+		return false;
+	}
+
+	/*
+	 * Find the compressed scan, possibly under a Sort node.
+	 */
+	Plan *compressed_plan = linitial(custom->custom_plans);
+	while (IsA(compressed_plan, Sort))
+	{
+		compressed_plan = compressed_plan->lefttree;
+	}
+
+	if (!IsA(compressed_plan, SeqScan) && !IsA(compressed_plan, IndexScan) &&
+		!IsA(compressed_plan, BitmapHeapScan))
+	{
+		return false;
+	}
+
+	const Scan *compressed_scan = (Scan *) compressed_plan;
+	const List *compressed_scan_tlist = compressed_scan->plan.targetlist;
+	const Oid compressed_relid = rt_fetch(compressed_scan->scanrelid, rtable)->relid;
+	const Oid chunk_relid = rt_fetch(custom->scan.scanrelid, rtable)->relid;
+
+	CompressionSettings *compression_settings = ts_compression_settings_get(chunk_relid);
+	if (compression_settings == NULL)
+	{
+		return false;
+	}
+
+	List *is_segmentby_column = list_nth(custom->custom_private, DCP_IsSegmentbyColumn);
+	List *decompression_map = list_nth(custom->custom_private, DCP_DecompressionMap);
+
+	/*
+	 * Check the aggregate functions.
+	 */
+	List *agg_result = NIL;
+	ListCell *lc;
+	foreach (lc, resolved_targetlist)
+	{
+		TargetEntry *target_entry = lfirst_node(TargetEntry, lc);
+		if (!IsA(target_entry->expr, Aggref))
+		{
+			/* A grouping column. */
+			agg_result = lappend_int(agg_result, 0);
+			continue;
+		}
+
+		Aggref *aggref = castNode(Aggref, target_entry->expr);
+		if (aggref->aggfilter != NULL)
+		{
+			return false;
+		}
+
+		if (aggref->args == NIL)
+		{
+			/* count(*) */
+			agg_result = lappend_int(agg_result, 0);
+			continue;
+		}
+
+		Expr *argument = castNode(TargetEntry, linitial(aggref->args))->expr;
+		if (!IsA(argument, Var))
+		{
+			/* The metadata can't be used for the expressions over the columns. */
+			return false;
+		}
+
+		Var *var = castNode(Var, argument);
+
+		/*
+		 * Any aggregate of a segmentby column can use the segmentby value and
+		 * the batch row count.
+		 */
+		bool is_segmentby = false;
+		for (int i = 0; i < list_length(decompression_map); i++)
+		{
+			const int custom_scan_attno = list_nth_int(decompression_map, i);
+			if (custom_scan_attno > 0 &&
+				custom_scan_to_uncompressed_chunk_attno(custom->custom_scan_tlist,
+														custom_scan_attno) == var->varattno)
+			{
+				is_segmentby = list_nth_int(is_segmentby_column, i);
+				break;
+			}
+		}
+
+		if (is_segmentby)
+		{
+			agg_result = lappend_int(agg_result, 0);
+			continue;
+		}
+
+		/*
+		 * For the compressed columns, we can only use the min/max metadata for
+		 * the min() and max() aggregates. They are the aggregates with the
+		 * sort operator that is the "less" or "greater" operator of the
+		 * default btree opfamily.
+		 */
+		if (OidIsValid(var->varcollid))
+		{
+			/*
+			 * For the collatable types, the metadata might use a different
+			 * collation, so don't bother.
+			 */
+			return false;
+		}
+
+		HeapTuple aggtuple = SearchSysCache1(AGGFNOID, ObjectIdGetDatum(aggref->aggfnoid));
+		if (!HeapTupleIsValid(aggtuple))
+		{
+			return false;
+		}
+		const Oid aggsortop = ((Form_pg_aggregate) GETSTRUCT(aggtuple))->aggsortop;
+		ReleaseSysCache(aggtuple);
+
+		if (!OidIsValid(aggsortop))
+		{
+			return false;
+		}
+
+		const int strategy = get_metadata_strategy(aggsortop, var->vartype);
+		char *metadata_type;
+		if (strategy == BTLessStrategyNumber)
+		{
+			metadata_type = "min";
+		}
+		else if (strategy == BTGreaterStrategyNumber)
+		{
+			metadata_type = "max";
+		}
+		else
+		{
+			return false;
+		}
+
+		const AttrNumber metadata_resno =
+			find_compressed_scan_resno(compressed_scan_tlist,
+									   compressed_column_metadata_attno(compression_settings,
+																		chunk_relid,
+																		var->varattno,
+																		compressed_relid,
+																		metadata_type));
+		if (metadata_resno == InvalidAttrNumber)
+		{
+			return false;
+		}
+
+		agg_result = lappend_int(agg_result, metadata_resno);
+	}
+
+	/*
+	 * Check the vectorized quals.
+	 */
+	List *qual_result = NIL;
+	List *vectorized_quals = linitial(custom->custom_exprs);
+	foreach (lc, vectorized_quals)
+	{
+		if (!IsA(lfirst(lc), OpExpr))
+		{
+			return false;
+		}
+
+		OpExpr *opexpr = lfirst_node(OpExpr, lc);
+		Assert(list_length(opexpr->args) == 2);
+		Node *arg1 = linitial(opexpr->args);
+		if (!IsA(arg1, Var))
+		{
+			return false;
+		}
+
+		Var *var = castNode(Var, arg1);
+		if (var->varno == INDEX_VAR)
+		{
+			var = castNode(Var,
+						   castNode(TargetEntry,
+									list_nth(custom->custom_scan_tlist,
+											 AttrNumberGetAttrOffset(var->varattno)))
+							   ->expr);
+		}
+
+		if (OidIsValid(var->varcollid) || OidIsValid(opexpr->inputcollid))
+		{
+			return false;
+		}
+
+		/*
+		 * The rows with null values don't pass the quals, and the metadata
+		 * doesn't tell us whether there are any, so the column must be NOT
+		 * NULL.
+		 */
+		if (!get_attnotnull(chunk_relid, var->varattno))
+		{
+			return false;
+		}
+
+		const int strategy = get_metadata_strategy(opexpr->opno, var->vartype);
+		if (strategy == InvalidStrategy || strategy > BTGreaterStrategyNumber)
+		{
+			return false;
+		}
+
+		/*
+		 * All rows of the batch pass "x < c" if max(x) < c, and pass "x > c"
+		 * if min(x) > c. For equality, both have to hold.
+		 */
+		const bool check_min = strategy >= BTEqualStrategyNumber;
+		const bool check_max = strategy <= BTEqualStrategyNumber;
+
+		AttrNumber min_resno = InvalidAttrNumber;
+		AttrNumber max_resno = InvalidAttrNumber;
+		if (check_min)
+		{
+			min_resno = find_compressed_scan_resno(compressed_scan_tlist,
+												   compressed_column_metadata_attno(compression_settings,
+																					chunk_relid,
+																					var->varattno,
+																					compressed_relid,
+																					"min"));
+			if (min_resno == InvalidAttrNumber)
+			{
+				return false;
+			}
+		}
+
+		if (check_max)
+		{
+			max_resno = find_compressed_scan_resno(compressed_scan_tlist,
+												   compressed_column_metadata_attno(compression_settings,
+																					chunk_relid,
+																					var->varattno,
+																					compressed_relid,
+																					"max"));
+			if (max_resno == InvalidAttrNumber)
+			{
+				return false;
+			}
+		}
+
+		qual_result = lappend_int(qual_result, min_resno);
+		qual_result = lappend_int(qual_result, max_resno);
+	}
+
+	*agg_columns = agg_result;
+	*qual_columns = qual_result;
+	return true;
+}
@@ -0,0 +1,515 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * Vectorized evaluation of the arithmetic expressions used as the arguments of
+ * the vectorized aggregate functions. The supported expressions are the
+ * arithmetic operators and abs() for the integer and float types, over the
+ * decompressed columns and the non-null constants. The result of each
+ * expression node is a temporary Arrow array with a value for every row of the
+ * batch, that is allocated in the current memory context.
+ *
+ * The errors like overflow or division by zero are reported only for the rows
+ * that are actually aggregated, i.e. pass the vectorized quals and the
+ * aggregate FILTER clause, and have non-null arguments. This is the same as in
+ * the row-by-row evaluation, where the other rows never reach the aggregate
+ * argument expression.
+ */
+
+#include <postgres.h>
+
+#include <catalog/pg_type_d.h>
+#include <common/int.h>
+#include <nodes/nodeFuncs.h>
+#include <utils/float.h>
+#include <utils/fmgroids.h>
+
+#include "vector_expr.h"
+
+#include "debug_assert.h"
+
+typedef enum
+{
+	VEO_Invalid = 0,
+	VEO_Add,
+	VEO_Sub,
+	VEO_Mul,
+	VEO_Div,
+	VEO_Neg,
+	VEO_Abs,
+} VectorExprOperation;
+
+/*
+ * Look up the operation for the given Postgres function. All the supported
+ * functions have the arguments of the same kind as the result, either integer
+ * or float, and not wider than the result, so the arguments can be converted to
+ * the result type before the operation, and this gives the same result as
+ * the Postgres functions.
+ */
+static VectorExprOperation
+get_operation(Oid funcid)
+{
+#define ARITHMETIC_FUNCTIONS(PREFIX)                                                               \
+	case F_##PREFIX##PL:                                                                           \
+		return VEO_Add;                                                                            \
+	case F_##PREFIX##MI:                                                                           \
+		return VEO_Sub;                                                                            \
+	case F_##PREFIX##MUL:                                                                          \
+		return VEO_Mul;                                                                            \
+	case F_##PREFIX##DIV:                                                                          \
+		return VEO_Div
+
+	switch (funcid)
+	{
+		ARITHMETIC_FUNCTIONS(INT2);
+		ARITHMETIC_FUNCTIONS(INT4);
+		ARITHMETIC_FUNCTIONS(INT8);
+		ARITHMETIC_FUNCTIONS(INT24);
+		ARITHMETIC_FUNCTIONS(INT42);
+		ARITHMETIC_FUNCTIONS(INT28);
+		ARITHMETIC_FUNCTIONS(INT82);
+		ARITHMETIC_FUNCTIONS(INT48);
+		ARITHMETIC_FUNCTIONS(INT84);
+		ARITHMETIC_FUNCTIONS(FLOAT4);
+		ARITHMETIC_FUNCTIONS(FLOAT8);
+		ARITHMETIC_FUNCTIONS(FLOAT48);
+		ARITHMETIC_FUNCTIONS(FLOAT84);
+
+		case F_INT2UM:
+		case F_INT4UM:
+		case F_INT8UM:
+		case F_FLOAT4UM:
+		case F_FLOAT8UM:
+			return VEO_Neg;
+
+		case F_INT2ABS:
+		case F_INT4ABS:
+		case F_INT8ABS:
+		case F_FLOAT4ABS:
+		case F_FLOAT8ABS:
+		case F_ABS_INT2:
+		case F_ABS_INT4:
+		case F_ABS_INT8:
+		case F_ABS_FLOAT4:
+		case F_ABS_FLOAT8:
+			return VEO_Abs;
+
+		default:
+			return VEO_Invalid;
+	}
+#undef ARITHMETIC_FUNCTIONS
+}
+
+bool
+vector_expr_function_is_supported(Oid funcid)
+{
+	return get_operation(funcid) != VEO_Invalid;
+}
+
+static int16
+get_value_bytes(Oid type)
+{
+	switch (type)
+	{
+		case INT2OID:
+			return 2;
+		case INT4OID:
+		case FLOAT4OID:
+			return 4;
+		case INT8OID:
+		case FLOAT8OID:
+			return 8;
+		default:
+			elog(ERROR, "unexpected type %u in vectorized expression", type);
+			pg_unreachable();
+	}
+}
+
+static ArrowArray *
+make_result_arrow(int n, int value_bytes, const uint64 *validity)
+{
+	ArrowArray *result = palloc0(sizeof(ArrowArray) + sizeof(void *) * 2);
+	const void **buffers = (const void **) &result[1];
+	buffers[0] = validity;
+	/* The value buffer has 64-byte padding as required by Arrow. */
+	buffers[1] = palloc(pad_to_multiple(64, (uint64) n * value_bytes));
+	result->n_buffers = 2;
+	result->buffers = buffers;
+	result->length = n;
+	return result;
+}
+
+/*
+ * The single value arrays that we get for the constants, the default values of
+ * the compressed columns or the segmentby columns, are repeated for every row
+ * of the batch, so that the operations work only with the full arrays.
+ */
+static const ArrowArray *
+broadcast_single_value(const ArrowArray *single, Oid type, int n)
+{
+	const int value_bytes = get_value_bytes(type);
+
+	uint64 *validity = NULL;
+	if (!arrow_row_is_valid(single->buffers[0], 0))
+	{
+		validity = palloc0(sizeof(uint64) * ((n + 63) / 64));
+	}
+
+	ArrowArray *result = make_result_arrow(n, value_bytes, validity);
+	uint8 *values = (uint8 *) result->buffers[1];
+	for (int row = 0; row < n; row++)
+	{
+		memcpy(&values[row * value_bytes], single->buffers[1], value_bytes);
+	}
+
+	return result;
+}
+
+static pg_attribute_always_inline int64
+get_integer(const void *values, int value_bytes, int row)
+{
+	switch (value_bytes)
+	{
+		case 2:
+			return ((const int16 *) values)[row];
+		case 4:
+			return ((const int32 *) values)[row];
+		default:
+			Assert(value_bytes == 8);
+			return ((const int64 *) values)[row];
+	}
+}
+
+/*
+ * Compute the integer operation with the result in the given range, which is
+ * the range of the result type. The narrower types can't overflow the int64
+ * intermediate result, so we only have to check the range for them.
+ */
+static pg_attribute_always_inline int64
+apply_integer_operation(VectorExprOperation operation, int64 x, int64 y, int64 min, int64 max,
+						const char *type_name)
+{
+	int64 result = 0;
+	bool overflow = false;
+	switch (operation)
+	{
+		case VEO_Add:
+			overflow = pg_add_s64_overflow(x, y, &result);
+			break;
+		case VEO_Sub:
+			overflow = pg_sub_s64_overflow(x, y, &result);
+			break;
+		case VEO_Mul:
+			overflow = pg_mul_s64_overflow(x, y, &result);
+			break;
+		case VEO_Div:
+			if (unlikely(y == 0))
+			{
+				ereport(ERROR, (errcode(ERRCODE_DIVISION_BY_ZERO), errmsg("division by zero")));
+			}
+
+			/* Dividing the minimal value by -1 overflows, and can trap. */
+			if (y == -1)
+			{
+				overflow = pg_sub_s64_overflow(0, x, &result);
+			}
+			else
+			{
+				result = x / y;
+			}
+			break;
+		case VEO_Neg:
+			overflow = pg_sub_s64_overflow(0, x, &result);
+			break;
+		case VEO_Abs:
+			if (x < 0)
+			{
+				overflow = pg_sub_s64_overflow(0, x, &result);
+			}
+			else
+			{
+				result = x;
+			}
+			break;
+		case VEO_Invalid:
+			pg_unreachable();
+	}
+
+	if (unlikely(overflow || result < min || result > max))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("%s out of range", type_name)));
+	}
+
+	return result;
+}
+
+static pg_attribute_always_inline void
+compute_integer_impl(VectorExprOperation operation, const ArrowArray *x, int x_bytes,
+					 const ArrowArray *y, int y_bytes, const uint64 *validity, ArrowArray *result,
+					 int result_bytes, int64 min, int64 max, const char *type_name)
+{
+	const int n = result->length;
+	for (int row = 0; row < n; row++)
+	{
+		int64 value = 0;
+		if (arrow_row_is_valid(validity, row))
+		{
+			const int64 x_value = get_integer(x->buffers[1], x_bytes, row);
+			const int64 y_value = y != NULL ? get_integer(y->buffers[1], y_bytes, row) : 0;
+			value = apply_integer_operation(operation, x_value, y_value, min, max, type_name);
+		}
+
+		switch (result_bytes)
+		{
+			case 2:
+				((int16 *) result->buffers[1])[row] = value;
+				break;
+			case 4:
+				((int32 *) result->buffers[1])[row] = value;
+				break;
+			default:
+				((int64 *) result->buffers[1])[row] = value;
+				break;
+		}
+	}
+}
+
+static void
+compute_integer(VectorExprOperation operation, const ArrowArray *x, int x_bytes,
+				const ArrowArray *y, int y_bytes, const uint64 *validity, ArrowArray *result,
+				Oid result_type)
+{
+	switch (result_type)
+	{
+		case INT2OID:
+			compute_integer_impl(operation,
+								 x,
+								 x_bytes,
+								 y,
+								 y_bytes,
+								 validity,
+								 result,
+								 2,
+								 PG_INT16_MIN,
+								 PG_INT16_MAX,
+								 "smallint");
+			break;
+		case INT4OID:
+			compute_integer_impl(operation,
+								 x,
+								 x_bytes,
+								 y,
+								 y_bytes,
+								 validity,
+								 result,
+								 4,
+								 PG_INT32_MIN,
+								 PG_INT32_MAX,
+								 "integer");
+			break;
+		default:
+			Assert(result_type == INT8OID);
+			compute_integer_impl(operation,
+								 x,
+								 x_bytes,
+								 y,
+								 y_bytes,
+								 validity,
+								 result,
+								 8,
+								 PG_INT64_MIN,
+								 PG_INT64_MAX,
+								 "bigint");
+			break;
+	}
+}
+
+/*
+ * The float operations use the same functions as Postgres, which report the
+ * overflow, underflow and division by zero.
+ */
+static void
+compute_float4(VectorExprOperation operation, const ArrowArray *x, const ArrowArray *y,
+			   const uint64 *validity, ArrowArray *result)
+{
+	const float4 *x_values = (const float4 *) x->buffers[1];
+	const float4 *y_values = y != NULL ? (const float4 *) y->buffers[1] : NULL;
+	float4 *result_values = (float4 *) result->buffers[1];
+	const int n = result->length;
+	for (int row = 0; row < n; row++)
+	{
+		if (!arrow_row_is_valid(validity, row))
+		{
+			result_values[row] = 0;
+			continue;
+		}
+
+		const float4 x_value = x_values[row];
+		const float4 y_value = y_values != NULL ? y_values[row] : 0;
+		switch (operation)
+		{
+			case VEO_Add:
+				result_values[row] = float4_pl(x_value, y_value);
+				break;
+			case VEO_Sub:
+				result_values[row] = float4_mi(x_value, y_value);
+				break;
+			case VEO_Mul:
+				result_values[row] = float4_mul(x_value, y_value);
+				break;
+			case VEO_Div:
+				result_values[row] = float4_div(x_value, y_value);
+				break;
+			case VEO_Neg:
+				result_values[row] = -x_value;
+				break;
+			case VEO_Abs:
+				result_values[row] = fabsf(x_value);
+				break;
+			case VEO_Invalid:
+				pg_unreachable();
+		}
+	}
+}
+
+static void
+compute_float8(VectorExprOperation operation, const ArrowArray *x, int x_bytes,
+			   const ArrowArray *y, int y_bytes, const uint64 *validity, ArrowArray *result)
+{
+	float8 *result_values = (float8 *) result->buffers[1];
+	const int n = result->length;
+	for (int row = 0; row < n; row++)
+	{
+		if (!arrow_row_is_valid(validity, row))
+		{
+			result_values[row] = 0;
+			continue;
+		}
+
+		const float8 x_value = x_bytes == 4 ? ((const float4 *) x->buffers[1])[row] :
+											  ((const float8 *) x->buffers[1])[row];
+		float8 y_value = 0;
+		if (y != NULL)
+		{
+			y_value = y_bytes == 4 ? ((const float4 *) y->buffers[1])[row] :
+									 ((const float8 *) y->buffers[1])[row];
+		}
+
+		switch (operation)
+		{
+			case VEO_Add:
+				result_values[row] = float8_pl(x_value, y_value);
+				break;
+			case VEO_Sub:
+				result_values[row] = float8_mi(x_value, y_value);
+				break;
+			case VEO_Mul:
+				result_values[row] = float8_mul(x_value, y_value);
+				break;
+			case VEO_Div:
+				result_values[row] = float8_div(x_value, y_value);
+				break;
+			case VEO_Neg:
+				result_values[row] = -x_value;
+				break;
+			case VEO_Abs:
+				result_values[row] = fabs(x_value);
+				break;
+			case VEO_Invalid:
+				pg_unreachable();
+		}
+	}
+}
+
+/*
+ * Compute the given expression for the batch. The result is computed only for
+ * the rows given by the bitmap, and the other rows are invalid in the result.
+ */
+const ArrowArray *
+vector_expr_compute(VectorQualState *vqstate, Expr *expr, const uint64 *rows)
+{
+	const int n = vqstate->num_results;
+	const Oid result_type = exprType((Node *) expr);
+
+	if (IsA(expr, Var))
+	{
+		bool is_default_value = false;
+		const ArrowArray *arrow = vqstate->get_arrow_array(vqstate, expr, &is_default_value);
+		if (is_default_value)
+		{
+			return broadcast_single_value(arrow, result_type, n);
+		}
+		return arrow;
+	}
+
+	if (IsA(expr, Const))
+	{
+		const Const *c = castNode(Const, expr);
+		return broadcast_single_value(make_single_value_arrow(c->consttype,
+															  c->constvalue,
+															  c->constisnull),
+									  result_type,
+									  n);
+	}
+
+	Oid funcid = InvalidOid;
+	List *args = NIL;
+	if (IsA(expr, OpExpr))
+	{
+		funcid = castNode(OpExpr, expr)->opfuncid;
+		args = castNode(OpExpr, expr)->args;
+	}
+	else if (IsA(expr, FuncExpr))
+	{
+		funcid = castNode(FuncExpr, expr)->funcid;
+		args = castNode(FuncExpr, expr)->args;
+	}
+
+	const VectorExprOperation operation = get_operation(funcid);
+	Ensure(operation != VEO_Invalid,
+		   "unsupported vectorized expression node %d",
+		   (int) nodeTag(expr));
+	Assert(list_length(args) == ((operation == VEO_Neg || operation == VEO_Abs) ? 1 : 2));
+
+	/*
+	 * All the supported functions are strict, so the result is valid where all
+	 * the arguments are valid.
+	 */
+	const ArrowArray *x = vector_expr_compute(vqstate, linitial(args), rows);
+	const int x_bytes = get_value_bytes(exprType(linitial(args)));
+	const ArrowArray *y = NULL;
+	int y_bytes = 0;
+	if (list_length(args) > 1)
+	{
+		y = vector_expr_compute(vqstate, lsecond(args), rows);
+		y_bytes = get_value_bytes(exprType(lsecond(args)));
+	}
+
+	const size_t num_words = (n + 63) / 64;
+	const uint64 *validity = arrow_combine_validity(num_words,
+													palloc(sizeof(uint64) * num_words),
+													rows,
+													x->buffers[0],
+													y != NULL ? y->buffers[0] : NULL);
+
+	ArrowArray *result = make_result_arrow(n, get_value_bytes(result_type), validity);
+	switch (result_type)
+	{
+		case FLOAT4OID:
+			compute_float4(operation, x, y, validity, result);
+			break;
+		case FLOAT8OID:
+			compute_float8(operation, x, x_bytes, y, y_bytes, validity, result);
+			break;
+		default:
+			compute_integer(operation, x, x_bytes, y, y_bytes, validity, result, result_type);
+			break;
+	}
+
+	return result;
+}
@@ -0,0 +1,21 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+#pragma once
+
+#include <postgres.h>
+#include <nodes/primnodes.h>
+
+#include "compression/arrow_c_data_interface.h"
+#include "nodes/decompress_chunk/vector_quals.h"
+
+/*
+ * Vectorized evaluation of the arithmetic expressions over the columns, that
+ * are used as the arguments of the vectorized aggregate functions, e.g.
+ * sum(a + b) or max(abs(x)).
+ */
+extern bool vector_expr_function_is_supported(Oid funcid);
+extern const ArrowArray *vector_expr_compute(VectorQualState *vqstate, Expr *expr,
+											 const uint64 *rows);
@@ -24,6 +24,7 @@
 #include "nodes/decompress_chunk/decompress_chunk.h"
 #include "nodes/frozen_chunk_dml/frozen_chunk_dml.h"
 #include "nodes/gapfill/gapfill.h"
+#include "nodes/runtime_filter/runtime_filter.h"
 #include "nodes/skip_scan/skip_scan.h"
 #include "nodes/vector_agg/plan.h"
 #include "planner.h"
@@ -91,6 +92,13 @@ tsl_create_upper_paths_hook(PlannerInfo *root, UpperRelationKind stage, RelOptIn
 				gapfill_adjust_window_targetlist(root, input_rel, output_rel);
 			break;
 		case UPPERREL_DISTINCT:
+			if (ts_guc_enable_chunkwise_aggregation && input_rel != NULL &&
+				!IS_DUMMY_REL(input_rel) && output_rel != NULL &&
+				involves_hypertable(root, input_rel))
+			{
+				tsl_pushdown_partial_distinct(root, ht, input_rel, output_rel);
+			}
+
 			tsl_skip_scan_paths_add(root, input_rel, output_rel);
 			break;
 		default:
@@ -235,6 +243,15 @@ tsl_postprocess_plan(PlannedStmt *stmt)
 		stmt->planTree = try_insert_vector_agg_node(stmt->planTree, stmt->rtable);
 	}
 
+	/*
+	 * The runtime filters are inserted after the vector aggregation, because
+	 * they don't work for DecompressChunk nodes under aggregation anyway.
+	 */
+	if (ts_guc_enable_runtime_join_filter)
+	{
+		try_insert_runtime_filters(stmt);
+	}
+
 #ifdef TS_DEBUG
 	if (ts_guc_debug_require_vector_agg != DRO_Allow)
 	{
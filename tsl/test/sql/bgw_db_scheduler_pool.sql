@@ -0,0 +1,242 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+--
+-- Setup
+--
+\c :TEST_DBNAME :ROLE_SUPERUSER
+CREATE OR REPLACE FUNCTION ts_bgw_db_scheduler_test_run(timeout INT = -1, mock_start_time INT = 0) RETURNS VOID
+AS :MODULE_PATHNAME LANGUAGE C VOLATILE;
+
+CREATE OR REPLACE FUNCTION ts_bgw_db_scheduler_test_wait_for_scheduler_finish() RETURNS VOID
+AS :MODULE_PATHNAME LANGUAGE C VOLATILE;
+
+CREATE OR REPLACE FUNCTION ts_bgw_params_create() RETURNS VOID AS :MODULE_PATHNAME LANGUAGE C VOLATILE;
+CREATE OR REPLACE FUNCTION ts_bgw_test_job_sleep(job_id INT, config JSONB) RETURNS VOID AS :MODULE_PATHNAME LANGUAGE C VOLATILE;
+
+CREATE OR REPLACE FUNCTION ts_bgw_params_reset_time(set_time BIGINT = 0, wait BOOLEAN = false) RETURNS VOID
+AS :MODULE_PATHNAME LANGUAGE C VOLATILE;
+
+CREATE OR REPLACE FUNCTION insert_job(
+       application_name NAME,
+       job_type NAME,
+       schedule_interval INTERVAL,
+       max_runtime INTERVAL,
+       retry_period INTERVAL,
+       owner regrole DEFAULT CURRENT_ROLE::regrole,
+       scheduled BOOL DEFAULT true,
+       fixed_schedule BOOL DEFAULT false
+) RETURNS INT LANGUAGE SQL SECURITY DEFINER AS
+$$
+  INSERT INTO _timescaledb_config.bgw_job(application_name,schedule_interval,max_runtime,max_retries,
+  retry_period,proc_name,proc_schema,owner,scheduled,fixed_schedule)
+  VALUES($1,$3,$4,5,$5,$2,'public',$6,$7,$8) RETURNING id;
+$$;
+
+\set WAIT_FOR_OTHER_TO_ADVANCE 2
+
+CREATE OR REPLACE FUNCTION ts_bgw_params_mock_wait_returns_immediately(new_val INTEGER) RETURNS VOID
+AS :MODULE_PATHNAME LANGUAGE C VOLATILE;
+
+-- Remove any default jobs, e.g., telemetry
+DELETE FROM _timescaledb_config.bgw_job WHERE TRUE;
+TRUNCATE _timescaledb_internal.bgw_job_stat;
+
+CREATE TABLE public.bgw_log(
+    msg_no INT,
+    mock_time BIGINT,
+    application_name TEXT,
+    msg TEXT
+);
+
+-- Only show the messages about the job pool and the jobs run in it, and
+-- mask the job ids and user oids
+CREATE VIEW pool_log AS
+    SELECT application_name,
+           regexp_replace(msg, '(job|user) [0-9]{4,}', '\1 N', 'g') AS msg
+      FROM bgw_log
+     WHERE msg LIKE '%job pool worker%'
+        OR msg LIKE '%due to timeout'
+        OR msg IN ('Execute job 1', 'Before sleep')
+     ORDER BY mock_time, application_name COLLATE "C", msg_no;
+
+CREATE VIEW pool_workers AS
+    SELECT pid, application_name, backend_type
+      FROM pg_stat_activity
+     WHERE backend_type = 'TimescaleDB Background Job Pool Worker';
+
+CREATE TABLE public.bgw_dsm_handle_store(
+    handle BIGINT
+);
+
+INSERT INTO public.bgw_dsm_handle_store VALUES (0);
+SELECT ts_bgw_params_create();
+
+CREATE FUNCTION wait_for_timer_to_run(started_at INTEGER, spins INTEGER=:TEST_SPINWAIT_ITERS) RETURNS BOOLEAN LANGUAGE PLPGSQL AS
+$BODY$
+DECLARE
+	num_runs INTEGER;
+	message TEXT;
+BEGIN
+	select format('[TESTING] Wait until %%, started at %s', started_at) into message;
+	FOR i in 1..spins
+	LOOP
+	SELECT COUNT(*) from bgw_log where msg LIKE message INTO num_runs;
+	if (num_runs > 0) THEN
+		RETURN true;
+	ELSE
+		PERFORM pg_sleep(0.1);
+	END IF;
+	END LOOP;
+	RETURN false;
+END
+$BODY$;
+
+CREATE FUNCTION wait_for_log(message TEXT, runs INTEGER, spins INTEGER=:TEST_SPINWAIT_ITERS) RETURNS BOOLEAN LANGUAGE PLPGSQL AS
+$BODY$
+DECLARE
+	num_runs INTEGER;
+BEGIN
+	FOR i in 1..spins
+	LOOP
+	SELECT COUNT(*) from bgw_log where msg = message INTO num_runs;
+	if (num_runs = runs) THEN
+		RETURN true;
+	ELSE
+		PERFORM pg_sleep(0.1);
+	END IF;
+	END LOOP;
+	RETURN false;
+END
+$BODY$;
+
+-- A pooled worker reports itself with the name of the pool as application
+-- name once it is done with its job
+CREATE FUNCTION wait_for_pool_workers(num INTEGER, idle BOOLEAN = false, spins INTEGER=:TEST_SPINWAIT_ITERS) RETURNS BOOLEAN LANGUAGE PLPGSQL AS
+$BODY$
+DECLARE
+	num_workers INTEGER;
+BEGIN
+	FOR i in 1..spins
+	LOOP
+	PERFORM pg_stat_clear_snapshot();
+	SELECT COUNT(*) from pool_workers where NOT idle OR application_name = backend_type INTO num_workers;
+	if (num_workers = num) THEN
+		RETURN true;
+	ELSE
+		PERFORM pg_sleep(0.1);
+	END IF;
+	END LOOP;
+	RETURN false;
+END
+$BODY$;
+
+ALTER SYSTEM SET timescaledb.bgw_job_pool_size = 1;
+ALTER SYSTEM SET timescaledb.bgw_job_pool_idle_timeout = '100ms';
+ALTER DATABASE :TEST_DBNAME SET timescaledb.bgw_log_level = 'DEBUG1';
+SELECT pg_reload_conf();
+
+\c :TEST_DBNAME :ROLE_SUPERUSER
+SELECT ts_bgw_params_mock_wait_returns_immediately(:WAIT_FOR_OTHER_TO_ADVANCE);
+
+--
+-- Test that jobs run in a pooled worker and that the worker is reused
+--
+SELECT insert_job('pool_job_1', 'bgw_test_job_1', INTERVAL '100s', INTERVAL '100s', INTERVAL '1s') AS job_1 \gset
+SELECT insert_job('pool_job_2', 'bgw_test_job_1', INTERVAL '100s', INTERVAL '100s', INTERVAL '1s', scheduled => false) AS job_2 \gset
+
+SELECT ts_bgw_db_scheduler_test_run(1000);
+SELECT wait_for_timer_to_run(0);
+SELECT wait_for_log('Execute job 1', 1);
+SELECT wait_for_pool_workers(1, idle => true);
+SELECT pid AS pool_pid FROM pool_workers \gset
+
+-- The job lock is a session-level advisory lock, which is released when
+-- the session is reset after the job
+SELECT count(*) FROM pg_locks WHERE locktype = 'advisory' AND pid = :pool_pid;
+
+-- The second job runs in the same worker
+SELECT scheduled FROM alter_job(:job_2, scheduled => true);
+SELECT ts_bgw_params_reset_time(50000, true);
+SELECT wait_for_timer_to_run(50000);
+SELECT wait_for_log('Execute job 1', 2);
+SELECT wait_for_pool_workers(1, idle => true);
+SELECT pid = :pool_pid AS same_worker FROM pool_workers;
+SELECT count(*) FROM pg_locks WHERE locktype = 'advisory' AND pid = :pool_pid;
+
+--
+-- Test that the worker exits after being idle for longer than
+-- bgw_job_pool_idle_timeout
+--
+SELECT ts_bgw_params_reset_time(100000, true);
+SELECT wait_for_timer_to_run(100000);
+-- Still within the idle timeout
+SELECT wait_for_pool_workers(1);
+SELECT ts_bgw_params_reset_time(250000, true);
+SELECT wait_for_timer_to_run(250000);
+SELECT wait_for_pool_workers(0);
+
+SELECT ts_bgw_params_reset_time(1000000, true);
+SELECT ts_bgw_db_scheduler_test_wait_for_scheduler_finish();
+SELECT * FROM pool_log;
+
+SELECT application_name, last_run_success, total_runs, total_successes
+FROM _timescaledb_internal.bgw_job_stat JOIN _timescaledb_config.bgw_job ON id = job_id ORDER BY id;
+
+--
+-- Test that shrinking bgw_job_pool_size stops the extra workers
+--
+TRUNCATE bgw_log;
+TRUNCATE _timescaledb_internal.bgw_job_stat;
+DELETE FROM _timescaledb_config.bgw_job;
+SELECT ts_bgw_params_reset_time();
+
+ALTER SYSTEM SET timescaledb.bgw_job_pool_size = 2;
+SELECT pg_reload_conf();
+\c :TEST_DBNAME :ROLE_SUPERUSER
+
+SELECT insert_job('pool_job_3', 'bgw_test_job_1', INTERVAL '100s', INTERVAL '100s', INTERVAL '1s') AS job_3 \gset
+SELECT insert_job('pool_job_4', 'bgw_test_job_1', INTERVAL '100s', INTERVAL '100s', INTERVAL '1s') AS job_4 \gset
+
+SELECT ts_bgw_db_scheduler_test_run(1000);
+SELECT wait_for_timer_to_run(0);
+SELECT wait_for_log('Execute job 1', 2);
+SELECT wait_for_pool_workers(2, idle => true);
+
+ALTER SYSTEM SET timescaledb.bgw_job_pool_size = 1;
+SELECT pg_reload_conf();
+
+-- Advance the time twice so that the scheduler has seen the new
+-- configuration, but stay within the idle timeout
+SELECT ts_bgw_params_reset_time(50000, true);
+SELECT wait_for_timer_to_run(50000);
+SELECT ts_bgw_params_reset_time(100000, true);
+SELECT wait_for_timer_to_run(100000);
+SELECT wait_for_pool_workers(1);
+
+--
+-- Test that a job that runs into its timeout terminates the pooled worker
+--
+SELECT insert_job('pool_sleep', 'ts_bgw_test_job_sleep', INTERVAL '100s', INTERVAL '100ms', INTERVAL '1s', scheduled => false) AS sleep_job \gset
+SELECT scheduled FROM alter_job(:sleep_job, scheduled => true);
+SELECT ts_bgw_params_reset_time(120000, true);
+SELECT wait_for_timer_to_run(120000);
+SELECT wait_for_log('Before sleep', 1);
+SELECT wait_for_pool_workers(1);
+
+SELECT ts_bgw_params_reset_time(300000, true);
+SELECT wait_for_timer_to_run(300000);
+SELECT wait_for_pool_workers(0);
+
+SELECT ts_bgw_params_reset_time(1000000, true);
+SELECT ts_bgw_db_scheduler_test_wait_for_scheduler_finish();
+SELECT * FROM pool_log;
+
+SELECT application_name, last_run_success, total_runs, total_successes
+FROM _timescaledb_internal.bgw_job_stat JOIN _timescaledb_config.bgw_job ON id = job_id ORDER BY id;
+
+ALTER SYSTEM RESET timescaledb.bgw_job_pool_size;
+ALTER SYSTEM RESET timescaledb.bgw_job_pool_idle_timeout;
+ALTER DATABASE :TEST_DBNAME RESET timescaledb.bgw_log_level;
+SELECT pg_reload_conf();
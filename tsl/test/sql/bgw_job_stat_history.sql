@@ -151,9 +151,81 @@ FROM _timescaledb_internal.bgw_job_stat_history
 WHERE job_id = :job_id_3
 ORDER BY id;
 
+-- The execution is only recorded once it ends, so block the job on an
+-- advisory lock to check the history while it is running
+CREATE PROCEDURE custom_job_wait(job_id int, config jsonb) LANGUAGE PLPGSQL AS
+$$
+BEGIN
+  PERFORM pg_advisory_xact_lock(4242);
+END
+$$;
+
+CREATE FUNCTION wait_for_job_to_block(spins INTEGER=:TEST_SPINWAIT_ITERS) RETURNS BOOLEAN LANGUAGE PLPGSQL AS
+$BODY$
+BEGIN
+  FOR i in 1..spins
+  LOOP
+    IF EXISTS (SELECT FROM pg_locks WHERE locktype = 'advisory' AND objid = 4242 AND NOT granted) THEN
+      RETURN true;
+    END IF;
+    PERFORM pg_sleep(0.1);
+  END LOOP;
+  RETURN false;
+END
+$BODY$;
+
+-- test.wait_for_job_to_run() gives up on the first failure, so wait for
+-- the failure explicitly
+CREATE FUNCTION wait_for_job_to_fail(job_param_id INTEGER, spins INTEGER=:TEST_SPINWAIT_ITERS) RETURNS BOOLEAN LANGUAGE PLPGSQL AS
+$BODY$
+BEGIN
+  FOR i in 1..spins
+  LOOP
+    IF EXISTS (SELECT FROM _timescaledb_internal.bgw_job_stat WHERE job_id = job_param_id AND total_failures > 0) THEN
+      RETURN true;
+    END IF;
+    PERFORM pg_sleep(0.1);
+  END LOOP;
+  RETURN false;
+END
+$BODY$;
+
+SELECT pg_advisory_lock(4242);
+SELECT add_job('custom_job_wait', schedule_interval => interval '1 hour', initial_start := now()) AS job_id_4 \gset
+SELECT wait_for_job_to_block();
+SELECT pid AS worker_pid FROM pg_locks WHERE locktype = 'advisory' AND objid = 4242 AND NOT granted \gset
+
+-- Running executions are not in the history, only in the job stats
+SELECT job_id, job_status FROM timescaledb_information.job_stats WHERE job_id = :job_id_4;
+SELECT count(*) FROM timescaledb_information.job_history WHERE job_id = :job_id_4;
+
+-- A single row is inserted when the execution ends, with the PID of the
+-- worker that ran it
+SELECT pg_advisory_unlock(4242);
+SELECT test.wait_for_job_to_run(:job_id_4, 1);
+SELECT succeeded, pid = :worker_pid AS worker_pid, finish_time IS NOT NULL AS finished, sqlerrcode, err_message
+FROM timescaledb_information.job_history
+WHERE job_id = :job_id_4
+ORDER BY id;
+
+-- Terminating the worker leaves it to the scheduler to record the failed
+-- execution, which does not know the PID of the worker
+SELECT pg_advisory_lock(4242);
+SELECT scheduled FROM alter_job(:job_id_4, next_start => now());
+SELECT wait_for_job_to_block();
+SELECT pg_terminate_backend(pid) FROM pg_locks WHERE locktype = 'advisory' AND objid = 4242 AND NOT granted;
+SELECT wait_for_job_to_fail(:job_id_4);
+SELECT pg_advisory_unlock(4242);
+
+SELECT succeeded, pid IS NULL AS no_pid, finish_time IS NOT NULL AS finished, sqlerrcode, err_message
+FROM timescaledb_information.job_history
+WHERE job_id = :job_id_4
+ORDER BY id;
+
 SELECT delete_job(:job_id_1);
 SELECT delete_job(:job_id_2);
 SELECT delete_job(:job_id_3);
+SELECT delete_job(:job_id_4);
 
 ALTER SYSTEM RESET timescaledb.enable_job_execution_logging;
 SELECT pg_reload_conf();
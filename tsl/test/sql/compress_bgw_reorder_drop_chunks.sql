@@ -161,3 +161,65 @@ SELECT indexrelid::regclass, indisclustered
     FROM pg_index
     WHERE indisclustered = true ORDER BY 1;
 
+
+------------------------------
+-- Test admission control of policy jobs. A job that is due while the
+-- limit for its class or hypertable is reached is held back and retried
+-- a second later, which is recorded in the job history.
+------------------------------
+
+\c :TEST_DBNAME :ROLE_SUPERUSER
+DELETE FROM _timescaledb_config.bgw_job WHERE TRUE;
+TRUNCATE _timescaledb_internal.bgw_job_stat;
+TRUNCATE _timescaledb_internal.bgw_job_stat_history;
+
+CREATE VIEW admission_history AS
+SELECT ht.table_name AS hypertable, j.proc_name, h.succeeded,
+       h.data->'admission'->>'deferrals' AS deferrals,
+       (h.data->'admission'->>'delay')::interval AS delay,
+       h.data->'admission'->>'last_reason' AS last_reason
+FROM _timescaledb_internal.bgw_job_stat_history h
+JOIN _timescaledb_config.bgw_job j ON j.id = h.job_id
+JOIN _timescaledb_catalog.hypertable ht ON ht.id = j.hypertable_id
+ORDER BY h.id;
+
+ALTER SYSTEM SET timescaledb.enable_job_execution_logging = on;
+ALTER SYSTEM SET timescaledb.bgw_max_concurrent_compression_jobs = 1;
+SELECT pg_reload_conf();
+
+\c :TEST_DBNAME :ROLE_DEFAULT_PERM_USER
+CREATE TABLE admission_1(time timestamptz NOT NULL, value int);
+CREATE TABLE admission_2(time timestamptz NOT NULL, value int);
+SELECT FROM create_hypertable('admission_1', 'time');
+SELECT FROM create_hypertable('admission_2', 'time');
+ALTER TABLE admission_1 SET (timescaledb.compress, timescaledb.compress_segmentby = '', timescaledb.compress_orderby = 'time DESC');
+ALTER TABLE admission_2 SET (timescaledb.compress, timescaledb.compress_segmentby = '', timescaledb.compress_orderby = 'time DESC');
+SELECT add_compression_policy('admission_1', INTERVAL '1 day') AS compress_job_1 \gset
+SELECT add_compression_policy('admission_2', INTERVAL '1 day') AS compress_job_2 \gset
+
+-- Both compression policies are due, but only one can run at a time
+SELECT ts_bgw_db_scheduler_test_run_and_wait_for_scheduler_finish(5000);
+
+\c :TEST_DBNAME :ROLE_SUPERUSER
+SELECT * FROM admission_history;
+
+-- A compression and a retention policy on the same hypertable cannot
+-- run at the same time
+ALTER SYSTEM RESET timescaledb.bgw_max_concurrent_compression_jobs;
+ALTER SYSTEM SET timescaledb.bgw_max_concurrent_jobs_per_hypertable = 1;
+SELECT pg_reload_conf();
+TRUNCATE _timescaledb_internal.bgw_job_stat;
+TRUNCATE _timescaledb_internal.bgw_job_stat_history;
+
+\c :TEST_DBNAME :ROLE_DEFAULT_PERM_USER
+SELECT scheduled FROM alter_job(:compress_job_2, scheduled => false);
+SELECT add_retention_policy('admission_1', INTERVAL '1 month') AS retention_job \gset
+
+SELECT ts_bgw_db_scheduler_test_run_and_wait_for_scheduler_finish(5000);
+
+\c :TEST_DBNAME :ROLE_SUPERUSER
+SELECT * FROM admission_history;
+
+ALTER SYSTEM RESET timescaledb.enable_job_execution_logging;
+ALTER SYSTEM RESET timescaledb.bgw_max_concurrent_jobs_per_hypertable;
+SELECT pg_reload_conf();
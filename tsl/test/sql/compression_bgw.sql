@@ -279,6 +279,58 @@ WHERE h.table_name = 'test_table_frozen'
 ORDER BY c.id
 LIMIT 1;
 
+-- test compression policy with a time budget
+CREATE TABLE test_table_budget(time TIMESTAMPTZ NOT NULL, val INT);
+SELECT table_name FROM create_hypertable('test_table_budget', 'time', chunk_time_interval => '1 day'::interval);
+ALTER TABLE test_table_budget SET (timescaledb.compress, timescaledb.compress_segmentby = 'val', timescaledb.compress_orderby = 'time');
+INSERT INTO test_table_budget
+SELECT t, 1 FROM generate_series('2020-01-01 00:00'::timestamptz, '2020-01-03 12:00'::timestamptz, '1 hour') t;
+
+SELECT add_compression_policy('test_table_budget', '1 day'::interval) AS budgetjob_id \gset
+
+-- with an empty time budget each run compresses only the oldest remaining chunk
+SELECT config->'compress_time_budget' AS budget
+FROM alter_job(:budgetjob_id, config => jsonb_set(config, '{compress_time_budget}', '"0 seconds"'));
+
+CALL run_job(:budgetjob_id);
+SELECT row_number() OVER (ORDER BY range_start) AS chunk, is_compressed
+FROM timescaledb_information.chunks WHERE hypertable_name = 'test_table_budget'
+ORDER BY range_start;
+
+CALL run_job(:budgetjob_id);
+SELECT row_number() OVER (ORDER BY range_start) AS chunk, is_compressed
+FROM timescaledb_information.chunks WHERE hypertable_name = 'test_table_budget'
+ORDER BY range_start;
+
+SELECT remove_compression_policy('test_table_budget');
+DROP TABLE test_table_budget;
+
+-- test compression policy with maxchunks_to_compress
+CREATE TABLE test_table_maxchunks(time TIMESTAMPTZ NOT NULL, val INT);
+SELECT table_name FROM create_hypertable('test_table_maxchunks', 'time', chunk_time_interval => '1 day'::interval);
+ALTER TABLE test_table_maxchunks SET (timescaledb.compress, timescaledb.compress_segmentby = 'val', timescaledb.compress_orderby = 'time');
+INSERT INTO test_table_maxchunks
+SELECT t, 1 FROM generate_series('2020-01-01 00:00'::timestamptz, '2020-01-04 12:00'::timestamptz, '1 hour') t;
+
+SELECT add_compression_policy('test_table_maxchunks', '1 day'::interval) AS maxchunksjob_id \gset
+
+-- each run compresses at most two chunks, oldest first
+SELECT config->'maxchunks_to_compress' AS maxchunks
+FROM alter_job(:maxchunksjob_id, config => jsonb_set(config, '{maxchunks_to_compress}', '2'));
+
+CALL run_job(:maxchunksjob_id);
+SELECT row_number() OVER (ORDER BY range_start) AS chunk, is_compressed
+FROM timescaledb_information.chunks WHERE hypertable_name = 'test_table_maxchunks'
+ORDER BY range_start;
+
+CALL run_job(:maxchunksjob_id);
+SELECT row_number() OVER (ORDER BY range_start) AS chunk, is_compressed
+FROM timescaledb_information.chunks WHERE hypertable_name = 'test_table_maxchunks'
+ORDER BY range_start;
+
+SELECT remove_compression_policy('test_table_maxchunks');
+DROP TABLE test_table_maxchunks;
+
 -- Teardown test
 \c :TEST_DBNAME :ROLE_SUPERUSER
 REVOKE CREATE ON SCHEMA public FROM NOLOGIN_ROLE;
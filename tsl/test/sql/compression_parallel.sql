@@ -0,0 +1,46 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Compression of a chunk by segmentby partitions in parallel workers
+SET timescaledb.debug_compression_path_info = on;
+CREATE TABLE cp(ts int NOT NULL, device int, tag text, value float8);
+SELECT FROM create_hypertable('cp', 'ts', chunk_time_interval => 1000);
+ALTER TABLE cp SET (timescaledb.compress, timescaledb.compress_segmentby = 'device, tag',
+    timescaledb.compress_orderby = 'ts');
+INSERT INTO cp SELECT t, t % 17, 'tag' || (t % 5), t * 0.5 FROM generate_series(1, 4999) t;
+CREATE TABLE cp_ref AS SELECT * FROM cp;
+
+SET max_parallel_maintenance_workers = 4;
+SET timescaledb.compress_chunk_parallel_workers = 4;
+SELECT count(compress_chunk(ch)) FROM show_chunks('cp') ch;
+RESET timescaledb.debug_compression_path_info;
+
+-- The compressed chunks contain exactly the original rows
+SELECT count(*) FROM (SELECT * FROM cp EXCEPT ALL SELECT * FROM cp_ref) missing;
+SELECT count(*) FROM (SELECT * FROM cp_ref EXCEPT ALL SELECT * FROM cp) extra;
+SELECT device, tag, count(*), sum(value) FROM cp GROUP BY 1, 2 ORDER BY 1, 2 LIMIT 5;
+
+-- Every segmentby group is compressed by a single worker, so the batches are
+-- the same as with serial compression
+SELECT sum(numrows_pre_compression) numrows_pre_compression,
+    sum(numrows_post_compression) numrows_post_compression
+FROM _timescaledb_catalog.compression_chunk_size;
+SELECT count(decompress_chunk(ch)) FROM show_chunks('cp') ch;
+
+-- The chunk is partitioned by the number of requested workers
+SET timescaledb.compress_chunk_parallel_workers = 2;
+SET timescaledb.debug_compression_path_info = on;
+SELECT compress_chunk('_timescaledb_internal._hyper_1_1_chunk');
+RESET timescaledb.debug_compression_path_info;
+SELECT decompress_chunk('_timescaledb_internal._hyper_1_1_chunk');
+
+RESET timescaledb.compress_chunk_parallel_workers;
+SELECT count(compress_chunk(ch)) FROM show_chunks('cp') ch;
+SELECT sum(numrows_pre_compression) numrows_pre_compression,
+    sum(numrows_post_compression) numrows_post_compression
+FROM _timescaledb_catalog.compression_chunk_size;
+
+RESET max_parallel_maintenance_workers;
+DROP TABLE cp;
+DROP TABLE cp_ref;
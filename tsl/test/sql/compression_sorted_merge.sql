@@ -636,3 +636,37 @@ VALUES  (109288, '2023-05-25 23:12:13.000000', 130, 14499, 13, 0.132165698840012
 SELECT compress_chunk(show_chunks('test', older_than => INTERVAL '1 week'), true);
 
 SELECT t.dttm FROM test t WHERE t.dttm > '2023-05-25T14:23:12' ORDER BY t.dttm;
+
+-- Batches that start after the current merge position are only decompressed
+-- when the output reaches their start, so under a LIMIT that is reached in
+-- the first batch, the other batches are never decompressed. Each device has
+-- its own time range here, so the batches don't overlap.
+CREATE TABLE deferred_batches(time int NOT NULL, device int NOT NULL, value int);
+SELECT FROM create_hypertable('deferred_batches', 'time', chunk_time_interval => 100000);
+INSERT INTO deferred_batches SELECT t, t / 1000, t FROM generate_series(0, 9999) t;
+ALTER TABLE deferred_batches SET (timescaledb.compress,
+    timescaledb.compress_segmentby = 'device', timescaledb.compress_orderby = 'time');
+SELECT count(compress_chunk(x)) FROM show_chunks('deferred_batches') x;
+ANALYZE deferred_batches;
+
+CREATE FUNCTION explain_decompressed_batches(query text) RETURNS SETOF text LANGUAGE plpgsql AS
+$$
+DECLARE
+    line text;
+BEGIN
+    FOR line IN EXECUTE 'EXPLAIN (analyze, verbose, costs off, timing off, summary off, decompress_stats) ' || query
+    LOOP
+        IF line ~ 'Batch Sorted Merge|Column ' THEN
+            RETURN NEXT regexp_replace(btrim(line), 'bytes=\d+', 'bytes=N');
+        END IF;
+    END LOOP;
+END;
+$$;
+
+SELECT explain_decompressed_batches('SELECT * FROM deferred_batches ORDER BY time LIMIT 10');
+SELECT explain_decompressed_batches('SELECT * FROM deferred_batches ORDER BY time LIMIT 1010');
+SELECT * FROM deferred_batches ORDER BY time LIMIT 3;
+SELECT * FROM deferred_batches ORDER BY time OFFSET 999 LIMIT 3;
+
+DROP FUNCTION explain_decompressed_batches;
+DROP TABLE deferred_batches;
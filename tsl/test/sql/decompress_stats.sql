@@ -0,0 +1,87 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+create table dstats(t int not null, s int, x int, v text);
+select create_hypertable('dstats', 't', chunk_time_interval => 1000);
+insert into dstats select t, t % 3, t % 100, 'v' || t % 7 from generate_series(1, 3000) t;
+alter table dstats set (timescaledb.compress, timescaledb.compress_orderby = 't',
+    timescaledb.compress_segmentby = 's');
+select count(compress_chunk(x)) from show_chunks('dstats') x;
+analyze dstats;
+
+set max_parallel_workers_per_gather = 0;
+set timescaledb.enable_vectorized_aggregation to off;
+
+-- The session statistics are only collected when enabled.
+select _timescaledb_functions.session_decompression_stats_reset();
+select count(*), sum(x) from dstats where x > 50;
+select count(*), sum(count) from timescaledb_information.session_decompression_stats;
+
+set timescaledb.enable_decompression_stats to on;
+select count(*), sum(x) from dstats where x > 50;
+select kind, name, count > 0 as counted, bytes > 0 as has_bytes
+from timescaledb_information.session_decompression_stats
+order by kind, name;
+
+select _timescaledb_functions.session_decompression_stats_reset();
+select count(*), sum(count) from timescaledb_information.session_decompression_stats;
+reset timescaledb.enable_decompression_stats;
+
+-- The per-node statistics in EXPLAIN. The timings are not shown with
+-- TIMING OFF, and we mask the numbers that depend on the compressed sizes.
+create function explain_stats(query text) returns setof text language plpgsql as
+$$
+declare
+    line text;
+begin
+    for line in execute 'explain (analyze, costs off, timing off, summary off, decompress_stats) ' || query
+    loop
+        if line ~ 'Decompression|Algorithm' then
+            return next regexp_replace(btrim(line), '\d+', 'N', 'g');
+        end if;
+    end loop;
+end;
+$$;
+
+select explain_stats('select sum(x) from dstats where t < 1000 and x > 50');
+
+-- With the decompression cost statistics, the number of rows per batch is
+-- estimated from the statistics of the compressed chunk instead of assuming
+-- full batches, and the estimates are shown by the decompress_stats option.
+create table dcost(t int not null, s int, x int);
+select create_hypertable('dcost', 't', chunk_time_interval => 100000);
+insert into dcost select t, t % 100, t % 7 from generate_series(1, 1000) t;
+alter table dcost set (timescaledb.compress, timescaledb.compress_orderby = 't',
+    timescaledb.compress_segmentby = 's');
+select count(compress_chunk(x)) from show_chunks('dcost') x;
+analyze dcost;
+
+create function explain_cost_stats(query text) returns setof text language plpgsql as
+$$
+declare
+    line text;
+begin
+    for line in execute 'explain (decompress_stats) ' || query
+    loop
+        if line ~ 'DecompressChunk' then
+            return next substring(line from 'rows=\d+');
+        elsif line ~ 'Estimated' then
+            return next regexp_replace(btrim(line), 'Cost: [0-9.]+', 'Cost: N');
+        end if;
+    end loop;
+end;
+$$;
+
+select explain_cost_stats('select * from dcost');
+set timescaledb.enable_decompression_cost_stats to on;
+select explain_cost_stats('select * from dcost');
+reset timescaledb.enable_decompression_cost_stats;
+
+-- The statistics are local to the session, so a new session starts without
+-- them. Reconnecting also resets the settings.
+set timescaledb.enable_decompression_stats to on;
+select count(*), sum(x) from dstats where x > 50;
+select sum(count) > 0 as collected from timescaledb_information.session_decompression_stats;
+\c
+select count(*), sum(count) from timescaledb_information.session_decompression_stats;
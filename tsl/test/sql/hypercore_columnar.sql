@@ -136,3 +136,47 @@ $$, :'chunk'));
 drop table readings;
 drop table saved;
 
+-- Test that each columnar scan only decompresses the columns that it
+-- references, even when other scans of the same relation in the query
+-- reference other columns.
+reset timescaledb.enable_columnarscan;
+set max_parallel_workers_per_gather to 0;
+
+create table wide(t int not null, device int, a int, b int, c int, d int);
+select create_hypertable('wide', 't', chunk_time_interval => 1000);
+insert into wide select t, t % 3, t, t * 2, t * 3, t * 4 from generate_series(1, 300) t;
+alter table wide set (
+      timescaledb.compress,
+      timescaledb.compress_orderby = 't',
+      timescaledb.compress_segmentby = 'device'
+);
+select show_chunks('wide') as wide_chunk \gset
+alter table :wide_chunk set access method hypercore;
+
+create function decompress_count(query text) returns text language plpgsql as
+$$
+declare
+    line text;
+begin
+    for line in execute
+        'explain (analyze, costs off, timing off, summary off, decompress_cache_stats) ' || query
+    loop
+        if line ~ '^Array:' then
+            return substring(line from 'count=\d+');
+        end if;
+    end loop;
+    return null;
+end;
+$$;
+
+-- One column for each of the three segments.
+select decompress_count(format('select a from %s', :'wide_chunk'));
+-- Two columns for each segment in each of the two scans.
+select decompress_count(format('select x.a, y.b from %1$s x join %1$s y on x.t = y.t',
+       :'wide_chunk'));
+select sum(x.a), sum(y.b)
+from :wide_chunk x join :wide_chunk y on x.t = y.t;
+
+reset max_parallel_workers_per_gather;
+drop table wide;
+drop function decompress_count(text);
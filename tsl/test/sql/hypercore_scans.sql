@@ -67,9 +67,21 @@ explain (analyze, costs off, timing off, summary off, decopress_cache_stats)
 select * from :chunk where device between 5 and 10;
 \set ON_ERROR_STOP 1
 
+-- Filter the rows in the index scans rather than with vectorized
+-- quals in the TAM, so that the rows removed by the filter are shown.
+set timescaledb.enable_hypercore_index_vector_quals to off;
 explain (analyze, costs off, timing off, summary off, decompress_cache_stats)
 select time, temp + humidity from readings where device between 5 and 10 and humidity > 5;
 
+-- With vectorized quals in index scans, the compressed rows that do
+-- not pass the filter are never returned by the TAM, so they are not
+-- counted as removed by the filter.
+set timescaledb.enable_hypercore_index_vector_quals to on;
+explain (analyze, costs off, timing off, summary off)
+select time, temp + humidity from readings where device between 5 and 10 and humidity > 5;
+select count(*) from readings where device between 5 and 10 and humidity > 5;
+set timescaledb.enable_hypercore_index_vector_quals to off;
+
 -- Testing JSON format to make sure it works and to get coverage for
 -- those parts of the code.
 explain (analyze, costs off, timing off, summary off, decompress_cache_stats, format json)
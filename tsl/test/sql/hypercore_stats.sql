@@ -141,3 +141,52 @@ analyze :hypertable;
 select * from relstats where relid = :'chunk2'::regclass;
 -- Just show that there are attrstats via a count avoid flaky output
 select count(*) from attrstats where relid = :'chunk2'::regclass;
+
+--
+-- Test the size estimate used to plan the number of workers for a
+-- parallel index build. Most of the compressed data is stored in the
+-- TOAST table of the compressed relation, so the estimate includes the
+-- TOAST pages in this case, while the query plans still use the
+-- relstats.
+--
+create table estimate(time int not null, device int, temp float8, humidity float8);
+select from create_hypertable('estimate', 'time', chunk_time_interval => 100000);
+insert into estimate
+select t, t % 10, sin(t) * 100, cos(t) * 100 from generate_series(1, 10000) t;
+alter table estimate set (
+	  timescaledb.compress,
+	  timescaledb.compress_orderby = 'time',
+	  timescaledb.compress_segmentby = 'device'
+);
+select show_chunks('estimate') as estimate_chunk \gset
+alter table :estimate_chunk set access method hypercore;
+alter table :estimate_chunk rename to estimate_chunk;
+analyze _timescaledb_internal.estimate_chunk;
+
+create function explain_rows(query text) returns text language plpgsql as
+$$
+declare
+    line text;
+begin
+    for line in execute 'explain ' || query loop
+        return substring(line from 'rows=\d+');
+    end loop;
+end;
+$$;
+
+select reltuples from pg_class where oid = '_timescaledb_internal.estimate_chunk'::regclass;
+select explain_rows('select * from _timescaledb_internal.estimate_chunk');
+
+set min_parallel_table_scan_size to '64kB';
+set max_parallel_maintenance_workers to 1;
+set maintenance_work_mem to '256MB';
+set client_min_messages to debug1;
+create index estimate_chunk_temp_idx on _timescaledb_internal.estimate_chunk (temp);
+reset client_min_messages;
+reset maintenance_work_mem;
+reset max_parallel_maintenance_workers;
+reset min_parallel_table_scan_size;
+
+select count(*) from _timescaledb_internal.estimate_chunk where temp > 50;
+drop table estimate;
+drop function explain_rows(text);
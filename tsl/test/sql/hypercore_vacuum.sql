@@ -259,3 +259,45 @@ alter table readings
       	   timescaledb.compress_segmentby = 'device');
 
 vacuum analyze readings;
+
+-- Test that vacuum removes the index entries that point into dead
+-- compressed segments. The entries of a segment are spread out over
+-- the "temp" index and all of them have to be removed.
+create table segvac(time timestamptz not null, location int, device int, temp float4);
+select from create_hypertable('segvac', 'time', create_default_indexes => false);
+alter table segvac set access method hypercore, set (
+      timescaledb.compress_orderby = 'time',
+      timescaledb.compress_segmentby = 'location'
+);
+insert into segvac (time, location, device, temp)
+select '2022-06-01'::timestamptz + t * interval '1 minute', t % 4, t % 10, t
+from generate_series(1, 1000) t;
+create index segvac_temp_idx on segvac (temp);
+create index segvac_device_idx on segvac (device);
+select count(compress_chunk(ch)) from show_chunks('segvac') ch;
+
+select indexrelid::regclass as segvac_temp_chunk_idx
+from pg_index i inner join pg_class c on (i.indexrelid=c.oid)
+where indrelid = (select ch from show_chunks('segvac') ch)
+and relname like '%temp%' \gset
+
+select tuple_count from pgstattuple(:'segvac_temp_chunk_idx');
+
+-- Avoid index scans that could mark the index entries as dead before
+-- vacuum removes them.
+set enable_indexscan to off;
+set enable_bitmapscan to off;
+delete from segvac where location = 1;
+select count(*) from segvac;
+select tuple_count > 750 as has_dead_entries from pgstattuple(:'segvac_temp_chunk_idx');
+reset enable_indexscan;
+reset enable_bitmapscan;
+
+vacuum (index_cleanup on) segvac;
+select tuple_count from pgstattuple(:'segvac_temp_chunk_idx');
+
+set enable_seqscan to off;
+select count(*) from segvac where temp > 500;
+select count(*) from segvac where device = 1;
+reset enable_seqscan;
+drop table segvac;
@@ -0,0 +1,120 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+create table rjf(t int not null, s int, x int);
+select create_hypertable('rjf', 't', chunk_time_interval => 1000);
+insert into rjf select t, t % 5, t % 100 from generate_series(1, 3000) t;
+alter table rjf set (timescaledb.compress, timescaledb.compress_orderby = 't',
+    timescaledb.compress_segmentby = 's');
+select count(compress_chunk(x)) from show_chunks('rjf') x;
+analyze rjf;
+
+create table dim(id int, v int);
+insert into dim values (5, 1), (1500, 7), (2999, 1), (4000, 42);
+create table empty_dim(id int);
+analyze dim;
+analyze empty_dim;
+
+set max_parallel_workers_per_gather = 0;
+set enable_mergejoin to off;
+set enable_nestloop to off;
+
+-- The results must be the same as without the runtime join filters, no matter
+-- whether the filters are used on the orderby, segmentby or other compressed
+-- columns.
+set timescaledb.enable_runtime_join_filter to on;
+select count(*), sum(x) from rjf join dim on rjf.t = dim.id;
+select count(*), sum(x) from rjf join dim on rjf.s = dim.v;
+select count(*), sum(t) from rjf join dim on rjf.x = dim.v;
+select count(*) from rjf where t in (select id from dim);
+select count(*) from rjf join empty_dim on rjf.t = empty_dim.id;
+
+-- With many inner keys, the bloom filter is used instead of the exact key set.
+create table big_dim as select generate_series(1, 200000, 2) id;
+analyze big_dim;
+select count(*), sum(x) from rjf join big_dim on rjf.t = big_dim.id;
+
+-- The filters are not used for the joins that return the outer rows without
+-- a match.
+select count(*) from rjf left join dim on rjf.t = dim.id;
+select count(*) from rjf where t not in (select id from dim);
+
+-- On rescan, the hash join might read the first outer tuple before it rebuilds
+-- the filter for the new parameter values, so the outer side must not use the
+-- filter left over from the previous execution. Here, it would remove the
+-- batches with the rows matching the next group.
+create table dim_grp(id int, grp int);
+insert into dim_grp values (2005, 1), (5, 2), (1500, 3), (7, 3);
+analyze dim_grp;
+select grp, (select count(*) from rjf join dim_grp on rjf.t = dim_grp.id
+    where dim_grp.grp = g.grp)
+from generate_series(1, 3) g(grp) order by grp;
+select grp, l.count from generate_series(1, 3) g(grp),
+    lateral (select count(*) from rjf join dim_grp on rjf.t = dim_grp.id
+        where dim_grp.grp = g.grp) l
+order by grp;
+
+set timescaledb.enable_runtime_join_filter to off;
+select count(*), sum(x) from rjf join dim on rjf.t = dim.id;
+select count(*), sum(x) from rjf join dim on rjf.s = dim.v;
+select count(*), sum(t) from rjf join dim on rjf.x = dim.v;
+select count(*) from rjf where t in (select id from dim);
+
+-- Show the runtime filter node and the batches it removes. The number of
+-- removed batches is not shown, because the first batch might be read before
+-- the hash table is built.
+create function explain_runtime_filter(query text) returns setof text
+language plpgsql as
+$$
+declare
+    line text;
+begin
+    for line in execute
+        'explain (analyze, verbose, costs off, timing off, summary off) ' || query
+    loop
+        if line ~ 'RuntimeFilter|Runtime Join Filters|Batches Removed by Filter' then
+            return next substring(line from
+                'Custom Scan \(RuntimeFilter\)|Runtime Join Filters: \d+|Batches Removed by Filter');
+        end if;
+    end loop;
+end;
+$$;
+
+set timescaledb.enable_runtime_join_filter to on;
+select explain_runtime_filter('select rjf.x from rjf join dim on rjf.s = dim.v');
+
+-- The non-integer join keys use the comparison and hash functions of the type.
+create table rjf_text(t int not null, device text, x int);
+select create_hypertable('rjf_text', 't', chunk_time_interval => 1000);
+insert into rjf_text select t, 'd' || t % 5, t % 100 from generate_series(1, 3000) t;
+alter table rjf_text set (timescaledb.compress, timescaledb.compress_orderby = 't',
+    timescaledb.compress_segmentby = 'device');
+select count(compress_chunk(x)) from show_chunks('rjf_text') x;
+analyze rjf_text;
+
+create table dim_text(device text);
+insert into dim_text values ('d1'), ('d3'), ('d9');
+analyze dim_text;
+
+select explain_runtime_filter('select rjf_text.x from rjf_text
+    join dim_text on rjf_text.device = dim_text.device');
+select count(*), sum(x) from rjf_text join dim_text on rjf_text.device = dim_text.device;
+
+set timescaledb.enable_runtime_join_filter to off;
+select explain_runtime_filter('select rjf_text.x from rjf_text
+    join dim_text on rjf_text.device = dim_text.device');
+select count(*), sum(x) from rjf_text join dim_text on rjf_text.device = dim_text.device;
+
+reset timescaledb.enable_runtime_join_filter;
+reset enable_mergejoin;
+reset enable_nestloop;
+reset max_parallel_workers_per_gather;
+drop table rjf;
+drop table dim;
+drop table empty_dim;
+drop table big_dim;
+drop table rjf_text;
+drop table dim_text;
+drop table dim_grp;
+drop function explain_runtime_filter(text);
@@ -0,0 +1,84 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+create table acd(t int not null, s int, g int, i2 smallint, i4 int, i8 bigint, f8 float8, txt text);
+select create_hypertable('acd', 't', chunk_time_interval => 3000);
+insert into acd select t, t % 3, t % 4, t % 1000, (t * 7919) % 20011, t / 2,
+    case when t % 11 = 0 then null else (t % 500) / 4.0 end, 'v' || (t % 300)
+from generate_series(0, 29999) t;
+alter table acd set (timescaledb.compress, timescaledb.compress_orderby = 't',
+    timescaledb.compress_segmentby = 's');
+select count(compress_chunk(x)) from show_chunks('acd') x;
+analyze acd;
+set max_parallel_workers_per_gather = 0;
+
+-- The estimates depend on the hash function, which is UMASH or the PostgreSQL
+-- one depending on the build, so we only check that they are close to the exact
+-- numbers of the distinct values. With 4096 registers, the standard error is
+-- about 1.6%.
+create function acd_close(estimate bigint, exact bigint) returns bool
+language sql immutable as 'select abs(estimate - exact) <= 0.05 * exact + 1';
+
+-- The approx_count_distinct() of the fixed-width and text columns, including the
+-- dictionary-encoded ones and the segmentby columns, is computed by the
+-- vectorized aggregation with both the batch and the hash grouping.
+set timescaledb.debug_require_vector_agg = 'require';
+create table acd_vec_total as
+select approx_count_distinct(i2) i2, approx_count_distinct(i4) i4, approx_count_distinct(i8) i8,
+    approx_count_distinct(f8) f8, approx_count_distinct(txt) txt, approx_count_distinct(s) s
+from acd;
+create table acd_vec_g as
+select g, approx_count_distinct(i4) i4, approx_count_distinct(txt) txt from acd group by g;
+create table acd_vec_s as
+select s, approx_count_distinct(f8) f8 from acd where t < 10000 group by s;
+
+-- The same estimates without the vectorized aggregation.
+set timescaledb.enable_vectorized_aggregation to off;
+set timescaledb.debug_require_vector_agg = 'forbid';
+create table acd_row_total as
+select approx_count_distinct(i2) i2, approx_count_distinct(i4) i4, approx_count_distinct(i8) i8,
+    approx_count_distinct(f8) f8, approx_count_distinct(txt) txt, approx_count_distinct(s) s
+from acd;
+create table acd_row_g as
+select g, approx_count_distinct(i4) i4, approx_count_distinct(txt) txt from acd group by g;
+create table acd_row_s as
+select s, approx_count_distinct(f8) f8 from acd where t < 10000 group by s;
+
+select count(*) from (select * from acd_vec_total except select * from acd_row_total) d;
+select count(*) from (select * from acd_vec_g except select * from acd_row_g) d;
+select count(*) from (select * from acd_vec_s except select * from acd_row_s) d;
+
+-- Compare the estimates to the exact numbers of the distinct values.
+select count(distinct i2) i2, count(distinct i4) i4, count(distinct i8) i8,
+    count(distinct f8) f8, count(distinct txt) txt, count(distinct s) s
+from acd;
+select acd_close(v.i2, e.i2) i2, acd_close(v.i4, e.i4) i4, acd_close(v.i8, e.i8) i8,
+    acd_close(v.f8, e.f8) f8, acd_close(v.txt, e.txt) txt, acd_close(v.s, e.s) s
+from acd_vec_total v, (select count(distinct i2) i2, count(distinct i4) i4,
+    count(distinct i8) i8, count(distinct f8) f8, count(distinct txt) txt,
+    count(distinct s) s from acd) e;
+select g, acd_close(v.i4, e.i4) i4, acd_close(v.txt, e.txt) txt
+from acd_vec_g v join (select g, count(distinct i4) i4, count(distinct txt) txt
+    from acd group by g) e using (g)
+order by g;
+select s, acd_close(v.f8, e.f8) f8
+from acd_vec_s v join (select s, count(distinct f8) f8 from acd where t < 10000 group by s) e
+    using (s)
+order by s;
+-- No rows.
+select approx_count_distinct(i4) from acd where t < 0;
+
+reset timescaledb.enable_vectorized_aggregation;
+reset timescaledb.debug_require_vector_agg;
+
+-- The aggregate can be used in continuous aggregates.
+create function acd_now() returns int language sql stable as 'select 30000';
+select set_integer_now_func('acd', 'acd_now');
+create materialized view acd_cagg with (timescaledb.continuous, timescaledb.materialized_only = true) as
+select time_bucket(3000, t) b, approx_count_distinct(i4) i4 from acd group by 1 with no data;
+call refresh_continuous_aggregate('acd_cagg', null, null);
+select b, acd_close(c.i4, e.i4) i4
+from acd_cagg c join (select time_bucket(3000, t) b, count(distinct i4) i4 from acd group by 1) e
+    using (b)
+order by b;
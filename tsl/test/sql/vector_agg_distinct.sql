@@ -0,0 +1,58 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+create table vd(t int not null, s int, d int, x int);
+select create_hypertable('vd', 't', chunk_time_interval => 1000);
+insert into vd select t, t % 5, t % 7, t from generate_series(0, 9999) t;
+alter table vd set (timescaledb.compress, timescaledb.compress_orderby = 't',
+    timescaledb.compress_segmentby = 's');
+select count(compress_chunk(x)) from show_chunks('vd') x;
+analyze vd;
+set max_parallel_workers_per_gather = 0;
+set timescaledb.enable_skipscan to off;
+
+-- DISTINCT and GROUP BY without aggregate functions are computed by the
+-- vectorized aggregation. The deduplication by segmentby columns emits one row
+-- per compressed batch.
+set timescaledb.debug_require_vector_agg = 'require';
+select distinct s from vd order by s;
+select distinct d from vd order by d;
+select distinct s from vd where x < 3 order by s;
+select d from vd group by d order by d;
+
+-- The same results without the vectorized aggregation.
+set timescaledb.enable_vectorized_aggregation to off;
+set timescaledb.debug_require_vector_agg = 'forbid';
+select distinct s from vd order by s;
+select distinct d from vd order by d;
+select d from vd group by d order by d;
+
+reset timescaledb.enable_vectorized_aggregation;
+reset timescaledb.debug_require_vector_agg;
+reset timescaledb.enable_skipscan;
+
+-- The pushdown of the grouping without aggregates is only planned for the
+-- hypertables with compressed chunks.
+create function plan_summary(query text) returns table(vector_agg bool, finalize_agg bool)
+language plpgsql as $$
+declare
+    line text;
+    plan text := '';
+begin
+    for line in execute 'explain (costs off) ' || query loop
+        plan := plan || line || E'\n';
+    end loop;
+    return query select plan ~ 'VectorAgg', plan ~ 'Finalize';
+end;
+$$;
+
+select * from plan_summary('select distinct s from vd');
+select * from plan_summary('select d from vd group by d');
+
+create table vd_plain(t int not null, s int, d int, x int);
+select from create_hypertable('vd_plain', 't', chunk_time_interval => 1000);
+insert into vd_plain select * from vd;
+analyze vd_plain;
+select * from plan_summary('select distinct s from vd_plain');
+select * from plan_summary('select d from vd_plain group by d');
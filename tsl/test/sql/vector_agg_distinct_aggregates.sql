@@ -0,0 +1,60 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+create table vc(t int not null, s int, x int);
+select create_hypertable('vc', 't', chunk_time_interval => 1000);
+insert into vc select t, t % 4, case when t % 17 = 0 then null else (t * 7) % 1009 end
+from generate_series(0, 5999) t;
+alter table vc set (timescaledb.compress, timescaledb.compress_orderby = 't',
+    timescaledb.compress_segmentby = 's');
+select count(compress_chunk(x)) from show_chunks('vc') x;
+analyze vc;
+set max_parallel_workers_per_gather = 0;
+
+-- The argument of DISTINCT aggregates is deduplicated in the chunks by the
+-- vectorized grouping.
+set timescaledb.debug_require_vector_agg = 'require';
+select count(distinct x) from vc;
+select count(distinct x), sum(distinct x), max(distinct x) from vc where t > 3500;
+select count(distinct x) from vc where s = 1 and t < 1500;
+
+-- With grouping, the deduplication is a vectorized grouping by the grouping
+-- columns and the argument. The grouping by several columns is only vectorized
+-- with the UMASH hashing, which is not available on all platforms.
+reset timescaledb.debug_require_vector_agg;
+create function has_vector_agg(query text) returns bool language plpgsql as
+$$
+declare
+    line text;
+begin
+    for line in execute 'explain (costs off) ' || query
+    loop
+        if line ~ 'VectorAgg' then
+            return true;
+        end if;
+    end loop;
+    return false;
+end;
+$$;
+select case when has_vector_agg('select t, x, count(*) from vc group by t, x')
+    then 'require' else 'allow' end guc_value
+\gset
+set timescaledb.debug_require_vector_agg = :'guc_value';
+select s, count(distinct x), sum(distinct x) from vc where t < 2500 group by s order by s;
+
+-- A single chunk has nothing to push the deduplication down to.
+reset timescaledb.debug_require_vector_agg;
+select s, count(distinct x) from vc where t < 500 group by s order by s;
+
+-- The same results without the vectorized aggregation.
+set timescaledb.enable_vectorized_aggregation to off;
+set timescaledb.debug_require_vector_agg = 'forbid';
+select count(distinct x) from vc;
+select count(distinct x), sum(distinct x), max(distinct x) from vc where t > 3500;
+select count(distinct x) from vc where s = 1 and t < 1500;
+select s, count(distinct x), sum(distinct x) from vc where t < 2500 group by s order by s;
+select s, count(distinct x) from vc where t < 500 group by s order by s;
+
+reset timescaledb.enable_vectorized_aggregation;
+reset timescaledb.debug_require_vector_agg;
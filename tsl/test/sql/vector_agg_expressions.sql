@@ -0,0 +1,42 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+create table ve(t int not null, s int, a int, b bigint, f float8);
+select create_hypertable('ve', 't', chunk_time_interval => 1000);
+insert into ve
+select t, t % 3, case when t % 13 = 0 then null else t % 100 end, t * 10,
+    case when t % 11 = 0 then null else t * 0.25 end
+from generate_series(0, 4999) t;
+alter table ve set (timescaledb.compress, timescaledb.compress_orderby = 't',
+    timescaledb.compress_segmentby = 's');
+select count(compress_chunk(x)) from show_chunks('ve') x;
+analyze ve;
+set max_parallel_workers_per_gather = 0;
+
+-- Arithmetic expressions over the columns as the aggregate function arguments
+-- are computed by the vectorized aggregation.
+set timescaledb.debug_require_vector_agg = 'require';
+select sum(a + b) from ve;
+select s, max(abs(a - 30)) from ve group by s order by s;
+select sum(f * 4), min(-f) from ve;
+select sum(s * a) from ve where t < 500;
+
+-- The errors are reported only for the rows that pass the filters.
+select sum(100 / a) from ve where a > 0;
+select sum(100 / a) filter (where a > 0), count(a / 3) from ve;
+select sum(a / (a - a)) from ve;
+select sum(a * 1000000000) from ve;
+
+-- The same results without the vectorized aggregation.
+set timescaledb.enable_vectorized_aggregation to off;
+set timescaledb.debug_require_vector_agg = 'forbid';
+select sum(a + b) from ve;
+select s, max(abs(a - 30)) from ve group by s order by s;
+select sum(f * 4), min(-f) from ve;
+select sum(s * a) from ve where t < 500;
+select sum(100 / a) from ve where a > 0;
+select sum(100 / a) filter (where a > 0), count(a / 3) from ve;
+
+reset timescaledb.enable_vectorized_aggregation;
+reset timescaledb.debug_require_vector_agg;
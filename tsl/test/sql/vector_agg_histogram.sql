@@ -0,0 +1,42 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+create table hvagg(t int not null, s int, sf float8, g int, x float8);
+select create_hypertable('hvagg', 't', chunk_time_interval => 1000);
+insert into hvagg select t, t % 3, (t % 3) * 2.5, t % 5,
+    case when t % 7 = 0 then null else (t % 100) / 10.0 end
+from generate_series(1, 2999) t;
+alter table hvagg set (timescaledb.compress, timescaledb.compress_orderby = 't',
+    timescaledb.compress_segmentby = 's, sf');
+select count(compress_chunk(x)) from show_chunks('hvagg') x;
+analyze hvagg;
+set max_parallel_workers_per_gather = 0;
+
+-- The histogram() of a float8 column is computed by the vectorized aggregation,
+-- with both the batch and the hash grouping. The null values are read as 0.0,
+-- like in the row-based histogram().
+set timescaledb.debug_require_vector_agg = 'require';
+select histogram(x, 1, 8, 7) from hvagg;
+select histogram(x, 0, 10, 4) from hvagg where t < 1500;
+select histogram(x, 0, 10, 2) from hvagg where x = 7::float8;
+select s, histogram(x, 2, 6, 4) from hvagg group by s order by s;
+select g, histogram(x, 0, 9.9, 3) from hvagg group by g order by g;
+select g, histogram(sf, 0, 5, 2) from hvagg group by g order by g;
+select g, histogram(x, 0, 10, 2) from hvagg where x > 0.5::float8 group by g order by g;
+
+\set ON_ERROR_STOP 0
+select histogram(x, 5, 1, 3) from hvagg;
+select histogram(x, 1, 1, 3) from hvagg;
+\set ON_ERROR_STOP 1
+
+-- The same results without the vectorized aggregation.
+set timescaledb.enable_vectorized_aggregation to off;
+set timescaledb.debug_require_vector_agg = 'forbid';
+select histogram(x, 1, 8, 7) from hvagg;
+select g, histogram(x, 0, 9.9, 3) from hvagg group by g order by g;
+select g, histogram(sf, 0, 5, 2) from hvagg group by g order by g;
+select g, histogram(x, 0, 10, 2) from hvagg where x > 0.5::float8 group by g order by g;
+
+reset timescaledb.enable_vectorized_aggregation;
+reset timescaledb.debug_require_vector_agg;
@@ -0,0 +1,67 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+create table mvagg(t int not null, s int, x int);
+select create_hypertable('mvagg', 't', chunk_time_interval => 1000);
+insert into mvagg select t, t % 3, t % 10 from generate_series(1, 3000) t;
+alter table mvagg set (timescaledb.compress, timescaledb.compress_orderby = 't',
+    timescaledb.compress_segmentby = 's');
+select count(compress_chunk(x)) from show_chunks('mvagg') x;
+analyze mvagg;
+set max_parallel_workers_per_gather = 0;
+
+-- The number of batches aggregated from their metadata is shown by EXPLAIN
+-- ANALYZE for each VectorAgg node.
+create function metadata_batches(query text) returns bigint language plpgsql as
+$$
+declare
+    line text;
+    total bigint = 0;
+begin
+    for line in execute 'explain (analyze, costs off, timing off, summary off) ' || query
+    loop
+        if line ~ 'Batches Aggregated from Metadata' then
+            total = total + substring(line from '\d+')::bigint;
+        end if;
+    end loop;
+    return total;
+end;
+$$;
+
+-- The batches where the metadata shows that all rows pass the filters are
+-- aggregated using only the metadata. The results must be the same as with
+-- the normal vectorized aggregation.
+set timescaledb.debug_require_vector_agg = 'require';
+
+set timescaledb.enable_batch_metadata_aggregation to on;
+select count(*), min(t), max(t) from mvagg;
+select count(*), min(t), max(t) from mvagg where t < 1500;
+select s, count(*), min(t), max(t), sum(s) from mvagg where t >= 1000 and t <= 2500
+    group by s order by s;
+select s, count(*), min(t), max(t), sum(s) from mvagg where t > 500 group by s order by s;
+-- Not supported for this aggregate function, uses the normal decompression.
+select count(*), min(x) from mvagg where t < 1500;
+
+select metadata_batches('select count(*), min(t), max(t) from mvagg');
+select metadata_batches('select count(*), min(t), max(t) from mvagg where t < 1500');
+select metadata_batches('select s, count(*), min(t), max(t), sum(s) from mvagg where t >= 1000 and t <= 2500 group by s');
+select metadata_batches('select s, count(*), min(t), max(t), sum(s) from mvagg where t > 500 group by s');
+select metadata_batches('select count(*), min(x) from mvagg where t < 1500');
+
+set timescaledb.enable_batch_metadata_aggregation to off;
+select count(*), min(t), max(t) from mvagg;
+select count(*), min(t), max(t) from mvagg where t < 1500;
+select s, count(*), min(t), max(t), sum(s) from mvagg where t >= 1000 and t <= 2500
+    group by s order by s;
+select s, count(*), min(t), max(t), sum(s) from mvagg where t > 500 group by s order by s;
+-- Not supported for this aggregate function, uses the normal decompression.
+select count(*), min(x) from mvagg where t < 1500;
+
+select metadata_batches('select count(*), min(t), max(t) from mvagg');
+select metadata_batches('select count(*), min(t), max(t) from mvagg where t < 1500');
+select metadata_batches('select s, count(*), min(t), max(t), sum(s) from mvagg where t >= 1000 and t <= 2500 group by s');
+select metadata_batches('select s, count(*), min(t), max(t), sum(s) from mvagg where t > 500 group by s');
+select metadata_batches('select count(*), min(x) from mvagg where t < 1500');
+
+reset timescaledb.enable_batch_metadata_aggregation;
+reset timescaledb.debug_require_vector_agg;
@@ -0,0 +1,92 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+create table ps(t int not null, s int, g int, x float8);
+select create_hypertable('ps', 't', chunk_time_interval => 3000);
+insert into ps select t, t % 3, t % 4,
+    case when t % 13 = 0 then null else ((t * 37) % 1000) / 10.0 - 20 end
+from generate_series(0, 29999) t;
+alter table ps set (timescaledb.compress, timescaledb.compress_orderby = 't',
+    timescaledb.compress_segmentby = 's');
+select count(compress_chunk(x)) from show_chunks('ps') x;
+analyze ps;
+set max_parallel_workers_per_gather = 0;
+
+-- The percentile_sketch() is computed by the vectorized aggregation with both
+-- the batch and the hash grouping.
+set timescaledb.debug_require_vector_agg = 'require';
+select approx_percentile(percentile_sketch(x), 0.01) p01,
+    approx_percentile(percentile_sketch(x), 0.5) p50,
+    approx_percentile(percentile_sketch(x), 0.99) p99
+from ps;
+select g, approx_percentile(percentile_sketch(x), 0.5) p50,
+    approx_percentile(percentile_sketch(x), 0.99) p99
+from ps group by g order by g;
+select s, approx_percentile(percentile_sketch(x), 0.5) p50 from ps where t < 10000
+group by s order by s;
+
+-- The same results without the vectorized aggregation, compared to the exact
+-- percentiles.
+set timescaledb.enable_vectorized_aggregation to off;
+set timescaledb.debug_require_vector_agg = 'forbid';
+select approx_percentile(percentile_sketch(x), 0.01) p01,
+    approx_percentile(percentile_sketch(x), 0.5) p50,
+    approx_percentile(percentile_sketch(x), 0.99) p99
+from ps;
+select percentile_disc(0.01) within group (order by x) p01,
+    percentile_disc(0.5) within group (order by x) p50,
+    percentile_disc(0.99) within group (order by x) p99
+from ps;
+select g, approx_percentile(percentile_sketch(x), 0.5) p50,
+    approx_percentile(percentile_sketch(x), 0.99) p99
+from ps group by g order by g;
+-- The exact minimum and maximum.
+select approx_percentile(percentile_sketch(x), 0) p0,
+    approx_percentile(percentile_sketch(x), 1) p100
+from ps;
+-- No rows.
+select percentile_sketch(x) is null from ps where t < 0;
+
+reset timescaledb.enable_vectorized_aggregation;
+reset timescaledb.debug_require_vector_agg;
+
+\set ON_ERROR_STOP 0
+select approx_percentile(percentile_sketch(x), 1.5) from ps;
+\set ON_ERROR_STOP 1
+
+-- NaN and infinite values are skipped like nulls.
+select approx_percentile(percentile_sketch(v), 0) p0,
+    approx_percentile(percentile_sketch(v), 1) p100
+from (values (1), ('nan'::float8), (3), ('inf'), (null), ('-inf')) v(v);
+select percentile_sketch(v) is null from (values ('nan'::float8), ('inf')) v(v);
+
+-- The sketches can be stored in continuous aggregates and merged at query time.
+create function ps_now() returns int language sql stable as 'select 30000';
+select set_integer_now_func('ps', 'ps_now');
+create materialized view ps_cagg with (timescaledb.continuous, timescaledb.materialized_only = true) as
+select time_bucket(3000, t) b, percentile_sketch(x) sk from ps group by 1 with no data;
+call refresh_continuous_aggregate('ps_cagg', null, null);
+select b, approx_percentile(sk, 0.5) p50 from ps_cagg order by b;
+select approx_percentile(percentile_sketch_merge(sk), 0.01) p01,
+    approx_percentile(percentile_sketch_merge(sk), 0.5) p50,
+    approx_percentile(percentile_sketch_merge(sk), 0.99) p99
+from ps_cagg;
+
+-- The vectorized aggregation skips NaN and infinite values as well.
+create table psnan(t int not null, g int, x float8);
+select create_hypertable('psnan', 't', chunk_time_interval => 1000);
+insert into psnan select t, t % 2,
+    case t % 5 when 0 then 'nan'::float8 when 1 then 'inf' when 2 then '-inf' else t end
+from generate_series(1, 2000) t;
+alter table psnan set (timescaledb.compress, timescaledb.compress_orderby = 't',
+    timescaledb.compress_segmentby = 'g');
+select count(compress_chunk(x)) from show_chunks('psnan') x;
+set timescaledb.debug_require_vector_agg = 'require';
+select approx_percentile(percentile_sketch(x), 0) p0,
+    approx_percentile(percentile_sketch(x), 1) p100
+from psnan;
+select g, approx_percentile(percentile_sketch(x), 0) p0,
+    approx_percentile(percentile_sketch(x), 1) p100
+from psnan group by g order by g;
+reset timescaledb.debug_require_vector_agg;